@@ -0,0 +1,24 @@
+#!/usr/bin/bash -e
+
+DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" >/dev/null && pwd)"
+
+VERSION="1.14.1"
+if [ "$(uname)" == "Darwin" ]; then
+  ARCHNAME="Darwin"
+  PKG="onnxruntime-osx-universal2-$VERSION"
+else
+  ARCHNAME="x86_64"
+  PKG="onnxruntime-linux-x64-$VERSION"
+fi
+
+cd $DIR
+curl -L -o /tmp/$PKG.tgz https://github.com/microsoft/onnxruntime/releases/download/v$VERSION/$PKG.tgz
+rm -rf /tmp/$PKG
+tar -xzf /tmp/$PKG.tgz -C /tmp
+
+INSTALL_DIR="$DIR/$ARCHNAME"
+rm -rf $INSTALL_DIR include
+mkdir -p $INSTALL_DIR
+
+cp -r /tmp/$PKG/include $DIR
+cp -P /tmp/$PKG/lib/libonnxruntime* $INSTALL_DIR
@@ -12,8 +12,9 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <string_view>
 #include <thread>
-#include <unordered_map>
+#include <utility>
 
 #include <libusb-1.0/libusb.h>
 
@@ -26,8 +27,10 @@
 #include "selfdrive/hardware/hw.h"
 #include "selfdrive/locationd/ublox_msg.h"
 
+#include "selfdrive/boardd/can_send_scheduler.h"
 #include "selfdrive/boardd/panda.h"
 #include "selfdrive/boardd/pigeon.h"
+#include "selfdrive/boardd/sim_panda.h"
 
 #define MAX_IR_POWER 0.5f
 #define MIN_IR_POWER 0.0f
@@ -102,7 +105,14 @@ void safety_setter_thread(Panda *panda) {
 Panda *usb_connect() {
   std::unique_ptr<Panda> panda;
   try {
-    panda = std::make_unique<Panda>();
+    if (getenv("SIMULATE_PANDA")) {
+      SimPandaConfig config;
+      config.bus_load = util::getenv("SIM_PANDA_BUS_LOAD", 0.0f);
+      config.error_rate = util::getenv("SIM_PANDA_ERROR_RATE", 0.0f);
+      panda = std::make_unique<Panda>(std::make_unique<SimPanda>(config));
+    } else {
+      panda = std::make_unique<Panda>();
+    }
   } catch (std::exception &e) {
     return nullptr;
   }
@@ -176,10 +186,8 @@ static Panda *usb_retry_connect() {
 }
 
 void can_recv(Panda *panda, PubMaster &pm) {
-  kj::Array<capnp::word> can_data;
-  panda->can_receive(can_data);
-  auto bytes = can_data.asBytes();
-  pm.send("can", bytes.begin(), bytes.size());
+  auto bytes = panda->can_receive();
+  pm.send("can", (capnp::byte *)bytes.begin(), bytes.size());
 }
 
 void can_send_thread(Panda *panda, bool fake_send) {
@@ -191,6 +199,10 @@ void can_send_thread(Panda *panda, bool fake_send) {
   assert(subscriber != NULL);
   subscriber->setTimeout(100);
 
+  CanSendScheduler scheduler;
+  uint32_t packet[CAN_SEND_MAX_FRAMES * 4];
+  uint64_t log_mono_times[CAN_SEND_MAX_FRAMES];
+
   // run as fast as messages come in
   while (!do_exit && panda->connected) {
     Message * msg = subscriber->receive();
@@ -202,17 +214,30 @@ void can_send_thread(Panda *panda, bool fake_send) {
       continue;
     }
 
-    capnp::FlatArrayMessageReader cmsg(aligned_buf.align(msg));
-    cereal::Event::Reader event = cmsg.getRoot<cereal::Event>();
+    // take everything that queued up while the last transfer was in flight
+    for (; msg != NULL; msg = subscriber->receive(true)) {
+      capnp::FlatArrayMessageReader cmsg(aligned_buf.align(msg));
+      cereal::Event::Reader event = cmsg.getRoot<cereal::Event>();
 
-    //Dont send if older than 1 second
-    if (nanos_since_boot() - event.getLogMonoTime() < 1e9) {
+      scheduler.enqueue(event.getSendcan(), event.getLogMonoTime());
+      delete msg;
+    }
+
+    // send the pending frames in as few transfers as possible, stale ones are dropped
+    int count;
+    while ((count = scheduler.pack(packet, CAN_SEND_MAX_FRAMES, nanos_since_boot(), log_mono_times)) > 0) {
       if (!fake_send) {
-        panda->can_send(event.getSendcan());
+        panda->can_send_packed(packet, count);
       }
-    }
 
-    delete msg;
+      // once per sendcan message in the transfer, including the time queued behind earlier writes
+      const uint64_t sent = nanos_since_boot();
+      std::sort(log_mono_times, log_mono_times + count);
+      uint64_t *end = std::unique(log_mono_times, log_mono_times + count);
+      for (uint64_t *t = log_mono_times; t != end; t++) {
+        panda->can_stats.sendcan_age.record(sent - *t);
+      }
+    }
   }
 
   delete subscriber;
@@ -225,25 +250,22 @@ void can_recv_thread(Panda *panda) {
   // can = 8006
   PubMaster pm({"can"});
 
-  // run at 100hz
+  // CAN IN transfers stay queued on the panda, so publish as soon as data arrives.
+  // can_receive times out after 10ms, keeping "can" at 100hz or more on a quiet bus
   const uint64_t dt = 10000000ULL;
-  uint64_t next_frame_time = nanos_since_boot() + dt;
-
+  uint64_t last_publish = nanos_since_boot();
   while (!do_exit && panda->connected) {
     can_recv(panda, pm);
 
     uint64_t cur_time = nanos_since_boot();
-    int64_t remaining = next_frame_time - cur_time;
-    if (remaining > 0) {
-      std::this_thread::sleep_for(std::chrono::nanoseconds(remaining));
-    } else {
-      if (ignition) {
-        LOGW("missed cycles (%d) %lld", (int)-1*remaining/dt, remaining);
-      }
-      next_frame_time = cur_time;
+    // more than a cycle past when can_receive should have returned
+    int64_t remaining = last_publish + dt - cur_time;
+    if (remaining <= -(int64_t)dt && ignition) {
+      LOGW("missed cycles (%d) %lld", (int)-1*remaining/dt, remaining);
     }
-
-    next_frame_time += dt;
+    panda->can_stats.recv_interval.record(cur_time - last_publish);
+    panda->can_stats.maybe_report(cur_time);
+    last_publish = cur_time;
   }
 }
 
@@ -470,7 +492,7 @@ void hardware_control_thread(Panda *panda) {
   }
 }
 
-static void pigeon_publish_raw(PubMaster &pm, const std::string &dat) {
+static void pigeon_publish_raw(PubMaster &pm, std::string_view dat) {
   // create message
   MessageBuilder msg;
   msg.initEvent().setUbloxRaw(capnp::Data::Reader((uint8_t*)dat.data(), dat.length()));
@@ -482,25 +504,36 @@ void pigeon_thread(Panda *panda) {
   bool ignition_last = false;
 
   Pigeon *pigeon = Hardware::TICI() ? Pigeon::connect("/dev/ttyHS0") : Pigeon::connect(panda);
+  UbxFramer framer;
 
-  std::unordered_map<char, uint64_t> last_recv_time;
-  std::unordered_map<char, int64_t> cls_max_dt = {
-    {(char)ublox::CLASS_NAV, int64_t(900000000ULL)}, // 0.9s
-    {(char)ublox::CLASS_RXM, int64_t(900000000ULL)}, // 0.9s
+  uint64_t last_recv_time[256] = {};
+  const std::pair<uint8_t, int64_t> cls_max_dt[] = {
+    {ublox::CLASS_NAV, int64_t(900000000ULL)}, // 0.9s
+    {ublox::CLASS_RXM, int64_t(900000000ULL)}, // 0.9s
   };
 
   while (!do_exit && panda->connected) {
     bool need_reset = false;
-    std::string recv = pigeon->receive();
-
-    // Parse message header
-    if (ignition && recv.length() >= 3) {
-      if (recv[0] == (char)ublox::PREAMBLE1 && recv[1] == (char)ublox::PREAMBLE2) {
-        const char msg_cls = recv[2];
-        uint64_t t = nanos_since_boot();
-        if (t > last_recv_time[msg_cls]) {
-          last_recv_time[msg_cls] = t;
+
+    // wake up at least every 100ms to follow ignition
+    if (pigeon->wait_for_data(100)) {
+      std::string recv = pigeon->receive();
+
+      // Check based on null bytes
+      if (ignition && recv.length() > 0 && recv[0] == (char)0x00) {
+        need_reset = true;
+        LOGW("received invalid ublox message while onroad, resetting panda GPS");
+      }
+
+      // publish every complete frame as soon as it's in
+      framer.add(recv);
+      std::string_view frame;
+      while (framer.next(frame)) {
+        if (ignition) {
+          const uint8_t msg_cls = frame[2];
+          last_recv_time[msg_cls] = std::max(last_recv_time[msg_cls], nanos_since_boot());
         }
+        pigeon_publish_raw(pm, frame);
       }
     }
 
@@ -514,16 +547,6 @@ void pigeon_thread(Panda *panda) {
       }
     }
 
-    // Check based on null bytes
-    if (ignition && recv.length() > 0 && recv[0] == (char)0x00) {
-      need_reset = true;
-      LOGW("received invalid ublox message while onroad, resetting panda GPS");
-    }
-
-    if (recv.length() > 0) {
-      pigeon_publish_raw(pm, recv);
-    }
-
     // init pigeon on rising ignition edge
     // since it was turned off in low power mode
     if((ignition && !ignition_last) || need_reset) {
@@ -542,9 +565,6 @@ void pigeon_thread(Panda *panda) {
     }
 
     ignition_last = ignition;
-
-    // 10ms - 100 Hz
-    util::sleep_for(10);
   }
 
   delete pigeon;
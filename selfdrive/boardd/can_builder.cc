@@ -0,0 +1,62 @@
+#include "selfdrive/boardd/can_builder.h"
+
+#include <cstring>
+
+#include <capnp/serialize.h>
+
+#include "cereal/gen/cpp/log.capnp.h"
+#include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/timing.h"
+
+// root pointer, Event struct and the list tag, with room to spare
+const size_t EVENT_WORDS = 16;
+// CanData struct (one data word, one pointer) plus up to 8 bytes of dat
+const size_t CAN_MSG_WORDS = 3;
+
+CanMessageBuilder::CanMessageBuilder(size_t max_recv) : max_msgs(max_recv / 0x10) {
+  arena = kj::heapArray<capnp::word>(1 + EVENT_WORDS + max_msgs * CAN_MSG_WORDS);
+  memset(arena.begin(), 0, arena.size() * sizeof(capnp::word));
+}
+
+kj::ArrayPtr<const capnp::byte> CanMessageBuilder::build(const uint32_t *data, size_t recv, bool valid) {
+  size_t num_msg = recv / 0x10;
+  if (num_msg > max_msgs) {
+    LOGE_100("CAN message builder overflow, dropping %zu messages", num_msg - max_msgs);
+    num_msg = max_msgs;
+  }
+
+  msg.reset();
+  msg.emplace(arena.slice(1, arena.size()), capnp::AllocationStrategy::FIXED_SIZE);
+
+  auto evt = msg->initRoot<cereal::Event>();
+  evt.setLogMonoTime(nanos_since_boot());
+  evt.setValid(valid);
+
+  // populate message
+  auto canData = evt.initCan(num_msg);
+  for (size_t i = 0; i < num_msg; i++) {
+    if (data[i*4] & 4) {
+      // extended
+      canData[i].setAddress(data[i*4] >> 3);
+    } else {
+      // normal
+      canData[i].setAddress(data[i*4] >> 21);
+    }
+    canData[i].setBusTime(data[i*4+1] >> 16);
+    int len = data[i*4+1]&0xF;
+    canData[i].setDat(kj::arrayPtr((uint8_t*)&data[i*4+2], len));
+    canData[i].setSrc((data[i*4+1] >> 4) & 0xff);
+  }
+
+  auto segments = msg->getSegmentsForOutput();
+  if (segments.size() != 1 || segments[0].begin() != &arena[1]) {
+    fallback = capnp::messageToFlatArray(*msg);
+    return fallback.asBytes();
+  }
+
+  // single segment table: segment count - 1, then the segment size in words
+  uint32_t *table = (uint32_t *)arena.begin();
+  table[0] = 0;
+  table[1] = segments[0].size();
+  return arena.slice(0, 1 + segments[0].size()).asBytes();
+}
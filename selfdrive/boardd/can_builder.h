@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include <capnp/message.h>
+#include <kj/array.h>
+
+// Builds "can" events from raw panda CAN IN data directly into a preallocated
+// single-segment arena. The arena is sized for the worst case up front, so a
+// cycle needs no heap allocation and the segment is sent without flattening.
+class CanMessageBuilder {
+public:
+  // max_recv: largest number of raw bytes passed to build()
+  CanMessageBuilder(size_t max_recv);
+
+  // the returned bytes stay valid until the next call to build()
+  kj::ArrayPtr<const capnp::byte> build(const uint32_t *data, size_t recv, bool valid);
+
+private:
+  size_t max_msgs;
+  // word 0 holds the segment table, the rest is the message's first segment
+  kj::Array<capnp::word> arena;
+  // the builder zeroes its part of the arena when reset, as capnp requires
+  std::optional<capnp::MallocMessageBuilder> msg;
+  // only used if a message outgrows the arena
+  kj::Array<capnp::word> fallback;
+};
@@ -0,0 +1,80 @@
+#include "selfdrive/boardd/can_send_scheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
+#include "selfdrive/common/swaglog.h"
+
+// UDS/ISO-TP addresses, multi frame requests break if frames are replaced
+static bool is_diagnostic(uint32_t addr) {
+  return (addr >= 0x700 && addr <= 0x7ff) || (addr & 0xfffe0000) == 0x18da0000;
+}
+
+CanSendScheduler::CanSendScheduler(CanSendConfig cfg) : config(cfg) {
+  pending.reserve(CAN_SEND_MAX_FRAMES);
+}
+
+void CanSendScheduler::enqueue(capnp::List<cereal::CanData>::Reader can_data_list, uint64_t log_mono_time) {
+  for (auto cmsg : can_data_list) {
+    Frame f = {};
+    f.addr = cmsg.getAddress();
+    f.bus = cmsg.getSrc();
+    auto can_data = cmsg.getDat();
+    assert(can_data.size() <= 8);
+    f.len = can_data.size();
+    memcpy(f.dat, can_data.begin(), f.len);
+
+    f.priority = config.bus_priority[std::min<int>(f.bus, std::size(config.bus_priority) - 1)];
+    f.seq = seq++;
+    f.log_mono_time = log_mono_time;
+    auto age = config.max_age_by_addr.find(f.addr);
+    f.deadline = log_mono_time + (age != config.max_age_by_addr.end() ? age->second : config.max_age);
+
+    if (config.replaceable_addrs.count(f.addr) && !is_diagnostic(f.addr)) {
+      auto it = std::find_if(pending.begin(), pending.end(), [&](const Frame &p) { return p.addr == f.addr && p.bus == f.bus; });
+      if (it != pending.end()) {
+        // keep the queue position of the frame it replaces
+        f.seq = it->seq;
+        *it = f;
+        superseded++;
+        continue;
+      }
+    }
+    pending.push_back(f);
+  }
+}
+
+int CanSendScheduler::pack(uint32_t *buf, int max_frames, uint64_t now, uint64_t *log_mono_times) {
+  auto expired_end = std::remove_if(pending.begin(), pending.end(), [&](const Frame &f) { return f.deadline < now; });
+  if (expired_end != pending.end()) {
+    const size_t dropped = pending.end() - expired_end;
+    LOGW_100("dropping %zu CAN frames past their deadline", dropped);
+    expired += dropped;
+    pending.erase(expired_end, pending.end());
+  }
+
+  std::sort(pending.begin(), pending.end(), [](const Frame &a, const Frame &b) {
+    return a.priority != b.priority ? a.priority < b.priority : a.seq < b.seq;
+  });
+
+  const int count = std::min<int>(max_frames, pending.size());
+  for (int i = 0; i < count; i++) {
+    const Frame &f = pending[i];
+    if (f.addr >= 0x800) { // extended
+      buf[i*4] = (f.addr << 3) | 5;
+    } else { // normal
+      buf[i*4] = (f.addr << 21) | 1;
+    }
+    buf[i*4+1] = f.len | (f.bus << 4);
+    buf[i*4+2] = 0;
+    buf[i*4+3] = 0;
+    memcpy(&buf[i*4+2], f.dat, f.len);
+    if (log_mono_times) {
+      log_mono_times[i] = f.log_mono_time;
+    }
+  }
+  pending.erase(pending.begin(), pending.begin() + count);
+  return count;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "cereal/gen/cpp/log.capnp.h"
+
+// most frames packed into one bulk transfer to the panda
+#define CAN_SEND_MAX_FRAMES (0x1000 / 0x10)
+
+struct CanSendConfig {
+  // frames are dropped this long after the logMonoTime of their sendcan message
+  uint64_t max_age = 1000000000ULL;
+  // per address overrides of max_age
+  std::unordered_map<uint32_t, uint64_t> max_age_by_addr;
+  // lower is sent first, the last entry applies to every higher bus
+  int bus_priority[4] = {0, 1, 1, 1};
+  // addresses where a pending frame may be replaced by a newer one on the same bus.
+  // most control messages carry counters and checksums the car checks, so this is opt-in
+  std::unordered_set<uint32_t> replaceable_addrs;
+};
+
+// Collects frames from sendcan messages and packs them into as few USB
+// transfers as possible. Frames go out by bus priority, and each bus keeps
+// the order they were sent in. Only frames in replaceable_addrs are replaced
+// by newer ones, never diagnostics. Frames past their deadline are dropped.
+class CanSendScheduler {
+public:
+  CanSendScheduler(CanSendConfig config = {});
+
+  void enqueue(capnp::List<cereal::CanData>::Reader can_data_list, uint64_t log_mono_time);
+  // packs up to max_frames pending frames in panda format into buf, returns the number of frames.
+  // log_mono_times, if given, gets the logMonoTime of each frame's sendcan message
+  int pack(uint32_t *buf, int max_frames, uint64_t now, uint64_t *log_mono_times = nullptr);
+  bool empty() const { return pending.empty(); }
+
+  uint64_t superseded = 0;
+  uint64_t expired = 0;
+
+private:
+  struct Frame {
+    uint32_t addr;
+    uint8_t bus;
+    uint8_t len;
+    uint8_t dat[8];
+    int priority;
+    uint64_t seq;
+    uint64_t log_mono_time;
+    uint64_t deadline;
+  };
+
+  CanSendConfig config;
+  std::vector<Frame> pending;
+  uint64_t seq = 0;
+};
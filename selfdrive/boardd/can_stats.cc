@@ -0,0 +1,54 @@
+#include "selfdrive/boardd/can_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "selfdrive/common/swaglog.h"
+
+void DurationHistogram::record(uint64_t ns) {
+  const uint64_t us = ns / 1000;
+  const int bucket = us == 0 ? 0 : std::min(NUM_BUCKETS - 1, 64 - __builtin_clzll(us));
+  buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+  uint64_t prev = max_ns.load(std::memory_order_relaxed);
+  while (ns > prev && !max_ns.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+}
+
+std::string DurationHistogram::summary() {
+  uint32_t counts[NUM_BUCKETS];
+  uint64_t total = 0;
+  for (int i = 0; i < NUM_BUCKETS; i++) {
+    counts[i] = buckets[i].exchange(0, std::memory_order_relaxed);
+    total += counts[i];
+  }
+  const uint64_t max_us = max_ns.exchange(0, std::memory_order_relaxed) / 1000;
+
+  // upper bound of the bucket holding the percentile, bucket i covers [2^(i-1), 2^i) us
+  auto percentile = [&](double p) -> uint64_t {
+    uint64_t target = p * total, seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+      seen += counts[i];
+      if (seen > target) return std::min<uint64_t>(1ULL << i, max_us);
+    }
+    return max_us;
+  };
+
+  char buf[128];
+  snprintf(buf, sizeof(buf), "{\"n\": %llu, \"p50\": %llu, \"p99\": %llu, \"max\": %llu}",
+           (unsigned long long)total, (unsigned long long)percentile(0.5),
+           (unsigned long long)percentile(0.99), (unsigned long long)max_us);
+  return buf;
+}
+
+void CanStats::maybe_report(uint64_t now) {
+  if (last_report == 0) {
+    last_report = now;
+    return;
+  }
+  if (now - last_report < report_interval) return;
+  last_report = now;
+
+  LOG("can_stats {\"usb_write\": %s, \"rx_queue\": %s, \"build\": %s, \"sendcan_age\": %s, \"recv_interval\": %s}",
+      usb_write.summary().c_str(), rx_queue.summary().c_str(), build.summary().c_str(),
+      sendcan_age.summary().c_str(), recv_interval.summary().c_str());
+}
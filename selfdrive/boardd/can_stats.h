@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Lock-free histogram of durations in power of two microsecond buckets.
+// Recording is safe from any thread, summary() reads and resets the window.
+class DurationHistogram {
+public:
+  void record(uint64_t ns);
+  // count, p50, p99 and max of the current window as a json object, in us
+  std::string summary();
+
+private:
+  static constexpr int NUM_BUCKETS = 24;  // last bucket is >= 2^23 us, about 8s
+  std::atomic<uint32_t> buckets[NUM_BUCKETS] = {};
+  std::atomic<uint64_t> max_ns = 0;
+};
+
+// Timing of the CAN path through boardd, logged as a "can_stats" json line every report_interval
+struct CanStats {
+  DurationHistogram usb_write;     // can_send bulk transfer
+  DurationHistogram rx_queue;      // received by the transport until picked up by can_receive
+  DurationHistogram build;         // capnp build of a "can" event
+  DurationHistogram sendcan_age;   // sendcan logMonoTime until its bulk write to the panda returned
+  DurationHistogram recv_interval; // between consecutive "can" publishes
+
+  // logs and resets the histograms if report_interval has passed since the last report
+  void maybe_report(uint64_t now);
+
+private:
+  static constexpr uint64_t report_interval = 10ULL * 1000000000ULL;
+  uint64_t last_report = 0;
+};
@@ -2,6 +2,7 @@
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 #include <vector>
@@ -9,6 +10,7 @@
 #include "cereal/messaging/messaging.h"
 #include "selfdrive/common/gpio.h"
 #include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/timing.h"
 #include "selfdrive/common/util.h"
 
 static int init_usb_ctx(libusb_context *context) {
@@ -28,7 +30,7 @@ static int init_usb_ctx(libusb_context *context) {
 }
 
 
-Panda::Panda(std::string serial) {
+PandaUsbTransport::PandaUsbTransport(std::string serial) {
   // init libusb
   ssize_t num_devices;
   libusb_device **dev_list = NULL;
@@ -71,11 +73,6 @@ Panda::Panda(std::string serial) {
   err = libusb_claim_interface(dev_handle, 0);
   if (err != 0) { goto fail; }
 
-  hw_type = get_hw_type();
-
-  has_rtc = (hw_type == cereal::PandaState::PandaType::UNO) ||
-            (hw_type == cereal::PandaState::PandaType::DOS);
-
   return;
 
 fail:
@@ -86,13 +83,13 @@ fail:
   throw std::runtime_error("Error connecting to panda");
 }
 
-Panda::~Panda() {
-  std::lock_guard lk(usb_lock);
+PandaUsbTransport::~PandaUsbTransport() {
   cleanup();
-  connected = false;
 }
 
-void Panda::cleanup() {
+void PandaUsbTransport::cleanup() {
+  stop_can_rx();
+
   if (dev_handle) {
     libusb_release_interface(dev_handle, 0);
     libusb_close(dev_handle);
@@ -103,6 +100,196 @@ void Panda::cleanup() {
   }
 }
 
+int PandaUsbTransport::control_transfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex,
+                                        unsigned char *data, uint16_t wLength, unsigned int timeout) {
+  return libusb_control_transfer(dev_handle, bmRequestType, bRequest, wValue, wIndex, data, wLength, timeout);
+}
+
+int PandaUsbTransport::bulk_transfer(unsigned char endpoint, unsigned char *data, int length, int *transferred, unsigned int timeout) {
+  return libusb_bulk_transfer(dev_handle, endpoint, data, length, transferred, timeout);
+}
+
+void PandaUsbTransport::usb_event_loop() {
+  // short enough to resubmit failed transfers close to their backoff
+  struct timeval tv = {0, 10000};
+  while (usb_events_running) {
+    libusb_handle_events_timeout_completed(ctx, &tv, NULL);
+    retry_can_rx();
+  }
+}
+
+bool PandaUsbTransport::start_can_rx(CanRxCallback callback) {
+  can_rx_callback = callback;
+  can_rx_running = true;
+  usb_events_running = true;
+  usb_event_thread = std::thread(&PandaUsbTransport::usb_event_loop, this);
+
+  std::lock_guard lk(can_rx_lock);
+  for (int i = 0; i < CAN_RX_TRANSFERS; i++) {
+    libusb_transfer *transfer = libusb_alloc_transfer(0);
+    if (transfer == NULL) {
+      LOGE("failed to allocate CAN transfer");
+      return false;
+    }
+    libusb_fill_bulk_transfer(transfer, dev_handle, 0x81, (unsigned char *)can_rx_bufs[i], RECV_SIZE,
+                              can_rx_complete, this, TIMEOUT);
+    can_rx_transfers[i] = transfer;
+
+    int err = libusb_submit_transfer(transfer);
+    if (err != 0) {
+      LOGE("failed to submit CAN transfer: %s", libusb_strerror((enum libusb_error)err));
+      return false;
+    }
+    can_rx_active++;
+  }
+  return true;
+}
+
+void PandaUsbTransport::stop_can_rx() {
+  {
+    std::lock_guard lk(can_rx_lock);
+    can_rx_running = false;
+  }
+  for (auto transfer : can_rx_transfers) {
+    if (transfer) libusb_cancel_transfer(transfer);
+  }
+
+  // cancelled transfers are retired by can_rx_complete on the event thread
+  bool retired = true;
+  {
+    std::unique_lock lk(can_rx_lock);
+    retired = can_rx_cv.wait_for(lk, std::chrono::seconds(1), [&] { return can_rx_active == 0; });
+  }
+
+  usb_events_running = false;
+  if (usb_event_thread.joinable()) {
+    usb_event_thread.join();
+  }
+
+  if (!retired) {
+    LOGE("CAN transfers still active, leaking them");
+    return;
+  }
+  for (auto &transfer : can_rx_transfers) {
+    if (transfer) libusb_free_transfer(transfer);
+    transfer = NULL;
+  }
+}
+
+void LIBUSB_CALL PandaUsbTransport::can_rx_complete(libusb_transfer *transfer) {
+  PandaUsbTransport *usb = (PandaUsbTransport *)transfer->user_data;
+
+  int err = LIBUSB_ERROR_IO;
+  switch (transfer->status) {
+    case LIBUSB_TRANSFER_COMPLETED: err = LIBUSB_SUCCESS; break;
+    case LIBUSB_TRANSFER_OVERFLOW: err = LIBUSB_ERROR_OVERFLOW; break;
+    case LIBUSB_TRANSFER_CANCELLED: err = LIBUSB_ERROR_INTERRUPTED; break;
+    case LIBUSB_TRANSFER_NO_DEVICE: err = LIBUSB_ERROR_NO_DEVICE; break;
+    case LIBUSB_TRANSFER_TIMED_OUT: err = LIBUSB_ERROR_TIMEOUT; break;
+    case LIBUSB_TRANSFER_STALL: err = LIBUSB_ERROR_PIPE; break;
+    default: break;
+  }
+
+  std::lock_guard lk(usb->can_rx_lock);
+  if (usb->can_rx_running) {
+    usb->can_rx_callback(err, transfer->buffer, transfer->actual_length);
+  }
+
+  // a stalled or failing endpoint completes again right away, so only these are resubmitted here
+  if (usb->can_rx_running && (err == LIBUSB_SUCCESS || err == LIBUSB_ERROR_TIMEOUT)) {
+    if (err == LIBUSB_SUCCESS) {
+      usb->can_rx_failures = 0;
+    }
+    err = libusb_submit_transfer(transfer);
+    if (err == 0) return;
+    usb->can_rx_callback(err, NULL, 0);
+  }
+
+  usb->can_rx_active--;
+  if (usb->can_rx_running && err != LIBUSB_ERROR_NO_DEVICE) {
+    usb->fail_can_rx(transfer, err);
+  }
+  usb->can_rx_cv.notify_all();
+}
+
+// with can_rx_lock held
+void PandaUsbTransport::fail_can_rx(libusb_transfer *transfer, int err) {
+  for (int i = 0; i < CAN_RX_TRANSFERS; i++) {
+    if (can_rx_transfers[i] == transfer) {
+      can_rx_failed[i] = true;
+    }
+  }
+  can_rx_stalled |= err == LIBUSB_ERROR_PIPE;
+  if (can_rx_retry_time == 0) {
+    const uint64_t backoff = std::min(CAN_RX_RETRY_MIN_NS << std::min(can_rx_failures, 7), CAN_RX_RETRY_MAX_NS);
+    can_rx_retry_time = nanos_since_boot() + backoff;
+    can_rx_failures++;
+  }
+}
+
+// runs on usb_event_thread between event handling
+void PandaUsbTransport::retry_can_rx() {
+  bool clear_halt = false;
+  {
+    std::lock_guard lk(can_rx_lock);
+    if (!can_rx_running || can_rx_retry_time == 0 || nanos_since_boot() < can_rx_retry_time) {
+      return;
+    }
+    can_rx_retry_time = 0;
+    std::swap(clear_halt, can_rx_stalled);
+  }
+
+  // handles events itself, so it can't run with can_rx_lock held
+  if (clear_halt) {
+    int err = libusb_clear_halt(dev_handle, 0x81);
+    if (err != 0) {
+      LOGE("failed to clear CAN endpoint halt: %s", libusb_strerror((enum libusb_error)err));
+    }
+  }
+
+  std::lock_guard lk(can_rx_lock);
+  for (int i = 0; i < CAN_RX_TRANSFERS && can_rx_running; i++) {
+    if (!can_rx_failed[i]) continue;
+
+    int err = libusb_submit_transfer(can_rx_transfers[i]);
+    if (err == 0) {
+      can_rx_failed[i] = false;
+      can_rx_active++;
+    } else {
+      can_rx_callback(err, NULL, 0);
+      if (err != LIBUSB_ERROR_NO_DEVICE) {
+        fail_can_rx(can_rx_transfers[i], err);
+      }
+    }
+  }
+}
+
+Panda::Panda(std::string serial) : Panda(std::make_unique<PandaUsbTransport>(serial)) {}
+
+Panda::Panda(std::unique_ptr<PandaTransport> t) : transport(std::move(t)) {
+  usb_serial = transport->usb_serial;
+  hw_type = get_hw_type();
+
+  has_rtc = (hw_type == cereal::PandaState::PandaType::UNO) ||
+            (hw_type == cereal::PandaState::PandaType::DOS);
+
+  // room for a few full transfers in case the publisher falls behind
+  can_rx_pending.reserve(CAN_RX_QUEUE_SIZE/4);
+  can_rx_ready.reserve(CAN_RX_QUEUE_SIZE/4);
+
+  if (!transport->start_can_rx([this](int err, const uint8_t *data, int length) { can_rx_handle(err, data, length); })) {
+    transport->stop_can_rx();
+    throw std::runtime_error("Error starting CAN receive");
+  }
+}
+
+Panda::~Panda() {
+  transport->stop_can_rx();
+  std::lock_guard lk(usb_lock);
+  transport.reset();
+  connected = false;
+}
+
 std::vector<std::string> Panda::list() {
   // init libusb
   ssize_t num_devices;
@@ -163,7 +350,7 @@ int Panda::usb_write(uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigne
 
   std::lock_guard lk(usb_lock);
   do {
-    err = libusb_control_transfer(dev_handle, bmRequestType, bRequest, wValue, wIndex, NULL, 0, timeout);
+    err = transport->control_transfer(bmRequestType, bRequest, wValue, wIndex, NULL, 0, timeout);
     if (err < 0) handle_usb_issue(err, __func__);
   } while (err < 0 && connected);
 
@@ -180,7 +367,7 @@ int Panda::usb_read(uint8_t bRequest, uint16_t wValue, uint16_t wIndex, unsigned
 
   std::lock_guard lk(usb_lock);
   do {
-    err = libusb_control_transfer(dev_handle, bmRequestType, bRequest, wValue, wIndex, data, wLength, timeout);
+    err = transport->control_transfer(bmRequestType, bRequest, wValue, wIndex, data, wLength, timeout);
     if (err < 0) handle_usb_issue(err, __func__);
   } while (err < 0 && connected);
 
@@ -199,7 +386,7 @@ int Panda::usb_bulk_write(unsigned char endpoint, unsigned char* data, int lengt
   do {
     // Try sending can messages. If the receive buffer on the panda is full it will NAK
     // and libusb will try again. After 5ms, it will time out. We will drop the messages.
-    err = libusb_bulk_transfer(dev_handle, endpoint, data, length, &transferred, timeout);
+    err = transport->bulk_transfer(endpoint, data, length, &transferred, timeout);
 
     if (err == LIBUSB_ERROR_TIMEOUT) {
       LOGW("Transmit buffer full");
@@ -223,7 +410,7 @@ int Panda::usb_bulk_read(unsigned char endpoint, unsigned char* data, int length
   std::lock_guard lk(usb_lock);
 
   do {
-    err = libusb_bulk_transfer(dev_handle, endpoint, data, length, &transferred, timeout);
+    err = transport->bulk_transfer(endpoint, data, length, &transferred, timeout);
 
     if (err == LIBUSB_ERROR_TIMEOUT) {
       break; // timeout is okay to exit, recv still happened
@@ -239,6 +426,49 @@ int Panda::usb_bulk_read(unsigned char endpoint, unsigned char* data, int length
   return transferred;
 }
 
+void Panda::can_rx_handle(int err, const uint8_t *data, int length) {
+  std::lock_guard lk(can_rx_lock);
+
+  if (err == LIBUSB_SUCCESS || err == LIBUSB_ERROR_INTERRUPTED || err == LIBUSB_ERROR_TIMEOUT) {
+    can_rx_error_time = 0;
+  } else if (can_rx_error_time == 0) {
+    can_rx_error_time = nanos_since_boot();
+  } else if (connected && nanos_since_boot() - can_rx_error_time > CAN_RX_ERROR_TIMEOUT_NS) {
+    // the transport retries with a backoff, reconnecting is all that's left
+    LOGE("CAN receive failing for %.1f s, reconnecting", (nanos_since_boot() - can_rx_error_time) / 1e9);
+    connected = false;
+    can_rx_cv.notify_all();
+  }
+
+  switch (err) {
+    case LIBUSB_SUCCESS: {
+      // only whole CAN messages, 0x10 bytes each
+      const size_t words = (length / 0x10) * 4;
+      if (can_rx_pending.size() + words > can_rx_pending.capacity()) {
+        LOGE_100("CAN receive queue full, dropping 0x%x bytes", length);
+      } else if (words > 0) {
+        if (can_rx_pending.empty()) {
+          can_rx_pending_time = nanos_since_boot();
+        }
+        can_rx_pending.insert(can_rx_pending.end(), (const uint32_t *)data, (const uint32_t *)data + words);
+        can_rx_cv.notify_all();
+      }
+      break;
+    }
+    case LIBUSB_ERROR_OVERFLOW:
+      comms_healthy = false;
+      LOGE_100("overflow got 0x%x", length);
+      break;
+    case LIBUSB_ERROR_INTERRUPTED:
+    case LIBUSB_ERROR_TIMEOUT:
+      break;
+    default:
+      handle_usb_issue(err, __func__);
+      if (!connected) can_rx_cv.notify_all();
+      break;
+  }
+}
+
 void Panda::set_safety_model(cereal::CarParams::SafetyModel safety_model, int safety_param) {
   usb_write(0xdc, (uint16_t)safety_model, safety_param);
 }
@@ -342,7 +572,7 @@ void Panda::can_send(capnp::List<cereal::CanData>::Reader can_data_list) {
   static std::vector<uint32_t> send;
   const int msg_count = can_data_list.size();
 
-  send.resize(msg_count*0x10);
+  send.resize(msg_count*4);
 
   for (int i = 0; i < msg_count; i++) {
     auto cmsg = can_data_list[i];
@@ -357,41 +587,30 @@ void Panda::can_send(capnp::List<cereal::CanData>::Reader can_data_list) {
     memcpy(&send[i*4+2], can_data.begin(), can_data.size());
   }
 
-  usb_bulk_write(3, (unsigned char*)send.data(), send.size(), 5);
+  can_send_packed(send.data(), msg_count);
 }
 
-int Panda::can_receive(kj::Array<capnp::word>& out_buf) {
-  uint32_t data[RECV_SIZE/4];
-  int recv = usb_bulk_read(0x81, (unsigned char*)data, RECV_SIZE);
-
-  // Not sure if this can happen
-  if (recv < 0) recv = 0;
+void Panda::can_send_packed(uint32_t *data, int msg_count) {
+  uint64_t start = nanos_since_boot();
+  usb_bulk_write(3, (unsigned char*)data, msg_count*0x10, 5);
+  can_stats.usb_write.record(nanos_since_boot() - start);
+}
 
-  if (recv == RECV_SIZE) {
-    LOGW("Receive buffer full");
+kj::ArrayPtr<const capnp::byte> Panda::can_receive(unsigned int timeout) {
+  {
+    // wait for the queued CAN IN transfers to deliver something
+    std::unique_lock lk(can_rx_lock);
+    can_rx_cv.wait_for(lk, std::chrono::milliseconds(timeout), [&] { return !can_rx_pending.empty() || !connected; });
+    std::swap(can_rx_pending, can_rx_ready);
+    can_rx_ready_time = can_rx_pending_time;
   }
-
-  size_t num_msg = recv / 0x10;
-  MessageBuilder msg;
-  auto evt = msg.initEvent();
-  evt.setValid(comms_healthy);
-
-  // populate message
-  auto canData = evt.initCan(num_msg);
-  for (int i = 0; i < num_msg; i++) {
-    if (data[i*4] & 4) {
-      // extended
-      canData[i].setAddress(data[i*4] >> 3);
-      //printf("got extended: %x\n", data[i*4] >> 3);
-    } else {
-      // normal
-      canData[i].setAddress(data[i*4] >> 21);
-    }
-    canData[i].setBusTime(data[i*4+1] >> 16);
-    int len = data[i*4+1]&0xF;
-    canData[i].setDat(kj::arrayPtr((uint8_t*)&data[i*4+2], len));
-    canData[i].setSrc((data[i*4+1] >> 4) & 0xff);
+  uint64_t start = nanos_since_boot();
+  if (!can_rx_ready.empty()) {
+    can_stats.rx_queue.record(start - can_rx_ready_time);
   }
-  out_buf = capnp::messageToFlatArray(msg);
-  return recv;
+
+  auto bytes = can_builder.build(can_rx_ready.data(), can_rx_ready.size() * sizeof(uint32_t), comms_healthy);
+  can_rx_ready.clear();
+  can_stats.build.record(nanos_since_boot() - start);
+  return bytes;
 }
@@ -1,20 +1,36 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <ctime>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include <libusb-1.0/libusb.h>
 
 #include "cereal/gen/cpp/car.capnp.h"
 #include "cereal/gen/cpp/log.capnp.h"
+#include "selfdrive/boardd/can_builder.h"
+#include "selfdrive/boardd/can_stats.h"
 
 // double the FIFO size
 #define RECV_SIZE (0x1000)
 #define TIMEOUT 0
+// number of CAN IN transfers kept queued on the bulk endpoint
+#define CAN_RX_TRANSFERS 4
+// backoff before resubmitting CAN IN transfers that failed, doubled per consecutive failure
+#define CAN_RX_RETRY_MIN_NS (10ULL * 1000000)
+#define CAN_RX_RETRY_MAX_NS (1000ULL * 1000000)
+// how long CAN receive can keep failing before reconnecting to the panda
+#define CAN_RX_ERROR_TIMEOUT_NS (2000ULL * 1000000)
+// bytes of received CAN data buffered between publishes
+#define CAN_RX_QUEUE_SIZE (CAN_RX_TRANSFERS * 2 * RECV_SIZE)
 
 // copied from panda/board/main.c
 struct __attribute__((packed)) health_t {
@@ -40,16 +56,84 @@ struct __attribute__((packed)) health_t {
 };
 
 
-class Panda {
+// USB endpoints of a panda. Errors are reported as libusb_error codes
+class PandaTransport {
+ public:
+  using CanRxCallback = std::function<void(int err, const uint8_t *data, int length)>;
+  virtual ~PandaTransport() {}
+
+  std::string usb_serial;
+
+  // returns the number of bytes transferred or a libusb_error
+  virtual int control_transfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex,
+                               unsigned char *data, uint16_t wLength, unsigned int timeout) = 0;
+  // returns a libusb_error, the number of bytes transferred is stored in transferred
+  virtual int bulk_transfer(unsigned char endpoint, unsigned char *data, int length, int *transferred, unsigned int timeout) = 0;
+  // keeps CAN IN transfers queued on endpoint 0x81 until stop_can_rx(),
+  // callback runs on the transport's thread once per completed transfer
+  virtual bool start_can_rx(CanRxCallback callback) = 0;
+  virtual void stop_can_rx() = 0;
+};
+
+// a panda connected over libusb
+class PandaUsbTransport : public PandaTransport {
+ public:
+  PandaUsbTransport(std::string serial);
+  ~PandaUsbTransport();
+
+  int control_transfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex,
+                       unsigned char *data, uint16_t wLength, unsigned int timeout);
+  int bulk_transfer(unsigned char endpoint, unsigned char *data, int length, int *transferred, unsigned int timeout);
+  bool start_can_rx(CanRxCallback callback);
+  void stop_can_rx();
+
  private:
   libusb_context *ctx = NULL;
   libusb_device_handle *dev_handle = NULL;
+  void cleanup();
+
+  // async CAN receive, completions are handled on usb_event_thread
+  std::thread usb_event_thread;
+  std::atomic<bool> usb_events_running = false;
+  libusb_transfer *can_rx_transfers[CAN_RX_TRANSFERS] = {};
+  uint32_t can_rx_bufs[CAN_RX_TRANSFERS][RECV_SIZE/4];
+  CanRxCallback can_rx_callback;
+  std::mutex can_rx_lock;
+  std::condition_variable can_rx_cv;
+  int can_rx_active = 0;
+  bool can_rx_running = false;
+  // transfers that completed with an error wait for retry_can_rx instead of being resubmitted
+  bool can_rx_failed[CAN_RX_TRANSFERS] = {};
+  bool can_rx_stalled = false;
+  int can_rx_failures = 0;
+  uint64_t can_rx_retry_time = 0;
+  void fail_can_rx(libusb_transfer *transfer, int err);
+  void retry_can_rx();
+  void usb_event_loop();
+  static void LIBUSB_CALL can_rx_complete(libusb_transfer *transfer);
+};
+
+class Panda {
+ private:
+  std::unique_ptr<PandaTransport> transport;
   std::mutex usb_lock;
   void handle_usb_issue(int err, const char func[]);
-  void cleanup();
+  void init();
+
+  // received CAN data, filled on the transport's thread
+  std::mutex can_rx_lock;
+  std::condition_variable can_rx_cv;
+  std::vector<uint32_t> can_rx_pending;  // guarded by can_rx_lock
+  std::vector<uint32_t> can_rx_ready;    // swapped out by can_receive
+  uint64_t can_rx_pending_time = 0;      // arrival of the oldest pending data
+  uint64_t can_rx_ready_time = 0;
+  uint64_t can_rx_error_time = 0;  // first error since the last successful transfer
+  CanMessageBuilder can_builder{CAN_RX_QUEUE_SIZE};
+  void can_rx_handle(int err, const uint8_t *data, int length);
 
  public:
   Panda(std::string serial="");
+  Panda(std::unique_ptr<PandaTransport> transport);
   ~Panda();
 
   std::string usb_serial;
@@ -57,6 +141,7 @@ class Panda {
   std::atomic<bool> comms_healthy = true;
   cereal::PandaState::PandaType hw_type = cereal::PandaState::PandaType::UNKNOWN;
   bool has_rtc = false;
+  CanStats can_stats;
 
   // Static functions
   static std::vector<std::string> list();
@@ -84,5 +169,8 @@ class Panda {
   void set_usb_power_mode(cereal::PandaState::UsbPowerMode power_mode);
   void send_heartbeat();
   void can_send(capnp::List<cereal::CanData>::Reader can_data_list);
-  int can_receive(kj::Array<capnp::word>& out_buf);
+  // sends msg_count frames already in the panda's 0x10 byte format
+  void can_send_packed(uint32_t *data, int msg_count);
+  // returns a serialized "can" event, valid until the next call
+  kj::ArrayPtr<const capnp::byte> can_receive(unsigned int timeout=10);
 };
@@ -1,6 +1,7 @@
 #include "selfdrive/boardd/pigeon.h"
 
 #include <fcntl.h>
+#include <poll.h>
 #include <termios.h>
 #include <unistd.h>
 
@@ -10,6 +11,7 @@
 
 #include "selfdrive/common/gpio.h"
 #include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/timing.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/locationd/ublox_msg.h"
 
@@ -27,6 +29,17 @@ const std::string nack = "\xb5\x62\x05\x00\x02\x00";
 const std::string sos_ack = "\xb5\x62\x09\x14\x08\x00\x02\x00\x00\x00\x01\x00\x00\x00";
 const std::string sos_nack = "\xb5\x62\x09\x14\x08\x00\x02\x00\x00\x00\x00\x00\x00\x00";
 
+// message classes defined by the UBX protocol
+static bool ubx_class_valid(uint8_t cls) {
+  switch (cls) {
+    case 0x01: case 0x02: case 0x04: case 0x05: case 0x06: case 0x09: case 0x0A:
+    case 0x0B: case 0x0D: case 0x10: case 0x13: case 0x21: case 0x27: case 0x28:
+      return true;
+    default:
+      return false;
+  }
+}
+
 Pigeon * Pigeon::connect(Panda * p) {
   PandaPigeon * pigeon = new PandaPigeon();
   pigeon->connect(p);
@@ -145,6 +158,53 @@ void Pigeon::stop() {
   }
 }
 
+void UbxFramer::add(const std::string &data) {
+  buf.erase(0, pos);
+  pos = 0;
+  buf += data;
+}
+
+bool UbxFramer::next(std::string_view &frame) {
+  const char preamble[] = {(char)ublox::PREAMBLE1, (char)ublox::PREAMBLE2};
+  while (true) {
+    size_t start = buf.find(preamble, pos, sizeof(preamble));
+    if (start == std::string::npos) {
+      // keep a trailing first preamble byte
+      pos = (!buf.empty() && buf.back() == preamble[0]) ? buf.size() - 1 : buf.size();
+      return false;
+    }
+    pos = start;
+
+    const size_t available = buf.size() - pos;
+    if (available < ublox::UBLOX_HEADER_SIZE) return false;
+
+    const uint8_t *msg = (const uint8_t *)&buf[pos];
+    const uint16_t payload_len = msg[4] | (msg[5] << 8);
+    if (!ubx_class_valid(msg[2]) || payload_len > ublox::UBLOX_MAX_PAYLOAD_SIZE) {
+      pos++;
+      continue;
+    }
+
+    const size_t total = ublox::UBLOX_HEADER_SIZE + payload_len + ublox::UBLOX_CHECKSUM_SIZE;
+    if (available < total) return false;
+
+    uint8_t ck_a = 0, ck_b = 0;
+    for (size_t i = 2; i < total - ublox::UBLOX_CHECKSUM_SIZE; i++) {
+      ck_a = ck_a + msg[i];
+      ck_b = ck_b + ck_a;
+    }
+    if (ck_a != msg[total - 2] || ck_b != msg[total - 1]) {
+      LOGD("ublox checksum mismatch, resyncing");
+      pos++;
+      continue;
+    }
+
+    frame = std::string_view(&buf[pos], total);
+    pos += total;
+    return true;
+  }
+}
+
 void PandaPigeon::connect(Panda * p) {
   panda = p;
 }
@@ -169,7 +229,8 @@ void PandaPigeon::send(const std::string &s) {
 }
 
 std::string PandaPigeon::receive() {
-  std::string r;
+  std::string r = std::move(pending);
+  pending.clear();
   r.reserve(0x1000 + 0x40);
   unsigned char dat[0x40];
   while (r.length() < 0x1000) {
@@ -181,6 +242,27 @@ std::string PandaPigeon::receive() {
   return r;
 }
 
+bool PandaPigeon::wait_for_data(int timeout_ms) {
+  if (!pending.empty()) return true;
+
+  // the panda can't signal GPS data, so poll quickly while it is flowing and back off to 10ms when idle
+  const uint64_t end = nanos_since_boot() + timeout_ms * 1000000ULL;
+  unsigned char dat[0x40];
+  while (!do_exit && panda->connected) {
+    int len = panda->usb_read(0xe0, 1, 0, dat, sizeof(dat));
+    if (len > 0) {
+      pending.append((char*)dat, len);
+      poll_interval = 1;
+      return true;
+    }
+    if (nanos_since_boot() >= end) break;
+
+    util::sleep_for(poll_interval);
+    poll_interval = std::min(poll_interval * 2, 10);
+  }
+  return false;
+}
+
 void PandaPigeon::set_power(bool power) {
   panda->usb_write(0xd9, power, 0);
 }
@@ -267,7 +349,8 @@ std::string TTYPigeon::receive() {
   while (r.length() < 0x1000) {
     int len = read(pigeon_tty_fd, dat, sizeof(dat));
     if(len < 0) {
-      handle_tty_issue(len, __func__);
+      handle_tty_issue(errno, __func__);
+      break;
     } else if (len == 0) {
       break;
     } else {
@@ -278,6 +361,23 @@ std::string TTYPigeon::receive() {
   return r;
 }
 
+bool TTYPigeon::wait_for_data(int timeout_ms) {
+  struct pollfd fds = {.fd = pigeon_tty_fd, .events = POLLIN};
+  int err = HANDLE_EINTR(poll(&fds, 1, timeout_ms));
+  if (err < 0) {
+    handle_tty_issue(errno, __func__);
+    util::sleep_for(timeout_ms);
+    return false;
+  }
+  if ((fds.revents & (POLLHUP | POLLERR | POLLNVAL)) && !(fds.revents & POLLIN)) {
+    handle_tty_issue(fds.revents & POLLHUP ? ENXIO : EIO, __func__);
+    // poll returns right away on a dead tty, back off instead of spinning
+    util::sleep_for(timeout_ms);
+    return false;
+  }
+  return err > 0 && (fds.revents & POLLIN);
+}
+
 void TTYPigeon::set_power(bool power) {
 #ifdef QCOM2
   int err = 0;
@@ -4,6 +4,7 @@
 
 #include <atomic>
 #include <string>
+#include <string_view>
 
 #include "selfdrive/boardd/panda.h"
 
@@ -21,17 +22,34 @@ class Pigeon {
   virtual void set_baud(int baud) = 0;
   virtual void send(const std::string &s) = 0;
   virtual std::string receive() = 0;
+  // blocks until there is data to receive or timeout_ms passed
+  virtual bool wait_for_data(int timeout_ms) = 0;
   virtual void set_power(bool power) = 0;
 };
 
+// Splits the byte stream from the ublox into complete UBX frames,
+// dropping bytes that aren't part of a frame with a valid checksum
+class UbxFramer {
+ public:
+  void add(const std::string &data);
+  // frame points into the framer and is valid until the next add()
+  bool next(std::string_view &frame);
+ private:
+  std::string buf;
+  size_t pos = 0;
+};
+
 class PandaPigeon : public Pigeon {
   Panda * panda = NULL;
+  std::string pending;
+  int poll_interval = 1;
 public:
   ~PandaPigeon();
   void connect(Panda * p);
   void set_baud(int baud);
   void send(const std::string &s);
   std::string receive();
+  bool wait_for_data(int timeout_ms);
   void set_power(bool power);
 };
 
@@ -45,5 +63,6 @@ public:
   void set_baud(int baud);
   void send(const std::string &s);
   std::string receive();
+  bool wait_for_data(int timeout_ms);
   void set_power(bool power);
 };
@@ -0,0 +1,218 @@
+#include "selfdrive/boardd/sim_panda.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "selfdrive/common/timing.h"
+#include "selfdrive/common/util.h"
+
+SimPanda::SimPanda(SimPandaConfig cfg) : config(cfg), gen(0) {
+  usb_serial = config.serial;
+  start_time = nanos_since_boot();
+  rtc = util::get_time();
+
+  health.voltage = 12000;
+  health.current = 500;
+  health.ignition_line = 0;
+  health.car_harness_status = 1;
+  health.usb_power_mode = (uint8_t)cereal::PandaState::UsbPowerMode::CDP;
+  health.safety_model = (uint8_t)cereal::CarParams::SafetyModel::SILENT;
+}
+
+SimPanda::~SimPanda() {
+  stop_can_rx();
+}
+
+void SimPanda::disconnect() {
+  connected = false;
+  cv.notify_all();
+}
+
+bool SimPanda::inject_error() {
+  return config.error_rate > 0 && std::uniform_real_distribution<double>(0, 1)(gen) < config.error_rate;
+}
+
+void SimPanda::push_rx(const std::array<uint32_t, 4> &frame) {
+  if (rx_fifo.size() >= SIM_PANDA_RX_FIFO_SIZE) {
+    health.can_rx_errs++;
+    return;
+  }
+  rx_fifo.push_back(frame);
+}
+
+void SimPanda::generate_bus_load() {
+  if (config.bus_load <= 0) return;
+
+  const uint64_t due = (nanos_since_boot() - start_time) * config.bus_load / 1e9;
+  // a long idle period only fills the FIFO once
+  load_frames = std::max(load_frames, due > SIM_PANDA_RX_FIFO_SIZE ? due - SIM_PANDA_RX_FIFO_SIZE : 0);
+
+  const uint32_t bus_time = (nanos_since_boot() / 1000) & 0xffff;
+  for (; load_frames < due; load_frames++) {
+    // standard addresses below 0x700, out of the way of test traffic
+    const uint32_t addr = gen() % 0x700;
+    const uint32_t bus = gen() % 3;
+    push_rx({addr << 21, (bus_time << 16) | (bus << 4) | 8, (uint32_t)gen(), (uint32_t)gen()});
+  }
+}
+
+int SimPanda::pop_rx(uint32_t *data, int length) {
+  generate_bus_load();
+
+  int count = std::min<int>(length / 0x10, rx_fifo.size());
+  for (int i = 0; i < count; i++) {
+    memcpy(&data[i*4], rx_fifo.front().data(), 0x10);
+    rx_fifo.pop_front();
+  }
+  return count * 0x10;
+}
+
+int SimPanda::control_transfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex,
+                               unsigned char *data, uint16_t wLength, unsigned int timeout) {
+  if (!connected) return LIBUSB_ERROR_NO_DEVICE;
+
+  std::lock_guard lk(lock);
+  if (inject_error()) return LIBUSB_ERROR_IO;
+
+  auto reply = [&](const void *src, size_t size) {
+    int len = std::min<size_t>(size, wLength);
+    memcpy(data, src, len);
+    return len;
+  };
+
+  if (bmRequestType & LIBUSB_ENDPOINT_IN) {
+    switch (bRequest) {
+      case 0xc1: {
+        uint8_t hw_type = (uint8_t)config.hw_type;
+        return reply(&hw_type, sizeof(hw_type));
+      }
+      case 0xd2:
+        health.uptime = (nanos_since_boot() - start_time) / 1e9;
+        return reply(&health, sizeof(health));
+      case 0xd3:
+      case 0xd4: {
+        uint8_t sig[64];
+        for (int i = 0; i < 64; i++) sig[i] = (bRequest - 0xd3) * 64 + i;
+        return reply(sig, sizeof(sig));
+      }
+      case 0xd0: {
+        char serial[16] = {0};
+        strncpy(serial, config.serial.c_str(), sizeof(serial));
+        return reply(serial, sizeof(serial));
+      }
+      case 0xb2: {
+        uint16_t rpm = fan_speed * 65;
+        return reply(&rpm, sizeof(rpm));
+      }
+      case 0xa0: {
+        struct __attribute__((packed)) {
+          uint16_t year; uint8_t month, day, weekday, hour, minute, second;
+        } t = {(uint16_t)(1900 + rtc.tm_year), (uint8_t)(1 + rtc.tm_mon), (uint8_t)rtc.tm_mday,
+               (uint8_t)(1 + rtc.tm_wday), (uint8_t)rtc.tm_hour, (uint8_t)rtc.tm_min, (uint8_t)rtc.tm_sec};
+        return reply(&t, sizeof(t));
+      }
+      case 0xe0:
+        // no GPS data on the uart
+        return 0;
+      default:
+        return LIBUSB_ERROR_PIPE;
+    }
+  }
+
+  switch (bRequest) {
+    case 0xdc:
+      health.safety_model = wValue;
+      health.safety_param = wIndex;
+      health.controls_allowed = 0;
+      break;
+    case 0xa1: rtc.tm_year = wValue - 1900; break;
+    case 0xa2: rtc.tm_mon = wValue - 1; break;
+    case 0xa3: rtc.tm_mday = wValue; break;
+    case 0xa5: rtc.tm_hour = wValue; break;
+    case 0xa6: rtc.tm_min = wValue; break;
+    case 0xa7: rtc.tm_sec = wValue; break;
+    case 0xb1: fan_speed = wValue; break;
+    case 0xe5: loopback = wValue; break;
+    case 0xe6: health.usb_power_mode = wValue; break;
+    case 0xe7: health.power_save_enabled = wValue; break;
+    case 0xf3: health.heartbeat_lost = 0; break;
+    // unsafe mode, IR power and the GPS uart are accepted and ignored
+    case 0xdf: case 0xb0: case 0xd9: case 0xe2: case 0xe4: break;
+    default:
+      return LIBUSB_ERROR_PIPE;
+  }
+  return 0;
+}
+
+int SimPanda::bulk_transfer(unsigned char endpoint, unsigned char *data, int length, int *transferred, unsigned int timeout) {
+  *transferred = 0;
+  if (!connected) return LIBUSB_ERROR_NO_DEVICE;
+
+  std::lock_guard lk(lock);
+  if (inject_error()) return LIBUSB_ERROR_IO;
+
+  if (endpoint == 0x81) {
+    *transferred = pop_rx((uint32_t *)data, length);
+  } else if (endpoint == 2) {
+    // GPS uart
+    *transferred = length;
+  } else if (endpoint == 3) {
+    const uint32_t *send = (const uint32_t *)data;
+    const uint32_t bus_time = (nanos_since_boot() / 1000) & 0xffff;
+    for (int i = 0; i < length / 0x10; i++) {
+      const uint32_t bus = (send[i*4+1] >> 4) & 0xff;
+      const uint32_t len = send[i*4+1] & 0xf;
+      std::array<uint32_t, 4> frame = {send[i*4] & ~1U, (bus_time << 16) | (bus << 4) | len, send[i*4+2], send[i*4+3]};
+      if (loopback) {
+        push_rx(frame);
+      }
+      frame[1] |= 0x80 << 4;
+      push_rx(frame);
+    }
+    tx_count += length / 0x10;
+    *transferred = length;
+    cv.notify_all();
+  } else {
+    return LIBUSB_ERROR_PIPE;
+  }
+  return 0;
+}
+
+bool SimPanda::start_can_rx(CanRxCallback callback) {
+  can_rx_callback = callback;
+  can_rx_running = true;
+  can_rx_thread = std::thread(&SimPanda::can_rx_loop, this);
+  return true;
+}
+
+void SimPanda::stop_can_rx() {
+  can_rx_running = false;
+  cv.notify_all();
+  if (can_rx_thread.joinable()) {
+    can_rx_thread.join();
+  }
+}
+
+void SimPanda::can_rx_loop() {
+  uint32_t buf[RECV_SIZE/4];
+
+  while (can_rx_running) {
+    int err = 0, recv = 0;
+    {
+      // an empty IN transfer completes once per 1ms USB frame
+      std::unique_lock lk(lock);
+      cv.wait_for(lk, std::chrono::milliseconds(1), [&] { return !rx_fifo.empty() || !can_rx_running || !connected; });
+      if (!connected) {
+        err = LIBUSB_ERROR_NO_DEVICE;
+      } else if (inject_error()) {
+        err = LIBUSB_ERROR_IO;
+      } else {
+        recv = pop_rx(buf, RECV_SIZE);
+      }
+    }
+
+    if (!can_rx_running) break;
+    can_rx_callback(err, (const uint8_t *)buf, recv);
+    if (err == LIBUSB_ERROR_NO_DEVICE) break;
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "selfdrive/boardd/panda.h"
+
+// size of the panda's CAN RX FIFO, in frames
+#define SIM_PANDA_RX_FIFO_SIZE 0x1000
+
+struct SimPandaConfig {
+  cereal::PandaState::PandaType hw_type = cereal::PandaState::PandaType::BLACK_PANDA;
+  std::string serial = "simpanda";
+  // background frames per second received from the car, spread over buses 0-2
+  double bus_load = 0;
+  // probability of a transfer failing with LIBUSB_ERROR_IO
+  double error_rate = 0;
+};
+
+// Software panda behind the USB endpoints, for running boardd without hardware.
+// Emulates the control requests boardd uses and CAN on the bulk endpoints:
+// sent frames are echoed back with 0x80 set in src and, with loopback enabled,
+// received again on the same bus.
+class SimPanda : public PandaTransport {
+ public:
+  SimPanda(SimPandaConfig config = {});
+  ~SimPanda();
+
+  int control_transfer(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex,
+                       unsigned char *data, uint16_t wLength, unsigned int timeout);
+  int bulk_transfer(unsigned char endpoint, unsigned char *data, int length, int *transferred, unsigned int timeout);
+  bool start_can_rx(CanRxCallback callback);
+  void stop_can_rx();
+
+  // every following transfer fails with LIBUSB_ERROR_NO_DEVICE
+  void disconnect();
+  uint64_t tx_frames() { return tx_count; }
+
+ private:
+  SimPandaConfig config;
+  std::atomic<bool> connected = true;
+  std::atomic<uint64_t> tx_count = 0;
+  uint64_t start_time;
+
+  std::mutex lock;
+  std::condition_variable cv;
+  std::mt19937 gen;
+  health_t health = {};
+  struct tm rtc = {};
+  uint16_t fan_speed = 0;
+  bool loopback = false;
+  uint64_t load_frames = 0;
+  std::deque<std::array<uint32_t, 4>> rx_fifo;
+
+  std::thread can_rx_thread;
+  std::atomic<bool> can_rx_running = false;
+  CanRxCallback can_rx_callback;
+  void can_rx_loop();
+
+  // the following need lock held
+  bool inject_error();
+  void push_rx(const std::array<uint32_t, 4> &frame);
+  void generate_bus_load();
+  int pop_rx(uint32_t *data, int length);
+};
@@ -0,0 +1,113 @@
+// compares building "can" events with CanMessageBuilder against MessageBuilder + messageToFlatArray
+// usage: ./can_benchmark [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/boardd/can_builder.h"
+#include "selfdrive/boardd/panda.h"
+#include "selfdrive/common/timing.h"
+
+// counts operator new, which covers kj arrays. MallocMessageBuilder callocs its segments directly
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  if (void *p = malloc(size)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+// the parser boardd used before, a calloc for the builder's segment and a new for the flat copy
+static kj::Array<capnp::word> reference_build(const uint32_t *data, size_t recv, bool valid) {
+  size_t num_msg = recv / 0x10;
+  MessageBuilder msg;
+  auto evt = msg.initEvent();
+  evt.setValid(valid);
+
+  auto canData = evt.initCan(num_msg);
+  for (size_t i = 0; i < num_msg; i++) {
+    if (data[i*4] & 4) {
+      canData[i].setAddress(data[i*4] >> 3);
+    } else {
+      canData[i].setAddress(data[i*4] >> 21);
+    }
+    canData[i].setBusTime(data[i*4+1] >> 16);
+    int len = data[i*4+1]&0xF;
+    canData[i].setDat(kj::arrayPtr((uint8_t*)&data[i*4+2], len));
+    canData[i].setSrc((data[i*4+1] >> 4) & 0xff);
+  }
+  return capnp::messageToFlatArray(msg);
+}
+
+static int compare(kj::ArrayPtr<const capnp::byte> a, kj::ArrayPtr<const capnp::byte> b) {
+  AlignedBuffer buf_a, buf_b;
+  capnp::FlatArrayMessageReader msg_a(buf_a.align((const char *)a.begin(), a.size()));
+  capnp::FlatArrayMessageReader msg_b(buf_b.align((const char *)b.begin(), b.size()));
+  auto can_a = msg_a.getRoot<cereal::Event>().getCan();
+  auto can_b = msg_b.getRoot<cereal::Event>().getCan();
+  if (can_a.size() != can_b.size()) return 1;
+
+  int errors = 0;
+  for (size_t i = 0; i < can_a.size(); i++) {
+    errors += can_a[i].getAddress() != can_b[i].getAddress() ||
+              can_a[i].getBusTime() != can_b[i].getBusTime() ||
+              can_a[i].getSrc() != can_b[i].getSrc() ||
+              can_a[i].getDat() != can_b[i].getDat();
+  }
+  return errors;
+}
+
+int main(int argc, char *argv[]) {
+  const int iterations = argc > 1 ? atoi(argv[1]) : 10000;
+
+  // a full USB buffer of random standard and extended frames
+  std::mt19937 gen(0);
+  std::vector<uint32_t> data(RECV_SIZE / 4);
+  for (size_t i = 0; i < data.size(); i += 4) {
+    bool extended = gen() % 2;
+    data[i] = extended ? ((gen() & 0x1fffffff) << 3) | 4 : (gen() & 0x7ff) << 21;
+    data[i+1] = (gen() & 0xffff0000) | ((gen() % 3) << 4) | (gen() % 9);
+    data[i+2] = gen();
+    data[i+3] = gen();
+  }
+
+  CanMessageBuilder builder(RECV_SIZE);
+
+  // correctness
+  auto ref = reference_build(data.data(), RECV_SIZE, true);
+  int errors = compare(ref.asBytes(), builder.build(data.data(), RECV_SIZE, true));
+  errors += compare(reference_build(data.data(), 0x100, true).asBytes(), builder.build(data.data(), 0x100, true));
+  errors += compare(ref.asBytes(), builder.build(data.data(), RECV_SIZE, true));
+  printf("compared %d messages, %d mismatches\n", RECV_SIZE / 0x10, errors);
+
+  // timing, parse and build only, no send
+  size_t allocs_start = allocations;
+  uint64_t t1 = nanos_since_boot();
+  for (int i = 0; i < iterations; i++) {
+    reference_build(data.data(), RECV_SIZE, true);
+  }
+  uint64_t t2 = nanos_since_boot();
+  size_t allocs_ref = allocations - allocs_start;
+  allocs_start = allocations;
+  for (int i = 0; i < iterations; i++) {
+    builder.build(data.data(), RECV_SIZE, true);
+  }
+  uint64_t t3 = nanos_since_boot();
+  size_t allocs_new = allocations - allocs_start;
+
+  printf("MessageBuilder + messageToFlatArray: %.2f us/iter, %.2f news/iter\n",
+         (t2 - t1) / 1e3 / iterations, (double)allocs_ref / iterations);
+  printf("CanMessageBuilder:                   %.2f us/iter, %.2f news/iter\n",
+         (t3 - t2) / 1e3 / iterations, (double)allocs_new / iterations);
+
+  return errors == 0 && allocs_new == 0 ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+// end-to-end CAN latency and throughput through Panda with a simulated panda in loopback
+// usage: ./sim_panda_benchmark [seconds] [bus load, frames/s] [usb error rate]
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/boardd/panda.h"
+#include "selfdrive/boardd/sim_panda.h"
+#include "selfdrive/common/timing.h"
+
+// frames sent per can_send call, one full 0x400 byte USB packet
+const int BATCH_SIZE = 64;
+const uint32_t TEST_ADDR = 0x7e0;
+
+int main(int argc, char *argv[]) {
+  const double seconds = argc > 1 ? atof(argv[1]) : 5.0;
+  SimPandaConfig config;
+  config.bus_load = argc > 2 ? atof(argv[2]) : 0;
+  config.error_rate = argc > 3 ? atof(argv[3]) : 0;
+
+  Panda panda(std::make_unique<SimPanda>(config));
+  panda.set_loopback(true);
+
+  // saturate the send path, each frame carries its send time
+  std::atomic<bool> running = true;
+  std::atomic<uint64_t> sent = 0;
+  std::thread sender([&]() {
+    while (running) {
+      MessageBuilder msg;
+      auto can = msg.initEvent().initSendcan(BATCH_SIZE);
+      uint64_t t = nanos_since_boot();
+      for (int i = 0; i < BATCH_SIZE; i++) {
+        can[i].setAddress(TEST_ADDR);
+        can[i].setSrc(i % 3);
+        can[i].setDat(kj::arrayPtr((uint8_t *)&t, sizeof(t)));
+      }
+      panda.can_send(can.asReader());
+      sent += BATCH_SIZE;
+    }
+  });
+
+  std::vector<uint64_t> latencies;
+  latencies.reserve(1 << 22);
+  uint64_t received = 0, echoes = 0, load = 0, publishes = 0;
+
+  AlignedBuffer aligned_buf;
+  const uint64_t start = nanos_since_boot();
+  const uint64_t end = start + seconds * 1e9;
+  while (nanos_since_boot() < end && panda.connected) {
+    auto bytes = panda.can_receive();
+    capnp::FlatArrayMessageReader cmsg(aligned_buf.align((const char *)bytes.begin(), bytes.size()));
+    const uint64_t now = nanos_since_boot();
+    publishes++;
+
+    for (auto c : cmsg.getRoot<cereal::Event>().getCan()) {
+      if (c.getAddress() != TEST_ADDR) {
+        load++;
+      } else if (c.getSrc() & 0x80) {
+        echoes++;
+      } else if (c.getDat().size() == sizeof(uint64_t)) {
+        uint64_t t;
+        memcpy(&t, c.getDat().begin(), sizeof(t));
+        latencies.push_back(now - t);
+        received++;
+      }
+    }
+  }
+  const double elapsed = (nanos_since_boot() - start) / 1e9;
+  running = false;
+  sender.join();
+
+  health_t health = panda.get_state();
+  printf("sent %.0f frames/s, received %.0f loopback frames/s, %.0f echoes/s, %.0f bus load frames/s\n",
+         sent / elapsed, received / elapsed, echoes / elapsed, load / elapsed);
+  printf("%.0f publishes/s, %u frames dropped by the panda FIFO\n", publishes / elapsed, health.can_rx_errs);
+
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&](double p) { return latencies[std::min(latencies.size() - 1, (size_t)(p * latencies.size()))] / 1e3; };
+    printf("latency: p50 %.1f us, p90 %.1f us, p99 %.1f us, max %.1f us\n", pct(0.5), pct(0.9), pct(0.99), latencies.back() / 1e3);
+  }
+  return received > 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/boardd/can_send_scheduler.h"
+
+struct TestFrame {
+  uint32_t addr;
+  uint8_t bus;
+  uint8_t dat;
+};
+
+static void enqueue(CanSendScheduler &scheduler, const std::vector<TestFrame> &frames, uint64_t log_mono_time) {
+  MessageBuilder msg;
+  auto can = msg.initEvent().initSendcan(frames.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    can[i].setAddress(frames[i].addr);
+    can[i].setSrc(frames[i].bus);
+    can[i].setDat(kj::arrayPtr(&frames[i].dat, 1));
+  }
+  scheduler.enqueue(can.asReader(), log_mono_time);
+}
+
+static std::vector<TestFrame> unpack(const uint32_t *buf, int count) {
+  std::vector<TestFrame> frames;
+  for (int i = 0; i < count; i++) {
+    uint32_t addr = (buf[i*4] & 4) ? buf[i*4] >> 3 : buf[i*4] >> 21;
+    frames.push_back({addr, (uint8_t)((buf[i*4+1] >> 4) & 0xff), (uint8_t)(buf[i*4+2] & 0xff)});
+  }
+  return frames;
+}
+
+TEST_CASE("CanSendScheduler") {
+  CanSendScheduler scheduler;
+  uint32_t buf[CAN_SEND_MAX_FRAMES * 4];
+
+  SECTION("coalesces batches in order") {
+    enqueue(scheduler, {{0x100, 0, 1}, {0x18ff1234, 0, 2}}, 0);
+    enqueue(scheduler, {{0x101, 0, 3}}, 0);
+    auto frames = unpack(buf, scheduler.pack(buf, CAN_SEND_MAX_FRAMES, 0));
+    REQUIRE(frames.size() == 3);
+    REQUIRE(frames[0].addr == 0x100);
+    REQUIRE(frames[1].addr == 0x18ff1234);
+    REQUIRE(frames[2].addr == 0x101);
+    REQUIRE(scheduler.empty());
+  }
+
+  SECTION("every frame is sent in order by default") {
+    enqueue(scheduler, {{0x100, 0, 1}, {0x100, 0, 2}, {0x101, 0, 3}}, 0);
+    enqueue(scheduler, {{0x100, 0, 4}}, 0);
+    auto frames = unpack(buf, scheduler.pack(buf, CAN_SEND_MAX_FRAMES, 0));
+    REQUIRE(frames.size() == 4);
+    for (int i = 0; i < 4; i++) {
+      REQUIRE(frames[i].dat == i + 1);
+    }
+    REQUIRE(scheduler.superseded == 0);
+  }
+
+  SECTION("newer frame replaces a pending one in place for allowed addresses") {
+    CanSendConfig config;
+    config.replaceable_addrs = {0x100, 0x7e0};
+    CanSendScheduler replacing(config);
+    enqueue(replacing, {{0x100, 0, 1}, {0x101, 0, 2}, {0x101, 0, 3}}, 0);
+    enqueue(replacing, {{0x100, 0, 4}, {0x100, 1, 5}}, 0);
+    auto frames = unpack(buf, replacing.pack(buf, CAN_SEND_MAX_FRAMES, 0));
+    REQUIRE(frames.size() == 4);
+    REQUIRE((frames[0].addr == 0x100 && frames[0].dat == 4));
+    REQUIRE((frames[1].dat == 2 && frames[2].dat == 3));
+    REQUIRE((frames[3].addr == 0x100 && frames[3].bus == 1));
+    REQUIRE(replacing.superseded == 1);
+
+    // diagnostics are never replaced, even when listed
+    enqueue(replacing, {{0x7e0, 0, 1}, {0x7e0, 0, 2}, {0x200, 0, 3}}, 0);
+    frames = unpack(buf, replacing.pack(buf, CAN_SEND_MAX_FRAMES, 0));
+    REQUIRE(frames.size() == 3);
+    REQUIRE((frames[0].dat == 1 && frames[1].dat == 2 && frames[2].dat == 3));
+  }
+
+  SECTION("bus priority") {
+    enqueue(scheduler, {{0x300, 2, 1}, {0x301, 1, 2}, {0x302, 0, 3}}, 0);
+    auto frames = unpack(buf, scheduler.pack(buf, CAN_SEND_MAX_FRAMES, 0));
+    REQUIRE(frames.size() == 3);
+    REQUIRE(frames[0].bus == 0);
+    REQUIRE(frames[1].bus == 2);
+    REQUIRE(frames[2].bus == 1);
+  }
+
+  SECTION("frames past their deadline are dropped") {
+    CanSendConfig config;
+    config.max_age_by_addr[0x101] = 10000000ULL;
+    CanSendScheduler deadlines(config);
+    enqueue(deadlines, {{0x100, 0, 1}, {0x101, 0, 2}}, 1000);
+    auto frames = unpack(buf, deadlines.pack(buf, CAN_SEND_MAX_FRAMES, 1000 + 20000000ULL));
+    REQUIRE(frames.size() == 1);
+    REQUIRE(frames[0].addr == 0x100);
+    REQUIRE(deadlines.expired == 1);
+    REQUIRE(deadlines.pack(buf, CAN_SEND_MAX_FRAMES, 1000 + 2000000000ULL) == 0);
+  }
+
+  SECTION("reports the logMonoTime of each packed frame") {
+    enqueue(scheduler, {{0x100, 0, 1}}, 1000);
+    enqueue(scheduler, {{0x101, 0, 2}, {0x102, 0, 3}}, 2000);
+    uint64_t log_mono_times[CAN_SEND_MAX_FRAMES];
+    REQUIRE(scheduler.pack(buf, CAN_SEND_MAX_FRAMES, 0, log_mono_times) == 3);
+    REQUIRE(log_mono_times[0] == 1000);
+    REQUIRE(log_mono_times[1] == 2000);
+    REQUIRE(log_mono_times[2] == 2000);
+  }
+
+  SECTION("splits into packets of max_frames") {
+    std::vector<TestFrame> many;
+    for (int i = 0; i < CAN_SEND_MAX_FRAMES + 10; i++) many.push_back({(uint32_t)i, 0, 0});
+    enqueue(scheduler, many, 0);
+    REQUIRE(scheduler.pack(buf, CAN_SEND_MAX_FRAMES, 0) == CAN_SEND_MAX_FRAMES);
+    REQUIRE(scheduler.pack(buf, CAN_SEND_MAX_FRAMES, 0) == 10);
+    REQUIRE(scheduler.pack(buf, CAN_SEND_MAX_FRAMES, 0) == 0);
+  }
+}
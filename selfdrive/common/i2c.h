@@ -8,10 +8,16 @@ class I2CBus {
   private:
     int i2c_fd;
 
+  protected:
+    // for buses that don't talk to /dev/i2c-*
+    I2CBus() : i2c_fd(-1) {}
+
   public:
     I2CBus(uint8_t bus_id);
-    ~I2CBus();
+    virtual ~I2CBus();
 
-    int read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len);
-    int set_register(uint8_t device_address, uint register_address, uint8_t data);
+    virtual int read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len);
+    virtual int set_register(uint8_t device_address, uint register_address, uint8_t data);
+    // register read as a single combined transaction, not limited to the 32 byte SMBus block size
+    virtual int read_burst(uint8_t device_address, uint register_address, uint8_t *buffer, uint16_t len);
 };
@@ -1,6 +1,7 @@
 #include "selfdrive/common/visionimg.h"
 
 #include <cassert>
+#include <cstring>
 
 #ifdef QCOM
 #include <gralloc_priv.h>
@@ -61,3 +62,86 @@ EGLImageTexture::~EGLImageTexture() {
   glDeleteTextures(1, &frame_tex);
 }
 #endif // ifdef QCOM
+
+FrameUploader::FrameUploader() {
+  glGenBuffers(2, pbo);
+}
+
+FrameUploader::~FrameUploader() {
+  glDeleteBuffers(2, pbo);
+}
+
+bool FrameUploader::isUploaded(const VisionBuf *buf, uint32_t frame_id) {
+  // paints without a new frame, e.g. on resize, reuse the texture
+  if (buf == uploaded_buf && frame_id == uploaded_frame_id) {
+    return true;
+  }
+  uploaded_buf = buf;
+  uploaded_frame_id = frame_id;
+  return false;
+}
+
+void FrameUploader::uploadRGB(GLuint tex, const VisionBuf *buf, uint32_t frame_id) {
+  if (isUploaded(buf, frame_id)) return;
+
+  const Plane plane = {tex, GL_RGB, (int)buf->width, (int)buf->height, (int)buf->stride, 3, (const uint8_t *)buf->addr};
+  upload(&plane, 1);
+}
+
+void FrameUploader::uploadYUV(const GLuint tex[3], const VisionBuf *buf, uint32_t frame_id) {
+  if (isUploaded(buf, frame_id)) return;
+
+  const int w = buf->width, h = buf->height;
+  const Plane planes[] = {
+    {tex[0], GL_RED, w, h, w, 1, buf->y},
+    {tex[1], GL_RED, w / 2, h / 2, w / 2, 1, buf->u},
+    {tex[2], GL_RED, w / 2, h / 2, w / 2, 1, buf->v},
+  };
+  upload(planes, 3);
+}
+
+void FrameUploader::upload(const Plane *planes, int cnt) {
+  size_t size = 0;
+  for (int i = 0; i < cnt; i++) {
+    size += (size_t)planes[i].stride * planes[i].height;
+  }
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo[cur]);
+  if (pbo_size[cur] != size) {
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    pbo_size[cur] = size;
+  }
+  // invalidating lets the driver hand out fresh memory if the buffer is still being read
+  uint8_t *dst = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if (dst != nullptr) {
+    for (int i = 0; i < cnt; i++) {
+      const size_t len = (size_t)planes[i].stride * planes[i].height;
+      memcpy(dst, planes[i].data, len);
+      dst += len;
+    }
+    if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+      dst = nullptr;
+    }
+  }
+  if (dst == nullptr) {
+    // upload from client memory
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  size_t offset = 0;
+  for (int i = 0; i < cnt; i++) {
+    const Plane &p = planes[i];
+    // with a pixel unpack buffer bound, pixels is an offset into it
+    const void *pixels = dst != nullptr ? (const void *)(uintptr_t)offset : p.data;
+    glBindTexture(GL_TEXTURE_2D, p.tex);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, p.stride / p.bpp);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, p.width, p.height, p.format, GL_UNSIGNED_BYTE, pixels);
+    offset += (size_t)p.stride * p.height;
+  }
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  cur = (cur + 1) % 2;
+}
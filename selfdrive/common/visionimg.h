@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 #include "cereal/visionipc/visionbuf.h"
 
 #ifdef __APPLE__
@@ -25,3 +28,33 @@ class EGLImageTexture {
   EGLImageKHR img_khr = 0;
 #endif
 };
+
+// Copies camera frames into textures where they can't be imported as EGLImages.
+// Texture storage is allocated once and updated with glTexSubImage2D from one of two
+// pixel buffer objects in turn, so writing a frame doesn't wait for the transfer of
+// the previous one and the texture isn't re-specified on every frame.
+class FrameUploader {
+ public:
+  FrameUploader();
+  ~FrameUploader();
+  // tex is an RGB texture of the buffer's size
+  void uploadRGB(GLuint tex, const VisionBuf *buf, uint32_t frame_id);
+  // tex are single channel textures for the Y, U and V planes of a YUV buffer
+  void uploadYUV(const GLuint tex[3], const VisionBuf *buf, uint32_t frame_id);
+
+ private:
+  struct Plane {
+    GLuint tex;
+    GLenum format;
+    int width, height, stride, bpp;
+    const uint8_t *data;
+  };
+  bool isUploaded(const VisionBuf *buf, uint32_t frame_id);
+  void upload(const Plane *planes, int cnt);
+
+  GLuint pbo[2] = {};
+  size_t pbo_size[2] = {};
+  int cur = 0;
+  const VisionBuf *uploaded_buf = nullptr;
+  uint32_t uploaded_frame_id = 0;
+};
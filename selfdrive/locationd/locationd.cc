@@ -1,6 +1,7 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 
+#include <algorithm>
 #include <cmath>
 
 #include "locationd.h"
@@ -19,9 +20,9 @@ const double VALID_TIME_SINCE_RESET = 1.0; // s
 const double VALID_POS_STD = 50.0; // m
 const double MAX_RESET_TRACKER = 5.0;
 
-static VectorXd floatlist2vector(const capnp::List<float, capnp::Kind::PRIMITIVE>::Reader& floatlist) {
-  VectorXd res(floatlist.size());
-  for (int i = 0; i < floatlist.size(); i++) {
+static Vector3d floatlist2vector(const capnp::List<float, capnp::Kind::PRIMITIVE>::Reader& floatlist) {
+  Vector3d res = Vector3d::Constant(NAN);
+  for (int i = 0; i < std::min<int>(floatlist.size(), 3); i++) {
     res[i] = floatlist[i];
   }
   return res;
@@ -31,23 +32,24 @@ static Vector4d quat2vector(const Quaterniond& quat) {
   return Vector4d(quat.w(), quat.x(), quat.y(), quat.z());
 }
 
-static Quaterniond vector2quat(const VectorXd& vec) {
+template <typename Derived>
+static Quaterniond vector2quat(const MatrixBase<Derived>& vec) {
   return Quaterniond(vec(0), vec(1), vec(2), vec(3));
 }
 
-static void init_measurement(cereal::LiveLocationKalman::Measurement::Builder meas, const VectorXd& val, const VectorXd& std, bool valid) {
+static void init_measurement(cereal::LiveLocationKalman::Measurement::Builder meas, const Vector3d& val, const Vector3d& std, bool valid) {
   meas.setValue(kj::arrayPtr(val.data(), val.size()));
   meas.setStd(kj::arrayPtr(std.data(), std.size()));
   meas.setValid(valid);
 }
 
 
-static MatrixXdr rotate_cov(const MatrixXdr& rot_matrix, const MatrixXdr& cov_in) {
+static Matrix3d rotate_cov(const Matrix3d& rot_matrix, const Matrix3d& cov_in) {
   // To rotate a covariance matrix, the cov matrix needs to multiplied left and right by the transform matrix
   return ((rot_matrix *  cov_in) * rot_matrix.transpose());
 }
 
-static VectorXd rotate_std(const MatrixXdr& rot_matrix, const VectorXd& std_in) {
+static Vector3d rotate_std(const Matrix3d& rot_matrix, const Vector3d& std_in) {
   // Stds cannot be rotated like values, only covariances can be rotated
   return rotate_cov(rot_matrix, std_in.array().square().matrix().asDiagonal()).diagonal().array().sqrt();
 }
@@ -57,45 +59,45 @@ Localizer::Localizer() {
   this->reset_kalman();
 
   this->calib = Vector3d(0.0, 0.0, 0.0);
-  this->device_from_calib = MatrixXdr::Identity(3, 3);
-  this->calib_from_device = MatrixXdr::Identity(3, 3);
+  this->device_from_calib = Matrix3d::Identity();
+  this->calib_from_device = Matrix3d::Identity();
 
   for (int i = 0; i < POSENET_STD_HIST_HALF * 2; i++) {
-    this->posenet_stds.push_back(10.0);
+    this->posenet_stds[i] = 10.0;
   }
 
-  VectorXd ecef_pos = this->kf->get_x().segment<STATE_ECEF_POS_LEN>(STATE_ECEF_POS_START);
+  Vector3d ecef_pos = this->kf->get_x().segment<STATE_ECEF_POS_LEN>(STATE_ECEF_POS_START);
   this->converter = std::make_unique<LocalCoord>((ECEF) { .x = ecef_pos[0], .y = ecef_pos[1], .z = ecef_pos[2] });
 }
 
 void Localizer::build_live_location(cereal::LiveLocationKalman::Builder& fix) {
-  VectorXd predicted_state = this->kf->get_x();
-  MatrixXdr predicted_cov = this->kf->get_P();
-  VectorXd predicted_std = predicted_cov.diagonal().array().sqrt();
+  const LiveStateVector& predicted_state = this->kf->get_x();
+  const LiveCovMatrix& predicted_cov = this->kf->get_P();
+  LiveStateErrVector predicted_std = predicted_cov.diagonal().array().sqrt();
 
-  VectorXd fix_ecef = predicted_state.segment<STATE_ECEF_POS_LEN>(STATE_ECEF_POS_START);
+  Vector3d fix_ecef = predicted_state.segment<STATE_ECEF_POS_LEN>(STATE_ECEF_POS_START);
   ECEF fix_ecef_ecef = { .x = fix_ecef(0), .y = fix_ecef(1), .z = fix_ecef(2) };
-  VectorXd fix_ecef_std = predicted_std.segment<STATE_ECEF_POS_ERR_LEN>(STATE_ECEF_POS_ERR_START);
-  VectorXd vel_ecef = predicted_state.segment<STATE_ECEF_VELOCITY_LEN>(STATE_ECEF_VELOCITY_START);
-  VectorXd vel_ecef_std = predicted_std.segment<STATE_ECEF_VELOCITY_ERR_LEN>(STATE_ECEF_VELOCITY_ERR_START);
-  VectorXd fix_pos_geo_vec = this->get_position_geodetic();
-  VectorXd orientation_ecef = quat2euler(vector2quat(predicted_state.segment<STATE_ECEF_ORIENTATION_LEN>(STATE_ECEF_ORIENTATION_START)));
-  VectorXd orientation_ecef_std = predicted_std.segment<STATE_ECEF_ORIENTATION_ERR_LEN>(STATE_ECEF_ORIENTATION_ERR_START);
-  MatrixXdr orientation_ecef_cov = predicted_cov.block<STATE_ECEF_ORIENTATION_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN>(STATE_ECEF_ORIENTATION_ERR_START, STATE_ECEF_ORIENTATION_ERR_START);
-  MatrixXdr device_from_ecef = euler2rot(orientation_ecef).transpose();
-  VectorXd calibrated_orientation_ecef = rot2euler((this->calib_from_device * device_from_ecef).transpose());
-
-  VectorXd acc_calib = this->calib_from_device * predicted_state.segment<STATE_ACCELERATION_LEN>(STATE_ACCELERATION_START);
-  MatrixXdr acc_calib_cov = predicted_cov.block<STATE_ACCELERATION_ERR_LEN, STATE_ACCELERATION_ERR_LEN>(STATE_ACCELERATION_ERR_START, STATE_ACCELERATION_ERR_START);
-  VectorXd acc_calib_std = rotate_cov(this->calib_from_device, acc_calib_cov).diagonal().array().sqrt();
-  VectorXd ang_vel_calib = this->calib_from_device * predicted_state.segment<STATE_ANGULAR_VELOCITY_LEN>(STATE_ANGULAR_VELOCITY_START);
-
-  MatrixXdr vel_angular_cov = predicted_cov.block<STATE_ANGULAR_VELOCITY_ERR_LEN, STATE_ANGULAR_VELOCITY_ERR_LEN>(STATE_ANGULAR_VELOCITY_ERR_START, STATE_ANGULAR_VELOCITY_ERR_START);
-  VectorXd ang_vel_calib_std = rotate_cov(this->calib_from_device, vel_angular_cov).diagonal().array().sqrt();
-
-  VectorXd vel_device = device_from_ecef * vel_ecef;
-  VectorXd device_from_ecef_eul = quat2euler(vector2quat(predicted_state.segment<STATE_ECEF_ORIENTATION_LEN>(STATE_ECEF_ORIENTATION_START))).transpose();
-  MatrixXdr condensed_cov(STATE_ECEF_ORIENTATION_ERR_LEN + STATE_ECEF_VELOCITY_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN + STATE_ECEF_VELOCITY_ERR_LEN);
+  Vector3d fix_ecef_std = predicted_std.segment<STATE_ECEF_POS_ERR_LEN>(STATE_ECEF_POS_ERR_START);
+  Vector3d vel_ecef = predicted_state.segment<STATE_ECEF_VELOCITY_LEN>(STATE_ECEF_VELOCITY_START);
+  Vector3d vel_ecef_std = predicted_std.segment<STATE_ECEF_VELOCITY_ERR_LEN>(STATE_ECEF_VELOCITY_ERR_START);
+  Vector3d fix_pos_geo_vec = this->get_position_geodetic();
+  Vector3d orientation_ecef = quat2euler(vector2quat(predicted_state.segment<STATE_ECEF_ORIENTATION_LEN>(STATE_ECEF_ORIENTATION_START)));
+  Vector3d orientation_ecef_std = predicted_std.segment<STATE_ECEF_ORIENTATION_ERR_LEN>(STATE_ECEF_ORIENTATION_ERR_START);
+  Matrix3d orientation_ecef_cov = predicted_cov.block<STATE_ECEF_ORIENTATION_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN>(STATE_ECEF_ORIENTATION_ERR_START, STATE_ECEF_ORIENTATION_ERR_START);
+  Matrix3d device_from_ecef = euler2rot(orientation_ecef).transpose();
+  Vector3d calibrated_orientation_ecef = rot2euler((this->calib_from_device * device_from_ecef).transpose());
+
+  Vector3d acc_calib = this->calib_from_device * predicted_state.segment<STATE_ACCELERATION_LEN>(STATE_ACCELERATION_START);
+  Matrix3d acc_calib_cov = predicted_cov.block<STATE_ACCELERATION_ERR_LEN, STATE_ACCELERATION_ERR_LEN>(STATE_ACCELERATION_ERR_START, STATE_ACCELERATION_ERR_START);
+  Vector3d acc_calib_std = rotate_cov(this->calib_from_device, acc_calib_cov).diagonal().array().sqrt();
+  Vector3d ang_vel_calib = this->calib_from_device * predicted_state.segment<STATE_ANGULAR_VELOCITY_LEN>(STATE_ANGULAR_VELOCITY_START);
+
+  Matrix3d vel_angular_cov = predicted_cov.block<STATE_ANGULAR_VELOCITY_ERR_LEN, STATE_ANGULAR_VELOCITY_ERR_LEN>(STATE_ANGULAR_VELOCITY_ERR_START, STATE_ANGULAR_VELOCITY_ERR_START);
+  Vector3d ang_vel_calib_std = rotate_cov(this->calib_from_device, vel_angular_cov).diagonal().array().sqrt();
+
+  Vector3d vel_device = device_from_ecef * vel_ecef;
+  Vector3d device_from_ecef_eul = quat2euler(vector2quat(predicted_state.segment<STATE_ECEF_ORIENTATION_LEN>(STATE_ECEF_ORIENTATION_START)));
+  Matrix<double, 6, 6, RowMajor> condensed_cov;
   condensed_cov.topLeftCorner<STATE_ECEF_ORIENTATION_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN>() =
     predicted_cov.block<STATE_ECEF_ORIENTATION_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN>(STATE_ECEF_ORIENTATION_ERR_START, STATE_ECEF_ORIENTATION_ERR_START);
   condensed_cov.topRightCorner<STATE_ECEF_ORIENTATION_ERR_LEN, STATE_ECEF_VELOCITY_ERR_LEN>() =
@@ -104,26 +106,26 @@ void Localizer::build_live_location(cereal::LiveLocationKalman::Builder& fix) {
     predicted_cov.block<STATE_ECEF_VELOCITY_ERR_LEN, STATE_ECEF_VELOCITY_ERR_LEN>(STATE_ECEF_VELOCITY_ERR_START, STATE_ECEF_VELOCITY_ERR_START);
   condensed_cov.bottomLeftCorner<STATE_ECEF_VELOCITY_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN>() =
     predicted_cov.block<STATE_ECEF_VELOCITY_ERR_LEN, STATE_ECEF_ORIENTATION_ERR_LEN>(STATE_ECEF_VELOCITY_ERR_START, STATE_ECEF_ORIENTATION_ERR_START);
-  VectorXd H_input(device_from_ecef_eul.size() + vel_ecef.size());
+  Matrix<double, 6, 1> H_input;
   H_input << device_from_ecef_eul, vel_ecef;
-  MatrixXdr HH = this->kf->H(H_input);
-  MatrixXdr vel_device_cov = (HH * condensed_cov) * HH.transpose();
-  VectorXd vel_device_std = vel_device_cov.diagonal().array().sqrt();
+  Matrix<double, 3, 6, RowMajor> HH = this->kf->H(H_input);
+  Matrix3d vel_device_cov = (HH * condensed_cov) * HH.transpose();
+  Vector3d vel_device_std = vel_device_cov.diagonal().array().sqrt();
 
-  VectorXd vel_calib = this->calib_from_device * vel_device;
-  VectorXd vel_calib_std = rotate_cov(this->calib_from_device, vel_device_cov).diagonal().array().sqrt();
+  Vector3d vel_calib = this->calib_from_device * vel_device;
+  Vector3d vel_calib_std = rotate_cov(this->calib_from_device, vel_device_cov).diagonal().array().sqrt();
 
-  VectorXd orientation_ned = ned_euler_from_ecef(fix_ecef_ecef, orientation_ecef);
-  VectorXd orientation_ned_std = rotate_cov(this->converter->ecef2ned_matrix, orientation_ecef_cov).diagonal().array().sqrt();
-  VectorXd calibrated_orientation_ned = ned_euler_from_ecef(fix_ecef_ecef, calibrated_orientation_ecef);
-  VectorXd nextfix_ecef = fix_ecef + vel_ecef;
-  VectorXd ned_vel = this->converter->ecef2ned((ECEF) { .x = nextfix_ecef(0), .y = nextfix_ecef(1), .z = nextfix_ecef(2) }).to_vector() - converter->ecef2ned(fix_ecef_ecef).to_vector();
+  Vector3d orientation_ned = ned_euler_from_ecef(fix_ecef_ecef, orientation_ecef);
+  Vector3d orientation_ned_std = rotate_cov(this->converter->ecef2ned_matrix, orientation_ecef_cov).diagonal().array().sqrt();
+  Vector3d calibrated_orientation_ned = ned_euler_from_ecef(fix_ecef_ecef, calibrated_orientation_ecef);
+  Vector3d nextfix_ecef = fix_ecef + vel_ecef;
+  Vector3d ned_vel = this->converter->ecef2ned((ECEF) { .x = nextfix_ecef(0), .y = nextfix_ecef(1), .z = nextfix_ecef(2) }).to_vector() - converter->ecef2ned(fix_ecef_ecef).to_vector();
 
-  VectorXd accDevice = predicted_state.segment<STATE_ACCELERATION_LEN>(STATE_ACCELERATION_START);
-  VectorXd accDeviceErr = predicted_std.segment<STATE_ACCELERATION_ERR_LEN>(STATE_ACCELERATION_ERR_START);
+  Vector3d accDevice = predicted_state.segment<STATE_ACCELERATION_LEN>(STATE_ACCELERATION_START);
+  Vector3d accDeviceErr = predicted_std.segment<STATE_ACCELERATION_ERR_LEN>(STATE_ACCELERATION_ERR_START);
 
-  VectorXd angVelocityDevice = predicted_state.segment<STATE_ANGULAR_VELOCITY_LEN>(STATE_ANGULAR_VELOCITY_START);
-  VectorXd angVelocityDeviceErr = predicted_std.segment<STATE_ANGULAR_VELOCITY_ERR_LEN>(STATE_ANGULAR_VELOCITY_ERR_START);
+  Vector3d angVelocityDevice = predicted_state.segment<STATE_ANGULAR_VELOCITY_LEN>(STATE_ANGULAR_VELOCITY_START);
+  Vector3d angVelocityDeviceErr = predicted_std.segment<STATE_ANGULAR_VELOCITY_ERR_LEN>(STATE_ANGULAR_VELOCITY_ERR_START);
 
   Vector3d nans = Vector3d(NAN, NAN, NAN);
 
@@ -145,14 +147,13 @@ void Localizer::build_live_location(cereal::LiveLocationKalman::Builder& fix) {
   init_measurement(fix.initAccelerationCalibrated(), acc_calib, acc_calib_std, this->calibrated);
 
   double old_mean = 0.0, new_mean = 0.0;
-  int i = 0;
-  for (double x : this->posenet_stds) {
+  for (int i = 0; i < POSENET_STD_HIST_HALF * 2; i++) {
+    double x = this->posenet_stds[(this->posenet_stds_pos + i) % (POSENET_STD_HIST_HALF * 2)];
     if (i < POSENET_STD_HIST_HALF) {
       old_mean += x;
     } else {
       new_mean += x;
     }
-    i++;
   }
   old_mean /= POSENET_STD_HIST_HALF;
   new_mean /= POSENET_STD_HIST_HALF;
@@ -179,8 +180,8 @@ void Localizer::build_live_location(cereal::LiveLocationKalman::Builder& fix) {
   }
 }
 
-VectorXd Localizer::get_position_geodetic() {
-  VectorXd fix_ecef = this->kf->get_x().segment<STATE_ECEF_POS_LEN>(STATE_ECEF_POS_START);
+Vector3d Localizer::get_position_geodetic() {
+  Vector3d fix_ecef = this->kf->get_x().segment<STATE_ECEF_POS_LEN>(STATE_ECEF_POS_START);
   ECEF fix_ecef_ecef = { .x = fix_ecef(0), .y = fix_ecef(1), .z = fix_ecef(2) };
   Geodetic fix_pos_geo = ecef2geodetic(fix_ecef_ecef);
   return Vector3d(fix_pos_geo.lat, fix_pos_geo.lon, fix_pos_geo.alt);
@@ -256,20 +257,20 @@ void Localizer::handle_gps(double current_time, const cereal::GpsLocationData::R
   // Process message
   this->last_gps_fix = current_time;
   Geodetic geodetic = { log.getLatitude(), log.getLongitude(), log.getAltitude() };
-  this->converter = std::make_unique<LocalCoord>(geodetic);
+  *this->converter = LocalCoord(geodetic);
 
-  VectorXd ecef_pos = this->converter->ned2ecef({ 0.0, 0.0, 0.0 }).to_vector();
-  VectorXd ecef_vel = this->converter->ned2ecef({ log.getVNED()[0], log.getVNED()[1], log.getVNED()[2] }).to_vector() - ecef_pos;
-  MatrixXdr ecef_pos_R = Vector3d::Constant(std::pow(3.0 * log.getVerticalAccuracy(), 2)).asDiagonal();
-  MatrixXdr ecef_vel_R = Vector3d::Constant(std::pow(log.getSpeedAccuracy(), 2)).asDiagonal();
+  Vector3d ecef_pos = this->converter->ned2ecef({ 0.0, 0.0, 0.0 }).to_vector();
+  Vector3d ecef_vel = this->converter->ned2ecef({ log.getVNED()[0], log.getVNED()[1], log.getVNED()[2] }).to_vector() - ecef_pos;
+  Matrix3d ecef_pos_R = Vector3d::Constant(std::pow(3.0 * log.getVerticalAccuracy(), 2)).asDiagonal();
+  Matrix3d ecef_vel_R = Vector3d::Constant(std::pow(log.getSpeedAccuracy(), 2)).asDiagonal();
 
   this->unix_timestamp_millis = log.getTimestamp();
-  double gps_est_error = (this->kf->get_x().head(3) - ecef_pos).norm();
+  double gps_est_error = (this->kf->get_x().head<3>() - ecef_pos).norm();
 
-  VectorXd orientation_ecef = quat2euler(vector2quat(this->kf->get_x().segment<STATE_ECEF_ORIENTATION_LEN>(STATE_ECEF_ORIENTATION_START)));
-  VectorXd orientation_ned = ned_euler_from_ecef({ ecef_pos(0), ecef_pos(1), ecef_pos(2) }, orientation_ecef);
-  VectorXd orientation_ned_gps = Vector3d(0.0, 0.0, DEG2RAD(log.getBearingDeg()));
-  VectorXd orientation_error = (orientation_ned - orientation_ned_gps).array() - M_PI;
+  Vector3d orientation_ecef = quat2euler(vector2quat(this->kf->get_x().segment<STATE_ECEF_ORIENTATION_LEN>(STATE_ECEF_ORIENTATION_START)));
+  Vector3d orientation_ned = ned_euler_from_ecef({ ecef_pos(0), ecef_pos(1), ecef_pos(2) }, orientation_ecef);
+  Vector3d orientation_ned_gps = Vector3d(0.0, 0.0, DEG2RAD(log.getBearingDeg()));
+  Vector3d orientation_error = (orientation_ned - orientation_ned_gps).array() - M_PI;
   for (int i = 0; i < orientation_error.size(); i++) {
     orientation_error(i) = std::fmod(orientation_error(i), 2.0 * M_PI);
     if (orientation_error(i) < 0.0) {
@@ -277,7 +278,7 @@ void Localizer::handle_gps(double current_time, const cereal::GpsLocationData::R
     }
     orientation_error(i) -= M_PI;
   }
-  VectorXd initial_pose_ecef_quat = quat2vector(euler2quat(ecef_euler_from_ned({ ecef_pos(0), ecef_pos(1), ecef_pos(2) }, orientation_ned_gps)));
+  Vector4d initial_pose_ecef_quat = quat2vector(euler2quat(ecef_euler_from_ned({ ecef_pos(0), ecef_pos(1), ecef_pos(2) }, orientation_ned_gps)));
 
   if (ecef_vel.norm() > 5.0 && orientation_error.norm() > 1.0) {
     LOGE("Locationd vs ubloxLocation orientation difference too large, kalman reset");
@@ -301,15 +302,15 @@ void Localizer::handle_car_state(double current_time, const cereal::CarState::Re
 }
 
 void Localizer::handle_cam_odo(double current_time, const cereal::CameraOdometry::Reader& log) {
-  VectorXd rot_device = this->device_from_calib * floatlist2vector(log.getRot());
-  VectorXd trans_device = this->device_from_calib * floatlist2vector(log.getTrans());
+  Vector3d rot_device = this->device_from_calib * floatlist2vector(log.getRot());
+  Vector3d trans_device = this->device_from_calib * floatlist2vector(log.getTrans());
 
   if ((rot_device.norm() > ROTATION_SANITY_CHECK) || (trans_device.norm() > TRANS_SANITY_CHECK)) {
     return;
   }
 
-  VectorXd rot_calib_std = floatlist2vector(log.getRotStd());
-  VectorXd trans_calib_std = floatlist2vector(log.getTransStd());
+  Vector3d rot_calib_std = floatlist2vector(log.getRotStd());
+  Vector3d trans_calib_std = floatlist2vector(log.getTransStd());
 
   if ((rot_calib_std.minCoeff() <= MIN_STD_SANITY_CHECK) || (trans_calib_std.minCoeff() <= MIN_STD_SANITY_CHECK)) {
     return;
@@ -319,24 +320,24 @@ void Localizer::handle_cam_odo(double current_time, const cereal::CameraOdometry
     return;
   }
 
-  this->posenet_stds.pop_front();
-  this->posenet_stds.push_back(trans_calib_std[0]);
+  this->posenet_stds[this->posenet_stds_pos] = trans_calib_std[0];
+  this->posenet_stds_pos = (this->posenet_stds_pos + 1) % (POSENET_STD_HIST_HALF * 2);
 
   // Multiply by 10 to avoid to high certainty in kalman filter because of temporally correlated noise
   trans_calib_std *= 10.0;
   rot_calib_std *= 10.0;
-  VectorXd rot_device_std = rotate_std(this->device_from_calib, rot_calib_std);
-  VectorXd trans_device_std = rotate_std(this->device_from_calib, trans_calib_std);
+  Vector3d rot_device_std = rotate_std(this->device_from_calib, rot_calib_std);
+  Vector3d trans_device_std = rotate_std(this->device_from_calib, trans_calib_std);
 
   this->kf->predict_and_observe(current_time, OBSERVATION_CAMERA_ODO_ROTATION,
-    { (VectorXd(rot_device.rows() + rot_device_std.rows()) << rot_device, rot_device_std).finished() });
+    { (Matrix<double, 6, 1>() << rot_device, rot_device_std).finished() });
   this->kf->predict_and_observe(current_time, OBSERVATION_CAMERA_ODO_TRANSLATION,
-    { (VectorXd(trans_device.rows() + trans_device_std.rows()) << trans_device, trans_device_std).finished() });
+    { (Matrix<double, 6, 1>() << trans_device, trans_device_std).finished() });
 }
 
 void Localizer::handle_live_calib(double current_time, const cereal::LiveCalibrationData::Reader& log) {
   if (log.getRpyCalib().size() > 0) {
-    auto calib = floatlist2vector(log.getRpyCalib());
+    Vector3d calib = floatlist2vector(log.getRpyCalib());
     if ((calib.minCoeff() < -CALIB_RPY_SANITY_CHECK) || (calib.maxCoeff() > CALIB_RPY_SANITY_CHECK)) {
       return;
     }
@@ -350,7 +351,7 @@ void Localizer::handle_live_calib(double current_time, const cereal::LiveCalibra
 
 void Localizer::reset_kalman(double current_time) {
   VectorXd init_x = this->kf->get_initial_x();
-  this->reset_kalman(current_time, init_x.segment<4>(3), init_x.head(3));
+  this->reset_kalman(current_time, init_x.segment<4>(3), init_x.head<3>());
 }
 
 void Localizer::finite_check(double current_time) {
@@ -382,7 +383,7 @@ void Localizer::update_reset_tracker() {
   }
 }
 
-void Localizer::reset_kalman(double current_time, VectorXd init_orient, VectorXd init_pos) {
+void Localizer::reset_kalman(double current_time, const Vector4d& init_orient, const Vector3d& init_pos) {
   // too nonlinear to init on completely wrong
   VectorXd init_x = this->kf->get_initial_x();
   MatrixXdr init_P = this->kf->get_initial_P();
@@ -440,49 +441,58 @@ bool Localizer::isGpsOK() {
 }
 
 int Localizer::locationd_thread() {
-  const std::initializer_list<const char *> service_list =
-      { "gpsLocationExternal", "sensorEvents", "cameraOdometry", "liveCalibration", "carState" };
+  OrderedInput input({
+    {"gpsLocationExternal", true},
+    {"sensorEvents"},
+    {"cameraOdometry"},
+    {"liveCalibration"},
+    {"carState"},
+  });
   PubMaster pm({ "liveLocationKalman" });
-  SubMaster sm(service_list, nullptr, { "gpsLocationExternal" });
 
   Params params;
+  uint64_t cam_odo_frame = 0;
+  uint64_t last_stats_time = nanos_since_boot();
 
   while (!do_exit) {
-    sm.update();
-    for (const char* service : service_list) {
-      if (sm.updated(service) && sm.valid(service)) {
-        const cereal::Event::Reader log = sm[service];
+    input.update();
+
+    // one stream in logMonoTime order, so the filter only rewinds for messages that arrive late
+    for (const auto &m : input.messages()) {
+      capnp::FlatArrayMessageReader cmsg(m.words);
+      const cereal::Event::Reader log = cmsg.getRoot<cereal::Event>();
+      if (m.valid) {
         this->handle_msg(log);
       }
-    }
 
-    if (sm.updated("cameraOdometry")) {
-      uint64_t logMonoTime = sm["cameraOdometry"].getLogMonoTime();
-      bool inputsOK = sm.allAliveAndValid();
-      bool sensorsOK = sm.alive("sensorEvents") && sm.valid("sensorEvents");
-      bool gpsOK = this->isGpsOK();
+      if (log.isCameraOdometry()) {
+        bool inputsOK = input.allAliveAndValid();
+        bool sensorsOK = input.alive("sensorEvents") && input.valid("sensorEvents");
+        bool gpsOK = this->isGpsOK();
 
-      MessageBuilder msg_builder;
-      kj::ArrayPtr<capnp::byte> bytes = this->get_message_bytes(msg_builder, logMonoTime, inputsOK, sensorsOK, gpsOK);
-      pm.send("liveLocationKalman", bytes.begin(), bytes.size());
+        MessageBuilder msg_builder;
+        kj::ArrayPtr<capnp::byte> bytes = this->get_message_bytes(msg_builder, m.log_mono_time, inputsOK, sensorsOK, gpsOK);
+        pm.send("liveLocationKalman", bytes.begin(), bytes.size());
 
-      if (sm.frame % 1200 == 0 && gpsOK) {  // once a minute
-        VectorXd posGeo = this->get_position_geodetic();
-        std::string lastGPSPosJSON = util::string_format(
-          "{\"latitude\": %.15f, \"longitude\": %.15f, \"altitude\": %.15f}", posGeo(0), posGeo(1), posGeo(2));
+        if (cam_odo_frame++ % 1200 == 0 && gpsOK) {  // once a minute
+          Vector3d posGeo = this->get_position_geodetic();
+          std::string lastGPSPosJSON = util::string_format(
+            "{\"latitude\": %.15f, \"longitude\": %.15f, \"altitude\": %.15f}", posGeo(0), posGeo(1), posGeo(2));
 
-        std::thread([&params] (const std::string gpsjson) {
-          params.put("LastGPSPosition", gpsjson);
-        }, lastGPSPosJSON).detach();
+          std::thread([&params] (const std::string gpsjson) {
+            params.put("LastGPSPosition", gpsjson);
+          }, lastGPSPosJSON).detach();
+        }
       }
     }
+
+    const uint64_t now = nanos_since_boot();
+    if (now - last_stats_time > 10e9) {
+      const LogMonoTimeMerge &stats = input.stats();
+      LOG("locationd input: %llu msgs, max batch %zu, %llu late, %llu filter rewinds", (unsigned long long)stats.received,
+          stats.max_batch, (unsigned long long)stats.late, (unsigned long long)this->kf->get_rewinds());
+      last_stats_time = now;
+    }
   }
   return 0;
 }
-
-int main() {
-  set_realtime_priority(5);
-
-  Localizer localizer;
-  return localizer.locationd_thread();
-}
@@ -17,6 +17,7 @@
 #define VISION_DECIMATION 2
 #define SENSOR_DECIMATION 10
 #include "selfdrive/locationd/models/live_kf.h"
+#include "selfdrive/locationd/ordered_input.h"
 
 #define POSENET_STD_HIST_HALF 20
 
@@ -27,7 +28,7 @@ public:
   int locationd_thread();
 
   void reset_kalman(double current_time = NAN);
-  void reset_kalman(double current_time, Eigen::VectorXd init_orient, Eigen::VectorXd init_pos);
+  void reset_kalman(double current_time, const Eigen::Vector4d& init_orient, const Eigen::Vector3d& init_pos);
   void finite_check(double current_time = NAN);
   void time_check(double current_time = NAN);
   void update_reset_tracker();
@@ -37,7 +38,7 @@ public:
     bool inputsOK, bool sensorsOK, bool gpsOK);
   void build_live_location(cereal::LiveLocationKalman::Builder& fix);
 
-  Eigen::VectorXd get_position_geodetic();
+  Eigen::Vector3d get_position_geodetic();
 
   void handle_msg_bytes(const char *data, const size_t size);
   void handle_msg(const cereal::Event::Reader& log);
@@ -50,14 +51,16 @@ public:
 private:
   std::unique_ptr<LiveKalman> kf;
 
-  Eigen::VectorXd calib;
-  MatrixXdr device_from_calib;
-  MatrixXdr calib_from_device;
+  Eigen::Vector3d calib;
+  Eigen::Matrix3d device_from_calib;
+  Eigen::Matrix3d calib_from_device;
   bool calibrated = false;
 
   double car_speed = 0.0;
   double last_reset_time = NAN;
-  std::deque<double> posenet_stds;
+  // ring buffer, oldest at posenet_stds_pos
+  double posenet_stds[POSENET_STD_HIST_HALF * 2];
+  int posenet_stds_pos = 0;
 
   std::unique_ptr<LocalCoord> converter;
 
@@ -0,0 +1,8 @@
+#include "selfdrive/locationd/locationd.h"
+
+int main() {
+  set_realtime_priority(5);
+
+  Localizer localizer;
+  return localizer.locationd_thread();
+}
@@ -28,8 +28,8 @@ std::vector<Eigen::Map<MatrixXdr>> get_vec_mapmat(std::vector<MatrixXdr>& mat_ve
 }
 
 LiveKalman::LiveKalman() {
-  this->dim_state = 26;
-  this->dim_state_err = 25;
+  this->dim_state = LIVE_DIM_STATE;
+  this->dim_state_err = LIVE_DIM_STATE_ERR;
 
   this->initial_x = live_initial_x;
   this->initial_P = live_initial_P_diag.asDiagonal();
@@ -42,28 +42,29 @@ LiveKalman::LiveKalman() {
   this->filter = std::make_shared<EKFSym>(this->name, get_mapmat(this->Q), get_mapvec(this->initial_x),
     get_mapmat(initial_P),  this->dim_state, this->dim_state_err, 0, 0, 0, std::vector<int>(),
     std::vector<int>{3}, std::vector<std::string>(), 0.2);
+  this->sync_state();
+}
+
+void LiveKalman::sync_state() {
+  this->x = this->filter->state();
+  this->P = this->filter->covs();
 }
 
 void LiveKalman::init_state(VectorXd& state, VectorXd& covs_diag, double filter_time) {
   MatrixXdr covs = covs_diag.asDiagonal();
   this->filter->init_state(get_mapvec(state), get_mapmat(covs), filter_time);
+  this->sync_state();
 }
 
 void LiveKalman::init_state(VectorXd& state, MatrixXdr& covs, double filter_time) {
   this->filter->init_state(get_mapvec(state), get_mapmat(covs), filter_time);
+  this->sync_state();
 }
 
 void LiveKalman::init_state(VectorXd& state, double filter_time) {
   MatrixXdr covs = this->filter->covs();
   this->filter->init_state(get_mapvec(state), get_mapmat(covs), filter_time);
-}
-
-VectorXd LiveKalman::get_x() {
-  return this->filter->state();
-}
-
-MatrixXdr LiveKalman::get_P() {
-  return this->filter->covs();
+  this->sync_state();
 }
 
 double LiveKalman::get_filter_time() {
@@ -80,6 +81,9 @@ std::vector<MatrixXdr> LiveKalman::get_R(int kind, int n) {
 
 std::optional<Estimate> LiveKalman::predict_and_observe(double t, int kind, std::vector<VectorXd> meas, std::vector<MatrixXdr> R) {
   std::optional<Estimate> r;
+  if (t < this->filter->get_filter_time()) {
+    this->rewinds++;
+  }
   switch (kind) {
   case OBSERVATION_CAMERA_ODO_TRANSLATION:
     r = this->predict_and_update_odo_trans(meas, t, kind);
@@ -97,6 +101,7 @@ std::optional<Estimate> LiveKalman::predict_and_observe(double t, int kind, std:
     r = this->filter->predict_and_update_batch(t, kind, get_vec_mapvec(meas), get_vec_mapmat(R));
     break;
   }
+  this->sync_state();
   return r;
 }
 
@@ -136,8 +141,7 @@ MatrixXdr LiveKalman::get_initial_P() {
   return this->initial_P;
 }
 
-MatrixXdr LiveKalman::H(VectorXd in) {
-  assert(in.size() == 6);
+Matrix<double, 3, 6, Eigen::RowMajor> LiveKalman::H(Matrix<double, 6, 1> in) {
   Matrix<double, 3, 6, Eigen::RowMajor> res;
   this->filter->get_extra_routine("H")(in.data(), res.data());
   return res;
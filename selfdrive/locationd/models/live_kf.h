@@ -12,6 +12,13 @@
 
 #define EARTH_GM 3.986005e14  // m^3/s^2 (gravitational constant * mass of earth)
 
+#define LIVE_DIM_STATE 26
+#define LIVE_DIM_STATE_ERR 25
+
+typedef Eigen::Matrix<double, LIVE_DIM_STATE, 1> LiveStateVector;
+typedef Eigen::Matrix<double, LIVE_DIM_STATE_ERR, 1> LiveStateErrVector;
+typedef Eigen::Matrix<double, LIVE_DIM_STATE_ERR, LIVE_DIM_STATE_ERR, Eigen::RowMajor> LiveCovMatrix;
+
 using namespace EKFS;
 
 Eigen::Map<Eigen::VectorXd> get_mapvec(Eigen::VectorXd& vec);
@@ -27,9 +34,12 @@ public:
   void init_state(Eigen::VectorXd& state, MatrixXdr& covs, double filter_time);
   void init_state(Eigen::VectorXd& state, double filter_time);
 
-  Eigen::VectorXd get_x();
-  MatrixXdr get_P();
+  // copies of the filter state, refreshed after every update
+  const LiveStateVector& get_x() const { return x; }
+  const LiveCovMatrix& get_P() const { return P; }
   double get_filter_time();
+  // observations older than the filter time, which rewind the filter
+  uint64_t get_rewinds() const { return rewinds; }
   std::vector<MatrixXdr> get_R(int kind, int n);
 
   std::optional<Estimate> predict_and_observe(double t, int kind, std::vector<Eigen::VectorXd> meas, std::vector<MatrixXdr> R = {});
@@ -40,9 +50,11 @@ public:
   Eigen::VectorXd get_initial_x();
   MatrixXdr get_initial_P();
 
-  MatrixXdr H(Eigen::VectorXd in);
+  Eigen::Matrix<double, 3, 6, Eigen::RowMajor> H(Eigen::Matrix<double, 6, 1> in);
 
 private:
+  void sync_state();
+
   std::string name = "live";
 
   std::shared_ptr<EKFSym> filter;
@@ -54,4 +66,8 @@ private:
   MatrixXdr initial_P;
   MatrixXdr Q;  // process noise
   std::unordered_map<int, MatrixXdr> obs_noise;
+
+  LiveStateVector x;
+  LiveCovMatrix P;
+  uint64_t rewinds = 0;
 };
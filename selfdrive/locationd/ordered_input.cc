@@ -0,0 +1,118 @@
+#include "selfdrive/locationd/ordered_input.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "cereal/services.h"
+#include "selfdrive/common/timing.h"
+
+static double service_freq(const char *name) {
+  for (const auto &it : services) {
+    if (strcmp(it.name, name) == 0) {
+      assert(it.frequency > 0);
+      return it.frequency;
+    }
+  }
+  assert(false);
+  return 0;
+}
+
+void LogMonoTimeMerge::merge(std::vector<OrderedMsg> &batch) {
+  // every socket is in order by itself, stable keeps it that way on equal times
+  std::stable_sort(batch.begin(), batch.end(), [](const OrderedMsg &a, const OrderedMsg &b) {
+    return a.log_mono_time < b.log_mono_time;
+  });
+
+  for (const auto &m : batch) {
+    late += m.log_mono_time < newest;
+  }
+  if (!batch.empty()) {
+    newest = std::max(newest, batch.back().log_mono_time);
+  }
+  received += batch.size();
+  max_batch = std::max(max_batch, batch.size());
+}
+
+OrderedInput::OrderedInput(const std::vector<ServiceConfig> &service_list) {
+  ctx.reset(Context::create());
+  poller.reset(Poller::create());
+  for (const auto &cfg : service_list) {
+    SubSocket *socket = SubSocket::create(ctx.get(), cfg.name);
+    assert(socket != 0);
+    poller->registerSocket(socket);
+    services.push_back({cfg.name, socket, service_freq(cfg.name), cfg.ignore_alive});
+  }
+}
+
+OrderedInput::~OrderedInput() {
+  for (auto &s : services) {
+    delete s.socket;
+  }
+}
+
+int OrderedInput::update(int timeout) {
+  msgs.clear();
+  if (poller->poll(timeout).empty()) {
+    return 0;
+  }
+
+  const uint64_t rcv_time = nanos_since_boot();
+  for (size_t i = 0; i < services.size(); i++) {
+    Service &s = services[i];
+    while (true) {
+      Message *msg = s.socket->receive(true);
+      if (msg == nullptr) {
+        break;
+      }
+
+      if (msgs.size() == buffers.size()) {
+        buffers.emplace_back();
+      }
+      auto words = buffers[msgs.size()].align(msg->getData(), msg->getSize());
+      delete msg;
+
+      capnp::FlatArrayMessageReader cmsg(words);
+      auto event = cmsg.getRoot<cereal::Event>();
+      msgs.push_back({event.getLogMonoTime(), (int)i, event.getValid(), words});
+
+      s.rcv_time = rcv_time;
+      s.valid = event.getValid();
+    }
+  }
+
+  merger.merge(msgs);
+  return msgs.size();
+}
+
+const OrderedInput::Service *OrderedInput::find(const char *name) const {
+  for (const auto &s : services) {
+    if (strcmp(s.name.c_str(), name) == 0) {
+      return &s;
+    }
+  }
+  assert(false);
+  return nullptr;
+}
+
+static bool service_alive(double freq, uint64_t rcv_time) {
+  return rcv_time > 0 && (nanos_since_boot() - rcv_time) * 1e-9 < 10.0 / freq;
+}
+
+bool OrderedInput::alive(const char *name) const {
+  const Service *s = find(name);
+  return service_alive(s->freq, s->rcv_time);
+}
+
+bool OrderedInput::valid(const char *name) const {
+  return find(name)->valid;
+}
+
+bool OrderedInput::allAliveAndValid() const {
+  for (const auto &s : services) {
+    if ((!s.ignore_alive && !service_alive(s.freq, s.rcv_time)) || !s.valid) {
+      return false;
+    }
+  }
+  return true;
+}
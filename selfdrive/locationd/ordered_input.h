@@ -0,0 +1,80 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+
+struct OrderedMsg {
+  uint64_t log_mono_time;
+  int service;
+  bool valid;
+  kj::ArrayPtr<const capnp::word> words;
+};
+
+// Orders every batch by logMonoTime and keeps count of the messages that are
+// older than the newest message of a previous batch.
+class LogMonoTimeMerge {
+public:
+  void merge(std::vector<OrderedMsg> &batch);
+
+  // totals since start
+  uint64_t received = 0;
+  // these reach the filter out of order no matter how the stream is merged
+  uint64_t late = 0;
+  // largest batch
+  size_t max_batch = 0;
+
+private:
+  uint64_t newest = 0;
+};
+
+// Subscribes to a set of services and, unlike SubMaster, drains every pending
+// message of every socket on each update, merged into one stream ordered by
+// logMonoTime. Also keeps the alive/valid state SubMaster would.
+class OrderedInput {
+public:
+  using Msg = OrderedMsg;
+
+  struct ServiceConfig {
+    const char *name;
+    bool ignore_alive = false;
+  };
+
+  OrderedInput(const std::vector<ServiceConfig> &service_list);
+  ~OrderedInput();
+
+  // waits up to timeout ms for any message, returns the number of messages received
+  int update(int timeout = 1000);
+  // messages of the last update, oldest first
+  const std::vector<Msg> &messages() const { return msgs; }
+  const char *name(const Msg &msg) const { return services[msg.service].name.c_str(); }
+
+  bool alive(const char *name) const;
+  bool valid(const char *name) const;
+  bool allAliveAndValid() const;
+
+  const LogMonoTimeMerge &stats() const { return merger; }
+
+private:
+  struct Service {
+    std::string name;
+    SubSocket *socket;
+    double freq;  // from the services table, alive until 10 periods without a message
+    bool ignore_alive;
+    uint64_t rcv_time = 0;
+    bool valid = true;
+  };
+
+  const Service *find(const char *name) const;
+
+  std::unique_ptr<Context> ctx;
+  std::unique_ptr<Poller> poller;
+  std::vector<Service> services;
+  std::vector<Msg> msgs;
+  // message copies, reused across updates so their buffers only grow
+  std::deque<AlignedBuffer> buffers;
+  LogMonoTimeMerge merger;
+};
@@ -0,0 +1,83 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <cstdlib>
+
+#include "selfdrive/locationd/locationd.h"
+
+// counts every malloc, which covers operator new, Eigen and capnp segments
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+
+static size_t allocations = 0;
+
+extern "C" void *malloc(size_t size) {
+  allocations++;
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size) {
+  allocations++;
+  return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *p, size_t size) {
+  allocations++;
+  return __libc_realloc(p, size);
+}
+
+static void live_calibration(MessageBuilder &msg, uint64_t log_mono_time) {
+  auto evt = msg.initEvent();
+  evt.setLogMonoTime(log_mono_time);
+  auto calib = evt.initLiveCalibration();
+  float rpy[] = {0.01, 0.02, 0.03};
+  calib.setRpyCalib(rpy);
+  calib.setCalStatus(1);
+}
+
+static void car_state(MessageBuilder &msg, uint64_t log_mono_time) {
+  auto evt = msg.initEvent();
+  evt.setLogMonoTime(log_mono_time);
+  auto cs = evt.initCarState();
+  cs.setVEgo(20.0);
+  cs.setStandstill(false);
+}
+
+TEST_CASE("Localizer steady state does not allocate") {
+  Localizer localizer;
+  const uint64_t t0 = 1000 * 1e9;
+
+  MessageBuilder calib_msg, car_state_msg;
+  live_calibration(calib_msg, t0);
+  car_state(car_state_msg, t0);
+  auto calib_event = calib_msg.getRoot<cereal::Event>().asReader();
+  auto car_state_event = car_state_msg.getRoot<cereal::Event>().asReader();
+
+  kj::Array<capnp::word> segment = kj::heapArray<capnp::word>(8192);
+
+  // warm up
+  localizer.handle_msg(calib_event);
+  localizer.handle_msg(car_state_event);
+
+  SECTION("handling messages that don't update the filter") {
+    allocations = 0;
+    for (int i = 0; i < 100; i++) {
+      localizer.handle_msg(calib_event);
+      localizer.handle_msg(car_state_event);
+    }
+    size_t n = allocations;
+    REQUIRE(n == 0);
+  }
+
+  SECTION("building liveLocationKalman") {
+    allocations = 0;
+    for (int i = 0; i < 100; i++) {
+      capnp::MallocMessageBuilder msg(segment);
+      auto fix = msg.initRoot<cereal::Event>().initLiveLocationKalman();
+      localizer.build_live_location(fix);
+    }
+    size_t n = allocations;
+    REQUIRE(n == 0);
+  }
+}
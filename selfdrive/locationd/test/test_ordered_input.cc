@@ -0,0 +1,75 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <vector>
+
+#include "selfdrive/locationd/ordered_input.h"
+
+static std::vector<OrderedMsg> batch(const std::vector<std::pair<int, uint64_t>> &msgs) {
+  std::vector<OrderedMsg> ret;
+  for (auto &[service, t] : msgs) {
+    ret.push_back({t, service, true, {}});
+  }
+  return ret;
+}
+
+static std::vector<uint64_t> times(const std::vector<OrderedMsg> &msgs) {
+  std::vector<uint64_t> ret;
+  for (auto &m : msgs) ret.push_back(m.log_mono_time);
+  return ret;
+}
+
+TEST_CASE("LogMonoTimeMerge") {
+  LogMonoTimeMerge merger;
+
+  SECTION("a batch is merged in logMonoTime order") {
+    // drained socket by socket, every socket in order by itself
+    auto msgs = batch({{0, 10}, {0, 40}, {0, 50}, {1, 20}, {1, 30}, {2, 5}});
+    merger.merge(msgs);
+    REQUIRE(times(msgs) == std::vector<uint64_t>{5, 10, 20, 30, 40, 50});
+    REQUIRE(merger.received == 6);
+    REQUIRE(merger.max_batch == 6);
+    REQUIRE(merger.late == 0);
+  }
+
+  SECTION("equal times keep the order of the sockets") {
+    auto msgs = batch({{0, 10}, {0, 20}, {1, 10}, {1, 20}});
+    merger.merge(msgs);
+    REQUIRE(times(msgs) == std::vector<uint64_t>{10, 10, 20, 20});
+    REQUIRE(msgs[0].service == 0);
+    REQUIRE(msgs[1].service == 1);
+    REQUIRE(msgs[2].service == 0);
+    REQUIRE(msgs[3].service == 1);
+  }
+
+  SECTION("messages older than a previous batch are late") {
+    auto first = batch({{0, 100}, {1, 200}});
+    merger.merge(first);
+
+    // a slow socket delivers messages from before the previous batch, which rewinds the filter
+    auto second = batch({{0, 300}, {1, 150}, {1, 250}, {1, 50}});
+    merger.merge(second);
+    REQUIRE(times(second) == std::vector<uint64_t>{50, 150, 250, 300});
+    REQUIRE(merger.late == 2);
+
+    // a rewind doesn't move the newest time back, so later messages are compared against 300
+    auto third = batch({{1, 280}, {0, 310}});
+    merger.merge(third);
+    REQUIRE(merger.late == 3);
+
+    REQUIRE(merger.received == 8);
+    REQUIRE(merger.max_batch == 4);
+  }
+
+  SECTION("empty batches change nothing") {
+    auto msgs = batch({{0, 100}});
+    merger.merge(msgs);
+    std::vector<OrderedMsg> empty;
+    merger.merge(empty);
+    auto next = batch({{0, 90}});
+    merger.merge(next);
+    REQUIRE(merger.late == 1);
+    REQUIRE(merger.received == 2);
+    REQUIRE(merger.max_batch == 1);
+  }
+}
@@ -0,0 +1,310 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/locationd/ublox_msg.h"
+
+// frames are built field by field in the layout the receiver sends, so every decoded field can be checked
+
+static std::string ubx_frame(uint8_t msg_class, uint8_t msg_id, const std::string &payload) {
+  std::string msg = "\xb5\x62"s;
+  msg.push_back(msg_class);
+  msg.push_back(msg_id);
+  msg.push_back(payload.size() & 0xFF);
+  msg.push_back(payload.size() >> 8);
+  return ublox::ubx_add_checksum(msg + payload);
+}
+
+template <typename T>
+static void put(std::string &payload, int offset, T v) {
+  memcpy(&payload[offset], &v, sizeof(T));
+}
+
+// sets bits [pos, pos + len) of the 24 data bits of the words of a GPS subframe, msb first as in IS-GPS-200
+static void set_gps_bits(uint32_t *words, int pos, int len, int64_t v) {
+  for (int b = pos; b < pos + len; b++) {
+    const uint32_t bit = (v >> (pos + len - 1 - b)) & 1;
+    words[b / 24] = (words[b / 24] & ~(1u << (23 - b % 24))) | (bit << (23 - b % 24));
+  }
+}
+
+static std::string gps_subframe(int sv_id, int subframe_id, uint32_t *words) {
+  set_gps_bits(words, 0, 8, 0x8b);
+  set_gps_bits(words, 43, 3, subframe_id);
+
+  std::string sfrbx(8 + 40, '\0');
+  sfrbx[0] = 0;  // GPS
+  sfrbx[1] = sv_id;
+  sfrbx[4] = 10;
+  for (int i = 0; i < 10; i++) {
+    put<uint32_t>(sfrbx, 8 + 4 * i, words[i] << 6);
+  }
+  return ubx_frame(ublox::CLASS_RXM, 0x13, sfrbx);
+}
+
+struct Decoded {
+  std::string service;
+  kj::Array<capnp::word> words;
+};
+
+// feeds the stream in chunks of chunk_size like serial reads, and decodes every frame
+static std::vector<Decoded> parse(UbloxMsgParser &parser, const std::string &stream, size_t chunk_size) {
+  std::vector<Decoded> ret;
+  const uint8_t *data = (const uint8_t *)stream.data();
+  for (size_t pos = 0; pos < stream.size(); pos += chunk_size) {
+    const size_t len = std::min(chunk_size, stream.size() - pos);
+    size_t consumed = 0;
+    while (consumed < len) {
+      consumed += parser.add_data(data + pos + consumed, len - consumed);
+      if (parser.frame_ready()) {
+        MessageBuilder msg;
+        const char *service = parser.gen_msg(msg);
+        if (service) {
+          ret.push_back({service, capnp::messageToFlatArray(msg)});
+        }
+      }
+    }
+  }
+  return ret;
+}
+
+// whole frames are decoded in place, split ones are staged first
+static const size_t chunk_sizes[] = {1, 7, 64, 1 << 16};
+
+TEST_CASE("NAV-PVT") {
+  std::string pvt(92, '\0');
+  put<uint16_t>(pvt, 4, 2021);
+  pvt[6] = 6; pvt[7] = 1; pvt[8] = 12; pvt[9] = 30; pvt[10] = 15;
+  put<int32_t>(pvt, 16, 500000000);
+  pvt[21] = 0x01;
+  put<int32_t>(pvt, 24, -1224194155);
+  put<int32_t>(pvt, 28, 377749295);
+  put<int32_t>(pvt, 32, 16000);
+  put<uint32_t>(pvt, 40, 2500);
+  put<uint32_t>(pvt, 44, 3500);
+  put<int32_t>(pvt, 48, 1000);
+  put<int32_t>(pvt, 52, -2000);
+  put<int32_t>(pvt, 56, 50);
+  put<int32_t>(pvt, 60, 2236);
+  put<int32_t>(pvt, 64, 29656505);
+  put<int32_t>(pvt, 68, 300);
+  put<uint32_t>(pvt, 72, 1500000);
+  const std::string stream = ubx_frame(ublox::CLASS_NAV, 0x07, pvt);
+
+  for (size_t chunk_size : chunk_sizes) {
+    UbloxMsgParser parser;
+    auto decoded = parse(parser, stream, chunk_size);
+    REQUIRE(decoded.size() == 1);
+    REQUIRE(decoded[0].service == "gpsLocationExternal");
+
+    capnp::FlatArrayMessageReader reader(decoded[0].words);
+    auto loc = reader.getRoot<cereal::Event>().getGpsLocationExternal();
+    REQUIRE(loc.getSource() == cereal::GpsLocationData::SensorSource::UBLOX);
+    REQUIRE(loc.getFlags() == 1);
+    REQUIRE(loc.getLatitude() == Approx(37.7749295));
+    REQUIRE(loc.getLongitude() == Approx(-122.4194155));
+    REQUIRE(loc.getAltitude() == Approx(16.0));
+    REQUIRE(loc.getAccuracy() == Approx(2.5));
+    REQUIRE(loc.getVerticalAccuracy() == Approx(3.5));
+    REQUIRE(loc.getSpeed() == Approx(2.236));
+    REQUIRE(loc.getBearingDeg() == Approx(296.56505));
+    REQUIRE(loc.getSpeedAccuracy() == Approx(0.3));
+    REQUIRE(loc.getBearingAccuracyDeg() == Approx(15.0));
+    // 2021-06-01 12:30:15.5 UTC
+    REQUIRE(loc.getTimestamp() == 1622550615500);
+    auto vned = loc.getVNED();
+    REQUIRE(vned.size() == 3);
+    REQUIRE(vned[0] == Approx(1.0));
+    REQUIRE(vned[1] == Approx(-2.0));
+    REQUIRE(vned[2] == Approx(0.05));
+  }
+}
+
+TEST_CASE("RXM-RAWX") {
+  std::string rawx(16 + 32 * 2, '\0');
+  put<double>(rawx, 0, 345618.5);
+  put<uint16_t>(rawx, 8, 2160);
+  rawx[10] = 18;
+  rawx[11] = 2;
+  rawx[12] = 0x05;
+  for (int i = 0; i < 2; i++) {
+    const int m = 16 + 32 * i;
+    put<double>(rawx, m, 21234567.25 + i);
+    put<double>(rawx, m + 8, 111587654.5 + i);
+    put<float>(rawx, m + 16, -512.5f + i);
+    rawx[m + 20] = i == 0 ? 0 : 6;  // GPS, GLONASS
+    rawx[m + 21] = 5 + i;
+    rawx[m + 23] = i == 0 ? 0 : 9;
+    put<uint16_t>(rawx, m + 24, 64500);
+    rawx[m + 26] = 42;
+    rawx[m + 27] = 3;
+    rawx[m + 28] = 5;
+    rawx[m + 29] = 2;
+    rawx[m + 30] = i == 0 ? 0x07 : 0x08;
+  }
+  const std::string stream = ubx_frame(ublox::CLASS_RXM, 0x15, rawx);
+
+  for (size_t chunk_size : chunk_sizes) {
+    UbloxMsgParser parser;
+    auto decoded = parse(parser, stream, chunk_size);
+    REQUIRE(decoded.size() == 1);
+    REQUIRE(decoded[0].service == "ubloxGnss");
+
+    capnp::FlatArrayMessageReader reader(decoded[0].words);
+    auto mr = reader.getRoot<cereal::Event>().getUbloxGnss().getMeasurementReport();
+    REQUIRE(mr.getRcvTow() == 345618.5);
+    REQUIRE(mr.getGpsWeek() == 2160);
+    REQUIRE(mr.getLeapSeconds() == 18);
+    REQUIRE(mr.getNumMeas() == 2);
+    REQUIRE(mr.getReceiverStatus().getLeapSecValid());
+    REQUIRE(mr.getReceiverStatus().getClkReset());
+
+    auto meas = mr.getMeasurements();
+    REQUIRE(meas.size() == 2);
+    for (int i = 0; i < 2; i++) {
+      REQUIRE(meas[i].getSvId() == 5 + i);
+      REQUIRE(meas[i].getGnssId() == (i == 0 ? 0 : 6));
+      REQUIRE(meas[i].getGlonassFrequencyIndex() == (i == 0 ? 0 : 9));
+      REQUIRE(meas[i].getPseudorange() == 21234567.25 + i);
+      REQUIRE(meas[i].getCarrierCycles() == 111587654.5 + i);
+      REQUIRE(meas[i].getDoppler() == -512.5f + i);
+      REQUIRE(meas[i].getLocktime() == 64500);
+      REQUIRE(meas[i].getCno() == 42);
+      REQUIRE(meas[i].getPseudorangeStdev() == Approx(0.08));
+      REQUIRE(meas[i].getCarrierPhaseStdev() == Approx(0.02));
+      REQUIRE(meas[i].getDopplerStdev() == Approx(0.008));
+    }
+    auto ts = meas[0].getTrackingStatus();
+    REQUIRE(ts.getPseudorangeValid());
+    REQUIRE(ts.getCarrierPhaseValid());
+    REQUIRE(ts.getHalfCycleValid());
+    REQUIRE(!ts.getHalfCycleSubtracted());
+    ts = meas[1].getTrackingStatus();
+    REQUIRE(!ts.getPseudorangeValid());
+    REQUIRE(ts.getHalfCycleSubtracted());
+  }
+}
+
+TEST_CASE("RXM-SFRBX GPS ephemeris") {
+  const int sv_id = 12;
+  uint32_t sf[5][10] = {};
+
+  // subframe 1: clock
+  set_gps_bits(sf[0], 48, 10, 112);
+  set_gps_bits(sf[0], 160, 8, -11);
+  set_gps_bits(sf[0], 176, 16, 21600);
+  set_gps_bits(sf[0], 192, 8, 0);
+  set_gps_bits(sf[0], 200, 16, -5);
+  set_gps_bits(sf[0], 216, 22, 123456);
+
+  // subframe 2: ephemeris
+  set_gps_bits(sf[1], 56, 16, -1234);
+  set_gps_bits(sf[1], 72, 16, 12345);
+  set_gps_bits(sf[1], 88, 32, 1234567890);
+  set_gps_bits(sf[1], 120, 16, -2345);
+  set_gps_bits(sf[1], 136, 32, 41943040);
+  set_gps_bits(sf[1], 168, 16, 3456);
+  set_gps_bits(sf[1], 184, 32, 2702000000);
+  set_gps_bits(sf[1], 216, 16, 21600);
+
+  // subframe 3: ephemeris
+  set_gps_bits(sf[2], 48, 16, -12);
+  set_gps_bits(sf[2], 64, 32, -987654321);
+  set_gps_bits(sf[2], 96, 16, 34);
+  set_gps_bits(sf[2], 112, 32, 654321098);
+  set_gps_bits(sf[2], 144, 16, 7890);
+  set_gps_bits(sf[2], 160, 32, -123456789);
+  set_gps_bits(sf[2], 192, 24, -20000);
+  set_gps_bits(sf[2], 216, 8, 77);
+  set_gps_bits(sf[2], 224, 14, -300);
+
+  std::string stream;
+  for (int i = 0; i < 5; i++) {
+    stream += gps_subframe(sv_id, i + 1, sf[i]);
+  }
+
+  for (size_t chunk_size : chunk_sizes) {
+    UbloxMsgParser parser;
+    // nothing until all five subframes are in
+    auto decoded = parse(parser, stream, chunk_size);
+    REQUIRE(parser.frames == 5);
+    REQUIRE(decoded.size() == 1);
+    REQUIRE(decoded[0].service == "ubloxGnss");
+
+    capnp::FlatArrayMessageReader reader(decoded[0].words);
+    auto eph = reader.getRoot<cereal::Event>().getUbloxGnss().getEphemeris();
+    REQUIRE(eph.getSvId() == sv_id);
+
+    REQUIRE(eph.getGpsWeek() == 112);
+    REQUIRE(eph.getTgd() == Approx(-11 * pow(2, -31)));
+    REQUIRE(eph.getToc() == 345600);
+    REQUIRE(eph.getAf2() == 0);
+    REQUIRE(eph.getAf1() == Approx(-5 * pow(2, -43)));
+    REQUIRE(eph.getAf0() == Approx(123456 * pow(2, -31)));
+
+    const double gpsPi = 3.1415926535898;
+    REQUIRE(eph.getCrs() == Approx(-1234 * pow(2, -5)));
+    REQUIRE(eph.getDeltaN() == Approx(12345 * pow(2, -43) * gpsPi));
+    REQUIRE(eph.getM0() == Approx(1234567890 * pow(2, -31) * gpsPi));
+    REQUIRE(eph.getCuc() == Approx(-2345 * pow(2, -29)));
+    REQUIRE(eph.getEcc() == Approx(41943040 * pow(2, -33)));
+    REQUIRE(eph.getCus() == Approx(3456 * pow(2, -29)));
+    REQUIRE(eph.getA() == Approx(pow(2702000000 * pow(2, -19), 2)));
+    REQUIRE(eph.getToe() == 345600);
+
+    REQUIRE(eph.getCic() == Approx(-12 * pow(2, -29)));
+    REQUIRE(eph.getOmega0() == Approx(-987654321 * pow(2, -31) * gpsPi));
+    REQUIRE(eph.getCis() == Approx(34 * pow(2, -29)));
+    REQUIRE(eph.getI0() == Approx(654321098 * pow(2, -31) * gpsPi));
+    REQUIRE(eph.getCrc() == Approx(7890 * pow(2, -5)));
+    REQUIRE(eph.getOmega() == Approx(-123456789 * pow(2, -31) * gpsPi));
+    REQUIRE(eph.getOmegaDot() == Approx(-20000 * pow(2, -43) * gpsPi));
+    REQUIRE(eph.getIode() == 77);
+    REQUIRE(eph.getIDot() == Approx(-300 * pow(2, -43) * gpsPi));
+  }
+}
+
+TEST_CASE("MON-HW") {
+  std::string hw(60, '\0');
+  put<uint16_t>(hw, 16, 87);
+  put<uint16_t>(hw, 18, 5432);
+  hw[20] = 2;  // antenna ok
+  hw[21] = 1;  // antenna powered
+  hw[22] = 0x05;
+  hw[45] = 12;
+  const std::string stream = ubx_frame(ublox::CLASS_MON, 0x09, hw);
+
+  for (size_t chunk_size : chunk_sizes) {
+    UbloxMsgParser parser;
+    auto decoded = parse(parser, stream, chunk_size);
+    REQUIRE(decoded.size() == 1);
+    REQUIRE(decoded[0].service == "ubloxGnss");
+
+    capnp::FlatArrayMessageReader reader(decoded[0].words);
+    auto status = reader.getRoot<cereal::Event>().getUbloxGnss().getHwStatus();
+    REQUIRE(status.getNoisePerMS() == 87);
+    REQUIRE(status.getAgcCnt() == 5432);
+    REQUIRE(status.getAStatus() == cereal::UbloxGnss::HwStatus::AntennaSupervisorState::OK);
+    REQUIRE(status.getAPower() == cereal::UbloxGnss::HwStatus::AntennaPowerStatus::ON);
+    REQUIRE(status.getFlags() == 0x05);
+    REQUIRE(status.getJamInd() == 12);
+  }
+}
+
+TEST_CASE("corrupt length doesn't swallow the following frames") {
+  // a header claiming a 60 KB payload, then a good frame
+  std::string stream = "\xb5\x62\x01\x07\x00\xf0"s;
+  stream += ubx_frame(ublox::CLASS_MON, 0x09, std::string(60, '\0'));
+
+  for (size_t chunk_size : chunk_sizes) {
+    UbloxMsgParser parser;
+    auto decoded = parse(parser, stream, chunk_size);
+    REQUIRE(decoded.size() == 1);
+    REQUIRE(parser.length_errors == 1);
+  }
+}
@@ -0,0 +1,136 @@
+// runs UbloxMsgParser over a ubloxRaw stream and reports throughput and decoded messages
+// usage: ./ubloxd_benchmark [file] [iterations]
+// file holds the concatenated ubloxRaw bytes of a drive, e.g. from
+//   python -c "from tools.lib.logreader import LogReader; import sys; \
+//     sys.stdout.buffer.write(b''.join(m.ubloxRaw for m in LogReader(sys.argv[1]) if m.which() == 'ubloxRaw'))" rlog.bz2 > ublox.raw
+// without one a synthetic stream of NAV-PVT, RXM-RAWX, RXM-SFRBX and MON-HW frames is used
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/locationd/ublox_msg.h"
+
+static std::string ubx_frame(uint8_t msg_class, uint8_t msg_id, const std::string &payload) {
+  std::string msg = "\xb5\x62"s;
+  msg.push_back(msg_class);
+  msg.push_back(msg_id);
+  msg.push_back(payload.size() & 0xFF);
+  msg.push_back(payload.size() >> 8);
+  return ublox::ubx_add_checksum(msg + payload);
+}
+
+template <typename T>
+static void put(std::string &payload, int offset, T v) {
+  memcpy(&payload[offset], &v, sizeof(T));
+}
+
+// one second of receiver output
+static std::string synthetic_epoch(int epoch) {
+  std::string out;
+
+  std::string pvt(92, '\0');
+  put<uint16_t>(pvt, 4, 2021);
+  pvt[6] = 6; pvt[7] = 1; pvt[8] = 12; pvt[9] = epoch / 60 % 60; pvt[10] = epoch % 60;
+  pvt[21] = 0x01;
+  put<int32_t>(pvt, 24, -1224000000);
+  put<int32_t>(pvt, 28, 377000000 + epoch);
+  put<int32_t>(pvt, 60, 25000);
+  out += ubx_frame(ublox::CLASS_NAV, 0x07, pvt);
+
+  const int num_meas = 24;
+  std::string rawx(16 + 32 * num_meas, '\0');
+  put<double>(rawx, 0, 345600.0 + epoch);
+  put<uint16_t>(rawx, 8, 2160);
+  rawx[11] = num_meas;
+  for (int i = 0; i < num_meas; i++) {
+    put<double>(rawx, 16 + 32 * i, 2.1e7 + i * 1000.0);
+    put<double>(rawx, 16 + 32 * i + 8, 1.1e8 + i);
+    put<float>(rawx, 16 + 32 * i + 16, -500.f + i);
+    rawx[16 + 32 * i + 21] = i + 1;
+    rawx[16 + 32 * i + 30] = 0x0F;
+  }
+  out += ubx_frame(ublox::CLASS_RXM, 0x15, rawx);
+
+  // a subframe every 6 s for each satellite, staggered
+  for (int sv = 1; sv <= 8; sv++) {
+    std::string sfrbx(8 + 40, '\0');
+    sfrbx[1] = sv;
+    sfrbx[4] = 10;
+    const uint32_t subframe_id = 1 + (epoch + sv) % 5;
+    put<uint32_t>(sfrbx, 8, 0x8b0000u << 6);
+    put<uint32_t>(sfrbx, 12, (subframe_id << 2) << 6);
+    for (int w = 2; w < 10; w++) {
+      put<uint32_t>(sfrbx, 8 + 4 * w, ((sv * 0x1234 + w * 0x567) & 0xFFFFFF) << 6);
+    }
+    out += ubx_frame(ublox::CLASS_RXM, 0x13, sfrbx);
+  }
+
+  out += ubx_frame(ublox::CLASS_MON, 0x09, std::string(60, '\0'));
+  return out;
+}
+
+int main(int argc, char *argv[]) {
+  std::string stream;
+  if (argc > 1) {
+    std::ifstream f(argv[1], std::ios::binary);
+    if (!f) {
+      printf("can't open %s\n", argv[1]);
+      return 1;
+    }
+    stream.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+  } else {
+    for (int i = 0; i < 600; i++) {
+      stream += synthetic_epoch(i);
+    }
+  }
+  const int iterations = argc > 2 ? atoi(argv[2]) : 20;
+
+  // chunks like serial reads, so some frames are split and staged
+  std::mt19937 rng(0);
+  std::vector<size_t> chunks;
+  for (size_t pos = 0; pos < stream.size();) {
+    size_t n = std::min<size_t>(stream.size() - pos, 64 + rng() % 2048);
+    chunks.push_back(n);
+    pos += n;
+  }
+
+  UbloxMsgParser parser;
+  uint64_t messages = 0, message_bytes = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; it++) {
+    const uint8_t *data = (const uint8_t *)stream.data();
+    for (size_t len : chunks) {
+      size_t consumed = 0;
+      while (consumed < len) {
+        consumed += parser.add_data(data + consumed, len - consumed);
+        if (parser.frame_ready()) {
+          MessageBuilder msg_builder;
+          if (parser.gen_msg(msg_builder)) {
+            messages++;
+            message_bytes += msg_builder.toBytes().size();
+          }
+        }
+      }
+      data += len;
+    }
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  const double total_bytes = (double)stream.size() * iterations;
+  printf("stream           %zu bytes, %zu chunks\n", stream.size(), chunks.size());
+  printf("throughput       %.1f MB/s\n", total_bytes / seconds / 1e6);
+  printf("frames           %llu, %.0f ns per frame\n", (unsigned long long)parser.frames, seconds * 1e9 / std::max<uint64_t>(1, parser.frames));
+  printf("messages         %llu, %.0f bytes each\n", (unsigned long long)messages, (double)message_bytes / std::max<uint64_t>(1, messages));
+  printf("checksum errors  %llu, length errors %llu, unknown %llu\n", (unsigned long long)parser.checksum_errors,
+         (unsigned long long)parser.length_errors, (unsigned long long)parser.unknown);
+  return 0;
+}
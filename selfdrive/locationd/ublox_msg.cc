@@ -2,333 +2,389 @@
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
-#include <unordered_map>
+#include <iterator>
 
 #include "selfdrive/common/swaglog.h"
 
 const double gpsPi = 3.1415926535898;
-#define UBLOX_MSG_SIZE(hdr) (*(uint16_t *)&hdr[4])
 
 inline static bool bit_to_bool(uint8_t val, int shifts) {
   return (bool)(val & (1 << shifts));
 }
 
-inline int UbloxMsgParser::needed_bytes() {
-  // Msg header incomplete?
-  if(bytes_in_parse_buf < ublox::UBLOX_HEADER_SIZE)
-    return ublox::UBLOX_HEADER_SIZE + ublox::UBLOX_CHECKSUM_SIZE - bytes_in_parse_buf;
-  uint16_t needed = UBLOX_MSG_SIZE(msg_parse_buf) + ublox::UBLOX_HEADER_SIZE + ublox::UBLOX_CHECKSUM_SIZE;
-  // too much data
-  if(needed < (uint16_t)bytes_in_parse_buf)
-    return -1;
-  return needed - (uint16_t)bytes_in_parse_buf;
+// little endian field at offset of a UBX payload
+template <typename T>
+inline static T get(const uint8_t *payload, int offset) {
+  T v;
+  memcpy(&v, payload + offset, sizeof(T));
+  return v;
 }
 
-inline bool UbloxMsgParser::valid_cheksum() {
-  uint8_t ck_a = 0, ck_b = 0;
-  for(int i = 2; i < bytes_in_parse_buf - ublox::UBLOX_CHECKSUM_SIZE;i++) {
-    ck_a = (ck_a + msg_parse_buf[i]) & 0xFF;
-    ck_b = (ck_b + ck_a) & 0xFF;
+// bits [pos, pos + len) of the 24 data bits of the words of a GPS subframe, msb first as in IS-GPS-200
+static uint32_t gps_bits(const uint32_t *words, int pos, int len) {
+  uint32_t r = 0;
+  for (int b = pos; b < pos + len; b++) {
+    r = (r << 1) | ((words[b / 24] >> (23 - b % 24)) & 1);
   }
-  if(ck_a != msg_parse_buf[bytes_in_parse_buf - 2]) {
-    LOGD("Checksum a mismtach: %02X, %02X", ck_a, msg_parse_buf[6]);
-    return false;
-  }
-  if(ck_b != msg_parse_buf[bytes_in_parse_buf - 1]) {
-    LOGD("Checksum b mismtach: %02X, %02X", ck_b, msg_parse_buf[7]);
-    return false;
-  }
-  return true;
+  return r;
 }
 
-inline bool UbloxMsgParser::valid() {
-  return bytes_in_parse_buf >= ublox::UBLOX_HEADER_SIZE + ublox::UBLOX_CHECKSUM_SIZE &&
-         needed_bytes() == 0 && valid_cheksum();
+static int32_t gps_sbits(const uint32_t *words, int pos, int len) {
+  return (int32_t)(gps_bits(words, pos, len) << (32 - len)) >> (32 - len);
 }
 
-inline bool UbloxMsgParser::valid_so_far() {
-  if(bytes_in_parse_buf > 0 && msg_parse_buf[0] != ublox::PREAMBLE1) {
-    return false;
-  }
-  if(bytes_in_parse_buf > 1 && msg_parse_buf[1] != ublox::PREAMBLE2) {
-    return false;
-  }
-  if(needed_bytes() == 0 && !valid()) {
-    return false;
-  }
-  return true;
+struct UbloxHandler {
+  uint8_t msg_class;
+  uint8_t msg_id;
+  const char *service;
+  bool (UbloxMsgParser::*gen)(const uint8_t *payload, uint16_t len, MessageBuilder &msg);
+};
+
+static const UbloxHandler ublox_handlers[] = {
+  {ublox::CLASS_NAV, 0x07, "gpsLocationExternal", &UbloxMsgParser::gen_nav_pvt},
+  {ublox::CLASS_RXM, 0x13, "ubloxGnss", &UbloxMsgParser::gen_rxm_sfrbx},
+  {ublox::CLASS_RXM, 0x15, "ubloxGnss", &UbloxMsgParser::gen_rxm_rawx},
+  {ublox::CLASS_MON, 0x09, "ubloxGnss", &UbloxMsgParser::gen_mon_hw},
+  {ublox::CLASS_MON, 0x0B, "ubloxGnss", &UbloxMsgParser::gen_mon_hw2},
+};
+
+void UbloxMsgParser::frame_done(const uint8_t *payload) {
+  msg_class = header[0];
+  msg_id = header[1];
+  frame_len = payload_len;
+  frame_payload = payload;
+  frames++;
 }
 
+size_t UbloxMsgParser::add_data(const uint8_t *incoming_data, size_t incoming_data_len) {
+  frame_payload = nullptr;
+
+  size_t i = 0;
+  while (i < incoming_data_len) {
+    const uint8_t b = incoming_data[i];
+    switch (state) {
+    case State::SYNC1:
+      i++;
+      if (b == ublox::PREAMBLE1) {
+        state = State::SYNC2;
+      }
+      break;
+    case State::SYNC2:
+      i++;
+      if (b == ublox::PREAMBLE2) {
+        state = State::HEADER;
+        header_pos = 0;
+        ck_a = ck_b = 0;
+      } else if (b != ublox::PREAMBLE1) {
+        state = State::SYNC1;
+      }
+      break;
+    case State::HEADER:
+      i++;
+      header[header_pos++] = b;
+      checksum(b);
+      if (header_pos < 4) {
+        break;
+      }
 
-bool UbloxMsgParser::add_data(const uint8_t *incoming_data, uint32_t incoming_data_len, size_t &bytes_consumed) {
-  int needed = needed_bytes();
-  if(needed > 0) {
-    bytes_consumed = std::min((uint32_t)needed, incoming_data_len );
-    // Add data to buffer
-    memcpy(msg_parse_buf + bytes_in_parse_buf, incoming_data, bytes_consumed);
-    bytes_in_parse_buf += bytes_consumed;
-  } else {
-    bytes_consumed = incoming_data_len;
-  }
-
-  // Validate msg format, detect invalid header and invalid checksum.
-  while(!valid_so_far() && bytes_in_parse_buf != 0) {
-    // Corrupted msg, drop a byte.
-    bytes_in_parse_buf -= 1;
-    if(bytes_in_parse_buf > 0)
-      memmove(&msg_parse_buf[0], &msg_parse_buf[1], bytes_in_parse_buf);
-  }
+      payload_len = header[2] | (header[3] << 8);
+      payload_pos = 0;
+      if (payload_len > ublox::UBLOX_MAX_PAYLOAD_SIZE) {
+        // staging it would swallow everything up to the bogus length, look for the next frame right here
+        LOGD("Invalid payload length: %d", payload_len);
+        length_errors++;
+        state = State::SYNC1;
+        break;
+      }
+      state = State::PAYLOAD;
 
-  // There is redundant data at the end of buffer, reset the buffer.
-  if(needed_bytes() == -1) {
-    bytes_in_parse_buf = 0;
+      // the whole frame is in this chunk, no need to stage it
+      if (incoming_data_len - i >= (size_t)(payload_len + ublox::UBLOX_CHECKSUM_SIZE)) {
+        const uint8_t *payload = &incoming_data[i];
+        for (int j = 0; j < payload_len; j++) {
+          checksum(payload[j]);
+        }
+        state = State::SYNC1;
+        if (ck_a == payload[payload_len] && ck_b == payload[payload_len + 1]) {
+          frame_done(payload);
+          return i + payload_len + ublox::UBLOX_CHECKSUM_SIZE;
+        }
+        // the length may be corrupt, look for the next frame inside this one
+        LOGD("Checksum mismatch: %02X %02X, %02X %02X", ck_a, ck_b, payload[payload_len], payload[payload_len + 1]);
+        checksum_errors++;
+      }
+      break;
+    case State::PAYLOAD: {
+      const size_t n = std::min((size_t)(payload_len - payload_pos), incoming_data_len - i);
+      memcpy(&msg_parse_buf[payload_pos], &incoming_data[i], n);
+      for (size_t j = 0; j < n; j++) {
+        checksum(incoming_data[i + j]);
+      }
+      payload_pos += n;
+      i += n;
+      if (payload_pos == payload_len) {
+        state = State::CK_A;
+      }
+      break;
+    }
+    case State::CK_A:
+      i++;
+      rcv_ck_a = b;
+      state = State::CK_B;
+      break;
+    case State::CK_B:
+      i++;
+      state = State::SYNC1;
+      if (rcv_ck_a == ck_a && b == ck_b) {
+        frame_done(msg_parse_buf);
+        return i;
+      }
+      LOGD("Checksum mismatch: %02X %02X, %02X %02X", ck_a, ck_b, rcv_ck_a, b);
+      checksum_errors++;
+      break;
+    }
   }
-  return valid();
+  return i;
 }
 
+const char *UbloxMsgParser::gen_msg(MessageBuilder &msg) {
+  assert(frame_ready());
 
-std::pair<std::string, kj::Array<capnp::word>> UbloxMsgParser::gen_msg() {
-  std::string dat = data();
-  kaitai::kstream stream(dat);
-
-  ubx_t ubx_message(&stream);
-  auto body = ubx_message.body();
-
-  switch (ubx_message.msg_type()) {
-  case 0x0107:
-    return {"gpsLocationExternal", gen_nav_pvt(static_cast<ubx_t::nav_pvt_t*>(body))};
-    break;
-  case 0x0213:
-    return {"ubloxGnss", gen_rxm_sfrbx(static_cast<ubx_t::rxm_sfrbx_t*>(body))};
-    break;
-  case 0x0215:
-    return {"ubloxGnss", gen_rxm_rawx(static_cast<ubx_t::rxm_rawx_t*>(body))};
-    break;
-  case 0x0a09:
-    return {"ubloxGnss", gen_mon_hw(static_cast<ubx_t::mon_hw_t*>(body))};
-    break;
-  case 0x0a0b:
-    return {"ubloxGnss", gen_mon_hw2(static_cast<ubx_t::mon_hw2_t*>(body))};
-    break;
-  default:
-    LOGE("Unknown message type %x", ubx_message.msg_type());
-    return {"ubloxGnss", kj::Array<capnp::word>()};
-    break;
+  for (const auto &h : ublox_handlers) {
+    if (h.msg_class == msg_class && h.msg_id == msg_id) {
+      return (this->*h.gen)(frame_payload, frame_len, msg) ? h.service : nullptr;
+    }
   }
+  LOGE("Unknown message type %x", (msg_class << 8) | msg_id);
+  unknown++;
+  return nullptr;
 }
 
+bool UbloxMsgParser::gen_nav_pvt(const uint8_t *payload, uint16_t len, MessageBuilder &msg) {
+  if (len < 92) {
+    LOGE("NAV-PVT too short: %d", len);
+    return false;
+  }
 
-kj::Array<capnp::word> UbloxMsgParser::gen_nav_pvt(ubx_t::nav_pvt_t *msg) {
-  MessageBuilder msg_builder;
-  auto gpsLoc = msg_builder.initEvent().initGpsLocationExternal();
+  auto gpsLoc = msg.initEvent().initGpsLocationExternal();
   gpsLoc.setSource(cereal::GpsLocationData::SensorSource::UBLOX);
-  gpsLoc.setFlags(msg->flags());
-  gpsLoc.setLatitude(msg->lat() * 1e-07);
-  gpsLoc.setLongitude(msg->lon() * 1e-07);
-  gpsLoc.setAltitude(msg->height() * 1e-03);
-  gpsLoc.setSpeed(msg->g_speed() * 1e-03);
-  gpsLoc.setBearingDeg(msg->head_mot() * 1e-5);
-  gpsLoc.setAccuracy(msg->h_acc() * 1e-03);
+  gpsLoc.setFlags(get<uint8_t>(payload, 21));
+  gpsLoc.setLatitude(get<int32_t>(payload, 28) * 1e-07);
+  gpsLoc.setLongitude(get<int32_t>(payload, 24) * 1e-07);
+  gpsLoc.setAltitude(get<int32_t>(payload, 32) * 1e-03);
+  gpsLoc.setSpeed(get<int32_t>(payload, 60) * 1e-03);
+  gpsLoc.setBearingDeg(get<int32_t>(payload, 64) * 1e-5);
+  gpsLoc.setAccuracy(get<uint32_t>(payload, 40) * 1e-03);
   std::tm timeinfo = std::tm();
-  timeinfo.tm_year = msg->year() - 1900;
-  timeinfo.tm_mon = msg->month() - 1;
-  timeinfo.tm_mday = msg->day();
-  timeinfo.tm_hour = msg->hour();
-  timeinfo.tm_min = msg->min();
-  timeinfo.tm_sec = msg->sec();
+  timeinfo.tm_year = get<uint16_t>(payload, 4) - 1900;
+  timeinfo.tm_mon = get<uint8_t>(payload, 6) - 1;
+  timeinfo.tm_mday = get<uint8_t>(payload, 7);
+  timeinfo.tm_hour = get<uint8_t>(payload, 8);
+  timeinfo.tm_min = get<uint8_t>(payload, 9);
+  timeinfo.tm_sec = get<uint8_t>(payload, 10);
 
   std::time_t utc_tt = timegm(&timeinfo);
-  gpsLoc.setTimestamp(utc_tt * 1e+03 + msg->nano() * 1e-06);
-  float f[] = { msg->vel_n() * 1e-03f, msg->vel_e() * 1e-03f, msg->vel_d() * 1e-03f };
+  gpsLoc.setTimestamp(utc_tt * 1e+03 + get<int32_t>(payload, 16) * 1e-06);
+  float f[] = { get<int32_t>(payload, 48) * 1e-03f, get<int32_t>(payload, 52) * 1e-03f, get<int32_t>(payload, 56) * 1e-03f };
   gpsLoc.setVNED(f);
-  gpsLoc.setVerticalAccuracy(msg->v_acc() * 1e-03);
-  gpsLoc.setSpeedAccuracy(msg->s_acc() * 1e-03);
-  gpsLoc.setBearingAccuracyDeg(msg->head_acc() * 1e-05);
-  return capnp::messageToFlatArray(msg_builder);
+  gpsLoc.setVerticalAccuracy(get<uint32_t>(payload, 44) * 1e-03);
+  gpsLoc.setSpeedAccuracy(get<int32_t>(payload, 68) * 1e-03);
+  gpsLoc.setBearingAccuracyDeg(get<uint32_t>(payload, 72) * 1e-05);
+  return true;
 }
 
+bool UbloxMsgParser::gen_rxm_sfrbx(const uint8_t *payload, uint16_t len, MessageBuilder &msg) {
+  if (len < 8 || len < 8 + 4 * payload[4]) {
+    LOGE("RXM-SFRBX too short: %d", len);
+    return false;
+  }
+  const uint8_t gnss_id = payload[0];
+  const uint8_t sv_id = payload[1];
+  const uint8_t num_words = payload[4];
+  if (gnss_id != 0 || sv_id >= std::size(gps_subframes)) {
+    return false;
+  }
 
-kj::Array<capnp::word> UbloxMsgParser::gen_rxm_sfrbx(ubx_t::rxm_sfrbx_t *msg) {
-  auto body = *msg->body();
-
-  if (msg->gnss_id() == ubx_t::gnss_type_t::GNSS_TYPE_GPS) {
-    // GPS subframes are packed into 10x 4 bytes, each containing 3 actual bytes
-    // We will first need to separate the data from the padding and parity
-    assert(body.size() == 10);
-
-    std::string subframe_data;
-    subframe_data.reserve(30);
-    for (uint32_t word : body) {
-      word = word >> 6; // TODO: Verify parity
-      subframe_data.push_back(word >> 16);
-      subframe_data.push_back(word >> 8);
-      subframe_data.push_back(word >> 0);
-    }
+  // GPS subframes are packed into 10x 4 bytes, each containing 3 actual bytes
+  // We will first need to separate the data from the padding and parity
+  if (num_words != 10) {
+    LOGE("GPS subframe with %d words", num_words);
+    return false;
+  }
+  uint32_t words[10];
+  for (int i = 0; i < 10; i++) {
+    words[i] = (get<uint32_t>(payload, 8 + 4 * i) >> 6) & 0xFFFFFF; // TODO: Verify parity
+  }
+  if (gps_bits(words, 0, 8) != 0x8b) {
+    LOGE("GPS subframe without TLM preamble");
+    return false;
+  }
+  const int subframe_id = gps_bits(words, 43, 3);
+  if (subframe_id < 1 || subframe_id > 5) {
+    return false;
+  }
 
-    // Collect subframes in map and parse when we have all the parts
-    kaitai::kstream stream(subframe_data);
-    gps_t subframe(&stream);
-    int subframe_id = subframe.how()->subframe_id();
-
-    if (subframe_id == 1) gps_subframes[msg->sv_id()].clear();
-    gps_subframes[msg->sv_id()][subframe_id] = subframe_data;
-
-    if (gps_subframes[msg->sv_id()].size() == 5) {
-      MessageBuilder msg_builder;
-      auto eph = msg_builder.initEvent().initUbloxGnss().initEphemeris();
-      eph.setSvId(msg->sv_id());
-
-      // Subframe 1
-      {
-        kaitai::kstream stream(gps_subframes[msg->sv_id()][1]);
-        gps_t subframe(&stream);
-        gps_t::subframe_1_t* subframe_1 = static_cast<gps_t::subframe_1_t*>(subframe.body());
-
-        eph.setGpsWeek(subframe_1->week_no());
-        eph.setTgd(subframe_1->t_gd() * pow(2, -31));
-        eph.setToc(subframe_1->t_oc() * pow(2, 4));
-        eph.setAf2(subframe_1->af_2() * pow(2, -55));
-        eph.setAf1(subframe_1->af_1() * pow(2, -43));
-        eph.setAf0(subframe_1->af_0() * pow(2, -31));
-      }
+  // Collect subframes and parse when we have all the parts
+  GpsSubframes &sv = gps_subframes[sv_id];
+  if (subframe_id == 1) sv.received = 0;
+  memcpy(sv.words[subframe_id - 1], words, sizeof(words));
+  sv.received |= 1 << subframe_id;
+  if (sv.received != 0b111110) {
+    return false;
+  }
 
-      // Subframe 2
-      {
-        kaitai::kstream stream(gps_subframes[msg->sv_id()][2]);
-        gps_t subframe(&stream);
-        gps_t::subframe_2_t* subframe_2 = static_cast<gps_t::subframe_2_t*>(subframe.body());
-
-        eph.setCrs(subframe_2->c_rs() * pow(2, -5));
-        eph.setDeltaN(subframe_2->delta_n() * pow(2, -43) * gpsPi);
-        eph.setM0(subframe_2->m_0() * pow(2, -31) * gpsPi);
-        eph.setCuc(subframe_2->c_uc() * pow(2, -29));
-        eph.setEcc(subframe_2->e() * pow(2, -33));
-        eph.setCus(subframe_2->c_us() * pow(2, -29));
-        eph.setA(pow(subframe_2->sqrt_a() * pow(2, -19), 2.0));
-        eph.setToe(subframe_2->t_oe() * pow(2, 4));
-      }
+  auto eph = msg.initEvent().initUbloxGnss().initEphemeris();
+  eph.setSvId(sv_id);
+
+  // Subframe 1
+  {
+    const uint32_t *w = sv.words[0];
+    eph.setGpsWeek(gps_bits(w, 48, 10));
+    eph.setTgd(gps_sbits(w, 160, 8) * pow(2, -31));
+    eph.setToc(gps_bits(w, 176, 16) * pow(2, 4));
+    eph.setAf2(gps_sbits(w, 192, 8) * pow(2, -55));
+    eph.setAf1(gps_sbits(w, 200, 16) * pow(2, -43));
+    eph.setAf0(gps_sbits(w, 216, 22) * pow(2, -31));
+  }
 
-      // Subframe 3
-      {
-        kaitai::kstream stream(gps_subframes[msg->sv_id()][3]);
-        gps_t subframe(&stream);
-        gps_t::subframe_3_t* subframe_3 = static_cast<gps_t::subframe_3_t*>(subframe.body());
-
-        eph.setCic(subframe_3->c_ic() * pow(2, -29));
-        eph.setOmega0(subframe_3->omega_0() * pow(2, -31) * gpsPi);
-        eph.setCis(subframe_3->c_is() * pow(2, -29));
-        eph.setI0(subframe_3->i_0() * pow(2, -31) * gpsPi);
-        eph.setCrc(subframe_3->c_rc() * pow(2, -5));
-        eph.setOmega(subframe_3->omega() * pow(2, -31) * gpsPi);
-        eph.setOmegaDot(subframe_3->omega_dot() * pow(2, -43) * gpsPi);
-        eph.setIode(subframe_3->iode());
-        eph.setIDot(subframe_3->idot() * pow(2, -43) * gpsPi);
-      }
+  // Subframe 2
+  {
+    const uint32_t *w = sv.words[1];
+    eph.setCrs(gps_sbits(w, 56, 16) * pow(2, -5));
+    eph.setDeltaN(gps_sbits(w, 72, 16) * pow(2, -43) * gpsPi);
+    eph.setM0(gps_sbits(w, 88, 32) * pow(2, -31) * gpsPi);
+    eph.setCuc(gps_sbits(w, 120, 16) * pow(2, -29));
+    eph.setEcc(gps_sbits(w, 136, 32) * pow(2, -33));
+    eph.setCus(gps_sbits(w, 168, 16) * pow(2, -29));
+    eph.setA(pow(gps_bits(w, 184, 32) * pow(2, -19), 2.0));
+    eph.setToe(gps_bits(w, 216, 16) * pow(2, 4));
+  }
 
-      // Subframe 4
-      {
-        kaitai::kstream stream(gps_subframes[msg->sv_id()][4]);
-        gps_t subframe(&stream);
-        gps_t::subframe_4_t* subframe_4 = static_cast<gps_t::subframe_4_t*>(subframe.body());
-
-        // This is page 18, why is the page id 56?
-        if (subframe_4->data_id() == 1 && subframe_4->page_id() == 56) {
-          auto iono = static_cast<gps_t::subframe_4_t::ionosphere_data_t*>(subframe_4->body());
-          double a0 = iono->a0() * pow(2, -30);
-          double a1 = iono->a1() * pow(2, -27);
-          double a2 = iono->a2() * pow(2, -24);
-          double a3 = iono->a3() * pow(2, -24);
-          eph.setIonoAlpha({a0, a1, a2, a3});
-
-          double b0 = iono->b0() * pow(2, 11);
-          double b1 = iono->b1() * pow(2, 14);
-          double b2 = iono->b2() * pow(2, 16);
-          double b3 = iono->b3() * pow(2, 16);
-          eph.setIonoBeta({b0, b1, b2, b3});
-        }
-      }
+  // Subframe 3
+  {
+    const uint32_t *w = sv.words[2];
+    eph.setCic(gps_sbits(w, 48, 16) * pow(2, -29));
+    eph.setOmega0(gps_sbits(w, 64, 32) * pow(2, -31) * gpsPi);
+    eph.setCis(gps_sbits(w, 96, 16) * pow(2, -29));
+    eph.setI0(gps_sbits(w, 112, 32) * pow(2, -31) * gpsPi);
+    eph.setCrc(gps_sbits(w, 144, 16) * pow(2, -5));
+    eph.setOmega(gps_sbits(w, 160, 32) * pow(2, -31) * gpsPi);
+    eph.setOmegaDot(gps_sbits(w, 192, 24) * pow(2, -43) * gpsPi);
+    eph.setIode(gps_bits(w, 216, 8));
+    eph.setIDot(gps_sbits(w, 224, 14) * pow(2, -43) * gpsPi);
+  }
 
-      return capnp::messageToFlatArray(msg_builder);
+  // Subframe 4
+  {
+    const uint32_t *w = sv.words[3];
+    // This is page 18, why is the page id 56?
+    if (gps_bits(w, 48, 2) == 1 && gps_bits(w, 50, 6) == 56) {
+      double a0 = gps_sbits(w, 56, 8) * pow(2, -30);
+      double a1 = gps_sbits(w, 64, 8) * pow(2, -27);
+      double a2 = gps_sbits(w, 72, 8) * pow(2, -24);
+      double a3 = gps_sbits(w, 80, 8) * pow(2, -24);
+      eph.setIonoAlpha({a0, a1, a2, a3});
+
+      double b0 = gps_sbits(w, 88, 8) * pow(2, 11);
+      double b1 = gps_sbits(w, 96, 8) * pow(2, 14);
+      double b2 = gps_sbits(w, 104, 8) * pow(2, 16);
+      double b3 = gps_sbits(w, 112, 8) * pow(2, 16);
+      eph.setIonoBeta({b0, b1, b2, b3});
     }
   }
-  return kj::Array<capnp::word>();
+  return true;
 }
 
-kj::Array<capnp::word> UbloxMsgParser::gen_rxm_rawx(ubx_t::rxm_rawx_t *msg) {
-  MessageBuilder msg_builder;
-  auto mr = msg_builder.initEvent().initUbloxGnss().initMeasurementReport();
-  mr.setRcvTow(msg->rcv_tow());
-  mr.setGpsWeek(msg->week());
-  mr.setLeapSeconds(msg->leap_s());
-  mr.setGpsWeek(msg->week());
-
-  auto mb = mr.initMeasurements(msg->num_meas());
-  auto measurements = *msg->measurements();
-  for(int8_t i = 0; i < msg->num_meas(); i++) {
-    mb[i].setSvId(measurements[i]->sv_id());
-    mb[i].setPseudorange(measurements[i]->pr_mes());
-    mb[i].setCarrierCycles(measurements[i]->cp_mes());
-    mb[i].setDoppler(measurements[i]->do_mes());
-    mb[i].setGnssId(measurements[i]->gnss_id());
-    mb[i].setGlonassFrequencyIndex(measurements[i]->freq_id());
-    mb[i].setLocktime(measurements[i]->lock_time());
-    mb[i].setCno(measurements[i]->cno());
-    mb[i].setPseudorangeStdev(0.01 * (pow(2, (measurements[i]->pr_stdev() & 15)))); // weird scaling, might be wrong
-    mb[i].setCarrierPhaseStdev(0.004 * (measurements[i]->cp_stdev() & 15));
-    mb[i].setDopplerStdev(0.002 * (pow(2, (measurements[i]->do_stdev() & 15)))); // weird scaling, might be wrong
+bool UbloxMsgParser::gen_rxm_rawx(const uint8_t *payload, uint16_t len, MessageBuilder &msg) {
+  if (len < 16 || len < 16 + 32 * payload[11]) {
+    LOGE("RXM-RAWX too short: %d", len);
+    return false;
+  }
+  const uint8_t num_meas = payload[11];
+  const uint8_t rec_stat = payload[12];
+
+  auto mr = msg.initEvent().initUbloxGnss().initMeasurementReport();
+  mr.setRcvTow(get<double>(payload, 0));
+  mr.setGpsWeek(get<uint16_t>(payload, 8));
+  mr.setLeapSeconds(get<int8_t>(payload, 10));
+
+  auto mb = mr.initMeasurements(num_meas);
+  for (int i = 0; i < num_meas; i++) {
+    const uint8_t *meas = payload + 16 + 32 * i;
+    mb[i].setSvId(meas[21]);
+    mb[i].setPseudorange(get<double>(meas, 0));
+    mb[i].setCarrierCycles(get<double>(meas, 8));
+    mb[i].setDoppler(get<float>(meas, 16));
+    mb[i].setGnssId(meas[20]);
+    mb[i].setGlonassFrequencyIndex(meas[23]);
+    mb[i].setLocktime(get<uint16_t>(meas, 24));
+    mb[i].setCno(meas[26]);
+    mb[i].setPseudorangeStdev(0.01 * (pow(2, (meas[27] & 15)))); // weird scaling, might be wrong
+    mb[i].setCarrierPhaseStdev(0.004 * (meas[28] & 15));
+    mb[i].setDopplerStdev(0.002 * (pow(2, (meas[29] & 15)))); // weird scaling, might be wrong
 
     auto ts = mb[i].initTrackingStatus();
-    auto trk_stat = measurements[i]->trk_stat();
+    auto trk_stat = meas[30];
     ts.setPseudorangeValid(bit_to_bool(trk_stat, 0));
     ts.setCarrierPhaseValid(bit_to_bool(trk_stat, 1));
     ts.setHalfCycleValid(bit_to_bool(trk_stat, 2));
     ts.setHalfCycleSubtracted(bit_to_bool(trk_stat, 3));
   }
 
-  mr.setNumMeas(msg->num_meas());
+  mr.setNumMeas(num_meas);
   auto rs = mr.initReceiverStatus();
-  rs.setLeapSecValid(bit_to_bool(msg->rec_stat(), 0));
-  rs.setClkReset(bit_to_bool(msg->rec_stat(), 2));
-  return capnp::messageToFlatArray(msg_builder);
+  rs.setLeapSecValid(bit_to_bool(rec_stat, 0));
+  rs.setClkReset(bit_to_bool(rec_stat, 2));
+  return true;
 }
 
-kj::Array<capnp::word> UbloxMsgParser::gen_mon_hw(ubx_t::mon_hw_t *msg) {
-  MessageBuilder msg_builder;
-  auto hwStatus = msg_builder.initEvent().initUbloxGnss().initHwStatus();
-  hwStatus.setNoisePerMS(msg->noise_per_ms());
-  hwStatus.setFlags(msg->flags());
-  hwStatus.setAgcCnt(msg->agc_cnt());
-  hwStatus.setAStatus((cereal::UbloxGnss::HwStatus::AntennaSupervisorState) msg->a_status());
-  hwStatus.setAPower((cereal::UbloxGnss::HwStatus::AntennaPowerStatus) msg->a_power());
-  hwStatus.setJamInd(msg->jam_ind());
-  return capnp::messageToFlatArray(msg_builder);
+bool UbloxMsgParser::gen_mon_hw(const uint8_t *payload, uint16_t len, MessageBuilder &msg) {
+  if (len < 60) {
+    LOGE("MON-HW too short: %d", len);
+    return false;
+  }
+
+  auto hwStatus = msg.initEvent().initUbloxGnss().initHwStatus();
+  hwStatus.setNoisePerMS(get<uint16_t>(payload, 16));
+  hwStatus.setFlags(payload[22]);
+  hwStatus.setAgcCnt(get<uint16_t>(payload, 18));
+  hwStatus.setAStatus((cereal::UbloxGnss::HwStatus::AntennaSupervisorState) payload[20]);
+  hwStatus.setAPower((cereal::UbloxGnss::HwStatus::AntennaPowerStatus) payload[21]);
+  hwStatus.setJamInd(payload[45]);
+  return true;
 }
 
-kj::Array<capnp::word> UbloxMsgParser::gen_mon_hw2(ubx_t::mon_hw2_t *msg) {
-  MessageBuilder msg_builder;
-  auto hwStatus = msg_builder.initEvent().initUbloxGnss().initHwStatus2();
-  hwStatus.setOfsI(msg->ofs_i());
-  hwStatus.setMagI(msg->mag_i());
-  hwStatus.setOfsQ(msg->ofs_q());
-  hwStatus.setMagQ(msg->mag_q());
+bool UbloxMsgParser::gen_mon_hw2(const uint8_t *payload, uint16_t len, MessageBuilder &msg) {
+  if (len < 28) {
+    LOGE("MON-HW2 too short: %d", len);
+    return false;
+  }
+
+  auto hwStatus = msg.initEvent().initUbloxGnss().initHwStatus2();
+  hwStatus.setOfsI(get<int8_t>(payload, 0));
+  hwStatus.setMagI(payload[1]);
+  hwStatus.setOfsQ(get<int8_t>(payload, 2));
+  hwStatus.setMagQ(payload[3]);
 
-  switch (msg->cfg_source()) {
-    case ubx_t::mon_hw2_t::config_source_t::CONFIG_SOURCE_ROM:
+  switch (payload[4]) {
+    case 113:
       hwStatus.setCfgSource(cereal::UbloxGnss::HwStatus2::ConfigSource::ROM);
       break;
-    case ubx_t::mon_hw2_t::config_source_t::CONFIG_SOURCE_OTP:
+    case 111:
       hwStatus.setCfgSource(cereal::UbloxGnss::HwStatus2::ConfigSource::OTP);
       break;
-    case ubx_t::mon_hw2_t::config_source_t::CONFIG_SOURCE_CONFIG_PINS:
+    case 112:
       hwStatus.setCfgSource(cereal::UbloxGnss::HwStatus2::ConfigSource::CONFIGPINS);
       break;
-    case ubx_t::mon_hw2_t::config_source_t::CONFIG_SOURCE_FLASH:
+    case 102:
       hwStatus.setCfgSource(cereal::UbloxGnss::HwStatus2::ConfigSource::FLASH);
       break;
     default:
@@ -336,8 +392,7 @@ kj::Array<capnp::word> UbloxMsgParser::gen_mon_hw2(ubx_t::mon_hw2_t *msg) {
       break;
   }
 
-  hwStatus.setLowLevCfg(msg->low_lev_cfg());
-  hwStatus.setPostStatus(msg->post_status());
-
-  return capnp::messageToFlatArray(msg_builder);
+  hwStatus.setLowLevCfg(get<uint32_t>(payload, 8));
+  hwStatus.setPostStatus(get<uint32_t>(payload, 20));
+  return true;
 }
@@ -2,15 +2,11 @@
 
 #include <cassert>
 #include <cstdint>
-#include <memory>
 #include <string>
-#include <unordered_map>
 #include <ctime>
 
 #include "cereal/messaging/messaging.h"
 #include "selfdrive/common/util.h"
-#include "selfdrive/locationd/generated/gps.h"
-#include "selfdrive/locationd/generated/ubx.h"
 
 using namespace std::string_literals;
 
@@ -21,7 +17,9 @@ namespace ublox {
 
   const int UBLOX_HEADER_SIZE = 6;
   const int UBLOX_CHECKSUM_SIZE = 2;
-  const int UBLOX_MAX_MSG_SIZE = 65536;
+  // longest payload the receiver sends, an RXM-RAWX with all 72 channels of the M8 in use.
+  // anything longer is a corrupt length, waiting for that much data would stall resync
+  const int UBLOX_MAX_PAYLOAD_SIZE = 16 + 32 * 72;
 
   // Boardd still uses these:
   const uint8_t CLASS_NAV = 0x01;
@@ -88,29 +86,58 @@ namespace ublox {
   }
 }
 
+// Frames UBX messages from the receiver byte stream and decodes the known ones
+// straight from the payload into capnp, dispatching on (class, id) through a table.
+// Frames that arrive whole in one chunk are checked and decoded in place, only
+// frames split over chunks are staged in msg_parse_buf.
 class UbloxMsgParser {
   public:
-    bool add_data(const uint8_t *incoming_data, uint32_t incoming_data_len, size_t &bytes_consumed);
-    inline void reset() {bytes_in_parse_buf = 0;}
-    inline int needed_bytes();
-    inline std::string data() {return std::string((const char*)msg_parse_buf, bytes_in_parse_buf);}
-
-    std::pair<std::string, kj::Array<capnp::word>> gen_msg();
-    kj::Array<capnp::word> gen_nav_pvt(ubx_t::nav_pvt_t *msg);
-    kj::Array<capnp::word> gen_rxm_sfrbx(ubx_t::rxm_sfrbx_t *msg);
-    kj::Array<capnp::word> gen_rxm_rawx(ubx_t::rxm_rawx_t *msg);
-    kj::Array<capnp::word> gen_mon_hw(ubx_t::mon_hw_t *msg);
-    kj::Array<capnp::word> gen_mon_hw2(ubx_t::mon_hw2_t *msg);
+    // Consumes bytes up to and including the end of the next valid frame.
+    // When frame_ready() the frame can be decoded with gen_msg() until the next call,
+    // it may point into incoming_data.
+    size_t add_data(const uint8_t *incoming_data, size_t incoming_data_len);
+    inline bool frame_ready() const {return frame_payload != nullptr;}
+
+    // decodes the ready frame into msg, returns the service to send it on or nullptr
+    const char *gen_msg(MessageBuilder &msg);
+
+    bool gen_nav_pvt(const uint8_t *payload, uint16_t len, MessageBuilder &msg);
+    bool gen_rxm_sfrbx(const uint8_t *payload, uint16_t len, MessageBuilder &msg);
+    bool gen_rxm_rawx(const uint8_t *payload, uint16_t len, MessageBuilder &msg);
+    bool gen_mon_hw(const uint8_t *payload, uint16_t len, MessageBuilder &msg);
+    bool gen_mon_hw2(const uint8_t *payload, uint16_t len, MessageBuilder &msg);
+
+    uint64_t frames = 0;
+    uint64_t checksum_errors = 0;
+    uint64_t length_errors = 0;
+    uint64_t unknown = 0;
 
   private:
-    inline bool valid_cheksum();
-    inline bool valid();
-    inline bool valid_so_far();
+    enum class State { SYNC1, SYNC2, HEADER, PAYLOAD, CK_A, CK_B };
 
-    std::unordered_map<int, std::unordered_map<int, std::string>> gps_subframes;
-
-    size_t bytes_in_parse_buf = 0;
-    uint8_t msg_parse_buf[ublox::UBLOX_HEADER_SIZE + ublox::UBLOX_MAX_MSG_SIZE];
+    inline void checksum(uint8_t b) {
+      ck_a += b;
+      ck_b += ck_a;
+    }
+    void frame_done(const uint8_t *payload);
+
+    State state = State::SYNC1;
+    uint8_t header[4];  // class, id, length
+    int header_pos = 0;
+    uint16_t payload_len = 0;
+    uint16_t payload_pos = 0;
+    uint8_t ck_a = 0, ck_b = 0, rcv_ck_a = 0;
+
+    uint8_t msg_class = 0, msg_id = 0;
+    uint16_t frame_len = 0;
+    const uint8_t *frame_payload = nullptr;
+
+    // 24 data bits of the 10 words of GPS subframes 1-5, per satellite
+    struct GpsSubframes {
+      uint32_t words[5][10];
+      uint8_t received = 0;  // bit per subframe id
+    };
+    GpsSubframes gps_subframes[64];
 
+    uint8_t msg_parse_buf[ublox::UBLOX_MAX_PAYLOAD_SIZE];
 };
-
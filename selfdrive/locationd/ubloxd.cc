@@ -1,7 +1,5 @@
 #include <cassert>
 
-#include <kaitai/kaitaistream.h>
-
 #include "cereal/messaging/messaging.h"
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
@@ -40,23 +38,15 @@ int main() {
     size_t len = ubloxRaw.size();
     size_t bytes_consumed = 0;
 
-    while(bytes_consumed < len && !do_exit) {
-      size_t bytes_consumed_this_time = 0U;
-      if(parser.add_data(data + bytes_consumed, (uint32_t)(len - bytes_consumed), bytes_consumed_this_time)) {
-
-        try {
-          auto msg = parser.gen_msg();
-          if (msg.second.size() > 0) {
-            auto bytes = msg.second.asBytes();
-            pm.send(msg.first.c_str(), bytes.begin(), bytes.size());
-          }
-        } catch (const std::exception& e) {
-          LOGE("Error parsing ublox message %s", e.what());
+    while (bytes_consumed < len && !do_exit) {
+      bytes_consumed += parser.add_data(data + bytes_consumed, len - bytes_consumed);
+      if (parser.frame_ready()) {
+        MessageBuilder msg_builder;
+        const char *service = parser.gen_msg(msg_builder);
+        if (service) {
+          pm.send(service, msg_builder);
         }
-
-        parser.reset();
       }
-      bytes_consumed += bytes_consumed_this_time;
     }
     delete msg;
   }
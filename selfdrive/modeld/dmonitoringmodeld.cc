@@ -5,8 +5,10 @@
 #include <cstdlib>
 
 #include "cereal/visionipc/visionipc_client.h"
+#include "selfdrive/common/clutil.h"
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
+#include "selfdrive/hardware/hw.h"
 #include "selfdrive/modeld/models/dmonitoring.h"
 
 ExitHandler do_exit;
@@ -21,7 +23,7 @@ void run_model(DMonitoringModelState &model, VisionIpcClient &vipc_client) {
     if (buf == nullptr) continue;
 
     double t1 = millis_since_boot();
-    DMonitoringResult res = dmonitoring_eval_frame(&model, buf->addr, buf->width, buf->height);
+    DMonitoringResult res = dmonitoring_eval_frame(&model, buf->addr, buf->buf_cl, buf->width, buf->height);
     double t2 = millis_since_boot();
 
     // send dm packet
@@ -35,11 +37,19 @@ void run_model(DMonitoringModelState &model, VisionIpcClient &vipc_client) {
 int main(int argc, char **argv) {
   setpriority(PRIO_PROCESS, 0, -15);
 
+  // cl init, preprocessing runs on the GPU on device
+  cl_device_id device_id = NULL;
+  cl_context context = NULL;
+  if (!Hardware::PC()) {
+    device_id = cl_get_device_id(CL_DEVICE_TYPE_DEFAULT);
+    context = CL_CHECK_ERR(clCreateContext(NULL, 1, &device_id, NULL, NULL, &err));
+  }
+
   // init the models
   DMonitoringModelState model;
-  dmonitoring_init(&model);
+  dmonitoring_init(&model, device_id, context);
 
-  VisionIpcClient vipc_client = VisionIpcClient("camerad", VISION_STREAM_YUV_FRONT, true);
+  VisionIpcClient vipc_client = VisionIpcClient("camerad", VISION_STREAM_YUV_FRONT, true, device_id, context);
   while (!do_exit && !vipc_client.connect(false)) {
     util::sleep_for(100);
   }
@@ -51,5 +61,6 @@ int main(int argc, char **argv) {
   }
 
   dmonitoring_free(&model);
+  if (context != NULL) CL_CHECK(clReleaseContext(context));
   return 0;
 }
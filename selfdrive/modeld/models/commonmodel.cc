@@ -10,34 +10,67 @@
 #include "selfdrive/common/timing.h"
 
 ModelFrame::ModelFrame(cl_device_id device_id, cl_context context) {
-  input_frames = std::make_unique<float[]>(buf_size);
+  input_frames = std::make_unique<float[]>((2 * MODEL_FRAME_HISTORY - 1) * MODEL_FRAME_SIZE);
 
   q = CL_CHECK_ERR(clCreateCommandQueue(context, device_id, 0, &err));
   y_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, MODEL_WIDTH * MODEL_HEIGHT, NULL, &err));
   u_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, (MODEL_WIDTH / 2) * (MODEL_HEIGHT / 2), NULL, &err));
   v_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, (MODEL_WIDTH / 2) * (MODEL_HEIGHT / 2), NULL, &err));
-  net_input_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, MODEL_FRAME_SIZE * sizeof(float), NULL, &err));
+  for (int i = 0; i < MODEL_FRAME_HISTORY; i++) {
+    net_input_cl[i] = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_READ_WRITE, MODEL_FRAME_SIZE * sizeof(float), NULL, &err));
+  }
 
   transform_init(&transform, context, device_id);
   loadyuv_init(&loadyuv, context, device_id, MODEL_WIDTH, MODEL_HEIGHT);
 }
 
-float* ModelFrame::prepare(cl_mem yuv_cl, int frame_width, int frame_height, const mat3 &transform) {
+void ModelFrame::queue(cl_mem yuv_cl, int frame_width, int frame_height, const mat3 &transform) {
+  // the oldest frame's slot is reused, so the net must be done with the previous window
+  wait();
+
+  const int slot = frame_count % MODEL_FRAME_HISTORY;
   transform_queue(&this->transform, q,
                   yuv_cl, frame_width, frame_height,
                   y_cl, u_cl, v_cl, MODEL_WIDTH, MODEL_HEIGHT, transform);
-  loadyuv_queue(&loadyuv, q, y_cl, u_cl, v_cl, net_input_cl);
+  loadyuv_queue(&loadyuv, q, y_cl, u_cl, v_cl, net_input_cl[slot]);
+
+  CL_CHECK(clEnqueueReadBuffer(q, net_input_cl[slot], CL_FALSE, 0, MODEL_FRAME_SIZE * sizeof(float),
+                               &input_frames[slot * MODEL_FRAME_SIZE], 0, nullptr, &read_events[num_read_events++]));
+  if (slot < MODEL_FRAME_HISTORY - 1) {
+    const int mirror = slot + MODEL_FRAME_HISTORY;
+    CL_CHECK(clEnqueueReadBuffer(q, net_input_cl[slot], CL_FALSE, 0, MODEL_FRAME_SIZE * sizeof(float),
+                                 &input_frames[mirror * MODEL_FRAME_SIZE], 0, nullptr, &read_events[num_read_events++]));
+  }
+  CL_CHECK(clFlush(q));
+  frame_count++;
+}
 
-  std::memmove(&input_frames[0], &input_frames[MODEL_FRAME_SIZE], sizeof(float) * MODEL_FRAME_SIZE);
-  clEnqueueReadBuffer(q, net_input_cl, CL_TRUE, 0, MODEL_FRAME_SIZE * sizeof(float), &input_frames[MODEL_FRAME_SIZE], 0, nullptr, nullptr);
-  clFinish(q);
-  return &input_frames[0];
+float* ModelFrame::wait() {
+  if (num_read_events > 0) {
+    CL_CHECK(clWaitForEvents(num_read_events, read_events));
+    for (int i = 0; i < num_read_events; i++) {
+      CL_CHECK(clReleaseEvent(read_events[i]));
+    }
+    num_read_events = 0;
+  }
+
+  // the window ends at the newest frame, which is frame_count - 1
+  const int start = frame_count % MODEL_FRAME_HISTORY;
+  return &input_frames[start * MODEL_FRAME_SIZE];
+}
+
+float* ModelFrame::prepare(cl_mem yuv_cl, int frame_width, int frame_height, const mat3 &transform) {
+  queue(yuv_cl, frame_width, frame_height, transform);
+  return wait();
 }
 
 ModelFrame::~ModelFrame() {
+  wait();
   transform_destroy(&transform);
   loadyuv_destroy(&loadyuv);
-  CL_CHECK(clReleaseMemObject(net_input_cl));
+  for (int i = 0; i < MODEL_FRAME_HISTORY; i++) {
+    CL_CHECK(clReleaseMemObject(net_input_cl[i]));
+  }
   CL_CHECK(clReleaseMemObject(v_cl));
   CL_CHECK(clReleaseMemObject(u_cl));
   CL_CHECK(clReleaseMemObject(y_cl));
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cfloat>
+#include <cstdint>
 #include <cstdlib>
 
 #include <memory>
@@ -20,6 +21,9 @@ constexpr int MODEL_WIDTH = 512;
 constexpr int MODEL_HEIGHT = 256;
 constexpr int MODEL_FRAME_SIZE = MODEL_WIDTH * MODEL_HEIGHT * 3 / 2;
 
+// the net takes the last MODEL_FRAME_HISTORY frames, oldest first
+constexpr int MODEL_FRAME_HISTORY = 2;
+
 const bool send_raw_pred = getenv("SEND_RAW_PRED") != NULL;
 
 void softmax(const float* input, float* output, size_t len);
@@ -30,14 +34,26 @@ class ModelFrame {
  public:
   ModelFrame(cl_device_id device_id, cl_context context);
   ~ModelFrame();
+  // enqueues the warp, loadyuv and readback of a frame without blocking
+  void queue(cl_mem yuv_cl, int width, int height, const mat3& transform);
+  // waits for the last queued frame and returns the contiguous input window
+  float* wait();
   float* prepare(cl_mem yuv_cl, int width, int height, const mat3& transform);
 
-  const int buf_size = MODEL_FRAME_SIZE * 2;
+  const int buf_size = MODEL_FRAME_SIZE * MODEL_FRAME_HISTORY;
 
  private:
   Transform transform;
   LoadYUVState loadyuv;
   cl_command_queue q;
-  cl_mem y_cl, u_cl, v_cl, net_input_cl;
+  cl_mem y_cl, u_cl, v_cl;
+
+  // frames are never shifted. frame n lives in slot n % MODEL_FRAME_HISTORY, and the first
+  // MODEL_FRAME_HISTORY - 1 slots are mirrored past the end of the host buffer so that every
+  // window of MODEL_FRAME_HISTORY frames is contiguous.
+  cl_mem net_input_cl[MODEL_FRAME_HISTORY];
   std::unique_ptr<float[]> input_frames;
+  cl_event read_events[2] = {};
+  int num_read_events = 0;
+  uint64_t frame_count = 0;
 };
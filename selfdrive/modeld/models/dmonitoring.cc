@@ -1,7 +1,6 @@
 #include <cstring>
 
-#include "libyuv.h"
-
+#include "selfdrive/common/clutil.h"
 #include "selfdrive/common/mat.h"
 #include "selfdrive/common/params.h"
 #include "selfdrive/common/timing.h"
@@ -13,10 +12,19 @@
 #define MODEL_HEIGHT 640
 #define FULL_W 852 // should get these numbers from camerad
 
-void dmonitoring_init(DMonitoringModelState* s) {
+constexpr int NET_INPUT_SIZE = (MODEL_WIDTH/2) * (MODEL_HEIGHT/2) * 6; // Y|u|v -> y|y|y|y|u|v
+
+void dmonitoring_init(DMonitoringModelState* s, cl_device_id device_id, cl_context context) {
   s->is_rhd = Params().getBool("IsRHD");
-  for (int x = 0; x < std::size(s->tensor); ++x) {
-    s->tensor[x] = (x - 128.f) * 0.0078125f;
+  s->net_input_buf.resize(NET_INPUT_SIZE);
+
+  s->use_cl = context != NULL;
+  if (s->use_cl) {
+    s->q = CL_CHECK_ERR(clCreateCommandQueue(context, device_id, 0, &err));
+    s->net_input_cl = CL_CHECK_ERR(clCreateBuffer(context, CL_MEM_WRITE_ONLY, NET_INPUT_SIZE * sizeof(float), NULL, &err));
+    dmonitoring_prep_init(&s->prep, context, device_id, MODEL_WIDTH, MODEL_HEIGHT);
+  } else {
+    dmonitoring_prep_cpu_init(&s->cpu_prep, MODEL_WIDTH, MODEL_HEIGHT);
   }
 
 #ifdef USE_ONNX_MODEL
@@ -26,34 +34,8 @@ void dmonitoring_init(DMonitoringModelState* s) {
 #endif
 }
 
-template <class T>
-static inline T *get_buffer(std::vector<T> &buf, const size_t size) {
-  if (buf.size() < size) buf.resize(size);
-  return buf.data();
-}
-
-static inline auto get_yuv_buf(std::vector<uint8_t> &buf, const int width, int height) {
-  uint8_t *y = get_buffer(buf, width * height * 3 / 2);
-  uint8_t *u = y + width * height;
-  uint8_t *v = u + (width /2) * (height / 2);
-  return std::make_tuple(y, u, v);
-}
-
-struct Rect {int x, y, w, h;};
-void crop_yuv(uint8_t *raw, int width, int height, uint8_t *y, uint8_t *u, uint8_t *v, const Rect &rect) {
-  uint8_t *raw_y = raw;
-  uint8_t *raw_u = raw_y + (width * height);
-  uint8_t *raw_v = raw_u + ((width / 2) * (height / 2));
-  for (int r = 0; r < rect.h / 2; r++) {
-    memcpy(y + 2 * r * rect.w, raw_y + (2 * r + rect.y) * width + rect.x, rect.w);
-    memcpy(y + (2 * r + 1) * rect.w, raw_y + (2 * r + rect.y + 1) * width + rect.x, rect.w);
-    memcpy(u + r * (rect.w / 2), raw_u + (r + (rect.y / 2)) * width / 2 + (rect.x / 2), rect.w / 2);
-    memcpy(v + r * (rect.w / 2), raw_v + (r + (rect.y / 2)) * width / 2 + (rect.x / 2), rect.w / 2);
-  }
-}
-
-DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, void* stream_buf, int width, int height) {
-  Rect crop_rect;
+DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, void* stream_buf, cl_mem stream_cl, int width, int height) {
+  DMRect crop_rect;
   if (Hardware::TICI()) {
     const int full_width_tici = 1928;
     const int full_height_tici = 1208;
@@ -77,72 +59,23 @@ DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, void* stream_
     }
   }
 
-  int resized_width = MODEL_WIDTH;
-  int resized_height = MODEL_HEIGHT;
-
-  auto [cropped_y, cropped_u, cropped_v] = get_yuv_buf(s->cropped_buf, crop_rect.w, crop_rect.h);
-  if (!s->is_rhd) {
-    crop_yuv((uint8_t *)stream_buf, width, height, cropped_y, cropped_u, cropped_v, crop_rect);
-  } else {
-    auto [mirror_y, mirror_u, mirror_v] = get_yuv_buf(s->premirror_cropped_buf, crop_rect.w, crop_rect.h);
-    crop_yuv((uint8_t *)stream_buf, width, height, mirror_y, mirror_u, mirror_v, crop_rect);
-    libyuv::I420Mirror(mirror_y, crop_rect.w,
-                       mirror_u, crop_rect.w / 2,
-                       mirror_v, crop_rect.w / 2,
-                       cropped_y, crop_rect.w,
-                       cropped_u, crop_rect.w / 2,
-                       cropped_v, crop_rect.w / 2,
-                       crop_rect.w, crop_rect.h);
-  }
-
-  auto [resized_buf, resized_u, resized_v] = get_yuv_buf(s->resized_buf, resized_width, resized_height);
-  uint8_t *resized_y = resized_buf;
-  libyuv::FilterMode mode = libyuv::FilterModeEnum::kFilterBilinear;
-  if (Hardware::TICI()) {
-    libyuv::I420Scale(cropped_y, crop_rect.w,
-                    cropped_u, crop_rect.w / 2,
-                    cropped_v, crop_rect.w / 2,
-                    crop_rect.w, crop_rect.h,
-                    resized_y, resized_width,
-                    resized_u, resized_width / 2,
-                    resized_v, resized_width / 2,
-                    resized_width, resized_height,
-                    mode);
-  } else {
-    const int source_height = 0.7*resized_height;
-    const int extra_height = (resized_height - source_height) / 2;
-    const int extra_width = (resized_width - source_height / 2) / 2;
+  DMPrepParams params = {width, height, crop_rect, {0, 0, MODEL_WIDTH, MODEL_HEIGHT}, s->is_rhd};
+  if (!Hardware::TICI()) {
+    // the crop is scaled into a vertically centered box on the left, the rest stays black
+    const int source_height = 0.7*MODEL_HEIGHT;
+    const int extra_height = (MODEL_HEIGHT - source_height) / 2;
+    const int extra_width = (MODEL_WIDTH - source_height / 2) / 2;
     const int source_width = source_height / 2 + extra_width;
-    libyuv::I420Scale(cropped_y, crop_rect.w,
-                    cropped_u, crop_rect.w / 2,
-                    cropped_v, crop_rect.w / 2,
-                    crop_rect.w, crop_rect.h,
-                    resized_y + extra_height * resized_width, resized_width,
-                    resized_u + extra_height / 2 * resized_width / 2, resized_width / 2,
-                    resized_v + extra_height / 2 * resized_width / 2, resized_width / 2,
-                    source_width, source_height,
-                    mode);
+    params.dst = {0, extra_height, source_width, source_height};
   }
 
-  int yuv_buf_len = (MODEL_WIDTH/2) * (MODEL_HEIGHT/2) * 6; // Y|u|v -> y|y|y|y|u|v
-  float *net_input_buf = get_buffer(s->net_input_buf, yuv_buf_len);
-  // one shot conversion, O(n) anyway
-  // yuvframe2tensor, normalize
-  for (int r = 0; r < MODEL_HEIGHT/2; r++) {
-    for (int c = 0; c < MODEL_WIDTH/2; c++) {
-      // Y_ul
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (0*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_y[(2*r)*resized_width + 2*c]];
-      // Y_dl
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (1*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_y[(2*r+1)*resized_width + 2*c]];
-      // Y_ur
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (2*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_y[(2*r)*resized_width + 2*c+1]];
-      // Y_dr
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (3*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_y[(2*r+1)*resized_width + 2*c+1]];
-      // U
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (4*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_u[r*resized_width/2 + c]];
-      // V
-      net_input_buf[(r*MODEL_WIDTH/2) + c + (5*(MODEL_WIDTH/2)*(MODEL_HEIGHT/2))] = s->tensor[resized_v[r*resized_width/2 + c]];
-    }
+  // crop, mirror, resize and normalize in one pass over the source
+  float *net_input_buf = s->net_input_buf.data();
+  if (s->use_cl) {
+    dmonitoring_prep_queue(&s->prep, s->q, stream_cl, params, s->net_input_cl);
+    CL_CHECK(clEnqueueReadBuffer(s->q, s->net_input_cl, CL_TRUE, 0, NET_INPUT_SIZE * sizeof(float), net_input_buf, 0, nullptr, nullptr));
+  } else {
+    dmonitoring_prep_cpu(&s->cpu_prep, (const uint8_t *)stream_buf, params, net_input_buf);
   }
 
   //printf("preprocess completed. %d \n", yuv_buf_len);
@@ -159,7 +92,7 @@ DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, void* stream_
   //fclose(dump_yuv_file2);
 
   double t1 = millis_since_boot();
-  s->m->execute(net_input_buf, yuv_buf_len);
+  s->m->execute(net_input_buf, NET_INPUT_SIZE);
   double t2 = millis_since_boot();
 
   DMonitoringResult ret = {0};
@@ -218,4 +151,9 @@ void dmonitoring_publish(PubMaster &pm, uint32_t frame_id, const DMonitoringResu
 
 void dmonitoring_free(DMonitoringModelState* s) {
   delete s->m;
+  if (s->use_cl) {
+    dmonitoring_prep_destroy(&s->prep);
+    CL_CHECK(clReleaseMemObject(s->net_input_cl));
+    CL_CHECK(clReleaseCommandQueue(s->q));
+  }
 }
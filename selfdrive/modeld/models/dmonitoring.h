@@ -6,6 +6,7 @@
 #include "selfdrive/common/util.h"
 #include "selfdrive/modeld/models/commonmodel.h"
 #include "selfdrive/modeld/runners/run.h"
+#include "selfdrive/modeld/transforms/dmonitoring_prep.h"
 
 #define OUTPUT_SIZE 39
 
@@ -32,15 +33,18 @@ typedef struct DMonitoringModelState {
   RunModel *m;
   bool is_rhd;
   float output[OUTPUT_SIZE];
-  std::vector<uint8_t> resized_buf;
-  std::vector<uint8_t> cropped_buf;
-  std::vector<uint8_t> premirror_cropped_buf;
   std::vector<float> net_input_buf;
-  float tensor[UINT8_MAX + 1];
+
+  // preprocessing runs on the GPU when a CL context is given, otherwise on the CPU
+  bool use_cl;
+  DMPrepCPUState cpu_prep;
+  DMPrepState prep;
+  cl_command_queue q;
+  cl_mem net_input_cl;
 } DMonitoringModelState;
 
-void dmonitoring_init(DMonitoringModelState* s);
-DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, void* stream_buf, int width, int height);
+void dmonitoring_init(DMonitoringModelState* s, cl_device_id device_id, cl_context context);
+DMonitoringResult dmonitoring_eval_frame(DMonitoringModelState* s, void* stream_buf, cl_mem stream_cl, int width, int height);
 void dmonitoring_publish(PubMaster &pm, uint32_t frame_id, const DMonitoringResult &res, float execution_time, kj::ArrayPtr<const float> raw_pred);
 void dmonitoring_free(DMonitoringModelState* s);
 
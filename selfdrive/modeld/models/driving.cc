@@ -3,7 +3,11 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
 #include <cstring>
 
 #include <eigen3/Eigen/Dense>
@@ -12,49 +16,6 @@
 #include "selfdrive/common/params.h"
 #include "selfdrive/common/timing.h"
 
-constexpr int DESIRE_PRED_SIZE = 32;
-constexpr int OTHER_META_SIZE = 48;
-constexpr int NUM_META_INTERVALS = 5;
-constexpr int META_STRIDE = 7;
-
-constexpr int PLAN_MHP_N = 5;
-constexpr int PLAN_MHP_COLUMNS = 15;
-constexpr int PLAN_MHP_VALS = 15*33;
-constexpr int PLAN_MHP_SELECTION = 1;
-constexpr int PLAN_MHP_GROUP_SIZE =  (2*PLAN_MHP_VALS + PLAN_MHP_SELECTION);
-
-constexpr int LEAD_MHP_N = 2;
-constexpr int LEAD_TRAJ_LEN = 6;
-constexpr int LEAD_PRED_DIM = 4;
-constexpr int LEAD_MHP_VALS = LEAD_PRED_DIM*LEAD_TRAJ_LEN;
-constexpr int LEAD_MHP_SELECTION = 3;
-constexpr int LEAD_MHP_GROUP_SIZE = (2*LEAD_MHP_VALS + LEAD_MHP_SELECTION);
-
-constexpr int POSE_SIZE = 12;
-
-constexpr int PLAN_IDX = 0;
-constexpr int LL_IDX = PLAN_IDX + PLAN_MHP_N*PLAN_MHP_GROUP_SIZE;
-constexpr int LL_PROB_IDX = LL_IDX + 4*2*2*33;
-constexpr int RE_IDX = LL_PROB_IDX + 8;
-constexpr int LEAD_IDX = RE_IDX + 2*2*2*33;
-constexpr int LEAD_PROB_IDX = LEAD_IDX + LEAD_MHP_N*(LEAD_MHP_GROUP_SIZE);
-constexpr int DESIRE_STATE_IDX = LEAD_PROB_IDX + 3;
-constexpr int META_IDX = DESIRE_STATE_IDX + DESIRE_LEN;
-constexpr int POSE_IDX = META_IDX + OTHER_META_SIZE + DESIRE_PRED_SIZE;
-constexpr int OUTPUT_SIZE =  POSE_IDX + POSE_SIZE;
-#ifdef TEMPORAL
-  constexpr int TEMPORAL_SIZE = 512;
-#else
-  constexpr int TEMPORAL_SIZE = 0;
-#endif
-
-constexpr float FCW_THRESHOLD_5MS2_HIGH = 0.15;
-constexpr float FCW_THRESHOLD_5MS2_LOW = 0.05;
-constexpr float FCW_THRESHOLD_3MS2 = 0.7;
-
-float prev_brake_5ms2_probs[5] = {0,0,0,0,0};
-float prev_brake_3ms2_probs[3] = {0,0,0};
-
 // #define DUMP_YUV
 
 void model_init(ModelState* s, cl_device_id device_id, cl_context context) {
@@ -88,6 +49,9 @@ void model_init(ModelState* s, cl_device_id device_id, cl_context context) {
 
 ModelDataRaw model_eval_frame(ModelState* s, cl_mem yuv_cl, int width, int height,
                            const mat3 &transform, float *desire_in) {
+  // kick off the warp and readback first so the GPU works while the inputs are set up
+  s->frame->queue(yuv_cl, width, height, transform);
+
 #ifdef DESIRE
   if (desire_in != NULL) {
     for (int i = 1; i < DESIRE_LEN; i++) {
@@ -105,7 +69,7 @@ ModelDataRaw model_eval_frame(ModelState* s, cl_mem yuv_cl, int width, int heigh
 
   //for (int i = 0; i < OUTPUT_SIZE + TEMPORAL_SIZE; i++) { printf("%f ", s->output[i]); } printf("\n");
 
-  auto net_input_buf = s->frame->prepare(yuv_cl, width, height, transform);
+  auto net_input_buf = s->frame->wait();
   s->m->execute(net_input_buf, s->frame->buf_size);
 
   // net outputs
@@ -118,6 +82,9 @@ ModelDataRaw model_eval_frame(ModelState* s, cl_mem yuv_cl, int width, int heigh
   net_outputs.lead_prob = &s->output[LEAD_PROB_IDX];
   net_outputs.meta = &s->output[DESIRE_STATE_IDX];
   net_outputs.pose = &s->output[POSE_IDX];
+
+  model_parse_outputs(&s->output[0], s->outputs);
+  net_outputs.outputs = &s->outputs;
   return net_outputs;
 }
 
@@ -136,147 +103,120 @@ static const float *get_best_data(const float *data, int size, int group_size, i
   return &data[max_idx * group_size];
 }
 
-static const float *get_plan_data(float *plan) {
-  return get_best_data(plan, PLAN_MHP_N, PLAN_MHP_GROUP_SIZE, -1);
-}
+// ***** output layout *****
 
-static const float *get_lead_data(const float *lead, int t_offset) {
-  return get_best_data(lead, LEAD_MHP_N, LEAD_MHP_GROUP_SIZE, t_offset - LEAD_MHP_SELECTION);
-}
+enum OutputTransform { OUT_NONE, OUT_EXP, OUT_SIGMOID, OUT_SOFTMAX };
 
+// where a field's src offset is counted from. plan and leads are the selected hypotheses
+enum OutputBase { BASE_RAW, BASE_PLAN, BASE_LEAD, BASE_COUNT = BASE_LEAD + LEAD_MHP_SELECTION };
 
-void fill_sigmoid(const float *input, float *output, int len, int stride) {
-  for (int i=0; i<len; i++) {
-    output[i] = sigmoid(input[i*stride]);
-  }
-}
+struct OutputField {
+  int base;
+  int src;
+  int stride;
+  int len;
+  OutputTransform transform;
+  size_t dst;  // byte offset into ModelOutputs
+};
 
-void fill_lead_v3(cereal::ModelDataV2::LeadDataV3::Builder lead, const float *lead_data, const float *prob, int t_offset, float prob_t) {
-  float t[LEAD_TRAJ_LEN] = {0.0, 2.0, 4.0, 6.0, 8.0, 10.0};
-  const float *data = get_lead_data(lead_data, t_offset);
-  lead.setProb(sigmoid(prob[t_offset]));
-  lead.setProbTime(prob_t);
-  float x_arr[LEAD_TRAJ_LEN];
-  float y_arr[LEAD_TRAJ_LEN];
-  float v_arr[LEAD_TRAJ_LEN];
-  float a_arr[LEAD_TRAJ_LEN];
-  float x_stds_arr[LEAD_TRAJ_LEN];
-  float y_stds_arr[LEAD_TRAJ_LEN];
-  float v_stds_arr[LEAD_TRAJ_LEN];
-  float a_stds_arr[LEAD_TRAJ_LEN];
-  for (int i=0; i<LEAD_TRAJ_LEN; i++) {
-    x_arr[i] = data[i*LEAD_PRED_DIM+0];
-    y_arr[i] = data[i*LEAD_PRED_DIM+1];
-    v_arr[i] = data[i*LEAD_PRED_DIM+2];
-    a_arr[i] = data[i*LEAD_PRED_DIM+3];
-    x_stds_arr[i] = exp(data[LEAD_MHP_VALS + i*LEAD_PRED_DIM+0]);
-    y_stds_arr[i] = exp(data[LEAD_MHP_VALS + i*LEAD_PRED_DIM+1]);
-    v_stds_arr[i] = exp(data[LEAD_MHP_VALS + i*LEAD_PRED_DIM+2]);
-    a_stds_arr[i] = exp(data[LEAD_MHP_VALS + i*LEAD_PRED_DIM+3]);
-  }
-  lead.setT(t);
-  lead.setX(x_arr);
-  lead.setY(y_arr);
-  lead.setV(v_arr);
-  lead.setA(a_arr);
-  lead.setXStd(x_stds_arr);
-  lead.setYStd(y_stds_arr);
-  lead.setVStd(v_stds_arr);
-  lead.setAStd(a_stds_arr);
-}
+#define OUT_OFFSET(member) offsetof(ModelOutputs, member)
+constexpr size_t TRAJ_BYTES = TRAJECTORY_SIZE * sizeof(float);
+constexpr size_t LEAD_BYTES = LEAD_TRAJ_LEN * sizeof(float);
 
-void fill_meta(cereal::ModelDataV2::MetaData::Builder meta, const float *meta_data) {
-  float desire_state_softmax[DESIRE_LEN];
-  float desire_pred_softmax[4*DESIRE_LEN];
-  softmax(&meta_data[0], desire_state_softmax, DESIRE_LEN);
-  for (int i=0; i<4; i++) {
-    softmax(&meta_data[DESIRE_LEN + OTHER_META_SIZE + i*DESIRE_LEN],
-            &desire_pred_softmax[i*DESIRE_LEN], DESIRE_LEN);
-  }
+constexpr int OUTPUT_LAYOUT_SIZE = 5*3 + 4*2 + 2 + 2*2 + 1 + 1 + 4 + 1 + 6 + LEAD_MHP_SELECTION*(1 + 2*LEAD_PRED_DIM) + 4;
 
-  float gas_disengage_sigmoid[NUM_META_INTERVALS];
-  float brake_disengage_sigmoid[NUM_META_INTERVALS];
-  float steer_override_sigmoid[NUM_META_INTERVALS];
-  float brake_3ms2_sigmoid[NUM_META_INTERVALS];
-  float brake_4ms2_sigmoid[NUM_META_INTERVALS];
-  float brake_5ms2_sigmoid[NUM_META_INTERVALS];
-
-  fill_sigmoid(&meta_data[DESIRE_LEN+1], gas_disengage_sigmoid, NUM_META_INTERVALS, META_STRIDE);
-  fill_sigmoid(&meta_data[DESIRE_LEN+2], brake_disengage_sigmoid, NUM_META_INTERVALS, META_STRIDE);
-  fill_sigmoid(&meta_data[DESIRE_LEN+3], steer_override_sigmoid, NUM_META_INTERVALS, META_STRIDE);
-  fill_sigmoid(&meta_data[DESIRE_LEN+4], brake_3ms2_sigmoid, NUM_META_INTERVALS, META_STRIDE);
-  fill_sigmoid(&meta_data[DESIRE_LEN+5], brake_4ms2_sigmoid, NUM_META_INTERVALS, META_STRIDE);
-  fill_sigmoid(&meta_data[DESIRE_LEN+6], brake_5ms2_sigmoid, NUM_META_INTERVALS, META_STRIDE);
-
-  std::memmove(prev_brake_5ms2_probs, &prev_brake_5ms2_probs[1], 4*sizeof(float));
-  std::memmove(prev_brake_3ms2_probs, &prev_brake_3ms2_probs[1], 2*sizeof(float));
-  prev_brake_5ms2_probs[4] = brake_5ms2_sigmoid[0];
-  prev_brake_3ms2_probs[2] = brake_3ms2_sigmoid[0];
+constexpr std::array<OutputField, OUTPUT_LAYOUT_SIZE> make_output_layout() {
+  std::array<OutputField, OUTPUT_LAYOUT_SIZE> l = {};
+  int n = 0;
 
-  bool above_fcw_threshold = true;
-  for (int i=0; i<5; i++) {
-    float threshold = i < 2 ? FCW_THRESHOLD_5MS2_LOW : FCW_THRESHOLD_5MS2_HIGH;
-    above_fcw_threshold = above_fcw_threshold && prev_brake_5ms2_probs[i] > threshold;
+  // plan
+  for (int i = 0; i < 3; i++) {
+    l[n++] = {BASE_PLAN, 0 + i, PLAN_MHP_COLUMNS, TRAJECTORY_SIZE, OUT_NONE, OUT_OFFSET(position) + i*TRAJ_BYTES};
+    l[n++] = {BASE_PLAN, PLAN_MHP_COLUMNS*TRAJECTORY_SIZE + i, PLAN_MHP_COLUMNS, TRAJECTORY_SIZE, OUT_NONE, OUT_OFFSET(position_std) + i*TRAJ_BYTES};
+    l[n++] = {BASE_PLAN, 3 + i, PLAN_MHP_COLUMNS, TRAJECTORY_SIZE, OUT_NONE, OUT_OFFSET(velocity) + i*TRAJ_BYTES};
+    l[n++] = {BASE_PLAN, 9 + i, PLAN_MHP_COLUMNS, TRAJECTORY_SIZE, OUT_NONE, OUT_OFFSET(orientation) + i*TRAJ_BYTES};
+    l[n++] = {BASE_PLAN, 12 + i, PLAN_MHP_COLUMNS, TRAJECTORY_SIZE, OUT_NONE, OUT_OFFSET(orientation_rate) + i*TRAJ_BYTES};
   }
-  for (int i=0; i<3; i++) {
-    above_fcw_threshold = above_fcw_threshold && prev_brake_3ms2_probs[i] > FCW_THRESHOLD_3MS2;
+
+  // lane lines and road edges, y then z, stds of the first point only
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 2; j++) {
+      l[n++] = {BASE_RAW, LL_IDX + i*TRAJECTORY_SIZE*2 + j, 2, TRAJECTORY_SIZE, OUT_NONE, OUT_OFFSET(lane_lines) + (i*2 + j)*TRAJ_BYTES};
+    }
   }
+  l[n++] = {BASE_RAW, LL_PROB_IDX + 1, 2, 4, OUT_SIGMOID, OUT_OFFSET(lane_line_probs)};
+  l[n++] = {BASE_RAW, LL_IDX + 2*TRAJECTORY_SIZE*4, 2*TRAJECTORY_SIZE, 4, OUT_EXP, OUT_OFFSET(lane_line_stds)};
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 2; j++) {
+      l[n++] = {BASE_RAW, RE_IDX + i*TRAJECTORY_SIZE*2 + j, 2, TRAJECTORY_SIZE, OUT_NONE, OUT_OFFSET(road_edges) + (i*2 + j)*TRAJ_BYTES};
+    }
+  }
+  l[n++] = {BASE_RAW, RE_IDX + 2*TRAJECTORY_SIZE*2, 2*TRAJECTORY_SIZE, 2, OUT_EXP, OUT_OFFSET(road_edge_stds)};
 
-  auto disengage = meta.initDisengagePredictions();
-  disengage.setT({2,4,6,8,10});
-  disengage.setGasDisengageProbs(gas_disengage_sigmoid);
-  disengage.setBrakeDisengageProbs(brake_disengage_sigmoid);
-  disengage.setSteerOverrideProbs(steer_override_sigmoid);
-  disengage.setBrake3MetersPerSecondSquaredProbs(brake_3ms2_sigmoid);
-  disengage.setBrake4MetersPerSecondSquaredProbs(brake_4ms2_sigmoid);
-  disengage.setBrake5MetersPerSecondSquaredProbs(brake_5ms2_sigmoid);
-
-  meta.setEngagedProb(sigmoid(meta_data[DESIRE_LEN]));
-  meta.setDesirePrediction(desire_pred_softmax);
-  meta.setDesireState(desire_state_softmax);
-  meta.setHardBrakePredicted(above_fcw_threshold);
-}
+  // meta
+  l[n++] = {BASE_RAW, DESIRE_STATE_IDX, 1, DESIRE_LEN, OUT_SOFTMAX, OUT_OFFSET(desire_state)};
+  for (int i = 0; i < 4; i++) {
+    l[n++] = {BASE_RAW, DESIRE_STATE_IDX + DESIRE_LEN + OTHER_META_SIZE + i*DESIRE_LEN, 1, DESIRE_LEN, OUT_SOFTMAX,
+              OUT_OFFSET(desire_pred) + i*DESIRE_LEN*sizeof(float)};
+  }
+  l[n++] = {BASE_RAW, DESIRE_STATE_IDX + DESIRE_LEN, 1, 1, OUT_SIGMOID, OUT_OFFSET(engaged_prob)};
+  for (int i = 0; i < 6; i++) {
+    l[n++] = {BASE_RAW, DESIRE_STATE_IDX + DESIRE_LEN + 1 + i, META_STRIDE, NUM_META_INTERVALS, OUT_SIGMOID,
+              OUT_OFFSET(disengage) + i*NUM_META_INTERVALS*sizeof(float)};
+  }
 
-void fill_xyzt(cereal::ModelDataV2::XYZTData::Builder xyzt, const float * data,
-               int columns, int column_offset, float * plan_t_arr, bool fill_std) {
-  float x_arr[TRAJECTORY_SIZE] = {};
-  float y_arr[TRAJECTORY_SIZE] = {};
-  float z_arr[TRAJECTORY_SIZE] = {};
-  float x_std_arr[TRAJECTORY_SIZE];
-  float y_std_arr[TRAJECTORY_SIZE];
-  float z_std_arr[TRAJECTORY_SIZE];
-  float t_arr[TRAJECTORY_SIZE];
-  for (int i=0; i<TRAJECTORY_SIZE; i++) {
-    // column_offset == -1 means this data is X indexed not T indexed
-    if (column_offset >= 0) {
-      t_arr[i] = T_IDXS[i];
-      x_arr[i] = data[i*columns + 0 + column_offset];
-      x_std_arr[i] = data[columns*(TRAJECTORY_SIZE + i) + 0 + column_offset];
-    } else {
-      t_arr[i] = plan_t_arr[i];
-      x_arr[i] = X_IDXS[i];
-      x_std_arr[i] = NAN;
+  // leads
+  for (int t = 0; t < LEAD_MHP_SELECTION; t++) {
+    l[n++] = {BASE_RAW, LEAD_PROB_IDX + t, 1, 1, OUT_SIGMOID, OUT_OFFSET(lead_prob) + t*sizeof(float)};
+    for (int i = 0; i < LEAD_PRED_DIM; i++) {
+      const size_t dst = (t*LEAD_PRED_DIM + i)*LEAD_BYTES;
+      l[n++] = {BASE_LEAD + t, i, LEAD_PRED_DIM, LEAD_TRAJ_LEN, OUT_NONE, OUT_OFFSET(lead) + dst};
+      l[n++] = {BASE_LEAD + t, LEAD_MHP_VALS + i, LEAD_PRED_DIM, LEAD_TRAJ_LEN, OUT_EXP, OUT_OFFSET(lead_std) + dst};
     }
-    y_arr[i] = data[i*columns + 1 + column_offset];
-    y_std_arr[i] = data[columns*(TRAJECTORY_SIZE + i) + 1 + column_offset];
-    z_arr[i] = data[i*columns + 2 + column_offset];
-    z_std_arr[i] = data[columns*(TRAJECTORY_SIZE + i) + 2 + column_offset];
   }
-  xyzt.setX(x_arr);
-  xyzt.setY(y_arr);
-  xyzt.setZ(z_arr);
-  xyzt.setT(t_arr);
-  if (fill_std) {
-    xyzt.setXStd(x_std_arr);
-    xyzt.setYStd(y_std_arr);
-    xyzt.setZStd(z_std_arr);
+
+  // pose
+  l[n++] = {BASE_RAW, POSE_IDX, 1, 3, OUT_NONE, OUT_OFFSET(trans)};
+  l[n++] = {BASE_RAW, POSE_IDX + 3, 1, 3, OUT_NONE, OUT_OFFSET(rot)};
+  l[n++] = {BASE_RAW, POSE_IDX + 6, 1, 3, OUT_EXP, OUT_OFFSET(trans_std)};
+  l[n++] = {BASE_RAW, POSE_IDX + 9, 1, 3, OUT_EXP, OUT_OFFSET(rot_std)};
+  return l;
+}
+
+constexpr auto OUTPUT_LAYOUT = make_output_layout();
+
+static std::array<float, TRAJECTORY_SIZE> to_float_idxs(const double (&idxs)[TRAJECTORY_SIZE]) {
+  std::array<float, TRAJECTORY_SIZE> out;
+  std::copy_n(idxs, TRAJECTORY_SIZE, out.begin());
+  return out;
+}
+
+// filled once at load time, before any thread can parse a frame
+static const std::array<float, TRAJECTORY_SIZE> T_IDXS_FLOAT = to_float_idxs(T_IDXS);
+static const std::array<float, TRAJECTORY_SIZE> X_IDXS_FLOAT = to_float_idxs(X_IDXS);
+static const float LEAD_T[LEAD_TRAJ_LEN] = {0.0, 2.0, 4.0, 6.0, 8.0, 10.0};
+static const float LEAD_T_OFFSETS[LEAD_MHP_SELECTION] = {0.0, 2.0, 4.0};
+static const float META_T[NUM_META_INTERVALS] = {2, 4, 6, 8, 10};
+
+static void apply_field(const OutputField &f, const float *src, float *dst) {
+  switch (f.transform) {
+    case OUT_NONE:
+      for (int i = 0; i < f.len; i++) dst[i] = src[i*f.stride];
+      break;
+    case OUT_EXP:
+      for (int i = 0; i < f.len; i++) dst[i] = expf(src[i*f.stride]);
+      break;
+    case OUT_SIGMOID:
+      for (int i = 0; i < f.len; i++) dst[i] = sigmoid(src[i*f.stride]);
+      break;
+    case OUT_SOFTMAX:
+      assert(f.stride == 1);
+      softmax(src, dst, f.len);
+      break;
   }
 }
 
-void fill_model(cereal::ModelDataV2::Builder &framed, const ModelDataRaw &net_outputs) {
-  // plan
-  const float *best_plan = get_plan_data(net_outputs.plan);
-  float plan_t_arr[TRAJECTORY_SIZE];
+static void fill_plan_t(const float *best_plan, float *plan_t_arr) {
   std::fill_n(plan_t_arr, TRAJECTORY_SIZE, NAN);
   plan_t_arr[0] = 0.0;
   for (int xidx=1, tidx=0; xidx<TRAJECTORY_SIZE; xidx++) {
@@ -296,41 +236,120 @@ void fill_model(cereal::ModelDataV2::Builder &framed, const ModelDataRaw &net_ou
       plan_t_arr[xidx] = p * T_IDXS[tidx+1] + (1 - p) * T_IDXS[tidx];
     }
   }
+}
+
+static bool update_fcw(ModelOutputs &out) {
+  const float *brake_3ms2 = out.disengage[3];
+  const float *brake_5ms2 = out.disengage[5];
+  std::memmove(out.prev_brake_5ms2_probs, &out.prev_brake_5ms2_probs[1], 4*sizeof(float));
+  std::memmove(out.prev_brake_3ms2_probs, &out.prev_brake_3ms2_probs[1], 2*sizeof(float));
+  out.prev_brake_5ms2_probs[4] = brake_5ms2[0];
+  out.prev_brake_3ms2_probs[2] = brake_3ms2[0];
 
-  fill_xyzt(framed.initPosition(), best_plan, PLAN_MHP_COLUMNS, 0, plan_t_arr, true);
-  fill_xyzt(framed.initVelocity(), best_plan, PLAN_MHP_COLUMNS, 3, plan_t_arr, false);
-  fill_xyzt(framed.initOrientation(), best_plan, PLAN_MHP_COLUMNS, 9, plan_t_arr, false);
-  fill_xyzt(framed.initOrientationRate(), best_plan, PLAN_MHP_COLUMNS, 12, plan_t_arr, false);
+  bool above_fcw_threshold = true;
+  for (int i=0; i<5; i++) {
+    float threshold = i < 2 ? FCW_THRESHOLD_5MS2_LOW : FCW_THRESHOLD_5MS2_HIGH;
+    above_fcw_threshold = above_fcw_threshold && out.prev_brake_5ms2_probs[i] > threshold;
+  }
+  for (int i=0; i<3; i++) {
+    above_fcw_threshold = above_fcw_threshold && out.prev_brake_3ms2_probs[i] > FCW_THRESHOLD_3MS2;
+  }
+  return above_fcw_threshold;
+}
+
+void model_parse_outputs(const float *raw, ModelOutputs &out) {
+  const float *bases[BASE_COUNT];
+  bases[BASE_RAW] = raw;
+  bases[BASE_PLAN] = get_best_data(&raw[PLAN_IDX], PLAN_MHP_N, PLAN_MHP_GROUP_SIZE, -1);
+  for (int t = 0; t < LEAD_MHP_SELECTION; t++) {
+    bases[BASE_LEAD + t] = get_best_data(&raw[LEAD_IDX], LEAD_MHP_N, LEAD_MHP_GROUP_SIZE, t - LEAD_MHP_SELECTION);
+  }
+
+  char *dst = (char *)&out;
+  for (const OutputField &f : OUTPUT_LAYOUT) {
+    apply_field(f, bases[f.base] + f.src, (float *)(dst + f.dst));
+  }
+
+  fill_plan_t(bases[BASE_PLAN], out.plan_t);
+  out.hard_brake_predicted = update_fcw(out);
+}
+
+// ***** capnp *****
+
+static inline kj::ArrayPtr<const float> to_kj_array_ptr(const float *data, size_t len) {
+  return kj::ArrayPtr<const float>(data, len);
+}
+
+static void fill_xyzt(cereal::ModelDataV2::XYZTData::Builder xyzt, const float *x, const float *y, const float *z,
+                      const float *t, const float *std = nullptr) {
+  xyzt.setX(to_kj_array_ptr(x, TRAJECTORY_SIZE));
+  xyzt.setY(to_kj_array_ptr(y, TRAJECTORY_SIZE));
+  xyzt.setZ(to_kj_array_ptr(z, TRAJECTORY_SIZE));
+  xyzt.setT(to_kj_array_ptr(t, TRAJECTORY_SIZE));
+  if (std != nullptr) {
+    xyzt.setXStd(to_kj_array_ptr(&std[0], TRAJECTORY_SIZE));
+    xyzt.setYStd(to_kj_array_ptr(&std[TRAJECTORY_SIZE], TRAJECTORY_SIZE));
+    xyzt.setZStd(to_kj_array_ptr(&std[2*TRAJECTORY_SIZE], TRAJECTORY_SIZE));
+  }
+}
+
+static void fill_xyzt(cereal::ModelDataV2::XYZTData::Builder xyzt, const float (&xyz)[3][TRAJECTORY_SIZE], const float *t,
+                      const float (*std)[TRAJECTORY_SIZE] = nullptr) {
+  fill_xyzt(xyzt, xyz[0], xyz[1], xyz[2], t, std != nullptr ? std[0] : nullptr);
+}
+
+void fill_model(cereal::ModelDataV2::Builder &framed, const ModelOutputs &out) {
+  // plan
+  fill_xyzt(framed.initPosition(), out.position, T_IDXS_FLOAT.data(), out.position_std);
+  fill_xyzt(framed.initVelocity(), out.velocity, T_IDXS_FLOAT.data());
+  fill_xyzt(framed.initOrientation(), out.orientation, T_IDXS_FLOAT.data());
+  fill_xyzt(framed.initOrientationRate(), out.orientation_rate, T_IDXS_FLOAT.data());
 
   // lane lines
   auto lane_lines = framed.initLaneLines(4);
-  float lane_line_probs_arr[4];
-  float lane_line_stds_arr[4];
   for (int i = 0; i < 4; i++) {
-    fill_xyzt(lane_lines[i], &net_outputs.lane_lines[i*TRAJECTORY_SIZE*2], 2, -1, plan_t_arr, false);
-    lane_line_probs_arr[i] = sigmoid(net_outputs.lane_lines_prob[i*2+1]);
-    lane_line_stds_arr[i] = exp(net_outputs.lane_lines[2*TRAJECTORY_SIZE*(4 + i)]);
+    fill_xyzt(lane_lines[i], X_IDXS_FLOAT.data(), out.lane_lines[i][0], out.lane_lines[i][1], out.plan_t);
   }
-  framed.setLaneLineProbs(lane_line_probs_arr);
-  framed.setLaneLineStds(lane_line_stds_arr);
+  framed.setLaneLineProbs(out.lane_line_probs);
+  framed.setLaneLineStds(out.lane_line_stds);
 
   // road edges
   auto road_edges = framed.initRoadEdges(2);
-  float road_edge_stds_arr[2];
   for (int i = 0; i < 2; i++) {
-    fill_xyzt(road_edges[i], &net_outputs.road_edges[i*TRAJECTORY_SIZE*2], 2, -1, plan_t_arr, false);
-    road_edge_stds_arr[i] = exp(net_outputs.road_edges[2*TRAJECTORY_SIZE*(2 + i)]);
+    fill_xyzt(road_edges[i], X_IDXS_FLOAT.data(), out.road_edges[i][0], out.road_edges[i][1], out.plan_t);
   }
-  framed.setRoadEdgeStds(road_edge_stds_arr);
+  framed.setRoadEdgeStds(out.road_edge_stds);
 
   // meta
-  fill_meta(framed.initMeta(), net_outputs.meta);
+  auto meta = framed.initMeta();
+  auto disengage = meta.initDisengagePredictions();
+  disengage.setT(META_T);
+  disengage.setGasDisengageProbs(out.disengage[0]);
+  disengage.setBrakeDisengageProbs(out.disengage[1]);
+  disengage.setSteerOverrideProbs(out.disengage[2]);
+  disengage.setBrake3MetersPerSecondSquaredProbs(out.disengage[3]);
+  disengage.setBrake4MetersPerSecondSquaredProbs(out.disengage[4]);
+  disengage.setBrake5MetersPerSecondSquaredProbs(out.disengage[5]);
+  meta.setEngagedProb(out.engaged_prob);
+  meta.setDesirePrediction(to_kj_array_ptr(out.desire_pred[0], 4*DESIRE_LEN));
+  meta.setDesireState(out.desire_state);
+  meta.setHardBrakePredicted(out.hard_brake_predicted);
 
   // leads
   auto leads = framed.initLeadsV3(LEAD_MHP_SELECTION);
-  float t_offsets[LEAD_MHP_SELECTION] = {0.0, 2.0, 4.0};
-  for (int t_offset=0; t_offset<LEAD_MHP_SELECTION; t_offset++) {
-    fill_lead_v3(leads[t_offset], net_outputs.lead, net_outputs.lead_prob, t_offset, t_offsets[t_offset]);
+  for (int t = 0; t < LEAD_MHP_SELECTION; t++) {
+    auto lead = leads[t];
+    lead.setProb(out.lead_prob[t]);
+    lead.setProbTime(LEAD_T_OFFSETS[t]);
+    lead.setT(LEAD_T);
+    lead.setX(out.lead[t][0]);
+    lead.setY(out.lead[t][1]);
+    lead.setV(out.lead[t][2]);
+    lead.setA(out.lead[t][3]);
+    lead.setXStd(out.lead_std[t][0]);
+    lead.setYStd(out.lead_std[t][1]);
+    lead.setVStd(out.lead_std[t][2]);
+    lead.setAStd(out.lead_std[t][3]);
   }
 }
 
@@ -348,31 +367,20 @@ void model_publish(PubMaster &pm, uint32_t vipc_frame_id, uint32_t frame_id, flo
   if (send_raw_pred) {
     framed.setRawPredictions(raw_pred.asBytes());
   }
-  fill_model(framed, net_outputs);
+  fill_model(framed, *net_outputs.outputs);
   pm.send("modelV2", msg);
 }
 
 void posenet_publish(PubMaster &pm, uint32_t vipc_frame_id, uint32_t vipc_dropped_frames,
                      const ModelDataRaw &net_outputs, uint64_t timestamp_eof) {
-  float trans_arr[3];
-  float trans_std_arr[3];
-  float rot_arr[3];
-  float rot_std_arr[3];
-
-  for (int i =0; i < 3; i++) {
-    trans_arr[i] = net_outputs.pose[i];
-    trans_std_arr[i] = exp(net_outputs.pose[6 + i]);
-
-    rot_arr[i] = net_outputs.pose[3 + i];
-    rot_std_arr[i] = exp(net_outputs.pose[9 + i]);
-  }
+  const ModelOutputs &out = *net_outputs.outputs;
 
   MessageBuilder msg;
   auto posenetd = msg.initEvent(vipc_dropped_frames < 1).initCameraOdometry();
-  posenetd.setTrans(trans_arr);
-  posenetd.setRot(rot_arr);
-  posenetd.setTransStd(trans_std_arr);
-  posenetd.setRotStd(rot_std_arr);
+  posenetd.setTrans(out.trans);
+  posenetd.setRot(out.rot);
+  posenetd.setTransStd(out.trans_std);
+  posenetd.setRotStd(out.rot_std);
 
   posenetd.setTimestampEof(timestamp_eof);
   posenetd.setFrameId(vipc_frame_id);
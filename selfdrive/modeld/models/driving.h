@@ -18,6 +18,80 @@ constexpr int DESIRE_LEN = 8;
 constexpr int TRAFFIC_CONVENTION_LEN = 2;
 constexpr int MODEL_FREQ = 20;
 
+constexpr int DESIRE_PRED_SIZE = 32;
+constexpr int OTHER_META_SIZE = 48;
+constexpr int NUM_META_INTERVALS = 5;
+constexpr int META_STRIDE = 7;
+
+constexpr int PLAN_MHP_N = 5;
+constexpr int PLAN_MHP_COLUMNS = 15;
+constexpr int PLAN_MHP_VALS = 15*33;
+constexpr int PLAN_MHP_SELECTION = 1;
+constexpr int PLAN_MHP_GROUP_SIZE =  (2*PLAN_MHP_VALS + PLAN_MHP_SELECTION);
+
+constexpr int LEAD_MHP_N = 2;
+constexpr int LEAD_TRAJ_LEN = 6;
+constexpr int LEAD_PRED_DIM = 4;
+constexpr int LEAD_MHP_VALS = LEAD_PRED_DIM*LEAD_TRAJ_LEN;
+constexpr int LEAD_MHP_SELECTION = 3;
+constexpr int LEAD_MHP_GROUP_SIZE = (2*LEAD_MHP_VALS + LEAD_MHP_SELECTION);
+
+constexpr int POSE_SIZE = 12;
+
+constexpr int PLAN_IDX = 0;
+constexpr int LL_IDX = PLAN_IDX + PLAN_MHP_N*PLAN_MHP_GROUP_SIZE;
+constexpr int LL_PROB_IDX = LL_IDX + 4*2*2*33;
+constexpr int RE_IDX = LL_PROB_IDX + 8;
+constexpr int LEAD_IDX = RE_IDX + 2*2*2*33;
+constexpr int LEAD_PROB_IDX = LEAD_IDX + LEAD_MHP_N*(LEAD_MHP_GROUP_SIZE);
+constexpr int DESIRE_STATE_IDX = LEAD_PROB_IDX + 3;
+constexpr int META_IDX = DESIRE_STATE_IDX + DESIRE_LEN;
+constexpr int POSE_IDX = META_IDX + OTHER_META_SIZE + DESIRE_PRED_SIZE;
+constexpr int OUTPUT_SIZE =  POSE_IDX + POSE_SIZE;
+#ifdef TEMPORAL
+  constexpr int TEMPORAL_SIZE = 512;
+#else
+  constexpr int TEMPORAL_SIZE = 0;
+#endif
+
+constexpr float FCW_THRESHOLD_5MS2_HIGH = 0.15;
+constexpr float FCW_THRESHOLD_5MS2_LOW = 0.05;
+constexpr float FCW_THRESHOLD_3MS2 = 0.7;
+
+// net outputs after their transforms, rebuilt in place every frame from OUTPUT_LAYOUT in driving.cc
+struct ModelOutputs {
+  float plan_t[TRAJECTORY_SIZE];
+  float position[3][TRAJECTORY_SIZE];
+  float position_std[3][TRAJECTORY_SIZE];
+  float velocity[3][TRAJECTORY_SIZE];
+  float orientation[3][TRAJECTORY_SIZE];
+  float orientation_rate[3][TRAJECTORY_SIZE];
+
+  // y and z, x is X_IDXS
+  float lane_lines[4][2][TRAJECTORY_SIZE];
+  float lane_line_probs[4];
+  float lane_line_stds[4];
+  float road_edges[2][2][TRAJECTORY_SIZE];
+  float road_edge_stds[2];
+
+  float desire_state[DESIRE_LEN];
+  float desire_pred[4][DESIRE_LEN];
+  float engaged_prob;
+  // gas, brake, steer override, brake 3, 4 and 5 m/s^2
+  float disengage[6][NUM_META_INTERVALS];
+  bool hard_brake_predicted;
+
+  float lead_prob[LEAD_MHP_SELECTION];
+  float lead[LEAD_MHP_SELECTION][LEAD_PRED_DIM][LEAD_TRAJ_LEN];
+  float lead_std[LEAD_MHP_SELECTION][LEAD_PRED_DIM][LEAD_TRAJ_LEN];
+
+  float trans[3], rot[3], trans_std[3], rot_std[3];
+
+  // fcw history, oldest first
+  float prev_brake_5ms2_probs[5];
+  float prev_brake_3ms2_probs[3];
+};
+
 struct ModelDataRaw {
   float *plan;
   float *lane_lines;
@@ -29,12 +103,14 @@ struct ModelDataRaw {
   float *meta;
   float *desire_pred;
   float *pose;
+  const ModelOutputs *outputs;
 };
 
 typedef struct ModelState {
   ModelFrame *frame;
   std::vector<float> output;
   std::unique_ptr<RunModel> m;
+  ModelOutputs outputs = {};
 #ifdef DESIRE
   float prev_desire[DESIRE_LEN] = {};
   float pulse_desire[DESIRE_LEN] = {};
@@ -49,6 +125,8 @@ ModelDataRaw model_eval_frame(ModelState* s, cl_mem yuv_cl, int width, int heigh
                            const mat3 &transform, float *desire_in);
 void model_free(ModelState* s);
 void poly_fit(float *in_pts, float *in_stds, float *out);
+void model_parse_outputs(const float *raw, ModelOutputs &out);
+void fill_model(cereal::ModelDataV2::Builder &framed, const ModelOutputs &out);
 void model_publish(PubMaster &pm, uint32_t vipc_frame_id, uint32_t frame_id, float frame_drop,
                    const ModelDataRaw &net_outputs, uint64_t timestamp_eof,
                    float model_execution_time, kj::ArrayPtr<const float> raw_pred);
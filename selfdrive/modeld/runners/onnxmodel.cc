@@ -14,6 +14,92 @@
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
 
+#ifdef USE_ONNXRUNTIME
+
+#define NET_INPUT_IDX 0
+#define DESIRE_IDX 1
+#define TRAFFIC_CONVENTION_IDX 2
+#define RECURRENT_IDX 3
+
+ONNXModel::ONNXModel(const char *path, float *_output, size_t _output_size, int runtime)
+  : env(ORT_LOGGING_LEVEL_WARNING, "modeld"),
+    memory_info(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)) {
+  LOGD("loading model %s", path);
+
+  output = _output;
+  output_size = _output_size;
+
+  Ort::SessionOptions options;
+  const char *threads = getenv("ONNX_THREADS");
+  options.SetIntraOpNumThreads(threads != NULL ? atoi(threads) : 4);
+  options.SetInterOpNumThreads(1);
+  options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+  options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+  session = std::make_unique<Ort::Session>(env, path, options);
+  binding = std::make_unique<Ort::IoBinding>(*session);
+
+  Ort::AllocatorWithDefaultOptions allocator;
+  for (size_t i = 0; i < session->GetInputCount(); i++) {
+    Input in;
+    in.name = session->GetInputNameAllocated(i, allocator).get();
+    in.shape = session->GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape();
+    in.size = 1;
+    for (auto &d : in.shape) {
+      // dynamic batch dimension
+      if (d < 0) d = 1;
+      in.size *= d;
+    }
+    LOGD("onnx input %zu: %s size %zu", i, in.name.c_str(), in.size);
+    inputs.push_back(in);
+  }
+
+  // outputs are written back to back into the caller's buffer, no copy after run
+  size_t offset = 0;
+  for (size_t i = 0; i < session->GetOutputCount(); i++) {
+    std::string name = session->GetOutputNameAllocated(i, allocator).get();
+    std::vector<int64_t> shape = session->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape();
+    size_t size = 1;
+    for (auto &d : shape) {
+      if (d < 0) d = 1;
+      size *= d;
+    }
+    assert(offset + size <= output_size);
+    Ort::Value tensor = Ort::Value::CreateTensor<float>(memory_info, &output[offset], size, shape.data(), shape.size());
+    binding->BindOutput(name.c_str(), tensor);
+    offset += size;
+  }
+  assert(offset == output_size);
+}
+
+void ONNXModel::bindInput(int idx, float *buf, int size) {
+  assert(idx < inputs.size());
+  Input &in = inputs[idx];
+  assert(size == in.size);
+  // wraps the caller's buffer, ORT reads it in place
+  Ort::Value tensor = Ort::Value::CreateTensor<float>(memory_info, buf, in.size, in.shape.data(), in.shape.size());
+  binding->BindInput(in.name.c_str(), tensor);
+}
+
+void ONNXModel::addRecurrent(float *state, int state_size) {
+  bindInput(RECURRENT_IDX, state, state_size);
+}
+
+void ONNXModel::addDesire(float *state, int state_size) {
+  bindInput(DESIRE_IDX, state, state_size);
+}
+
+void ONNXModel::addTrafficConvention(float *state, int state_size) {
+  bindInput(TRAFFIC_CONVENTION_IDX, state, state_size);
+}
+
+void ONNXModel::execute(float *net_input_buf, int buf_size) {
+  // the image window moves every frame, the other inputs stay bound
+  bindInput(NET_INPUT_IDX, net_input_buf, buf_size);
+  session->Run(Ort::RunOptions{nullptr}, *binding);
+}
+
+#else
+
 ONNXModel::ONNXModel(const char *path, float *_output, size_t _output_size, int runtime) {
   LOGD("loading model %s", path);
 
@@ -114,3 +200,4 @@ void ONNXModel::execute(float *net_input_buf, int buf_size) {
   pread(output, output_size);
 }
 
+#endif
@@ -2,22 +2,49 @@
 
 #include <cstdlib>
 
+#ifdef USE_ONNXRUNTIME
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <onnxruntime_cxx_api.h>
+#endif
+
 #include "selfdrive/modeld/runners/runmodel.h"
 
+// Runs the model in-process with ONNX Runtime when it's vendored in phonelibs/onnxruntime
+// (see build.sh there), otherwise through onnx_runner.py over pipes.
 class ONNXModel : public RunModel {
 public:
   ONNXModel(const char *path, float *output, size_t output_size, int runtime);
+#ifndef USE_ONNXRUNTIME
 	~ONNXModel();
+#endif
   void addRecurrent(float *state, int state_size);
   void addDesire(float *state, int state_size);
   void addTrafficConvention(float *state, int state_size);
   void execute(float *net_input_buf, int buf_size);
 private:
-  int proc_pid;
-
   float *output;
   size_t output_size;
 
+#ifdef USE_ONNXRUNTIME
+  Ort::Env env;
+  std::unique_ptr<Ort::Session> session;
+  Ort::MemoryInfo memory_info;
+  std::unique_ptr<Ort::IoBinding> binding;
+
+  // model inputs in declaration order: image, desire, traffic convention, recurrent state
+  struct Input {
+    std::string name;
+    std::vector<int64_t> shape;
+    size_t size;
+  };
+  std::vector<Input> inputs;
+  void bindInput(int idx, float *buf, int size);
+#else
+  int proc_pid;
+
   float *rnn_input_buf = NULL;
   int rnn_state_size;
   float *desire_input_buf = NULL;
@@ -30,5 +57,5 @@ private:
   void pwrite(float *buf, int size);
   int pipein[2];
   int pipeout[2];
+#endif
 };
-
@@ -0,0 +1,67 @@
+// compares the fused driver monitoring preprocessing on the CPU with the libyuv crop, mirror and scale it replaced
+// usage: ./benchmark [iterations]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "selfdrive/common/timing.h"
+#include "selfdrive/modeld/test/dmonitoring_prep/reference.h"
+
+const int MODEL_WIDTH = 320;
+const int MODEL_HEIGHT = 640;
+const int BATCHES = 10;
+
+// the fastest of BATCHES batches, so other processes on the device don't count
+template <typename F>
+static double us_per_frame(int iterations, F f) {
+  f();  // builds the taps
+  double best = 1e9;
+  for (int b = 0; b < BATCHES; b++) {
+    const double start = nanos_since_boot();
+    for (int i = 0; i < iterations / BATCHES; i++) {
+      f();
+    }
+    best = std::min(best, (nanos_since_boot() - start) / 1e3 / (iterations / BATCHES));
+  }
+  return best;
+}
+
+static void run(const char *name, const DMPrepParams &params, int iterations) {
+  std::vector<uint8_t> yuv(params.width * params.height * 3 / 2);
+  for (int i = 0; i < yuv.size(); i++) {
+    yuv[i] = (i * 7 + i / params.width) & 0xff;
+  }
+  std::vector<float> out(MODEL_WIDTH * MODEL_HEIGHT * 3 / 2);
+
+  DMPrepReference ref;
+  const double libyuv_us = us_per_frame(iterations, [&]() {
+    ref.run(yuv.data(), params, MODEL_WIDTH, MODEL_HEIGHT, out.data());
+  });
+
+  DMPrepCPUState s;
+  dmonitoring_prep_cpu_init(&s, MODEL_WIDTH, MODEL_HEIGHT);
+  const double fused_us = us_per_frame(iterations, [&]() {
+    dmonitoring_prep_cpu(&s, yuv.data(), params, out.data());
+  });
+
+  printf("%-8s libyuv: %8.2f us/frame, fused: %8.2f us/frame\n", name, libyuv_us, fused_us);
+}
+
+int main(int argc, char *argv[]) {
+  const int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+
+  // the crops of dmonitoring_eval_frame
+  const int cropped_height = 954 / 1.33;
+  for (bool mirror : {false, true}) {
+    DMRect crop = {1928 / 2 - 954 / 2 - 72, 1208 / 2 - cropped_height / 2 - 144, cropped_height / 2, cropped_height};
+    if (!mirror) crop.x += 954 - crop.w;
+    run(mirror ? "tici rhd" : "tici", {1928, 1208, crop, {0, 0, MODEL_WIDTH, MODEL_HEIGHT}, mirror}, iterations);
+  }
+  for (bool mirror : {false, true}) {
+    DMRect crop = {mirror ? 0 : 1152 - 372, 0, 372, 864};
+    run(mirror ? "eon rhd" : "eon", {1152, 864, crop, {0, 96, 272, 448}, mirror}, iterations);
+  }
+  return 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "libyuv.h"
+
+#include "selfdrive/modeld/transforms/dmonitoring_prep.h"
+
+// the preprocessing dmonitoring_prep replaced: crop into a temporary I420 buffer, mirror it
+// into another, scale it with libyuv and normalize through a lookup table
+struct DMPrepReference {
+  std::vector<uint8_t> cropped_buf, premirror_cropped_buf, resized_buf;
+  float tensor[UINT8_MAX + 1];
+
+  DMPrepReference() {
+    for (int x = 0; x < std::size(tensor); ++x) {
+      tensor[x] = (x - 128.f) * 0.0078125f;
+    }
+  }
+
+  static void crop_yuv(const uint8_t *raw, int width, int height, uint8_t *y, uint8_t *u, uint8_t *v, const DMRect &rect) {
+    const uint8_t *raw_y = raw;
+    const uint8_t *raw_u = raw_y + (width * height);
+    const uint8_t *raw_v = raw_u + ((width / 2) * (height / 2));
+    for (int r = 0; r < rect.h / 2; r++) {
+      memcpy(y + 2 * r * rect.w, raw_y + (2 * r + rect.y) * width + rect.x, rect.w);
+      memcpy(y + (2 * r + 1) * rect.w, raw_y + (2 * r + rect.y + 1) * width + rect.x, rect.w);
+      memcpy(u + r * (rect.w / 2), raw_u + (r + (rect.y / 2)) * width / 2 + (rect.x / 2), rect.w / 2);
+      memcpy(v + r * (rect.w / 2), raw_v + (r + (rect.y / 2)) * width / 2 + (rect.x / 2), rect.w / 2);
+    }
+  }
+
+  void run(const uint8_t *yuv, const DMPrepParams &p, int out_width, int out_height, float *out) {
+    const DMRect &crop = p.crop;
+    // crop_yuv copies crop.h / 2 row pairs, with an odd height the scaler reads one
+    // more luma row and one more chroma row than were copied. pad so that stays in bounds
+    const int padding = crop.w * 2;
+    cropped_buf.assign(crop.w * crop.h * 3 / 2 + padding, 0);
+    uint8_t *cropped_y = cropped_buf.data();
+    uint8_t *cropped_u = cropped_y + crop.w * crop.h;
+    uint8_t *cropped_v = cropped_u + (crop.w / 2) * (crop.h / 2);
+    if (!p.mirror) {
+      crop_yuv(yuv, p.width, p.height, cropped_y, cropped_u, cropped_v, crop);
+    } else {
+      premirror_cropped_buf.assign(crop.w * crop.h * 3 / 2 + padding, 0);
+      uint8_t *mirror_y = premirror_cropped_buf.data();
+      uint8_t *mirror_u = mirror_y + crop.w * crop.h;
+      uint8_t *mirror_v = mirror_u + (crop.w / 2) * (crop.h / 2);
+      crop_yuv(yuv, p.width, p.height, mirror_y, mirror_u, mirror_v, crop);
+      libyuv::I420Mirror(mirror_y, crop.w, mirror_u, crop.w / 2, mirror_v, crop.w / 2,
+                         cropped_y, crop.w, cropped_u, crop.w / 2, cropped_v, crop.w / 2,
+                         crop.w, crop.h);
+    }
+
+    // outside the destination the buffer stays 0, like the zero-filled vector of the old path
+    resized_buf.assign(out_width * out_height * 3 / 2, 0);
+    uint8_t *resized_y = resized_buf.data();
+    uint8_t *resized_u = resized_y + out_width * out_height;
+    uint8_t *resized_v = resized_u + (out_width / 2) * (out_height / 2);
+    const DMRect &dst = p.dst;
+    libyuv::I420Scale(cropped_y, crop.w, cropped_u, crop.w / 2, cropped_v, crop.w / 2,
+                      crop.w, crop.h,
+                      resized_y + dst.y * out_width + dst.x, out_width,
+                      resized_u + dst.y / 2 * out_width / 2 + dst.x / 2, out_width / 2,
+                      resized_v + dst.y / 2 * out_width / 2 + dst.x / 2, out_width / 2,
+                      dst.w, dst.h, libyuv::kFilterBilinear);
+
+    const int out_w = out_width / 2, out_h = out_height / 2, plane_size = out_w * out_h;
+    for (int r = 0; r < out_h; r++) {
+      for (int c = 0; c < out_w; c++) {
+        out[r * out_w + c + 0 * plane_size] = tensor[resized_y[(2*r) * out_width + 2*c]];
+        out[r * out_w + c + 1 * plane_size] = tensor[resized_y[(2*r + 1) * out_width + 2*c]];
+        out[r * out_w + c + 2 * plane_size] = tensor[resized_y[(2*r) * out_width + 2*c + 1]];
+        out[r * out_w + c + 3 * plane_size] = tensor[resized_y[(2*r + 1) * out_width + 2*c + 1]];
+        out[r * out_w + c + 4 * plane_size] = tensor[resized_u[r * out_width / 2 + c]];
+        out[r * out_w + c + 5 * plane_size] = tensor[resized_v[r * out_width / 2 + c]];
+      }
+    }
+  }
+};
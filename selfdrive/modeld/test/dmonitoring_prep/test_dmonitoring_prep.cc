@@ -0,0 +1,103 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "selfdrive/modeld/test/dmonitoring_prep/reference.h"
+
+const int MODEL_WIDTH = 320;
+const int MODEL_HEIGHT = 640;
+const int NET_INPUT_SIZE = MODEL_WIDTH * MODEL_HEIGHT * 3 / 2;
+
+// both sample from pixel centers, but the fused path rounds its weights to 1/256 and libyuv
+// keeps 16.16 positions, so pixels may be off by one after rounding.
+// the tolerance is in 8 bit levels, one level is 1/128 of the normalized input
+const float MAX_LEVELS = 1;
+const float MEAN_LEVELS = 0.25;
+
+// smooth content with some noise on top, like a camera frame
+static std::vector<uint8_t> make_frame(int width, int height, uint32_t seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> noise(-8, 8);
+  std::vector<uint8_t> yuv(width * height * 3 / 2);
+  auto fill = [&](uint8_t *plane, int w, int h, float fx, float fy) {
+    for (int r = 0; r < h; r++) {
+      for (int c = 0; c < w; c++) {
+        const float v = 128 + 100 * sinf(c * fx) * cosf(r * fy) + noise(gen);
+        plane[r * w + c] = std::clamp((int)v, 0, 255);
+      }
+    }
+  };
+  fill(yuv.data(), width, height, 0.031f, 0.017f);
+  fill(yuv.data() + width * height, width / 2, height / 2, 0.043f, 0.029f);
+  fill(yuv.data() + width * height * 5 / 4, width / 2, height / 2, 0.023f, 0.037f);
+  return yuv;
+}
+
+static void compare(const DMPrepParams &params) {
+  auto yuv = make_frame(params.width, params.height, params.crop.x);
+
+  std::vector<float> expected(NET_INPUT_SIZE), out(NET_INPUT_SIZE);
+  DMPrepReference ref;
+  ref.run(yuv.data(), params, MODEL_WIDTH, MODEL_HEIGHT, expected.data());
+
+  DMPrepCPUState s;
+  dmonitoring_prep_cpu_init(&s, MODEL_WIDTH, MODEL_HEIGHT);
+  dmonitoring_prep_cpu(&s, yuv.data(), params, out.data());
+
+  // with an odd crop height the old path scaled the last row from a row it never copied
+  // (black for luma, the next plane or past the buffer for chroma). the fused path samples
+  // the frame there, so the last luma and chroma row of the destination are not compared
+  const int plane_size = NET_INPUT_SIZE / 6;
+  const int last_y = (params.dst.y + params.dst.h - 1) / 2;
+  const int last_uv = params.dst.y / 2 + (params.dst.h + 1) / 2 - 1;
+  float max_diff = 0, sum_diff = 0;
+  int count = 0;
+  for (int i = 0; i < NET_INPUT_SIZE; i++) {
+    const int plane = i / plane_size, r = (i % plane_size) / (MODEL_WIDTH / 2);
+    if (params.crop.h % 2 == 1 && r == (plane < 4 ? last_y : last_uv)) continue;
+
+    const float diff = fabsf(out[i] - expected[i]) * 128;
+    max_diff = std::max(max_diff, diff);
+    sum_diff += diff;
+    count++;
+  }
+  INFO("max " << max_diff << " mean " << sum_diff / count << " levels");
+  REQUIRE(max_diff <= MAX_LEVELS);
+  REQUIRE(sum_diff / count <= MEAN_LEVELS);
+
+  // outside the destination the input is black, exactly
+  for (int row = 0; row < MODEL_HEIGHT; row++) {
+    if (row >= params.dst.y && row < params.dst.y + params.dst.h) continue;
+    const float *y = out.data() + (row & 1) * plane_size + (row / 2) * (MODEL_WIDTH / 2);
+    for (int c = 0; c < MODEL_WIDTH / 2; c++) {
+      REQUIRE(y[c] == -1.0f);
+    }
+  }
+
+  // same result when the cached taps are reused
+  std::vector<float> again(NET_INPUT_SIZE);
+  dmonitoring_prep_cpu(&s, yuv.data(), params, again.data());
+  REQUIRE(again == out);
+}
+
+TEST_CASE("dmonitoring_prep_cpu matches the libyuv crop, mirror and scale") {
+  const bool mirror = GENERATE(false, true);
+
+  SECTION("tici") {
+    // crop from dmonitoring_eval_frame on a tici road camera sized frame
+    const int cropped_height = 954 / 1.33;
+    DMRect crop = {1928 / 2 - 954 / 2 - 72, 1208 / 2 - cropped_height / 2 - 144, cropped_height / 2, cropped_height};
+    if (!mirror) crop.x += 954 - crop.w;
+    compare({1928, 1208, crop, {0, 0, MODEL_WIDTH, MODEL_HEIGHT}, mirror});
+  }
+
+  SECTION("eon") {
+    // crop into a vertically centered box on the left, the rest stays black
+    const int width = 1152, height = 864;
+    DMRect crop = {mirror ? 0 : width - 372, 0, 372, height};
+    compare({width, height, crop, {0, 96, 272, 448}, mirror});
+  }
+}
@@ -0,0 +1,309 @@
+// compares the table driven output parser in driving.cc with the per-field parser it replaced
+// usage: ./benchmark [iterations]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/common/timing.h"
+#include "selfdrive/modeld/models/driving.h"
+
+namespace reference {
+
+float prev_brake_5ms2_probs[5] = {0,0,0,0,0};
+float prev_brake_3ms2_probs[3] = {0,0,0};
+
+const float *get_best_data(const float *data, int size, int group_size, int offset) {
+  int max_idx = 0;
+  for (int i = 1; i < size; i++) {
+    if (data[(i + 1) * group_size + offset] >
+        data[(max_idx + 1) * group_size + offset]) {
+      max_idx = i;
+    }
+  }
+  return &data[max_idx * group_size];
+}
+
+void fill_sigmoid(const float *input, float *output, int len, int stride) {
+  for (int i=0; i<len; i++) {
+    output[i] = sigmoid(input[i*stride]);
+  }
+}
+
+void fill_lead_v3(cereal::ModelDataV2::LeadDataV3::Builder lead, const float *lead_data, const float *prob, int t_offset, float prob_t) {
+  float t[LEAD_TRAJ_LEN] = {0.0, 2.0, 4.0, 6.0, 8.0, 10.0};
+  const float *data = get_best_data(lead_data, LEAD_MHP_N, LEAD_MHP_GROUP_SIZE, t_offset - LEAD_MHP_SELECTION);
+  lead.setProb(sigmoid(prob[t_offset]));
+  lead.setProbTime(prob_t);
+  float x_arr[LEAD_TRAJ_LEN], y_arr[LEAD_TRAJ_LEN], v_arr[LEAD_TRAJ_LEN], a_arr[LEAD_TRAJ_LEN];
+  float x_stds_arr[LEAD_TRAJ_LEN], y_stds_arr[LEAD_TRAJ_LEN], v_stds_arr[LEAD_TRAJ_LEN], a_stds_arr[LEAD_TRAJ_LEN];
+  for (int i=0; i<LEAD_TRAJ_LEN; i++) {
+    x_arr[i] = data[i*LEAD_PRED_DIM+0];
+    y_arr[i] = data[i*LEAD_PRED_DIM+1];
+    v_arr[i] = data[i*LEAD_PRED_DIM+2];
+    a_arr[i] = data[i*LEAD_PRED_DIM+3];
+    x_stds_arr[i] = exp(data[LEAD_MHP_VALS + i*LEAD_PRED_DIM+0]);
+    y_stds_arr[i] = exp(data[LEAD_MHP_VALS + i*LEAD_PRED_DIM+1]);
+    v_stds_arr[i] = exp(data[LEAD_MHP_VALS + i*LEAD_PRED_DIM+2]);
+    a_stds_arr[i] = exp(data[LEAD_MHP_VALS + i*LEAD_PRED_DIM+3]);
+  }
+  lead.setT(t);
+  lead.setX(x_arr);
+  lead.setY(y_arr);
+  lead.setV(v_arr);
+  lead.setA(a_arr);
+  lead.setXStd(x_stds_arr);
+  lead.setYStd(y_stds_arr);
+  lead.setVStd(v_stds_arr);
+  lead.setAStd(a_stds_arr);
+}
+
+void fill_meta(cereal::ModelDataV2::MetaData::Builder meta, const float *meta_data) {
+  float desire_state_softmax[DESIRE_LEN];
+  float desire_pred_softmax[4*DESIRE_LEN];
+  softmax(&meta_data[0], desire_state_softmax, DESIRE_LEN);
+  for (int i=0; i<4; i++) {
+    softmax(&meta_data[DESIRE_LEN + OTHER_META_SIZE + i*DESIRE_LEN],
+            &desire_pred_softmax[i*DESIRE_LEN], DESIRE_LEN);
+  }
+
+  float sigmoids[6][NUM_META_INTERVALS];
+  for (int i = 0; i < 6; i++) {
+    fill_sigmoid(&meta_data[DESIRE_LEN+1+i], sigmoids[i], NUM_META_INTERVALS, META_STRIDE);
+  }
+
+  std::memmove(prev_brake_5ms2_probs, &prev_brake_5ms2_probs[1], 4*sizeof(float));
+  std::memmove(prev_brake_3ms2_probs, &prev_brake_3ms2_probs[1], 2*sizeof(float));
+  prev_brake_5ms2_probs[4] = sigmoids[5][0];
+  prev_brake_3ms2_probs[2] = sigmoids[3][0];
+
+  bool above_fcw_threshold = true;
+  for (int i=0; i<5; i++) {
+    float threshold = i < 2 ? FCW_THRESHOLD_5MS2_LOW : FCW_THRESHOLD_5MS2_HIGH;
+    above_fcw_threshold = above_fcw_threshold && prev_brake_5ms2_probs[i] > threshold;
+  }
+  for (int i=0; i<3; i++) {
+    above_fcw_threshold = above_fcw_threshold && prev_brake_3ms2_probs[i] > FCW_THRESHOLD_3MS2;
+  }
+
+  auto disengage = meta.initDisengagePredictions();
+  disengage.setT({2,4,6,8,10});
+  disengage.setGasDisengageProbs(sigmoids[0]);
+  disengage.setBrakeDisengageProbs(sigmoids[1]);
+  disengage.setSteerOverrideProbs(sigmoids[2]);
+  disengage.setBrake3MetersPerSecondSquaredProbs(sigmoids[3]);
+  disengage.setBrake4MetersPerSecondSquaredProbs(sigmoids[4]);
+  disengage.setBrake5MetersPerSecondSquaredProbs(sigmoids[5]);
+
+  meta.setEngagedProb(sigmoid(meta_data[DESIRE_LEN]));
+  meta.setDesirePrediction(desire_pred_softmax);
+  meta.setDesireState(desire_state_softmax);
+  meta.setHardBrakePredicted(above_fcw_threshold);
+}
+
+void fill_xyzt(cereal::ModelDataV2::XYZTData::Builder xyzt, const float * data,
+               int columns, int column_offset, float * plan_t_arr, bool fill_std) {
+  float x_arr[TRAJECTORY_SIZE] = {};
+  float y_arr[TRAJECTORY_SIZE] = {};
+  float z_arr[TRAJECTORY_SIZE] = {};
+  float x_std_arr[TRAJECTORY_SIZE];
+  float y_std_arr[TRAJECTORY_SIZE];
+  float z_std_arr[TRAJECTORY_SIZE];
+  float t_arr[TRAJECTORY_SIZE];
+  for (int i=0; i<TRAJECTORY_SIZE; i++) {
+    if (column_offset >= 0) {
+      t_arr[i] = T_IDXS[i];
+      x_arr[i] = data[i*columns + 0 + column_offset];
+      x_std_arr[i] = data[columns*(TRAJECTORY_SIZE + i) + 0 + column_offset];
+    } else {
+      t_arr[i] = plan_t_arr[i];
+      x_arr[i] = X_IDXS[i];
+      x_std_arr[i] = NAN;
+    }
+    y_arr[i] = data[i*columns + 1 + column_offset];
+    y_std_arr[i] = data[columns*(TRAJECTORY_SIZE + i) + 1 + column_offset];
+    z_arr[i] = data[i*columns + 2 + column_offset];
+    z_std_arr[i] = data[columns*(TRAJECTORY_SIZE + i) + 2 + column_offset];
+  }
+  xyzt.setX(x_arr);
+  xyzt.setY(y_arr);
+  xyzt.setZ(z_arr);
+  xyzt.setT(t_arr);
+  if (fill_std) {
+    xyzt.setXStd(x_std_arr);
+    xyzt.setYStd(y_std_arr);
+    xyzt.setZStd(z_std_arr);
+  }
+}
+
+void fill_model(cereal::ModelDataV2::Builder &framed, const float *output) {
+  const float *best_plan = get_best_data(&output[PLAN_IDX], PLAN_MHP_N, PLAN_MHP_GROUP_SIZE, -1);
+  float plan_t_arr[TRAJECTORY_SIZE];
+  std::fill_n(plan_t_arr, TRAJECTORY_SIZE, NAN);
+  plan_t_arr[0] = 0.0;
+  for (int xidx=1, tidx=0; xidx<TRAJECTORY_SIZE; xidx++) {
+    while (tidx < TRAJECTORY_SIZE-1 && best_plan[(tidx+1)*PLAN_MHP_COLUMNS] < X_IDXS[xidx]) {
+      tidx++;
+    }
+    float current_x_val = best_plan[tidx*PLAN_MHP_COLUMNS];
+    float next_x_val = best_plan[(tidx+1)*PLAN_MHP_COLUMNS];
+    if (next_x_val < X_IDXS[xidx]) {
+      plan_t_arr[xidx] = T_IDXS[TRAJECTORY_SIZE-1];
+      break;
+    } else {
+      float p = (X_IDXS[xidx] - current_x_val) / (next_x_val - current_x_val);
+      plan_t_arr[xidx] = p * T_IDXS[tidx+1] + (1 - p) * T_IDXS[tidx];
+    }
+  }
+
+  fill_xyzt(framed.initPosition(), best_plan, PLAN_MHP_COLUMNS, 0, plan_t_arr, true);
+  fill_xyzt(framed.initVelocity(), best_plan, PLAN_MHP_COLUMNS, 3, plan_t_arr, false);
+  fill_xyzt(framed.initOrientation(), best_plan, PLAN_MHP_COLUMNS, 9, plan_t_arr, false);
+  fill_xyzt(framed.initOrientationRate(), best_plan, PLAN_MHP_COLUMNS, 12, plan_t_arr, false);
+
+  const float *lane_lines_data = &output[LL_IDX];
+  auto lane_lines = framed.initLaneLines(4);
+  float lane_line_probs_arr[4];
+  float lane_line_stds_arr[4];
+  for (int i = 0; i < 4; i++) {
+    fill_xyzt(lane_lines[i], &lane_lines_data[i*TRAJECTORY_SIZE*2], 2, -1, plan_t_arr, false);
+    lane_line_probs_arr[i] = sigmoid(output[LL_PROB_IDX + i*2+1]);
+    lane_line_stds_arr[i] = exp(lane_lines_data[2*TRAJECTORY_SIZE*(4 + i)]);
+  }
+  framed.setLaneLineProbs(lane_line_probs_arr);
+  framed.setLaneLineStds(lane_line_stds_arr);
+
+  const float *road_edges_data = &output[RE_IDX];
+  auto road_edges = framed.initRoadEdges(2);
+  float road_edge_stds_arr[2];
+  for (int i = 0; i < 2; i++) {
+    fill_xyzt(road_edges[i], &road_edges_data[i*TRAJECTORY_SIZE*2], 2, -1, plan_t_arr, false);
+    road_edge_stds_arr[i] = exp(road_edges_data[2*TRAJECTORY_SIZE*(2 + i)]);
+  }
+  framed.setRoadEdgeStds(road_edge_stds_arr);
+
+  fill_meta(framed.initMeta(), &output[DESIRE_STATE_IDX]);
+
+  auto leads = framed.initLeadsV3(LEAD_MHP_SELECTION);
+  float t_offsets[LEAD_MHP_SELECTION] = {0.0, 2.0, 4.0};
+  for (int t_offset=0; t_offset<LEAD_MHP_SELECTION; t_offset++) {
+    fill_lead_v3(leads[t_offset], &output[LEAD_IDX], &output[LEAD_PROB_IDX], t_offset, t_offsets[t_offset]);
+  }
+}
+
+}  // namespace reference
+
+static bool approx_equal(float a, float b) {
+  return (std::isnan(a) && std::isnan(b)) || std::abs(a - b) <= 1e-5 * std::max(1.f, std::abs(a));
+}
+
+static int compare(capnp::List<float>::Reader a, capnp::List<float>::Reader b, const char *name) {
+  if (a.size() != b.size()) {
+    printf("%s: size mismatch %zu != %zu\n", name, a.size(), b.size());
+    return 1;
+  }
+  for (int i = 0; i < a.size(); i++) {
+    if (!approx_equal(a[i], b[i])) {
+      printf("%s[%d]: %f != %f\n", name, i, a[i], b[i]);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int compare_xyzt(cereal::ModelDataV2::XYZTData::Reader a, cereal::ModelDataV2::XYZTData::Reader b, const char *name) {
+  return compare(a.getX(), b.getX(), name) + compare(a.getY(), b.getY(), name) + compare(a.getZ(), b.getZ(), name) +
+         compare(a.getT(), b.getT(), name) + compare(a.getXStd(), b.getXStd(), name) +
+         compare(a.getYStd(), b.getYStd(), name) + compare(a.getZStd(), b.getZStd(), name);
+}
+
+static int compare_models(cereal::ModelDataV2::Reader a, cereal::ModelDataV2::Reader b) {
+  int errors = 0;
+  errors += compare_xyzt(a.getPosition(), b.getPosition(), "position");
+  errors += compare_xyzt(a.getVelocity(), b.getVelocity(), "velocity");
+  errors += compare_xyzt(a.getOrientation(), b.getOrientation(), "orientation");
+  errors += compare_xyzt(a.getOrientationRate(), b.getOrientationRate(), "orientationRate");
+  for (int i = 0; i < 4; i++) errors += compare_xyzt(a.getLaneLines()[i], b.getLaneLines()[i], "laneLines");
+  for (int i = 0; i < 2; i++) errors += compare_xyzt(a.getRoadEdges()[i], b.getRoadEdges()[i], "roadEdges");
+  errors += compare(a.getLaneLineProbs(), b.getLaneLineProbs(), "laneLineProbs");
+  errors += compare(a.getLaneLineStds(), b.getLaneLineStds(), "laneLineStds");
+  errors += compare(a.getRoadEdgeStds(), b.getRoadEdgeStds(), "roadEdgeStds");
+
+  auto ma = a.getMeta(), mb = b.getMeta();
+  errors += !approx_equal(ma.getEngagedProb(), mb.getEngagedProb());
+  errors += ma.getHardBrakePredicted() != mb.getHardBrakePredicted();
+  errors += compare(ma.getDesireState(), mb.getDesireState(), "desireState");
+  errors += compare(ma.getDesirePrediction(), mb.getDesirePrediction(), "desirePrediction");
+  auto da = ma.getDisengagePredictions(), db = mb.getDisengagePredictions();
+  errors += compare(da.getGasDisengageProbs(), db.getGasDisengageProbs(), "gasDisengageProbs");
+  errors += compare(da.getBrake5MetersPerSecondSquaredProbs(), db.getBrake5MetersPerSecondSquaredProbs(), "brake5");
+
+  for (int t = 0; t < LEAD_MHP_SELECTION; t++) {
+    auto la = a.getLeadsV3()[t], lb = b.getLeadsV3()[t];
+    errors += !approx_equal(la.getProb(), lb.getProb());
+    errors += compare(la.getX(), lb.getX(), "leadX") + compare(la.getA(), lb.getA(), "leadA");
+    errors += compare(la.getXStd(), lb.getXStd(), "leadXStd") + compare(la.getAStd(), lb.getAStd(), "leadAStd");
+  }
+  return errors;
+}
+
+int main(int argc, char *argv[]) {
+  const int iterations = argc > 1 ? atoi(argv[1]) : 10000;
+
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dist(0.0, 2.0);
+  std::vector<std::vector<float>> frames(16, std::vector<float>(OUTPUT_SIZE));
+  for (auto &f : frames) {
+    for (auto &v : f) v = dist(gen);
+    // keep the plan x monotonic so plan_t interpolation runs
+    for (int h = 0; h < PLAN_MHP_N; h++) {
+      for (int i = 0; i < TRAJECTORY_SIZE; i++) {
+        f[PLAN_IDX + h*PLAN_MHP_GROUP_SIZE + i*PLAN_MHP_COLUMNS] = X_IDXS[i] * 0.8;
+      }
+    }
+  }
+
+  // correctness
+  ModelOutputs outputs = {};
+  int errors = 0;
+  for (auto &f : frames) {
+    MessageBuilder msg_ref, msg_new;
+    auto framed_ref = msg_ref.initEvent().initModelV2();
+    auto framed_new = msg_new.initEvent().initModelV2();
+    reference::fill_model(framed_ref, f.data());
+    model_parse_outputs(f.data(), outputs);
+    fill_model(framed_new, outputs);
+    errors += compare_models(framed_ref.asReader(), framed_new.asReader());
+  }
+  printf("compared %zu frames, %d mismatches\n", frames.size(), errors);
+
+  // timing, parse and build only, no send
+  uint64_t t1 = nanos_since_boot();
+  for (int i = 0; i < iterations; i++) {
+    MessageBuilder msg;
+    auto framed = msg.initEvent().initModelV2();
+    reference::fill_model(framed, frames[i % frames.size()].data());
+  }
+  uint64_t t2 = nanos_since_boot();
+  for (int i = 0; i < iterations; i++) {
+    MessageBuilder msg;
+    auto framed = msg.initEvent().initModelV2();
+    model_parse_outputs(frames[i % frames.size()].data(), outputs);
+    fill_model(framed, outputs);
+  }
+  uint64_t t3 = nanos_since_boot();
+  for (int i = 0; i < iterations; i++) {
+    model_parse_outputs(frames[i % frames.size()].data(), outputs);
+  }
+  uint64_t t4 = nanos_since_boot();
+
+  printf("reference fill_model:      %8.2f us/frame\n", (t2 - t1) / 1e3 / iterations);
+  printf("parse + fill_model:        %8.2f us/frame\n", (t3 - t2) / 1e3 / iterations);
+  printf("  of which parse only:     %8.2f us/frame\n", (t4 - t3) / 1e3 / iterations);
+  return errors != 0;
+}
@@ -1,4 +1,10 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <cassert>
+#include <cstring>
 #include <set>
 
 #include "json11.hpp"
@@ -7,9 +13,212 @@ using namespace json11;
 
 extern map<cl_program, string> g_program_source;
 
+// ***** binary container *****
+// header, object table, program table, kernel table, arg table, string blob, then data.
+// every weight buffer and program binary starts on a page boundary so it can be used from the mapping in place.
+
+#define THNEED_MAGIC "THNB"
+#define THNEED_VERSION 1
+#define THNEED_ALIGN 0x1000
+
+#define THNEED_OBJ_BUFFER 0
+#define THNEED_OBJ_IMAGE2D 1
+#define THNEED_OBJ_IMAGE1D 2
+
+struct ThneedHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_objects, num_programs, num_kernels, num_args;
+  uint64_t objects_offset, programs_offset, kernels_offset, args_offset, blob_offset;
+  uint64_t file_size;
+};
+
+struct ThneedObject {
+  uint64_t id;          // cl_mem at save time, used to resolve kernel args
+  uint64_t buffer_id;   // backing buffer for images, 0 otherwise
+  uint32_t type;
+  uint32_t needs_load;
+  uint64_t size;
+  uint32_t width, height, row_pitch, pad;
+  uint64_t data_offset;
+};
+
+struct ThneedProgram {
+  uint32_t name_offset, name_length;  // in blob
+  uint32_t is_binary, pad;
+  uint64_t data_offset, data_length;  // binaries in data, sources in blob
+};
+
+struct ThneedKernel {
+  uint32_t program;
+  uint32_t work_dim;
+  uint64_t global_work_size[3];
+  uint64_t local_work_size[3];
+  uint32_t num_args, first_arg;
+};
+
+struct ThneedArg {
+  uint32_t size;
+  uint32_t length;  // 0 for local memory args
+  uint64_t value_offset;  // in blob
+};
+
+static uint64_t align_up(uint64_t x) {
+  return (x + THNEED_ALIGN - 1) & ~(uint64_t)(THNEED_ALIGN - 1);
+}
+
 void Thneed::load(const char *filename) {
   printf("Thneed::load: loading from %s\n", filename);
 
+  int fd = open(filename, O_RDONLY);
+  assert(fd >= 0);
+  struct stat st;
+  int err = fstat(fd, &st);
+  assert(err == 0);
+
+  char magic[4] = {0};
+  if (read(fd, magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, THNEED_MAGIC, sizeof(magic)) != 0) {
+    close(fd);
+    load_json(filename);
+    return;
+  }
+
+  // private writable mapping: weights are handed to the GPU in place and only faulted in when touched
+  mapped_size = st.st_size;
+  mapped = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  assert(mapped != MAP_FAILED);
+
+  const char *base = (const char *)mapped;
+  const ThneedHeader *hdr = (const ThneedHeader *)base;
+  assert(hdr->version == THNEED_VERSION);
+  assert(hdr->file_size == mapped_size);
+  const ThneedObject *objects = (const ThneedObject *)(base + hdr->objects_offset);
+  const ThneedProgram *programs = (const ThneedProgram *)(base + hdr->programs_offset);
+  const ThneedKernel *kernels = (const ThneedKernel *)(base + hdr->kernels_offset);
+  const ThneedArg *args = (const ThneedArg *)(base + hdr->args_offset);
+  const char *blob = base + hdr->blob_offset;
+
+  map<uint64_t, cl_mem> real_mem;
+  real_mem[0] = NULL;
+
+  for (int i = 0; i < hdr->num_objects; i++) {
+    const ThneedObject &obj = objects[i];
+    cl_mem clbuf = NULL;
+
+    if (obj.buffer_id != 0) {
+      // image buffer must already be allocated
+      clbuf = real_mem[obj.buffer_id];
+      assert(!obj.needs_load);
+    } else if (obj.needs_load) {
+      void *host_ptr = (void *)(base + obj.data_offset);
+      clbuf = clCreateBuffer(context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, obj.size, host_ptr, NULL);
+      if (clbuf == NULL) {
+        // the driver refused the mapping, fall back to one copy
+        clbuf = clCreateBuffer(context, CL_MEM_COPY_HOST_PTR | CL_MEM_READ_WRITE, obj.size, host_ptr, NULL);
+      }
+    } else {
+      clbuf = clCreateBuffer(context, CL_MEM_READ_WRITE, obj.size, NULL, NULL);
+    }
+    assert(clbuf != NULL);
+
+    if (obj.type == THNEED_OBJ_IMAGE2D || obj.type == THNEED_OBJ_IMAGE1D) {
+      cl_image_desc desc = {0};
+      desc.image_type = (obj.type == THNEED_OBJ_IMAGE2D) ? CL_MEM_OBJECT_IMAGE2D : CL_MEM_OBJECT_IMAGE1D_BUFFER;
+      desc.image_width = obj.width;
+      desc.image_height = obj.height;
+      desc.image_row_pitch = obj.row_pitch;
+      desc.buffer = clbuf;
+
+      cl_image_format format;
+      format.image_channel_order = CL_RGBA;
+      format.image_channel_data_type = CL_HALF_FLOAT;
+
+      clbuf = clCreateImage(context, CL_MEM_READ_WRITE, &format, &desc, NULL, NULL);
+      assert(clbuf != NULL);
+    }
+
+    real_mem[obj.id] = clbuf;
+  }
+
+  // programs are only built when their first kernel runs
+  vector<string> program_names;
+  for (int i = 0; i < hdr->num_programs; i++) {
+    const ThneedProgram &prg = programs[i];
+    string name(blob + prg.name_offset, prg.name_length);
+    const char *data = prg.is_binary ? base + prg.data_offset : blob + prg.data_offset;
+    pending_programs[name] = {data, (size_t)prg.data_length, (bool)prg.is_binary};
+    program_names.push_back(name);
+  }
+
+  for (int i = 0; i < hdr->num_kernels; i++) {
+    const ThneedKernel &k = kernels[i];
+    auto kk = shared_ptr<CLQueuedKernel>(new CLQueuedKernel(this));
+
+    kk->name = program_names[k.program];
+    kk->work_dim = k.work_dim;
+    for (int j = 0; j < k.work_dim; j++) {
+      kk->global_work_size[j] = k.global_work_size[j];
+      kk->local_work_size[j] = k.local_work_size[j];
+    }
+    kk->num_args = k.num_args;
+    for (int j = 0; j < k.num_args; j++) {
+      const ThneedArg &a = args[k.first_arg + j];
+      kk->args_size.push_back(a.size);
+      if (a.size == 8 && a.length == 8) {
+        uint64_t id;
+        memcpy(&id, blob + a.value_offset, sizeof(id));
+        cl_mem val = real_mem[id];
+        kk->args.push_back(string((char*)&val, sizeof(val)));
+      } else {
+        kk->args.push_back(string(blob + a.value_offset, a.length));
+      }
+    }
+    kq.push_back(kk);
+  }
+
+  clFinish(command_queue);
+}
+
+cl_program Thneed::build_program(const string &name) {
+  auto it = pending_programs.find(name);
+  assert(it != pending_programs.end());
+  const PendingProgram &p = it->second;
+
+  if (record & THNEED_DEBUG) printf("building %s %s with size %zu\n", p.is_binary ? "binary" : "source", name.c_str(), p.length);
+
+  cl_int err;
+  cl_program program;
+  if (p.is_binary) {
+    const unsigned char *srcs[1] = {(const unsigned char *)p.data};
+    program = clCreateProgramWithBinary(context, 1, &device_id, &p.length, srcs, NULL, &err);
+  } else {
+    const char *srcs[1] = {p.data};
+    program = clCreateProgramWithSource(context, 1, srcs, &p.length, &err);
+  }
+  assert(program != NULL && err == CL_SUCCESS);
+  err = clBuildProgram(program, 1, &device_id, "", NULL, NULL);
+  if (err != CL_SUCCESS) {
+    printf("got err %d\n", err);
+    size_t length;
+    char buffer[2048];
+    clGetProgramBuildInfo(program, device_id, CL_PROGRAM_BUILD_LOG, sizeof(buffer), buffer, &length);
+    buffer[length] = '\0';
+    printf("%s\n", buffer);
+  }
+  assert(err == CL_SUCCESS);
+
+  // kernels sharing a name share the program
+  for (auto &k : kq) {
+    if (k->program == NULL && k->name == name) k->program = program;
+  }
+  pending_programs.erase(it);
+  return program;
+}
+
+void Thneed::load_json(const char *filename) {
+  printf("Thneed::load_json: loading from %s\n", filename);
+
   FILE *f = fopen(filename, "rb");
   fseek(f, 0L, SEEK_END);
   int sz = ftell(f);
@@ -142,150 +351,180 @@ void Thneed::load(const char *filename) {
 void Thneed::save(const char *filename, bool save_binaries) {
   printf("Thneed::save: saving to %s\n", filename);
 
-  // get kernels
-  std::vector<Json> kernels;
   std::set<string> saved_objects;
-  std::vector<Json> objects;
-  std::map<string, string> programs;
-  std::map<string, string> binaries;
+  vector<ThneedObject> objects;
+  vector<ThneedProgram> programs;
+  vector<ThneedKernel> kernels;
+  vector<ThneedArg> args;
+  map<string, uint32_t> program_index;
+  string blob;
+  // (offset placeholder index, contents) for everything in the aligned data section
+  vector<pair<uint64_t *, string> > data;
+
+  auto blob_add = [&](const string &s) {
+    uint64_t off = blob.size();
+    blob += s;
+    return off;
+  };
 
   for (auto &k : kq) {
-    kernels.push_back(k->to_json());
-
     // check args for objects
-    int i = 0;
-    for (auto &a : k->args) {
-      if (a.size() == 8) {
-        if (saved_objects.find(a) == saved_objects.end()) {
-          saved_objects.insert(a);
-          cl_mem val = *(cl_mem*)(a.data());
-          if (val != NULL) {
-            bool needs_load = k->arg_names[i] == "weights" || k->arg_names[i] == "biases";
-
-            auto jj = Json::object({
-              {"id", a},
-              {"arg_type", k->arg_types[i]},
-            });
-
-            if (k->arg_types[i] == "image2d_t" || k->arg_types[i] == "image1d_t") {
-              cl_mem buf;
-              clGetImageInfo(val, CL_IMAGE_BUFFER, sizeof(buf), &buf, NULL);
-              string aa = string((char *)&buf, sizeof(buf));
-              jj["buffer_id"] = aa;
-
-              size_t width, height, row_pitch;
-              clGetImageInfo(val, CL_IMAGE_WIDTH, sizeof(width), &width, NULL);
-              clGetImageInfo(val, CL_IMAGE_HEIGHT, sizeof(height), &height, NULL);
-              clGetImageInfo(val, CL_IMAGE_ROW_PITCH, sizeof(row_pitch), &row_pitch, NULL);
-              jj["width"] = (int)width;
-              jj["height"] = (int)height;
-              jj["row_pitch"] = (int)row_pitch;
-              jj["size"] = (int)(height * row_pitch);
-              jj["needs_load"] = false;
-
-              if (saved_objects.find(aa) == saved_objects.end()) {
-                saved_objects.insert(aa);
-                size_t sz;
-                clGetMemObjectInfo(buf, CL_MEM_SIZE, sizeof(sz), &sz, NULL);
-                // save the buffer
-                objects.push_back(Json::object({
-                  {"id", aa},
-                  {"arg_type", "<image buffer>"},
-                  {"needs_load", needs_load},
-                  {"size", (int)sz}
-                }));
-                if (needs_load) assert(sz == height * row_pitch);
-              }
-            } else {
-              size_t sz = 0;
-              clGetMemObjectInfo(val, CL_MEM_SIZE, sizeof(sz), &sz, NULL);
-              jj["size"] = (int)sz;
-              jj["needs_load"] = needs_load;
-            }
-
-            objects.push_back(jj);
-          }
+    for (int i = 0; i < k->num_args; i++) {
+      const string &a = k->args[i];
+      if (a.size() != 8 || saved_objects.find(a) != saved_objects.end()) continue;
+      saved_objects.insert(a);
+      cl_mem val = *(cl_mem*)(a.data());
+      if (val == NULL) continue;
+
+      ThneedObject obj = {};
+      obj.id = *(uint64_t *)a.data();
+      obj.needs_load = k->arg_names[i] == "weights" || k->arg_names[i] == "biases";
+
+      if (k->arg_types[i] == "image2d_t" || k->arg_types[i] == "image1d_t") {
+        cl_mem buf;
+        clGetImageInfo(val, CL_IMAGE_BUFFER, sizeof(buf), &buf, NULL);
+        string aa = string((char *)&buf, sizeof(buf));
+
+        size_t width, height, row_pitch;
+        clGetImageInfo(val, CL_IMAGE_WIDTH, sizeof(width), &width, NULL);
+        clGetImageInfo(val, CL_IMAGE_HEIGHT, sizeof(height), &height, NULL);
+        clGetImageInfo(val, CL_IMAGE_ROW_PITCH, sizeof(row_pitch), &row_pitch, NULL);
+
+        if (saved_objects.find(aa) == saved_objects.end()) {
+          saved_objects.insert(aa);
+          size_t sz;
+          clGetMemObjectInfo(buf, CL_MEM_SIZE, sizeof(sz), &sz, NULL);
+          // save the buffer
+          ThneedObject bobj = {};
+          bobj.id = *(uint64_t *)aa.data();
+          bobj.type = THNEED_OBJ_BUFFER;
+          bobj.needs_load = obj.needs_load;
+          bobj.size = sz;
+          if (obj.needs_load) assert(sz == height * row_pitch);
+          objects.push_back(bobj);
         }
+
+        obj.buffer_id = *(uint64_t *)aa.data();
+        obj.type = (k->arg_types[i] == "image2d_t") ? THNEED_OBJ_IMAGE2D : THNEED_OBJ_IMAGE1D;
+        obj.width = width;
+        obj.height = height;
+        obj.row_pitch = row_pitch;
+        obj.size = height * row_pitch;
+        obj.needs_load = false;
+      } else {
+        size_t sz = 0;
+        clGetMemObjectInfo(val, CL_MEM_SIZE, sizeof(sz), &sz, NULL);
+        obj.type = THNEED_OBJ_BUFFER;
+        obj.size = sz;
       }
-      i++;
+      objects.push_back(obj);
     }
 
-    if (save_binaries) {
-      int err;
-      size_t binary_size = 0;
-      err = clGetProgramInfo(k->program, CL_PROGRAM_BINARY_SIZES, sizeof(binary_size), &binary_size, NULL);
-      assert(err == 0);
-      assert(binary_size > 0);
-      string sv(binary_size, '\x00');
-
-      uint8_t* bufs[1] = { (uint8_t*)sv.data(), };
-      err = clGetProgramInfo(k->program, CL_PROGRAM_BINARIES, sizeof(bufs), &bufs, NULL);
-      assert(err == 0);
+    if (program_index.find(k->name) == program_index.end()) {
+      ThneedProgram prg = {};
+      prg.name_length = k->name.size();
+      prg.name_offset = blob_add(k->name);
+      prg.is_binary = save_binaries;
+      if (save_binaries) {
+        int err;
+        size_t binary_size = 0;
+        err = clGetProgramInfo(k->program, CL_PROGRAM_BINARY_SIZES, sizeof(binary_size), &binary_size, NULL);
+        assert(err == 0);
+        assert(binary_size > 0);
+        string sv(binary_size, '\x00');
+
+        uint8_t* bufs[1] = { (uint8_t*)sv.data(), };
+        err = clGetProgramInfo(k->program, CL_PROGRAM_BINARIES, sizeof(bufs), &bufs, NULL);
+        assert(err == 0);
+        prg.data_length = binary_size;
+        data.push_back({NULL, sv});
+      } else {
+        const string &src = g_program_source[k->program];
+        prg.data_length = src.size();
+        prg.data_offset = blob_add(src);
+      }
+      program_index[k->name] = programs.size();
+      programs.push_back(prg);
+    }
 
-      binaries[k->name] = sv;
-    } else {
-      programs[k->name] = g_program_source[k->program];
+    ThneedKernel kk = {};
+    kk.program = program_index[k->name];
+    kk.work_dim = k->work_dim;
+    for (int j = 0; j < 3; j++) {
+      kk.global_work_size[j] = k->global_work_size[j];
+      kk.local_work_size[j] = k->local_work_size[j];
+    }
+    kk.num_args = k->num_args;
+    kk.first_arg = args.size();
+    for (int i = 0; i < k->num_args; i++) {
+      ThneedArg arg = {};
+      arg.size = k->args_size[i];
+      arg.length = k->args[i].size();
+      arg.value_offset = blob_add(k->args[i]);
+      args.push_back(arg);
     }
+    kernels.push_back(kk);
+  }
+
+  // program binaries were queued before the weights are known, point them at their table entries now
+  int binary_idx = 0;
+  for (auto &prg : programs) {
+    if (prg.is_binary) data[binary_idx++].first = &prg.data_offset;
   }
 
-  vector<string> saved_buffers;
   for (auto &obj : objects) {
-    auto mobj = obj.object_items();
-    cl_mem val = *(cl_mem*)(mobj["id"].string_value().data());
-    int sz = mobj["size"].int_value();
-    if (mobj["needs_load"].bool_value()) {
-      char *buf = (char *)malloc(sz);
-      if (mobj["arg_type"] == "image2d_t" || mobj["arg_type"] == "image1d_t") {
-        assert(false);
-      } else {
-        // buffers allocated with CL_MEM_HOST_WRITE_ONLY, hence this hack
-        //hexdump((uint32_t*)val, 0x100);
+    if (!obj.needs_load) continue;
+    string buf(obj.size, '\x00');
+    if (obj.type != THNEED_OBJ_BUFFER) {
+      assert(false);
+    } else {
+      // buffers allocated with CL_MEM_HOST_WRITE_ONLY, hence this hack
+      cl_mem val = (cl_mem)obj.id;
 
-        // the worst hack in thneed, the flags are at 0x14
-        ((uint32_t*)val)[0x14] &= ~CL_MEM_HOST_WRITE_ONLY;
-        cl_int ret = clEnqueueReadBuffer(command_queue, val, CL_TRUE, 0, sz, buf, 0, NULL, NULL);
-        assert(ret == CL_SUCCESS);
-      }
-      //printf("saving buffer: %d %p %s\n", sz, buf, mobj["arg_type"].string_value().c_str());
-      saved_buffers.push_back(string(buf, sz));
-      free(buf);
+      // the worst hack in thneed, the flags are at 0x14
+      ((uint32_t*)val)[0x14] &= ~CL_MEM_HOST_WRITE_ONLY;
+      cl_int ret = clEnqueueReadBuffer(command_queue, val, CL_TRUE, 0, obj.size, (void *)buf.data(), 0, NULL, NULL);
+      assert(ret == CL_SUCCESS);
     }
+    data.push_back({&obj.data_offset, buf});
   }
 
-  std::vector<Json> jbinaries;
-  for (auto &obj : binaries) {
-    jbinaries.push_back(Json::object({{"name", obj.first}, {"length", (int)obj.second.size()}}));
-    saved_buffers.push_back(obj.second);
+  // lay out the file
+  ThneedHeader hdr = {};
+  memcpy(hdr.magic, THNEED_MAGIC, sizeof(hdr.magic));
+  hdr.version = THNEED_VERSION;
+  hdr.num_objects = objects.size();
+  hdr.num_programs = programs.size();
+  hdr.num_kernels = kernels.size();
+  hdr.num_args = args.size();
+  hdr.objects_offset = sizeof(hdr);
+  hdr.programs_offset = hdr.objects_offset + objects.size() * sizeof(ThneedObject);
+  hdr.kernels_offset = hdr.programs_offset + programs.size() * sizeof(ThneedProgram);
+  hdr.args_offset = hdr.kernels_offset + kernels.size() * sizeof(ThneedKernel);
+  hdr.blob_offset = hdr.args_offset + args.size() * sizeof(ThneedArg);
+
+  uint64_t ptr = align_up(hdr.blob_offset + blob.size());
+  for (auto &d : data) {
+    *d.first = ptr;
+    ptr = align_up(ptr + d.second.size());
   }
-
-  Json jdat = Json::object({
-    {"kernels", kernels},
-    {"objects", objects},
-    {"programs", programs},
-    {"binaries", jbinaries},
-  });
-
-  string str = jdat.dump();
-  int jsz = str.length();
+  hdr.file_size = ptr;
 
   FILE *f = fopen(filename, "wb");
-  fwrite(&jsz, 1, sizeof(jsz), f);
-  fwrite(str.data(), 1, jsz, f);
-  for (auto &s : saved_buffers) {
-    fwrite(s.data(), 1, s.length(), f);
+  assert(f != NULL);
+  fwrite(&hdr, 1, sizeof(hdr), f);
+  fwrite(objects.data(), sizeof(ThneedObject), objects.size(), f);
+  fwrite(programs.data(), sizeof(ThneedProgram), programs.size(), f);
+  fwrite(kernels.data(), sizeof(ThneedKernel), kernels.size(), f);
+  fwrite(args.data(), sizeof(ThneedArg), args.size(), f);
+  fwrite(blob.data(), 1, blob.size(), f);
+  for (auto &d : data) {
+    fseek(f, *d.first, SEEK_SET);
+    fwrite(d.second.data(), 1, d.second.size(), f);
   }
+  // pad out the last section
+  fflush(f);
+  int err = ftruncate(fileno(f), hdr.file_size);
+  assert(err == 0);
   fclose(f);
 }
-
-Json CLQueuedKernel::to_json() const {
-  return Json::object {
-    { "name", name },
-    { "work_dim", (int)work_dim },
-    { "global_work_size", Json::array { (int)global_work_size[0], (int)global_work_size[1], (int)global_work_size[2] } },
-    { "local_work_size", Json::array { (int)local_work_size[0], (int)local_work_size[1], (int)local_work_size[2] } },
-    { "num_args", (int)num_args },
-    { "args", args },
-    { "args_size", args_size },
-  };
-}
-
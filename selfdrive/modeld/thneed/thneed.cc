@@ -498,6 +498,9 @@ int CLQueuedKernel::get_arg_num(const char *search_arg_name) {
 
 cl_int CLQueuedKernel::exec() {
   if (kernel == NULL) {
+    // binary thneed files defer building programs to first use
+    if (program == NULL) thneed->build_program(name);
+
     kernel = clCreateKernel(program, name.c_str(), NULL);
     arg_names.clear();
     arg_types.clear();
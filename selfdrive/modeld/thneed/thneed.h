@@ -6,6 +6,7 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -20,9 +21,6 @@
 
 using namespace std;
 
-namespace json11 {
-  class Json;
-}
 class Thneed;
 
 class GPUMalloc {
@@ -46,7 +44,7 @@ class CLQueuedKernel {
     cl_int exec();
     void debug_print(bool verbose);
     int get_arg_num(const char *search_arg_name);
-    cl_program program;
+    cl_program program = NULL;
     string name;
     cl_uint num_args;
     vector<string> arg_names;
@@ -54,7 +52,6 @@ class CLQueuedKernel {
     vector<string> args;
     vector<int> args_size;
     cl_kernel kernel = NULL;
-    json11::Json to_json() const;
 
     cl_uint work_dim;
     size_t global_work_size[3] = {0};
@@ -127,7 +124,19 @@ class Thneed {
     // loading and saving
     void load(const char *filename);
     void save(const char *filename, bool save_binaries=false);
+    cl_program build_program(const string &name);
   private:
     void clinit();
+    void load_json(const char *filename);
+
+    // binary model file, kept mapped since weights may be used in place
+    void *mapped = NULL;
+    size_t mapped_size = 0;
+    struct PendingProgram {
+      const char *data;
+      size_t length;
+      bool is_binary;
+    };
+    map<string, PendingProgram> pending_programs;
 };
 
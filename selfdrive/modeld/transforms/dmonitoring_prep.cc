@@ -0,0 +1,177 @@
+#include "selfdrive/modeld/transforms/dmonitoring_prep.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// ***** CPU *****
+
+static bool params_equal(const DMPrepParams &a, const DMPrepParams &b) {
+  return a.width == b.width && a.height == b.height && a.mirror == b.mirror &&
+         memcmp(&a.crop, &b.crop, sizeof(DMRect)) == 0 && memcmp(&a.dst, &b.dst, sizeof(DMRect)) == 0;
+}
+
+// taps for one axis: out_len positions, of which [dst_off, dst_off + dst_len) sample src_len pixels starting at src_off.
+// positions outside the region get x0 = -1
+static void build_taps(std::vector<DMTap> &taps, int out_len, int src_off, int src_len, int dst_off, int dst_len, bool mirror) {
+  taps.resize(out_len);
+  for (int i = 0; i < out_len; i++) {
+    if (i < dst_off || i >= dst_off + dst_len) {
+      taps[i] = {-1, -1, 0};
+      continue;
+    }
+    // pixel center origin, same as the OpenCL path
+    const float f = std::clamp((i - dst_off + 0.5f) * src_len / dst_len - 0.5f, 0.0f, (float)(src_len - 1));
+    int x0 = (int)f;
+    int x1 = std::min(x0 + 1, src_len - 1);
+    if (mirror) {
+      x0 = src_len - 1 - x0;
+      x1 = src_len - 1 - x1;
+    }
+    taps[i] = {src_off + x0, src_off + x1, (int)lroundf((f - (int)f) * 256)};
+  }
+}
+
+void dmonitoring_prep_cpu_init(DMPrepCPUState* s, int out_width, int out_height) {
+  s->out_width = out_width;
+  s->out_height = out_height;
+  s->valid = false;
+}
+
+static void update_taps(DMPrepCPUState* s, const DMPrepParams &p) {
+  if (s->valid && params_equal(s->params, p)) return;
+  // luma columns are scaled in even/odd pairs
+  assert(p.dst.x % 2 == 0 && p.dst.w % 2 == 0);
+
+  build_taps(s->y_cols, s->out_width, p.crop.x, p.crop.w, p.dst.x, p.dst.w, p.mirror);
+  build_taps(s->y_rows, s->out_height, p.crop.y, p.crop.h, p.dst.y, p.dst.h, false);
+  // chroma of an odd sized region rounds up, like libyuv
+  build_taps(s->uv_cols, s->out_width / 2, p.crop.x / 2, (p.crop.w + 1) / 2, p.dst.x / 2, p.dst.w / 2, p.mirror);
+  build_taps(s->uv_rows, s->out_height / 2, p.crop.y / 2, (p.crop.h + 1) / 2, p.dst.y / 2, (p.dst.h + 1) / 2, false);
+  s->blend.resize(p.width);
+  s->params = p;
+  s->valid = true;
+}
+
+static inline float normalize(int v) {
+  return (v - 128.f) * 0.0078125f;
+}
+
+// vertically blends the two source rows of ty over the crop columns, in 1/256
+static void blend_rows(uint16_t *blend, const uint8_t *plane, int stride, int src_off, int src_len, const DMTap &ty) {
+  const uint8_t *r0 = plane + ty.x0 * stride + src_off;
+  const uint8_t *r1 = plane + ty.x1 * stride + src_off;
+  const int wy = ty.w;
+  blend += src_off;
+  for (int x = 0; x < src_len; x++) {
+    blend[x] = r0[x] * (256 - wy) + r1[x] * wy;
+  }
+}
+
+// horizontal pass over every step-th column tap starting at first, rounded to 8 bits and normalized
+static void scale_cols(float *out, const uint16_t *blend, const DMTap *cols, int first, int step, int len) {
+  for (int c = 0; c < len; c++) {
+    const DMTap &tx = cols[first + c * step];
+    out[c] = normalize((blend[tx.x0] * (256 - tx.w) + blend[tx.x1] * tx.w + (1 << 15)) >> 16);
+  }
+}
+
+// the columns of out outside [col_off, col_off + col_len) are black
+static void fill_outside(float *out, int out_len, int col_off, int col_len) {
+  std::fill(out, out + col_off, normalize(0));
+  std::fill(out + col_off + col_len, out + out_len, normalize(0));
+}
+
+void dmonitoring_prep_cpu(DMPrepCPUState* s, const uint8_t *yuv, const DMPrepParams &params, float *out) {
+  update_taps(s, params);
+
+  const int width = params.width;
+  const int out_w = s->out_width / 2;
+  const int plane_size = out_w * (s->out_height / 2);
+  const uint8_t *y = yuv;
+  const uint8_t *u = y + width * params.height;
+  const uint8_t *v = u + (width / 2) * (params.height / 2);
+  const DMRect &crop = params.crop, &dst = params.dst;
+  uint16_t *blend = s->blend.data();
+
+  // output columns of the region, the same for the luma pairs and chroma
+  const int first = dst.x / 2, len = dst.w / 2;
+
+  // 02
+  // 13
+  for (int row = 0; row < s->out_height; row++) {
+    float *even = out + (row & 1) * plane_size + (row / 2) * out_w;  // y0 or y1
+    float *odd = even + 2 * plane_size;                               // y2 or y3
+    const DMTap &ty = s->y_rows[row];
+    if (ty.x0 < 0) {
+      std::fill(even, even + out_w, normalize(0));
+      std::fill(odd, odd + out_w, normalize(0));
+      continue;
+    }
+    blend_rows(blend, y, width, crop.x, crop.w, ty);
+    scale_cols(even + first, blend, s->y_cols.data(), 2 * first, 2, len);
+    scale_cols(odd + first, blend, s->y_cols.data(), 2 * first + 1, 2, len);
+    fill_outside(even, out_w, first, len);
+    fill_outside(odd, out_w, first, len);
+  }
+
+  const int uv_src_len = (crop.w + 1) / 2;
+  float *out_u = out + 4*plane_size, *out_v = out + 5*plane_size;
+  for (int r = 0; r < s->out_height / 2; r++) {
+    const DMTap &ty = s->uv_rows[r];
+    float *planes[] = {out_u + r * out_w, out_v + r * out_w};
+    const uint8_t *srcs[] = {u, v};
+    for (int i = 0; i < 2; i++) {
+      if (ty.x0 < 0) {
+        std::fill(planes[i], planes[i] + out_w, normalize(0));
+        continue;
+      }
+      blend_rows(blend, srcs[i], width / 2, crop.x / 2, uv_src_len, ty);
+      scale_cols(planes[i] + first, blend, s->uv_cols.data(), first, 1, len);
+      fill_outside(planes[i], out_w, first, len);
+    }
+  }
+}
+
+// ***** OpenCL *****
+
+void dmonitoring_prep_init(DMPrepState* s, cl_context ctx, cl_device_id device_id, int out_width, int out_height) {
+  s->out_width = out_width;
+  s->out_height = out_height;
+
+  char args[1024];
+  snprintf(args, sizeof(args),
+           "-cl-fast-relaxed-math -cl-denorms-are-zero "
+           "-DMODEL_WIDTH=%d -DMODEL_HEIGHT=%d",
+           out_width, out_height);
+  cl_program prg = cl_program_from_file(ctx, device_id, "transforms/dmonitoring_prep.cl", args);
+  s->krnl = CL_CHECK_ERR(clCreateKernel(prg, "dmonitoring_prep", &err));
+
+  // done with this
+  CL_CHECK(clReleaseProgram(prg));
+}
+
+void dmonitoring_prep_destroy(DMPrepState* s) {
+  CL_CHECK(clReleaseKernel(s->krnl));
+}
+
+void dmonitoring_prep_queue(DMPrepState* s, cl_command_queue q,
+                            cl_mem yuv_cl, const DMPrepParams &params,
+                            cl_mem out_cl) {
+  const cl_int args[] = {
+    params.width, params.height,
+    params.crop.x, params.crop.y, params.crop.w, params.crop.h,
+    params.dst.x, params.dst.y, params.dst.w, params.dst.h,
+    params.mirror,
+  };
+  CL_CHECK(clSetKernelArg(s->krnl, 0, sizeof(cl_mem), &yuv_cl));
+  for (int i = 0; i < std::size(args); i++) {
+    CL_CHECK(clSetKernelArg(s->krnl, i + 1, sizeof(cl_int), &args[i]));
+  }
+  CL_CHECK(clSetKernelArg(s->krnl, std::size(args) + 1, sizeof(cl_mem), &out_cl));
+
+  const size_t work_size[2] = {(size_t)s->out_width / 2, (size_t)s->out_height / 2};
+  CL_CHECK(clEnqueueNDRangeKernel(q, s->krnl, 2, NULL, work_size, NULL, 0, 0, NULL));
+}
@@ -0,0 +1,57 @@
+#define OUT_W (MODEL_WIDTH/2)
+#define OUT_H (MODEL_HEIGHT/2)
+#define PLANE_SIZE (OUT_W*OUT_H)
+
+float sample(__global const uchar *plane, int stride,
+             int cx, int cy, int cw, int ch,
+             int rx, int ry, int rw, int rh,
+             int mirror, int dx, int dy)
+{
+    if (dx < rx || dx >= rx + rw || dy < ry || dy >= ry + rh) return 0.0f;
+
+    // pixel center origin, same as the CPU path
+    const float fx = clamp((dx - rx + 0.5f) * cw / rw - 0.5f, 0.0f, (float)(cw - 1));
+    const float fy = clamp((dy - ry + 0.5f) * ch / rh - 0.5f, 0.0f, (float)(ch - 1));
+    int x0 = (int)fx;
+    int y0 = (int)fy;
+    int x1 = min(x0 + 1, cw - 1);
+    const int y1 = min(y0 + 1, ch - 1);
+    const float wx = fx - x0;
+    const float wy = fy - y0;
+    if (mirror) {
+      x0 = cw - 1 - x0;
+      x1 = cw - 1 - x1;
+    }
+
+    __global const uchar *r0 = plane + (cy + y0) * stride + cx;
+    __global const uchar *r1 = plane + (cy + y1) * stride + cx;
+    const float top = mix((float)r0[x0], (float)r0[x1], wx);
+    const float bot = mix((float)r1[x0], (float)r1[x1], wx);
+    return mix(top, bot, wy);
+}
+
+__kernel void dmonitoring_prep(__global const uchar *yuv, int width, int height,
+                               int cx, int cy, int cw, int ch,
+                               int rx, int ry, int rw, int rh,
+                               int mirror, __global float *out)
+{
+    const int c = get_global_id(0);
+    const int r = get_global_id(1);
+    const int o = r * OUT_W + c;
+
+    __global const uchar *y = yuv;
+    __global const uchar *u = y + width * height;
+    __global const uchar *v = u + (width / 2) * (height / 2);
+
+    // 02
+    // 13
+    #define Y(dx, dy) sample(y, width, cx, cy, cw, ch, rx, ry, rw, rh, mirror, 2*c + dx, 2*r + dy)
+    // chroma of an odd sized region rounds up, like libyuv
+    #define UV(p) sample(p, width / 2, cx / 2, cy / 2, (cw + 1) / 2, (ch + 1) / 2, rx / 2, ry / 2, (rw + 1) / 2, (rh + 1) / 2, mirror, c, r)
+    out[o + 0*PLANE_SIZE] = (Y(0, 0) - 128.0f) * 0.0078125f;
+    out[o + 1*PLANE_SIZE] = (Y(0, 1) - 128.0f) * 0.0078125f;
+    out[o + 2*PLANE_SIZE] = (Y(1, 0) - 128.0f) * 0.0078125f;
+    out[o + 3*PLANE_SIZE] = (Y(1, 1) - 128.0f) * 0.0078125f;
+    out[o + 4*PLANE_SIZE] = (UV(u) - 128.0f) * 0.0078125f;
+    out[o + 5*PLANE_SIZE] = (UV(v) - 128.0f) * 0.0078125f;
+}
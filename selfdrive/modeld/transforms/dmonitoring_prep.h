@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "selfdrive/common/clutil.h"
+
+// crops, optionally mirrors and bilinearly scales an I420 frame in one pass,
+// writing the normalized y0|y1|y2|y3|u|v float input of the driver monitoring model
+
+typedef struct {
+  int x, y, w, h;
+} DMRect;
+
+typedef struct {
+  int width, height;  // source frame
+  DMRect crop;        // in the source frame
+  DMRect dst;         // luma region of the model input the crop is scaled into, the rest is black. x and w are even
+  bool mirror;
+} DMPrepParams;
+
+// CPU: per column and row source taps, rebuilt when the params change.
+// Each output row is a vertical blend of two source rows over the crop, which the compiler
+// vectorizes, and a branch-free horizontal pass over the column taps that also normalizes.
+// Columns outside the region are filled separately.
+typedef struct {
+  int x0, x1;
+  int w;  // weight of x1 in 1/256
+} DMTap;
+
+typedef struct {
+  int out_width, out_height;
+  DMPrepParams params;
+  bool valid;
+  std::vector<DMTap> y_cols, y_rows, uv_cols, uv_rows;
+  std::vector<uint16_t> blend;  // vertically blended source row, in 1/256
+} DMPrepCPUState;
+
+void dmonitoring_prep_cpu_init(DMPrepCPUState* s, int out_width, int out_height);
+void dmonitoring_prep_cpu(DMPrepCPUState* s, const uint8_t *yuv, const DMPrepParams &params, float *out);
+
+// OpenCL
+typedef struct {
+  int out_width, out_height;
+  cl_kernel krnl;
+} DMPrepState;
+
+void dmonitoring_prep_init(DMPrepState* s, cl_context ctx, cl_device_id device_id, int out_width, int out_height);
+
+void dmonitoring_prep_destroy(DMPrepState* s);
+
+void dmonitoring_prep_queue(DMPrepState* s, cl_command_queue q,
+                            cl_mem yuv_cl, const DMPrepParams &params,
+                            cl_mem out_cl);
@@ -1,21 +1,67 @@
 
 #include <sys/resource.h>
 
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
+#include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/timing.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/proclogd/proclog.h"
+#include "selfdrive/proclogd/thread_sampler.h"
 
 ExitHandler do_exit;
 
 int main(int argc, char **argv) {
   setpriority(PRIO_PROCESS, 0, -15);
 
+  // sampling is cheap enough to run much faster when profiling
+  const int interval_ms = util::getenv("PROCLOGD_INTERVAL_MS", 2000);
+
+  // per-thread telemetry of the comma separated processes, e.g. PROCLOGD_THREADS=modeld,camerad,controlsd
+  std::vector<std::string> tags;
+  std::istringstream tag_list(util::getenv("PROCLOGD_THREADS"));
+  for (std::string tag; std::getline(tag_list, tag, ',');) {
+    if (!tag.empty()) tags.push_back(tag);
+  }
+  std::unique_ptr<ThreadSampler> thread_sampler;
+  uint64_t thread_period = 0;
+  if (!tags.empty()) {
+    thread_sampler = std::make_unique<ThreadSampler>(tags);
+    thread_period = 1e9 / std::max(1, util::getenv("PROCLOGD_THREADS_HZ", 20));
+  }
+
   PubMaster publisher({"procLog"});
+  uint64_t next_proclog = nanos_since_boot();
+  uint64_t next_threads = next_proclog;
   while (!do_exit) {
-    MessageBuilder msg;
-    buildProcLogMessage(msg);
-    publisher.send("procLog", msg);
+    uint64_t now = nanos_since_boot();
+    if (now >= next_proclog) {
+      MessageBuilder msg;
+      buildProcLogMessage(msg);
+      publisher.send("procLog", msg);
+      next_proclog += interval_ms * 1000000ULL;
+    }
+
+    // the thread deltas go to the logs, next to the events they explain
+    if (thread_sampler && now >= next_threads) {
+      std::string threads = thread_sampler->sample(now);
+      if (!threads.empty()) {
+        LOG("proclogd threads %s", threads.c_str());
+      }
+      next_threads += thread_period;
+    }
 
-    util::sleep_for(2000);  // 2 secs
+    now = nanos_since_boot();
+    uint64_t next = thread_sampler ? std::min(next_proclog, next_threads) : next_proclog;
+    if (next > now) {
+      util::sleep_for((next - now) / 1000000);
+    } else {
+      // fell behind, don't try to catch up
+      next_proclog = std::max(next_proclog, now);
+      next_threads = std::max(next_threads, now);
+    }
   }
 
   return 0;
@@ -1,48 +1,147 @@
 #include "selfdrive/proclogd/proclog.h"
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
-#include <fstream>
+#include <cstring>
 #include <iterator>
-#include <sstream>
+#include <unordered_map>
 
 #include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/util.h"
 
+std::string_view ProcReader::read(int fd) {
+  while (true) {
+    ssize_t n = pread(fd, buf.data(), buf.size(), 0);
+    if (n < 0) {
+      return {};
+    }
+    if ((size_t)n < buf.size()) {
+      return {buf.data(), (size_t)n};
+    }
+    buf.resize(buf.size() * 2);
+  }
+}
+
+std::string_view ProcReader::read(const char *path) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return {};
+  }
+  std::string_view ret = read(fd);
+  close(fd);
+  return ret;
+}
+
 namespace Parser {
 
+static inline void skip_spaces(const char *&p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t')) p++;
+}
+
+// parses the number at p and moves p past it
+template <typename T>
+static bool parse_num(const char *&p, const char *end, T &val) {
+  skip_spaces(p, end);
+  const bool neg = p < end && *p == '-';
+  if (neg) p++;
+  if (p == end || *p < '0' || *p > '9') {
+    return false;
+  }
+  unsigned long long r = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    r = r * 10 + (*p++ - '0');
+  }
+  val = neg ? (T)(-(long long)r) : (T)r;
+  return true;
+}
+
+static inline std::string_view next_line(std::string_view &str) {
+  size_t n = str.find('\n');
+  std::string_view line = str.substr(0, n);
+  str.remove_prefix(n == std::string_view::npos ? str.size() : n + 1);
+  return line;
+}
+
 // parse /proc/stat
-std::vector<CPUTime> cpuTimes(std::istream &stream) {
-  std::vector<CPUTime> cpu_times;
-  std::string line;
+void cpuTimes(std::string_view stat, std::vector<CPUTime> &cpu_times) {
+  cpu_times.clear();
   // skip the first line for cpu total
-  std::getline(stream, line);
-  while (std::getline(stream, line)) {
+  next_line(stat);
+  while (!stat.empty()) {
+    std::string_view line = next_line(stat);
     if (line.compare(0, 3, "cpu") != 0) break;
 
     CPUTime t = {};
-    std::istringstream iss(line);
-    if (iss.ignore(3) >> t.id >> t.utime >> t.ntime >> t.stime >> t.itime >> t.iowtime >> t.irqtime >> t.sirqtime)
+    const char *p = line.data() + 3, *end = line.data() + line.size();
+    if (parse_num(p, end, t.id) && parse_num(p, end, t.utime) && parse_num(p, end, t.ntime) &&
+        parse_num(p, end, t.stime) && parse_num(p, end, t.itime) && parse_num(p, end, t.iowtime) &&
+        parse_num(p, end, t.irqtime) && parse_num(p, end, t.sirqtime)) {
       cpu_times.push_back(t);
+    }
   }
-  return cpu_times;
 }
 
 // parse /proc/meminfo
-std::unordered_map<std::string, uint64_t> memInfo(std::istream &stream) {
-  std::unordered_map<std::string, uint64_t> mem_info;
-  std::string line, key;
-  while (std::getline(stream, line)) {
-    uint64_t val = 0;
-    std::istringstream iss(line);
-    if (iss >> key >> val) {
-      mem_info[key] = val * 1024;
+MemInfo memInfo(std::string_view meminfo) {
+  static const std::pair<std::string_view, uint64_t MemInfo::*> keys[] = {
+    {"MemTotal:", &MemInfo::total},
+    {"MemFree:", &MemInfo::free},
+    {"MemAvailable:", &MemInfo::available},
+    {"Buffers:", &MemInfo::buffers},
+    {"Cached:", &MemInfo::cached},
+    {"Active:", &MemInfo::active},
+    {"Inactive:", &MemInfo::inactive},
+    {"Shmem:", &MemInfo::shared},
+  };
+
+  MemInfo mem_info = {};
+  while (!meminfo.empty()) {
+    std::string_view line = next_line(meminfo);
+    std::string_view key = line.substr(0, line.find(' '));
+    for (const auto &[name, field] : keys) {
+      uint64_t val = 0;
+      const char *p = line.data() + key.size(), *end = line.data() + line.size();
+      if (key == name && parse_num(p, end, val)) {
+        mem_info.*field = val * 1024;
+        break;
+      }
     }
   }
   return mem_info;
 }
 
+// value of the "key: value" line starting with key
+static bool find_value(std::string_view str, std::string_view key, uint64_t &val) {
+  for (size_t pos = 0; (pos = str.find(key, pos)) != std::string_view::npos; pos += key.size()) {
+    if (pos != 0 && str[pos - 1] != '\n') continue;
+
+    const char *p = str.data() + pos + key.size(), *end = str.data() + str.size();
+    while (p < end && (*p == ' ' || *p == '\t' || *p == ':')) p++;
+    return parse_num(p, end, val);
+  }
+  return false;
+}
+
+// parse /proc/pid/task/tid/schedstat
+bool schedStat(std::string_view schedstat, ThreadStat &t) {
+  const char *p = schedstat.data(), *end = schedstat.data() + schedstat.size();
+  return parse_num(p, end, t.run_time) && parse_num(p, end, t.wait_time) && parse_num(p, end, t.timeslices);
+}
+
+// parse the context switches of /proc/pid/task/tid/status
+bool ctxtSwitches(std::string_view status, ThreadStat &t) {
+  return find_value(status, "voluntary_ctxt_switches", t.voluntary_switches) &&
+         find_value(status, "nonvoluntary_ctxt_switches", t.involuntary_switches);
+}
+
+bool migrations(std::string_view sched, uint64_t &migrations) {
+  return find_value(sched, "se.nr_migrations", migrations);
+}
+
 // field position (https://man7.org/linux/man-pages/man5/proc.5.html)
 enum StatPos {
   pid = 1,
@@ -63,103 +162,125 @@ enum StatPos {
 };
 
 // parse /proc/pid/stat
-std::optional<ProcStat> procStat(std::string stat) {
+bool procStat(std::string_view stat, ProcStat &p) {
   // To avoid being fooled by names containing a closing paren, scan backwards.
   auto open_paren = stat.find('(');
   auto close_paren = stat.rfind(')');
-  if (open_paren == std::string::npos || close_paren == std::string::npos || open_paren > close_paren) {
-    return std::nullopt;
-  }
-
-  std::string name = stat.substr(open_paren + 1, close_paren - open_paren - 1);
-  // repace space in name with _
-  std::replace(&stat[open_paren], &stat[close_paren], ' ', '_');
-  std::istringstream iss(stat);
-  std::vector<std::string> v{std::istream_iterator<std::string>(iss),
-                             std::istream_iterator<std::string>()};
-  try {
-    if (v.size() != StatPos::MAX_FIELD) {
-      throw std::invalid_argument("stat");
+  if (open_paren == std::string_view::npos || close_paren == std::string_view::npos || open_paren > close_paren) {
+    return false;
+  }
+
+  std::string_view name = stat.substr(open_paren + 1, close_paren - open_paren - 1);
+  if (p.name != name) {
+    p.name = name;
+  }
+
+  const char *s = stat.data(), *end = stat.data() + stat.size();
+  bool ok = parse_num(s, s + open_paren, p.pid);
+
+  // the name is field 2, the rest are separated by single spaces
+  int field = 2;
+  s = stat.data() + close_paren + 1;
+  while (ok) {
+    while (s < end && (*s == ' ' || *s == '\n')) s++;
+    if (s == end) break;
+
+    const char *tok = s;
+    while (s < end && *s != ' ' && *s != '\n') s++;
+    switch (++field) {
+      case StatPos::state: p.state = *tok; break;
+      case StatPos::ppid: ok = parse_num(tok, s, p.ppid); break;
+      case StatPos::utime: ok = parse_num(tok, s, p.utime); break;
+      case StatPos::stime: ok = parse_num(tok, s, p.stime); break;
+      case StatPos::cutime: ok = parse_num(tok, s, p.cutime); break;
+      case StatPos::cstime: ok = parse_num(tok, s, p.cstime); break;
+      case StatPos::priority: ok = parse_num(tok, s, p.priority); break;
+      case StatPos::nice: ok = parse_num(tok, s, p.nice); break;
+      case StatPos::num_threads: ok = parse_num(tok, s, p.num_threads); break;
+      case StatPos::starttime: ok = parse_num(tok, s, p.starttime); break;
+      case StatPos::vsize: ok = parse_num(tok, s, p.vms); break;
+      case StatPos::rss: ok = parse_num(tok, s, p.rss); break;
+      case StatPos::processor: ok = parse_num(tok, s, p.processor); break;
     }
-    ProcStat p = {
-      .name = name,
-      .pid = stoi(v[StatPos::pid - 1]),
-      .state = v[StatPos::state - 1][0],
-      .ppid = stoi(v[StatPos::ppid - 1]),
-      .utime = stoul(v[StatPos::utime - 1]),
-      .stime = stoul(v[StatPos::stime - 1]),
-      .cutime = stol(v[StatPos::cutime - 1]),
-      .cstime = stol(v[StatPos::cstime - 1]),
-      .priority = stol(v[StatPos::priority - 1]),
-      .nice = stol(v[StatPos::nice - 1]),
-      .num_threads = stol(v[StatPos::num_threads - 1]),
-      .starttime = stoull(v[StatPos::starttime - 1]),
-      .vms = stoul(v[StatPos::vsize - 1]),
-      .rss = stoul(v[StatPos::rss - 1]),
-      .processor = stoi(v[StatPos::processor - 1]),
-    };
-    return p;
-  } catch (const std::invalid_argument &e) {
-    LOGE("failed to parse procStat (%s) :%s", e.what(), stat.c_str());
-  } catch (const std::out_of_range &e) {
-    LOGE("failed to parse procStat (%s) :%s", e.what(), stat.c_str());
-  }
-  return std::nullopt;
+  }
+
+  if (!ok || field != StatPos::MAX_FIELD) {
+    LOGE("failed to parse procStat (field %d) :%.*s", field, (int)stat.size(), stat.data());
+    return false;
+  }
+  return true;
 }
 
 // return list of PIDs from /proc
-std::vector<int> pids() {
-  std::vector<int> ids;
-  DIR *d = opendir("/proc");
+void pids(std::vector<int> &ids) {
+  static DIR *d = opendir("/proc");
   assert(d);
+  rewinddir(d);
+
+  ids.clear();
   char *p_end;
   struct dirent *de = NULL;
   while ((de = readdir(d))) {
     if (de->d_type == DT_DIR) {
       int pid = strtol(de->d_name, &p_end, 10);
-      if (p_end == (de->d_name + strlen(de->d_name))) {
+      if (p_end != de->d_name && *p_end == '\0') {
         ids.push_back(pid);
       }
     }
   }
-  closedir(d);
-  return ids;
 }
 
 // null-delimited cmdline arguments to vector
-std::vector<std::string> cmdline(std::istream &stream) {
-  std::vector<std::string> ret;
-  std::string line;
-  while (std::getline(stream, line, '\0')) {
-    if (!line.empty()) {
-      ret.push_back(line);
+void cmdline(std::string_view str, std::vector<std::string> &args) {
+  args.clear();
+  while (!str.empty()) {
+    size_t n = str.find('\0');
+    if (n != 0) {
+      args.emplace_back(str.substr(0, n));
     }
+    str.remove_prefix(n == std::string_view::npos ? str.size() : n + 1);
   }
-  return ret;
 }
 
-const ProcCache &getProcExtraInfo(int pid, const std::string &name) {
-  static std::unordered_map<pid_t, ProcCache> proc_cache;
+static std::unordered_map<int, ProcCache> proc_cache;
+static uint64_t proc_cache_generation = 0;
+
+const ProcCache &getProcExtraInfo(int pid, unsigned long long starttime, const std::string &name) {
   ProcCache &cache = proc_cache[pid];
-  if (cache.pid != pid || cache.name != name) {
+  if (cache.pid != pid || cache.starttime != starttime || cache.name != name) {
     cache.pid = pid;
+    cache.starttime = starttime;
     cache.name = name;
-    std::string proc_path = "/proc/" + std::to_string(pid);
-    cache.exe = util::readlink(proc_path + "/exe");
-    std::ifstream stream(proc_path + "/cmdline");
-    cache.cmdline = cmdline(stream);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/exe", pid);
+    cache.exe = util::readlink(path);
+    snprintf(path, sizeof(path), "/proc/%d/cmdline", pid);
+    ProcReader reader;
+    cmdline(reader.read(path), cache.cmdline);
   }
+  cache.generation = proc_cache_generation;
   return cache;
 }
 
+void evictProcCache() {
+  for (auto it = proc_cache.begin(); it != proc_cache.end();) {
+    it = it->second.generation != proc_cache_generation ? proc_cache.erase(it) : std::next(it);
+  }
+  proc_cache_generation++;
+}
+
 }  // namespace Parser
 
 const double jiffy = sysconf(_SC_CLK_TCK);
 const size_t page_size = sysconf(_SC_PAGE_SIZE);
 
+static ProcReader reader;
+
 void buildCPUTimes(cereal::ProcLog::Builder &builder) {
-  std::ifstream stream("/proc/stat");
-  std::vector<CPUTime> stats = Parser::cpuTimes(stream);
+  static int fd = open("/proc/stat", O_RDONLY | O_CLOEXEC);
+  static std::vector<CPUTime> stats;
+  Parser::cpuTimes(reader.read(fd), stats);
 
   auto log_cpu_times = builder.initCpuTimes(stats.size());
   for (int i = 0; i < stats.size(); ++i) {
@@ -177,33 +298,40 @@ void buildCPUTimes(cereal::ProcLog::Builder &builder) {
 }
 
 void buildMemInfo(cereal::ProcLog::Builder &builder) {
-  std::ifstream stream("/proc/meminfo");
-  auto mem_info = Parser::memInfo(stream);
+  static int fd = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+  const MemInfo mem_info = Parser::memInfo(reader.read(fd));
 
   auto mem = builder.initMem();
-  mem.setTotal(mem_info["MemTotal:"]);
-  mem.setFree(mem_info["MemFree:"]);
-  mem.setAvailable(mem_info["MemAvailable:"]);
-  mem.setBuffers(mem_info["Buffers:"]);
-  mem.setCached(mem_info["Cached:"]);
-  mem.setActive(mem_info["Active:"]);
-  mem.setInactive(mem_info["Inactive:"]);
-  mem.setShared(mem_info["Shmem:"]);
+  mem.setTotal(mem_info.total);
+  mem.setFree(mem_info.free);
+  mem.setAvailable(mem_info.available);
+  mem.setBuffers(mem_info.buffers);
+  mem.setCached(mem_info.cached);
+  mem.setActive(mem_info.active);
+  mem.setInactive(mem_info.inactive);
+  mem.setShared(mem_info.shared);
 }
 
 void buildProcs(cereal::ProcLog::Builder &builder) {
-  auto pids = Parser::pids();
-  std::vector<ProcStat> proc_stats;
-  proc_stats.reserve(pids.size());
+  // kept across calls, so the names in them keep their storage
+  static std::vector<int> pids;
+  static std::vector<ProcStat> proc_stats;
+
+  Parser::pids(pids);
+  if (proc_stats.size() < pids.size()) {
+    proc_stats.resize(pids.size());
+  }
+  size_t count = 0;
   for (int pid : pids) {
-    std::string path = "/proc/" + std::to_string(pid) + "/stat";
-    if (auto stat = Parser::procStat(util::read_file(path))) {
-      proc_stats.push_back(*stat);
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    if (Parser::procStat(reader.read(path), proc_stats[count])) {
+      count++;
     }
   }
 
-  auto procs = builder.initProcs(proc_stats.size());
-  for (size_t i = 0; i < proc_stats.size(); i++) {
+  auto procs = builder.initProcs(count);
+  for (size_t i = 0; i < count; i++) {
     auto l = procs[i];
     const ProcStat &r = proc_stats[i];
     l.setPid(r.pid);
@@ -222,13 +350,14 @@ void buildProcs(cereal::ProcLog::Builder &builder) {
     l.setProcessor(r.processor);
     l.setName(r.name);
 
-    const ProcCache &extra_info = Parser::getProcExtraInfo(r.pid, r.name);
+    const ProcCache &extra_info = Parser::getProcExtraInfo(r.pid, r.starttime, r.name);
     l.setExe(extra_info.exe);
     auto lcmdline = l.initCmdline(extra_info.cmdline.size());
     for (size_t i = 0; i < lcmdline.size(); i++) {
       lcmdline.set(i, extra_info.cmdline[i]);
     }
   }
+  Parser::evictProcCache();
 }
 
 void buildProcLogMessage(MessageBuilder &msg) {
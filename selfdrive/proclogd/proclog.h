@@ -1,6 +1,7 @@
-#include <optional>
+#pragma once
+
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
 #include "cereal/messaging/messaging.h"
@@ -11,10 +12,16 @@ struct CPUTime {
   unsigned long iowtime, irqtime, sirqtime;
 };
 
+struct MemInfo {
+  uint64_t total, free, available, buffers, cached, active, inactive, shared;
+};
+
 struct ProcCache {
   int pid;
+  unsigned long long starttime;
   std::string name, exe;
   std::vector<std::string> cmdline;
+  uint64_t generation;
 };
 
 struct ProcStat {
@@ -26,14 +33,45 @@ struct ProcStat {
   std::string name;
 };
 
+struct ThreadStat {
+  int pid, tid, processor;
+  char state;
+  unsigned long utime, stime;
+  unsigned long long starttime;
+  uint64_t run_time, wait_time, timeslices;  // ns, from schedstat
+  uint64_t voluntary_switches, involuntary_switches;
+  uint64_t migrations;
+  std::string name;
+};
+
+// Reads whole /proc files with a single pread into a buffer that is reused
+// across reads and only grows when a file doesn't fit.
+class ProcReader {
+public:
+  ProcReader(size_t size = 4096) : buf(size) {}
+  // the views are valid until the next read
+  std::string_view read(int fd);
+  std::string_view read(const char *path);
+
+private:
+  std::vector<char> buf;
+};
+
 namespace Parser {
 
-std::vector<int> pids();
-std::optional<ProcStat> procStat(std::string stat);
-std::vector<std::string> cmdline(std::istream &stream);
-std::vector<CPUTime> cpuTimes(std::istream &stream);
-std::unordered_map<std::string, uint64_t> memInfo(std::istream &stream);
-const ProcCache &getProcExtraInfo(int pid, const std::string &name);
+void pids(std::vector<int> &ids);
+bool procStat(std::string_view stat, ProcStat &p);
+void cmdline(std::string_view str, std::vector<std::string> &args);
+void cpuTimes(std::string_view stat, std::vector<CPUTime> &cpu_times);
+MemInfo memInfo(std::string_view meminfo);
+bool schedStat(std::string_view schedstat, ThreadStat &t);
+bool ctxtSwitches(std::string_view status, ThreadStat &t);
+// se.nr_migrations from /proc/<pid>/task/<tid>/sched, which needs CONFIG_SCHED_DEBUG
+bool migrations(std::string_view sched, uint64_t &migrations);
+// exe and cmdline are only read again when the pid was reused or the process exec'd
+const ProcCache &getProcExtraInfo(int pid, unsigned long long starttime, const std::string &name);
+// drops processes that weren't looked up since the last call
+void evictProcCache();
 
 };  // namespace Parser
 
@@ -1,7 +1,13 @@
 #define CATCH_CONFIG_MAIN
 #include "catch2/catch.hpp"
+#include <atomic>
+#include <thread>
+
+#include "json11.hpp"
+#include "selfdrive/common/timing.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/proclogd/proclog.h"
+#include "selfdrive/proclogd/thread_sampler.h"
 
 const std::string allowed_states = "RSDTZtWXxKWPI";
 
@@ -12,32 +18,47 @@ TEST_CASE("Parser::procStat") {
         "0 20 0 39 0 53077 830029824 62214 18446744073709551615 94257242783744 94257366235808 "
         "140735738643248 0 0 0 0 4098 1073808632 0 0 0 17 2 0 0 2 0 0 94257370858656 94257371248232 "
         "94257404952576 140735738648768 140735738648823 140735738648823 140735738650595 0";
-    auto stat = Parser::procStat(stat_str);
-    REQUIRE(stat);
-    REQUIRE(stat->pid == 33012);
-    REQUIRE(stat->name == "code )");
-    REQUIRE(stat->state == 'S');
-    REQUIRE(stat->ppid == 32978);
-    REQUIRE(stat->utime == 24510);
-    REQUIRE(stat->stime == 11627);
-    REQUIRE(stat->cutime == 0);
-    REQUIRE(stat->cstime == 0);
-    REQUIRE(stat->priority == 20);
-    REQUIRE(stat->nice == 0);
-    REQUIRE(stat->num_threads == 39);
-    REQUIRE(stat->starttime == 53077);
-    REQUIRE(stat->vms == 830029824);
-    REQUIRE(stat->rss == 62214);
-    REQUIRE(stat->processor == 2);
+    ProcStat stat = {};
+    REQUIRE(Parser::procStat(stat_str, stat));
+    REQUIRE(stat.pid == 33012);
+    REQUIRE(stat.name == "code )");
+    REQUIRE(stat.state == 'S');
+    REQUIRE(stat.ppid == 32978);
+    REQUIRE(stat.utime == 24510);
+    REQUIRE(stat.stime == 11627);
+    REQUIRE(stat.cutime == 0);
+    REQUIRE(stat.cstime == 0);
+    REQUIRE(stat.priority == 20);
+    REQUIRE(stat.nice == 0);
+    REQUIRE(stat.num_threads == 39);
+    REQUIRE(stat.starttime == 53077);
+    REQUIRE(stat.vms == 830029824);
+    REQUIRE(stat.rss == 62214);
+    REQUIRE(stat.processor == 2);
+  }
+  SECTION("negative priority") {
+    const std::string stat_str =
+        "12 (rt) S 2 0 0 0 -1 69238848 0 0 0 0 0 0 0 0 -51 0 1 0 35 0 0 18446744073709551615 0 0 0 0 0 0 0 "
+        "2147483647 0 0 0 0 17 0 50 1 0 0 0 0 0 0 0 0 0 0 0";
+    ProcStat stat = {};
+    REQUIRE(Parser::procStat(stat_str, stat));
+    REQUIRE(stat.priority == -51);
+    REQUIRE(stat.starttime == 35);
+  }
+  SECTION("truncated") {
+    ProcStat stat = {};
+    REQUIRE(!Parser::procStat("33012 (code) S 32978 6620", stat));
   }
   SECTION("all processes") {
-    std::vector<int> pids = Parser::pids();
+    std::vector<int> pids;
+    Parser::pids(pids);
     REQUIRE(pids.size() > 1);
     int parsed_cnt = 0;
+    ProcStat stat = {};
     for (int pid : pids) {
-      if (auto stat = Parser::procStat(util::read_file("/proc/" + std::to_string(pid) + "/stat"))) {
-        REQUIRE(stat->pid == pid);
-        REQUIRE(allowed_states.find(stat->state) != std::string::npos);
+      if (Parser::procStat(util::read_file("/proc/" + std::to_string(pid) + "/stat"), stat)) {
+        REQUIRE(stat.pid == pid);
+        REQUIRE(allowed_states.find(stat.state) != std::string::npos);
         ++parsed_cnt;
       }
     }
@@ -51,8 +72,8 @@ TEST_CASE("Parser::cpuTimes") {
         "cpu  0 0 0 0 0 0 0 0 0 0\n"
         "cpu0 1 2 3 4 5 6 7 8 9 10\n"
         "cpu1 1 2 3 4 5 6 7 8 9 10\n";
-    std::istringstream stream(stat);
-    auto stats = Parser::cpuTimes(stream);
+    std::vector<CPUTime> stats;
+    Parser::cpuTimes(stat, stats);
     REQUIRE(stats.size() == 2);
     for (int i = 0; i < stats.size(); ++i) {
       REQUIRE(stats[i].id == i);
@@ -66,8 +87,8 @@ TEST_CASE("Parser::cpuTimes") {
     }
   }
   SECTION("all cpus") {
-    std::istringstream stream(util::read_file("/proc/stat"));
-    auto stats = Parser::cpuTimes(stream);
+    std::vector<CPUTime> stats;
+    Parser::cpuTimes(util::read_file("/proc/stat"), stats);
     REQUIRE(stats.size() == sysconf(_SC_NPROCESSORS_ONLN));
     for (int i = 0; i < stats.size(); ++i) {
       REQUIRE(stats[i].id == i);
@@ -77,26 +98,71 @@ TEST_CASE("Parser::cpuTimes") {
 
 TEST_CASE("Parser::memInfo") {
   SECTION("from string") {
-    std::istringstream stream("MemTotal:    1024 kb\nMemFree:    2048 kb\n");
-    auto meminfo = Parser::memInfo(stream);
-    REQUIRE(meminfo["MemTotal:"] == 1024 * 1024);
-    REQUIRE(meminfo["MemFree:"] == 2048 * 1024);
+    auto meminfo = Parser::memInfo("MemTotal:    1024 kb\nMemFree:    2048 kb\nActive(anon):    1 kb\n");
+    REQUIRE(meminfo.total == 1024 * 1024);
+    REQUIRE(meminfo.free == 2048 * 1024);
+    REQUIRE(meminfo.active == 0);
   }
   SECTION("from /proc/meminfo") {
-    std::string require_keys[] = {"MemTotal:", "MemFree:", "MemAvailable:", "Buffers:", "Cached:", "Active:", "Inactive:", "Shmem:"};
-    std::istringstream stream(util::read_file("/proc/meminfo"));
-    auto meminfo = Parser::memInfo(stream);
-    for (auto &key : require_keys) {
-      REQUIRE(meminfo.find(key) != meminfo.end());
-      REQUIRE(meminfo[key] > 0);
+    auto meminfo = Parser::memInfo(util::read_file("/proc/meminfo"));
+    for (uint64_t val : {meminfo.total, meminfo.free, meminfo.available, meminfo.buffers, meminfo.cached,
+                         meminfo.active, meminfo.inactive, meminfo.shared}) {
+      REQUIRE(val > 0);
     }
   }
 }
 
+TEST_CASE("Parser thread stats") {
+  ThreadStat t = {};
+  REQUIRE(Parser::schedStat("5000 1200 7\n", t));
+  REQUIRE(t.run_time == 5000);
+  REQUIRE(t.wait_time == 1200);
+  REQUIRE(t.timeslices == 7);
+
+  REQUIRE(Parser::ctxtSwitches("Name:\tx\nvoluntary_ctxt_switches:\t12\nnonvoluntary_ctxt_switches:\t3\n", t));
+  REQUIRE(t.voluntary_switches == 12);
+  REQUIRE(t.involuntary_switches == 3);
+  REQUIRE(!Parser::ctxtSwitches("Name:\tx\n", t));
+
+  uint64_t migrations = 0;
+  REQUIRE(Parser::migrations("x (1, #threads: 1)\n---\nse.nr_migrations                             :                   42\n", migrations));
+  REQUIRE(migrations == 42);
+}
+
+TEST_CASE("ThreadSampler") {
+  REQUIRE(ThreadSampler::matches("selfdrive.controls.controlsd", "controlsd"));
+  REQUIRE(ThreadSampler::matches("./_modeld", "modeld"));
+  REQUIRE(!ThreadSampler::matches("dmonitoringmodeld", "modeld"));
+
+  std::atomic<bool> done = false;
+  std::thread busy([&]() {
+    while (!done) {}
+  });
+
+  ThreadSampler sampler({"test_proclog"});
+  REQUIRE(sampler.sample(nanos_since_boot()).empty());
+  util::sleep_for(200);
+  std::string err;
+  auto json = json11::Json::parse(sampler.sample(nanos_since_boot()), err);
+  done = true;
+  busy.join();
+
+  REQUIRE(err.empty());
+  REQUIRE(json["dt"].number_value() > 0.1);
+  auto threads = json["threads"].array_items();
+  REQUIRE(threads.size() >= 2);
+  double cpu = 0;
+  for (auto &t : threads) {
+    REQUIRE(t["pid"].int_value() == getpid());
+    REQUIRE(t["process"].string_value() == "test_proclog");
+    cpu += t["cpuUser"].number_value() + t["cpuSystem"].number_value();
+  }
+  REQUIRE(cpu > 0.05);
+}
+
 void test_cmdline(std::string cmdline, const std::vector<std::string> requires) {
-  std::stringstream ss;
-  ss.write(&cmdline[0], cmdline.size());
-  auto cmds = Parser::cmdline(ss);
+  std::vector<std::string> cmds;
+  Parser::cmdline(cmdline, cmds);
   REQUIRE(cmds.size() == requires.size());
   for (int i = 0; i < requires.size(); ++i) {
     REQUIRE(cmds[i] == requires[i]);
@@ -108,8 +174,32 @@ TEST_CASE("Parser::cmdline") {
   test_cmdline(std::string("a\0b\0c\0\0\0", 9), {"a", "b", "c"});
 }
 
+TEST_CASE("ProcReader") {
+  // grows past its initial size for larger files
+  ProcReader reader(16);
+  std::string_view stat = reader.read("/proc/self/stat");
+  REQUIRE(stat.size() > 16);
+  REQUIRE(stat.substr(0, stat.find(' ')) == std::to_string(getpid()));
+  REQUIRE(reader.read("/proc/self/nonexistent").empty());
+}
+
+TEST_CASE("Parser::getProcExtraInfo") {
+  ProcStat stat = {};
+  REQUIRE(Parser::procStat(util::read_file("/proc/self/stat"), stat));
+
+  const ProcCache &cache = Parser::getProcExtraInfo(stat.pid, stat.starttime, stat.name);
+  REQUIRE_THAT(cache.exe, Catch::Matchers::Contains("test_proclog"));
+  REQUIRE(cache.cmdline.size() > 0);
+
+  // a different starttime is a new process with the same pid
+  const ProcCache &reused = Parser::getProcExtraInfo(stat.pid, stat.starttime + 1, stat.name);
+  REQUIRE(reused.starttime == stat.starttime + 1);
+  REQUIRE_THAT(reused.exe, Catch::Matchers::Contains("test_proclog"));
+}
+
 TEST_CASE("buildProcLogerMessage") {
-  std::vector<int> current_pids = Parser::pids();
+  std::vector<int> current_pids;
+  Parser::pids(current_pids);
 
   MessageBuilder msg;
   buildProcLogMessage(msg);
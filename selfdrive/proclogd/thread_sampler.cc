@@ -0,0 +1,153 @@
+#include "selfdrive/proclogd/thread_sampler.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+
+#include "json11.hpp"
+
+// processes come and go rarely, the threads of tagged ones are listed again at this interval
+const uint64_t SCAN_INTERVAL = 1e9;
+
+const double jiffy = sysconf(_SC_CLK_TCK);
+
+ThreadSampler::ThreadSampler(const std::vector<std::string> &tags) : tags(tags) {}
+
+bool ThreadSampler::matches(const std::string &arg, const std::string &tag) {
+  if (arg.size() < tag.size() || arg.compare(arg.size() - tag.size(), tag.size(), tag) != 0) {
+    return false;
+  }
+  if (arg.size() == tag.size()) {
+    return true;
+  }
+  const char c = arg[arg.size() - tag.size() - 1];
+  return c == '/' || c == '.' || c == '_';
+}
+
+void ThreadSampler::scan() {
+  tasks.clear();
+  Parser::pids(pids);
+  for (int pid : pids) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    if (!Parser::procStat(reader.read(path), proc_stat)) {
+      continue;
+    }
+
+    const ProcCache &cache = Parser::getProcExtraInfo(pid, proc_stat.starttime, proc_stat.name);
+    auto tag = std::find_if(tags.begin(), tags.end(), [&](const std::string &tag) {
+      return matches(proc_stat.name, tag) ||
+             std::any_of(cache.cmdline.begin(), cache.cmdline.end(), [&](const std::string &arg) { return matches(arg, tag); });
+    });
+    if (tag == tags.end()) {
+      continue;
+    }
+
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    DIR *d = opendir(path);
+    if (!d) {
+      continue;
+    }
+    struct dirent *de = NULL;
+    while ((de = readdir(d))) {
+      char *p_end;
+      int tid = strtol(de->d_name, &p_end, 10);
+      if (p_end != de->d_name && *p_end == '\0') {
+        tasks.push_back({pid, tid, &(*tag)});
+      }
+    }
+    closedir(d);
+  }
+
+  for (auto it = last.begin(); it != last.end();) {
+    bool alive = std::any_of(tasks.begin(), tasks.end(), [&](const Thread &t) { return t.tid == it->first; });
+    it = alive ? std::next(it) : last.erase(it);
+  }
+}
+
+bool ThreadSampler::read(const Thread &thread, ThreadStat &t) {
+  char path[96];
+  snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", thread.pid, thread.tid);
+  if (!Parser::procStat(reader.read(path), proc_stat)) {
+    return false;
+  }
+  t.pid = thread.pid;
+  t.tid = thread.tid;
+  t.processor = proc_stat.processor;
+  t.state = proc_stat.state;
+  t.utime = proc_stat.utime;
+  t.stime = proc_stat.stime;
+  t.starttime = proc_stat.starttime;
+  if (t.name != proc_stat.name) {
+    t.name = proc_stat.name;
+  }
+
+  snprintf(path, sizeof(path), "/proc/%d/task/%d/schedstat", thread.pid, thread.tid);
+  if (!Parser::schedStat(reader.read(path), t)) {
+    return false;
+  }
+  snprintf(path, sizeof(path), "/proc/%d/task/%d/status", thread.pid, thread.tid);
+  if (!Parser::ctxtSwitches(reader.read(path), t)) {
+    return false;
+  }
+  snprintf(path, sizeof(path), "/proc/%d/task/%d/sched", thread.pid, thread.tid);
+  if (!Parser::migrations(reader.read(path), t.migrations)) {
+    t.migrations = UINT64_MAX;
+  }
+  return true;
+}
+
+std::string ThreadSampler::sample(uint64_t now) {
+  if (now - last_scan > SCAN_INTERVAL) {
+    scan();
+    last_scan = now;
+  }
+
+  const double dt = (now - last_sample) * 1e-9;
+  json11::Json::array threads;
+  ThreadStat t = {};
+  for (const Thread &thread : tasks) {
+    if (!read(thread, t)) {
+      continue;
+    }
+
+    auto it = last.find(thread.tid);
+    if (it != last.end() && it->second.starttime == t.starttime) {
+      ThreadStat &prev = it->second;
+      if (t.migrations == UINT64_MAX) {
+        t.migrations = prev.migrations + (prev.processor != t.processor);
+      }
+      threads.push_back(json11::Json::object {
+        {"pid", t.pid},
+        {"tid", t.tid},
+        {"name", t.name},
+        {"process", *thread.tag},
+        {"state", std::string(1, t.state)},
+        {"processor", t.processor},
+        {"cpuUser", (t.utime - prev.utime) / jiffy},
+        {"cpuSystem", (t.stime - prev.stime) / jiffy},
+        {"runTime", (t.run_time - prev.run_time) * 1e-9},
+        {"runDelay", (t.wait_time - prev.wait_time) * 1e-9},
+        {"voluntarySwitches", (int)(t.voluntary_switches - prev.voluntary_switches)},
+        {"involuntarySwitches", (int)(t.involuntary_switches - prev.involuntary_switches)},
+        {"migrations", (int)(t.migrations - prev.migrations)},
+      });
+      prev = t;
+    } else {
+      if (t.migrations == UINT64_MAX) {
+        t.migrations = 0;
+      }
+      last[thread.tid] = t;
+    }
+  }
+
+  const bool first = last_sample == 0;
+  last_sample = now;
+  if (first) {
+    return "";
+  }
+  return json11::Json(json11::Json::object {{"dt", dt}, {"threads", threads}}).dump();
+}
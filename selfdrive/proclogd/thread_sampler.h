@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "selfdrive/proclogd/proclog.h"
+
+// Samples the threads of a set of tagged processes from /proc/<pid>/task/<tid>
+// and reports the per-thread deltas between samples: cpu time, run queue wait,
+// context switches and migrations. Migrations are counted from changes of the
+// last cpu when the kernel has no /proc/<pid>/task/<tid>/sched.
+class ThreadSampler {
+public:
+  // tags match the process name, or the end of a cmdline argument after a '/', '.' or '_'
+  ThreadSampler(const std::vector<std::string> &tags);
+
+  // returns the deltas since the previous sample as json, empty on the first sample
+  std::string sample(uint64_t now);
+
+  static bool matches(const std::string &arg, const std::string &tag);
+
+private:
+  struct Thread {
+    int pid, tid;
+    const std::string *tag;
+  };
+
+  void scan();
+  bool read(const Thread &thread, ThreadStat &t);
+
+  std::vector<std::string> tags;
+  std::vector<Thread> tasks;
+  std::unordered_map<int, ThreadStat> last;
+  std::vector<int> pids;
+  ProcStat proc_stat = {};
+  ProcReader reader;
+  uint64_t last_sample = 0;
+  uint64_t last_scan = 0;
+};
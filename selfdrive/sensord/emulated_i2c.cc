@@ -0,0 +1,341 @@
+#include "selfdrive/sensord/emulated_i2c.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/timing.h"
+#include "selfdrive/sensord/sensors/bmx055_accel.h"
+#include "selfdrive/sensord/sensors/bmx055_gyro.h"
+#include "selfdrive/sensord/sensors/bmx055_magn.h"
+#include "selfdrive/sensord/sensors/lsm6ds3_accel.h"
+#include "selfdrive/sensord/sensors/lsm6ds3_fifo.h"
+#include "selfdrive/sensord/sensors/lsm6ds3_gyro.h"
+#include "selfdrive/sensord/sensors/lsm6ds3_temp.h"
+#include "selfdrive/sensord/sensors/mmc5603nj_magn.h"
+
+// SMBus block reads stop after 32 bytes, like i2c_smbus_read_i2c_block_data
+#define SMBUS_BLOCK_MAX 32
+// 8 kB
+#define LSM6DS3_FIFO_WORDS 4096
+
+// with the trim values set below, the BMX055 compensation is close to linear
+#define BMX055_MAGN_XY_UT_PER_LSB 0.363f
+#define BMX055_MAGN_Z_UT_PER_LSB  0.357f
+#define BMX055_MAGN_RHALL         6611
+// half the self test z difference the driver expects, in raw counts
+#define BMX055_MAGN_SELF_TEST_LSB 294
+
+static const float accel_scale_12 = 9.81 * 2.0f / (1 << 11);
+static const float accel_scale_16 = 9.81 * 2.0f / (1 << 15);
+
+EmulatedMotion synthetic_motion(uint64_t t) {
+  const double s = t * 1e-9;
+  EmulatedMotion m = {};
+  m.accel[0] = 0.5 * sin(2 * M_PI * 0.5 * s);
+  m.accel[1] = 0.3 * cos(2 * M_PI * 0.3 * s);
+  m.accel[2] = 9.81 + 0.1 * sin(2 * M_PI * 2.0 * s);
+  m.gyro[0] = 0.02 * sin(2 * M_PI * 1.0 * s);
+  m.gyro[1] = 0.01 * cos(2 * M_PI * 0.7 * s);
+  m.gyro[2] = 0.1 * sin(2 * M_PI * 0.2 * s);
+  m.magn[0] = 20.0;
+  m.magn[1] = 5.0;
+  m.magn[2] = -40.0;
+  m.temp = 35.0 + 0.5 * sin(2 * M_PI * 0.01 * s);
+  return m;
+}
+
+static void put_16(uint8_t *regs, uint reg, int32_t value) {
+  const int16_t v = std::clamp<int32_t>(value, INT16_MIN, INT16_MAX);
+  regs[reg] = v & 0xFF;
+  regs[reg + 1] = (v >> 8) & 0xFF;
+}
+
+static double to_deg(float rad) {
+  return rad * 180.0 / M_PI;
+}
+
+EmulatedI2CBus::EmulatedI2CBus(EmulatedI2CConfig cfg) : config(cfg) {
+  if (config.bmx055) {
+    devices[BMX055_ACCEL_I2C_ADDR].regs[BMX055_ACCEL_I2C_REG_ID] = BMX055_ACCEL_CHIP_ID;
+    devices[BMX055_GYRO_I2C_ADDR].regs[BMX055_GYRO_I2C_REG_ID] = BMX055_GYRO_CHIP_ID;
+
+    // typical trim, the chip id only reads back once powered on
+    uint8_t *magn = devices[BMX055_MAGN_I2C_ADDR].regs;
+    magn[BMX055_MAGN_I2C_REG_DIG_X2] = 26;
+    magn[BMX055_MAGN_I2C_REG_DIG_Y2] = 26;
+    magn[BMX055_MAGN_I2C_REG_DIG_XY1] = 29;
+    magn[BMX055_MAGN_I2C_REG_DIG_XY2] = (uint8_t)-3;
+    put_16(magn, BMX055_MAGN_I2C_REG_DIG_Z1_LSB, 24747);
+    put_16(magn, BMX055_MAGN_I2C_REG_DIG_Z2_LSB, 743);
+    put_16(magn, BMX055_MAGN_I2C_REG_DIG_XYZ1_LSB, BMX055_MAGN_RHALL);
+  }
+  if (config.lsm6ds3) {
+    devices[LSM6DS3_ACCEL_I2C_ADDR].regs[LSM6DS3_ACCEL_I2C_REG_ID] = config.lsm6ds3trc ? LSM6DS3TRC_ACCEL_CHIP_ID : LSM6DS3_ACCEL_CHIP_ID;
+  }
+  if (config.mmc5603nj) {
+    devices[MMC5603NJ_I2C_ADDR].regs[MMC5603NJ_I2C_REG_ID] = MMC5603NJ_CHIP_ID;
+  }
+}
+
+EmulatedI2CBus::Device *EmulatedI2CBus::device(uint8_t address) {
+  auto it = devices.find(address);
+  return it != devices.end() ? &it->second : nullptr;
+}
+
+void EmulatedI2CBus::bus_time(int len) {
+  if (config.bus_hz <= 0) return;
+
+  // start, address, register, repeated start, address and data bytes, 9 clocks each.
+  // the bus is idle while a transfer is in flight, so sleep instead of spinning
+  std::this_thread::sleep_for(std::chrono::nanoseconds((uint64_t)(len + 3) * 9 * 1000000000ULL / config.bus_hz));
+}
+
+void EmulatedI2CBus::update(uint64_t t) {
+  if (!config.motion) return;
+  const EmulatedMotion m = config.motion(t);
+
+  if (Device *d = device(BMX055_ACCEL_I2C_ADDR)) {
+    const float xyz[] = {-m.accel[0], -m.accel[1], m.accel[2]};
+    for (int i = 0; i < 3; i++) {
+      put_16(d->regs, BMX055_ACCEL_I2C_REG_X_LSB + i * 2, std::lround(xyz[i] / accel_scale_12) * (1 << 4));
+    }
+    d->regs[BMX055_ACCEL_I2C_REG_TEMP] = (int8_t)std::lround((m.temp - 23.0f) * 2.0f);
+  }
+
+  if (Device *d = device(BMX055_GYRO_I2C_ADDR)) {
+    const float xyz[] = {-m.gyro[0], -m.gyro[1], m.gyro[2]};
+    for (int i = 0; i < 3; i++) {
+      put_16(d->regs, BMX055_GYRO_I2C_REG_RATE_X_LSB + i * 2, std::lround(to_deg(xyz[i]) * (1 << 15) / 125.0));
+    }
+  }
+
+  if (Device *d = device(LSM6DS3_ACCEL_I2C_ADDR)) {
+    const float accel[] = {-m.accel[1], m.accel[0], m.accel[2]};
+    const float gyro[] = {-m.gyro[1], m.gyro[0], m.gyro[2]};
+    for (int i = 0; i < 3; i++) {
+      put_16(d->regs, LSM6DS3_ACCEL_I2C_REG_OUTX_L_XL + i * 2, std::lround(accel[i] / accel_scale_16));
+      put_16(d->regs, LSM6DS3_GYRO_I2C_REG_OUTX_L_G + i * 2, std::lround(to_deg(gyro[i]) * 1000.0 / 8.75));
+    }
+    const float temp_scale = config.lsm6ds3trc ? 256.0f : 16.0f;
+    put_16(d->regs, LSM6DS3_TEMP_I2C_REG_OUT_TEMP_L, std::lround((m.temp - 25.0f) * temp_scale));
+  }
+
+  if (Device *d = device(MMC5603NJ_I2C_ADDR)) {
+    // 20 bit unsigned, zero field at mid scale, 16384 counts per gauss
+    for (int i = 0; i < 3; i++) {
+      const uint32_t raw = std::clamp<int64_t>((1 << 19) + std::lround(m.magn[i] / 100.0f * 16384), 0, (1 << 20) - 1);
+      d->regs[MMC5603NJ_I2C_REG_XOUT0 + i * 2] = raw >> 12;
+      d->regs[MMC5603NJ_I2C_REG_XOUT0 + i * 2 + 1] = (raw >> 4) & 0xFF;
+      d->regs[MMC5603NJ_I2C_REG_XOUT0 + 6 + i] = (raw & 0xF) << 4;
+    }
+  }
+}
+
+void EmulatedI2CBus::update_fifo(uint64_t t) {
+  Device *d = device(LSM6DS3_ACCEL_I2C_ADDR);
+  if (d == nullptr) return;
+
+  const uint8_t ctrl5 = d->regs[LSM6DS3_FIFO_I2C_REG_CTRL5];
+  const int odr = (ctrl5 >> 3) & 0xF;
+  if ((ctrl5 & 0b111) != LSM6DS3_FIFO_MODE_CONTINUOUS || odr == 0) return;
+
+  static const double odr_hz[] = {0, 12.5, 26, 52, 104, 208, 416, 833, 1660, 3330, 6660};
+  if (odr >= (int)std::size(odr_hz)) return;
+  const uint64_t period = 1e9 / odr_hz[odr];
+  while (fifo_next_sample <= t) {
+    update(fifo_next_sample);
+    for (int i = 0; i < 6; i++) {
+      fifo.push_back(d->regs[LSM6DS3_GYRO_I2C_REG_OUTX_L_G + i * 2] | (d->regs[LSM6DS3_GYRO_I2C_REG_OUTX_L_G + i * 2 + 1] << 8));
+    }
+    for (int i = 0; i < 6 && fifo.size() > LSM6DS3_FIFO_WORDS; i++) {
+      fifo.pop_front();
+      fifo_popped++;
+      fifo_overrun = true;
+    }
+    fifo_next_sample += period;
+  }
+}
+
+void EmulatedI2CBus::magn_measurement(int self_test) {
+  Device *d = device(BMX055_MAGN_I2C_ADDR);
+  const EmulatedMotion m = config.motion ? config.motion(nanos_since_boot()) : EmulatedMotion{};
+
+  // inverse of the axis swap in BMX055_Magn::get_event
+  const int32_t x = std::lround(-m.magn[1] / BMX055_MAGN_XY_UT_PER_LSB);
+  const int32_t y = std::lround(m.magn[0] / BMX055_MAGN_XY_UT_PER_LSB);
+  int32_t z = std::lround(m.magn[2] / BMX055_MAGN_Z_UT_PER_LSB);
+  if (self_test == 0b10) z -= BMX055_MAGN_SELF_TEST_LSB;
+  if (self_test == 0b11) z += BMX055_MAGN_SELF_TEST_LSB;
+
+  put_16(d->regs, BMX055_MAGN_I2C_REG_DATAX_LSB, std::clamp(x, -4096, 4095) * (1 << 3));
+  put_16(d->regs, BMX055_MAGN_I2C_REG_DATAX_LSB + 2, std::clamp(y, -4096, 4095) * (1 << 3));
+  put_16(d->regs, BMX055_MAGN_I2C_REG_DATAX_LSB + 4, std::clamp(z, -16384, 16383) * (1 << 1));
+  // data ready in bit 0
+  put_16(d->regs, BMX055_MAGN_I2C_REG_RHALL_LSB, (BMX055_MAGN_RHALL << 2) | 1);
+}
+
+int EmulatedI2CBus::read(uint8_t device_address, uint register_address, uint8_t *buffer, int len) {
+  transactions++;
+  bus_time(len);
+
+  auto stream = replay.find({device_address, register_address});
+  if (stream != replay.end()) {
+    auto &s = stream->second;
+    const auto &rec = s.reads[s.pos];
+    s.pos = (s.pos + 1) % s.reads.size();
+    for (int i = 0; i < len; i++) {
+      buffer[i] = i < (int)rec.size() ? rec[i] : 0;
+    }
+    bytes += len;
+    return len;
+  }
+
+  Device *d = device(device_address);
+  if (d == nullptr) return -ENXIO;
+
+  const uint64_t now = nanos_since_boot();
+  if (device_address == LSM6DS3_ACCEL_I2C_ADDR) {
+    update_fifo(now);
+  }
+  update(now);
+
+  if (device_address == LSM6DS3_ACCEL_I2C_ADDR && register_address == LSM6DS3_FIFO_I2C_REG_DATA_OUT_L) {
+    // pops words, the address wraps between DATA_OUT_L and DATA_OUT_H
+    uint16_t word = 0;
+    for (int i = 0; i < len; i++) {
+      if (i % 2 == 0 && !fifo.empty()) {
+        word = fifo.front();
+        fifo.pop_front();
+        fifo_popped++;
+      }
+      buffer[i] = i % 2 ? word >> 8 : word & 0xFF;
+    }
+    bytes += len;
+    return len;
+  }
+
+  if (device_address == LSM6DS3_ACCEL_I2C_ADDR) {
+    const int words = std::min<int>(fifo.size(), 0xFFF);
+    const int pattern = fifo_popped % LSM6DS3_FIFO_SET_WORDS;
+    d->regs[LSM6DS3_FIFO_I2C_REG_STATUS1] = words & 0xFF;
+    d->regs[LSM6DS3_FIFO_I2C_REG_STATUS1 + 1] = (words >> 8) | (fifo_overrun ? LSM6DS3_FIFO_STATUS2_OVER_RUN : 0) | (fifo.empty() ? (1 << 4) : 0);
+    d->regs[LSM6DS3_FIFO_I2C_REG_STATUS1 + 2] = pattern & 0xFF;
+    d->regs[LSM6DS3_FIFO_I2C_REG_STATUS1 + 3] = pattern >> 8;
+    if (register_address == LSM6DS3_FIFO_I2C_REG_STATUS1) {
+      fifo_overrun = false;
+    }
+  }
+
+  for (int i = 0; i < len; i++) {
+    buffer[i] = d->regs[(register_address + i) & 0xFF];
+  }
+  bytes += len;
+  return len;
+}
+
+int EmulatedI2CBus::read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len) {
+  return read(device_address, register_address, buffer, std::min<int>(len, SMBUS_BLOCK_MAX));
+}
+
+int EmulatedI2CBus::read_burst(uint8_t device_address, uint register_address, uint8_t *buffer, uint16_t len) {
+  return read(device_address, register_address, buffer, len);
+}
+
+int EmulatedI2CBus::set_register(uint8_t device_address, uint register_address, uint8_t data) {
+  transactions++;
+  bus_time(1);
+  bytes += 1;
+
+  Device *d = device(device_address);
+  if (d == nullptr) return -ENXIO;
+  d->regs[register_address & 0xFF] = data;
+
+  if (device_address == LSM6DS3_ACCEL_I2C_ADDR && register_address == LSM6DS3_FIFO_I2C_REG_CTRL5) {
+    if ((data & 0b111) == LSM6DS3_FIFO_MODE_BYPASS) {
+      fifo.clear();
+      fifo_popped = 0;
+      fifo_overrun = false;
+    }
+    fifo_next_sample = nanos_since_boot();
+  } else if (device_address == BMX055_MAGN_I2C_ADDR && register_address == BMX055_MAGN_I2C_REG_PWR_0) {
+    d->regs[BMX055_MAGN_I2C_REG_ID] = (data & 1) ? BMX055_MAGN_CHIP_ID : 0;
+  } else if (device_address == BMX055_MAGN_I2C_ADDR && register_address == BMX055_MAGN_I2C_REG_MAG) {
+    if ((data & (0b11 << 1)) == BMX055_MAGN_FORCED) {
+      magn_measurement(data >> 6);
+    }
+  }
+  return 0;
+}
+
+bool EmulatedI2CBus::load_replay(const std::string &path) {
+  std::ifstream f(path);
+  if (!f.is_open()) {
+    LOGE("failed to open replay %s", path.c_str());
+    return false;
+  }
+
+  replay.clear();
+  std::string line;
+  while (std::getline(f, line)) {
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream ss(line);
+    uint addr, reg, b;
+    if (!(ss >> std::hex >> addr >> reg)) continue;
+    std::vector<uint8_t> data;
+    while (ss >> b) data.push_back(b);
+    replay[{(uint8_t)addr, reg}].reads.push_back(std::move(data));
+  }
+
+  if (replay.empty()) {
+    LOGE("no register reads in replay %s", path.c_str());
+    return false;
+  }
+  // the recording is the only source of sensor data
+  config.motion = nullptr;
+  return true;
+}
+
+RecordingI2CBus::RecordingI2CBus(I2CBus *bus, const std::string &path) : bus(bus) {
+  file = fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    LOGE("failed to open %s for recording", path.c_str());
+  }
+}
+
+RecordingI2CBus::~RecordingI2CBus() {
+  if (file) fclose(file);
+}
+
+void RecordingI2CBus::record(uint8_t device_address, uint register_address, const uint8_t *buffer, int len) {
+  if (file == nullptr || len <= 0) return;
+
+  fprintf(file, "%02x %02x", device_address, register_address);
+  for (int i = 0; i < len; i++) {
+    fprintf(file, " %02x", buffer[i]);
+  }
+  fputc('\n', file);
+}
+
+int RecordingI2CBus::read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len) {
+  int ret = bus->read_register(device_address, register_address, buffer, len);
+  record(device_address, register_address, buffer, ret);
+  return ret;
+}
+
+int RecordingI2CBus::read_burst(uint8_t device_address, uint register_address, uint8_t *buffer, uint16_t len) {
+  int ret = bus->read_burst(device_address, register_address, buffer, len);
+  record(device_address, register_address, buffer, ret);
+  return ret;
+}
+
+int RecordingI2CBus::set_register(uint8_t device_address, uint register_address, uint8_t data) {
+  return bus->set_register(device_address, register_address, data);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "selfdrive/common/i2c.h"
+
+// Physical state of the device, in the frame and units sensord publishes
+struct EmulatedMotion {
+  float accel[3];  // m/s^2
+  float gyro[3];   // rad/s
+  float magn[3];   // uT
+  float temp;      // deg C
+};
+
+// slow sinusoids around 1g on z
+EmulatedMotion synthetic_motion(uint64_t t);
+
+struct EmulatedI2CConfig {
+  bool bmx055 = true;
+  bool lsm6ds3 = true;
+  bool lsm6ds3trc = false;  // LSM6DS3TR-C chip id and temperature scale
+  bool mmc5603nj = true;
+  // transactions take as long as on a real bus at this clock, 0 for instant
+  int bus_hz = 400000;
+  std::function<EmulatedMotion(uint64_t t)> motion = synthetic_motion;
+};
+
+// I2C bus with register maps of the BMX055, LSM6DS3 and MMC5603NJ, including
+// the LSM6DS3 FIFO, so the sensord drivers and SensorLoop can run off device.
+// Output registers follow config.motion, or a register stream recorded by
+// RecordingI2CBus when one is loaded: every read of a recorded register
+// returns the next recorded value, looping at the end.
+class EmulatedI2CBus : public I2CBus {
+public:
+  EmulatedI2CBus(EmulatedI2CConfig config = {});
+
+  int read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len) override;
+  int set_register(uint8_t device_address, uint register_address, uint8_t data) override;
+  int read_burst(uint8_t device_address, uint register_address, uint8_t *buffer, uint16_t len) override;
+
+  bool load_replay(const std::string &path);
+
+  uint64_t transactions = 0;
+  uint64_t bytes = 0;
+
+private:
+  struct Device {
+    uint8_t regs[256] = {};
+  };
+  struct ReplayStream {
+    std::vector<std::vector<uint8_t>> reads;
+    size_t pos = 0;
+  };
+
+  Device *device(uint8_t address);
+  int read(uint8_t device_address, uint register_address, uint8_t *buffer, int len);
+  void bus_time(int len);
+  void update(uint64_t t);
+  void update_fifo(uint64_t t);
+  void magn_measurement(int self_test);
+
+  EmulatedI2CConfig config;
+  std::map<uint8_t, Device> devices;
+  std::map<std::pair<uint8_t, uint>, ReplayStream> replay;
+
+  // LSM6DS3 FIFO
+  std::deque<uint16_t> fifo;
+  uint64_t fifo_next_sample = 0;
+  uint64_t fifo_popped = 0;
+  bool fifo_overrun = false;
+};
+
+// Passes transactions through to bus and writes every read to path in the
+// format EmulatedI2CBus::load_replay expects, one "addr reg bytes..." line in hex
+class RecordingI2CBus : public I2CBus {
+public:
+  RecordingI2CBus(I2CBus *bus, const std::string &path);
+  ~RecordingI2CBus();
+
+  int read_register(uint8_t device_address, uint register_address, uint8_t *buffer, uint8_t len) override;
+  int set_register(uint8_t device_address, uint register_address, uint8_t data) override;
+  int read_burst(uint8_t device_address, uint register_address, uint8_t *buffer, uint16_t len) override;
+
+private:
+  void record(uint8_t device_address, uint register_address, const uint8_t *buffer, int len);
+
+  I2CBus *bus;
+  FILE *file;
+};
@@ -0,0 +1,91 @@
+#include "selfdrive/sensord/sensor_loop.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/util.h"
+
+SensorLoop::SensorLoop(I2CBus *bus, const std::string &light_path)
+  : period(1000000 / std::max(1, util::getenv("SENSORD_PUBLISH_HZ", 100))),
+    bmx055_accel(bus), bmx055_gyro(bus), bmx055_magn(bus), bmx055_temp(bus),
+    lsm6ds3_accel(bus), lsm6ds3_gyro(bus), lsm6ds3_temp(bus),
+    lsm6ds3_fifo(bus, &lsm6ds3_accel, &lsm6ds3_gyro, util::getenv("SENSORD_IMU_ODR", 416)),
+    mmc5603nj_magn(bus), light(light_path) {
+  imu_samples.reserve(LSM6DS3_FIFO_MAX_SETS);
+}
+
+int SensorLoop::init() {
+  // Sensor init
+  std::vector<std::pair<Sensor *, bool>> sensors_init; // Sensor, required
+  sensors_init.push_back({&bmx055_accel, false});
+  sensors_init.push_back({&bmx055_gyro, false});
+  sensors_init.push_back({&bmx055_magn, false});
+  sensors_init.push_back({&bmx055_temp, false});
+
+  sensors_init.push_back({&lsm6ds3_accel, true});
+  sensors_init.push_back({&lsm6ds3_gyro, true});
+  sensors_init.push_back({&lsm6ds3_temp, true});
+
+  sensors_init.push_back({&mmc5603nj_magn, false});
+
+  sensors_init.push_back({&light, true});
+
+  bool has_magnetometer = false;
+
+  // Initialize sensors
+  sensors.clear();
+  for (auto &sensor : sensors_init) {
+    int err = sensor.first->init();
+    if (err < 0) {
+      // Fail on required sensors
+      if (sensor.second) {
+        LOGE("Error initializing sensors");
+        return -1;
+      }
+    } else {
+      if (sensor.first == &bmx055_magn || sensor.first == &mmc5603nj_magn) {
+        has_magnetometer = true;
+      }
+      sensors.push_back(sensor.first);
+    }
+  }
+
+  if (!has_magnetometer) {
+    LOGE("No magnetometer present");
+    return -1;
+  }
+
+  // IMU samples are batched in the LSM6DS3 FIFO at a higher rate than we publish,
+  // fall back to polling the output registers if the FIFO can't be set up
+  use_fifo = util::getenv("SENSORD_IMU_FIFO", 1) && lsm6ds3_fifo.init() >= 0;
+  if (use_fifo) {
+    sensors.erase(std::remove_if(sensors.begin(), sensors.end(), [&](Sensor *s) {
+      return s == &lsm6ds3_accel || s == &lsm6ds3_gyro;
+    }), sensors.end());
+  } else {
+    LOGW("LSM6DS3 FIFO disabled, polling IMU");
+  }
+  return 0;
+}
+
+void SensorLoop::read(MessageBuilder &msg) {
+  if (use_fifo && lsm6ds3_fifo.read(imu_samples) < 0) {
+    LOGE_100("LSM6DS3 FIFO read failed");
+  }
+
+  const int num_events = sensors.size() + imu_samples.size() * 2;
+  auto sensor_events = msg.initEvent().initSensorEvents(num_events);
+
+  int i = 0;
+  for (auto &sample : imu_samples) {
+    auto gyro_event = sensor_events[i++];
+    auto accel_event = sensor_events[i++];
+    lsm6ds3_fifo.fill_events(sample, gyro_event, accel_event);
+  }
+
+  for (auto sensor : sensors) {
+    auto event = sensor_events[i++];
+    sensor->get_event(event);
+  }
+}
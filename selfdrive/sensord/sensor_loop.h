@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/common/i2c.h"
+#include "selfdrive/sensord/sensors/bmx055_accel.h"
+#include "selfdrive/sensord/sensors/bmx055_gyro.h"
+#include "selfdrive/sensord/sensors/bmx055_magn.h"
+#include "selfdrive/sensord/sensors/bmx055_temp.h"
+#include "selfdrive/sensord/sensors/light_sensor.h"
+#include "selfdrive/sensord/sensors/lsm6ds3_accel.h"
+#include "selfdrive/sensord/sensors/lsm6ds3_fifo.h"
+#include "selfdrive/sensord/sensors/lsm6ds3_gyro.h"
+#include "selfdrive/sensord/sensors/lsm6ds3_temp.h"
+#include "selfdrive/sensord/sensors/mmc5603nj_magn.h"
+#include "selfdrive/sensord/sensors/sensor.h"
+
+#define LIGHT_SENSOR_PATH "/sys/class/i2c-adapter/i2c-2/2-0038/iio:device1/in_intensity_both_raw"
+
+// One sensord cycle: every sensor on the IMU bus and the light sensor read
+// into a single sensorEvents message. Runs against any I2CBus, so the same
+// code can be driven by EmulatedI2CBus off device.
+class SensorLoop {
+public:
+  SensorLoop(I2CBus *bus, const std::string &light_path = LIGHT_SENSOR_PATH);
+  // initializes the sensors, < 0 if a required one is missing
+  int init();
+  // reads all sensors into msg as a sensorEvents event
+  void read(MessageBuilder &msg);
+
+  // time between cycles, SENSORD_PUBLISH_HZ
+  std::chrono::microseconds period;
+
+private:
+  BMX055_Accel bmx055_accel;
+  BMX055_Gyro bmx055_gyro;
+  BMX055_Magn bmx055_magn;
+  BMX055_Temp bmx055_temp;
+
+  LSM6DS3_Accel lsm6ds3_accel;
+  LSM6DS3_Gyro lsm6ds3_gyro;
+  LSM6DS3_Temp lsm6ds3_temp;
+  LSM6DS3_Fifo lsm6ds3_fifo;
+
+  MMC5603NJ_Magn mmc5603nj_magn;
+
+  LightSensor light;
+
+  std::vector<Sensor *> sensors;
+  bool use_fifo = false;
+  std::vector<LSM6DS3_Sample> imu_samples;
+};
@@ -39,12 +39,15 @@ fail:
 }
 
 void LSM6DS3_Accel::get_event(cereal::SensorEventData::Builder &event) {
-
   uint64_t start_time = nanos_since_boot();
   uint8_t buffer[6];
   int len = read_register(LSM6DS3_ACCEL_I2C_REG_OUTX_L_XL, buffer, sizeof(buffer));
   assert(len == sizeof(buffer));
 
+  fill_event(event, start_time, buffer);
+}
+
+void LSM6DS3_Accel::fill_event(cereal::SensorEventData::Builder &event, uint64_t timestamp, const uint8_t *buffer) {
   float scale = 9.81 * 2.0f / (1 << 15);
   float x = read_16_bit(buffer[0], buffer[1]) * scale;
   float y = read_16_bit(buffer[2], buffer[3]) * scale;
@@ -54,11 +57,10 @@ void LSM6DS3_Accel::get_event(cereal::SensorEventData::Builder &event) {
   event.setVersion(1);
   event.setSensor(SENSOR_ACCELEROMETER);
   event.setType(SENSOR_TYPE_ACCELEROMETER);
-  event.setTimestamp(start_time);
+  event.setTimestamp(timestamp);
 
   float xyz[] = {y, -x, z};
   auto svec = event.initAcceleration();
   svec.setV(xyz);
   svec.setStatus(true);
-
 }
@@ -0,0 +1,132 @@
+#include "lsm6ds3_fifo.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/timing.h"
+
+static uint8_t odr_bits(int odr_hz) {
+  switch (odr_hz) {
+    case 104: return 0b0100;
+    case 208: return 0b0101;
+    case 416: return 0b0110;
+    case 833: return 0b0111;
+    default: return 0;
+  }
+}
+
+LSM6DS3_Fifo::LSM6DS3_Fifo(I2CBus *bus, LSM6DS3_Accel *accel, LSM6DS3_Gyro *gyro, int odr_hz)
+  : bus(bus), accel(accel), gyro(gyro), odr_hz(odr_hz), period(odr_hz > 0 ? 1000000000ULL / odr_hz : 0) {}
+
+int LSM6DS3_Fifo::init() {
+  int ret = 0;
+  const uint8_t odr = odr_bits(odr_hz);
+
+  if (odr == 0) {
+    LOGE("Unsupported LSM6DS3 ODR: %d Hz", odr_hz);
+    ret = -1;
+    goto fail;
+  }
+
+  // sensor ODR, keeps the default scales
+  ret = bus->set_register(LSM6DS3_ACCEL_I2C_ADDR, LSM6DS3_ACCEL_I2C_REG_CTRL1_XL, odr << 4);
+  if (ret < 0) {
+    goto fail;
+  }
+  ret = bus->set_register(LSM6DS3_GYRO_I2C_ADDR, LSM6DS3_GYRO_I2C_REG_CTRL2_G, odr << 4);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  // both sensors into the FIFO at full rate
+  ret = bus->set_register(LSM6DS3_ACCEL_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_CTRL3, LSM6DS3_FIFO_GYRO_NO_DEC | LSM6DS3_FIFO_ACCEL_NO_DEC);
+  if (ret < 0) {
+    goto fail;
+  }
+
+  // bypass clears the FIFO, then continuous mode overwrites the oldest samples when full
+  ret = bus->set_register(LSM6DS3_ACCEL_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_CTRL5, LSM6DS3_FIFO_MODE_BYPASS);
+  if (ret < 0) {
+    goto fail;
+  }
+  ret = bus->set_register(LSM6DS3_ACCEL_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_CTRL5, (odr << 3) | LSM6DS3_FIFO_MODE_CONTINUOUS);
+  if (ret < 0) {
+    goto fail;
+  }
+
+fail:
+  return ret;
+}
+
+int LSM6DS3_Fifo::read(std::vector<LSM6DS3_Sample> &samples) {
+  samples.clear();
+
+  uint64_t read_time = nanos_since_boot();
+  uint8_t status[4];
+  int ret = bus->read_register(LSM6DS3_ACCEL_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_STATUS1, status, sizeof(status));
+  if (ret < 0) {
+    return ret;
+  }
+
+  int words = status[0] | ((status[1] & 0x0F) << 8);
+  const int pattern = status[2] | ((status[3] & 0x03) << 8);
+  if (status[1] & LSM6DS3_FIFO_STATUS2_OVER_RUN) {
+    LOGW_100("LSM6DS3 FIFO overrun");
+  }
+
+  // the next word should be the gyro x of a set, skip ahead if we got out of step
+  uint8_t buffer[LSM6DS3_FIFO_MAX_SETS * LSM6DS3_FIFO_SET_WORDS * 2];
+  if (pattern != 0) {
+    const int skip = std::min(words, LSM6DS3_FIFO_SET_WORDS - pattern);
+    ret = bus->read_burst(LSM6DS3_ACCEL_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_DATA_OUT_L, buffer, skip * 2);
+    if (ret < 0) {
+      return ret;
+    }
+    words -= skip;
+  }
+
+  const int sets = std::min(words / LSM6DS3_FIFO_SET_WORDS, LSM6DS3_FIFO_MAX_SETS);
+  if (sets == 0) {
+    return 0;
+  }
+
+  // the address wraps from DATA_OUT_H back to DATA_OUT_L, so the whole FIFO comes out in one burst
+  ret = bus->read_burst(LSM6DS3_ACCEL_I2C_ADDR, LSM6DS3_FIFO_I2C_REG_DATA_OUT_L, buffer, sets * LSM6DS3_FIFO_SET_WORDS * 2);
+  if (ret < 0) {
+    return ret;
+  }
+
+  // Continue the timeline of the previous read at the ODR cadence and only pull
+  // it slowly towards the read time, which jitters with scheduling and bus load.
+  // Start over if it got too far off, e.g. after an overrun.
+  // The correction is spread over the batch to keep the intervals even.
+  uint64_t newest = last_timestamp + sets * period;
+  const int64_t error = (int64_t)(read_time - newest);
+  uint64_t oldest;
+  if (last_timestamp == 0 || (uint64_t)std::llabs(error) > 4 * period) {
+    newest = read_time;
+    oldest = newest - sets * period;
+  } else {
+    newest += error / 16;
+    oldest = last_timestamp;
+  }
+  const uint64_t interval = (newest - oldest) / sets;
+  last_timestamp = newest;
+
+  for (int i = 0; i < sets; i++) {
+    LSM6DS3_Sample sample;
+    sample.timestamp = newest - (sets - 1 - i) * interval;
+    const uint8_t *set = &buffer[i * LSM6DS3_FIFO_SET_WORDS * 2];
+    std::copy(set, set + 6, sample.gyro);
+    std::copy(set + 6, set + 12, sample.accel);
+    samples.push_back(sample);
+  }
+  return sets;
+}
+
+void LSM6DS3_Fifo::fill_events(const LSM6DS3_Sample &sample, cereal::SensorEventData::Builder &gyro_event,
+                               cereal::SensorEventData::Builder &accel_event) {
+  gyro->fill_event(gyro_event, sample.timestamp, sample.gyro);
+  accel->fill_event(accel_event, sample.timestamp, sample.accel);
+}
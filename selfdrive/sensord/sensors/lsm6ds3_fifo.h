@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "selfdrive/common/i2c.h"
+#include "selfdrive/sensord/sensors/lsm6ds3_accel.h"
+#include "selfdrive/sensord/sensors/lsm6ds3_gyro.h"
+
+// Registers of the chip
+#define LSM6DS3_FIFO_I2C_REG_CTRL3      0x08
+#define LSM6DS3_FIFO_I2C_REG_CTRL5      0x0A
+#define LSM6DS3_FIFO_I2C_REG_STATUS1    0x3A
+#define LSM6DS3_FIFO_I2C_REG_DATA_OUT_L 0x3E
+
+// Constants
+#define LSM6DS3_FIFO_MODE_BYPASS       0b000
+#define LSM6DS3_FIFO_MODE_CONTINUOUS   0b110
+#define LSM6DS3_FIFO_GYRO_NO_DEC       (0b001 << 3)
+#define LSM6DS3_FIFO_ACCEL_NO_DEC      0b001
+#define LSM6DS3_FIFO_STATUS2_OVER_RUN  (1 << 6)
+
+// a set is one gyro and one accel sample, 6 words of 16 bits
+#define LSM6DS3_FIFO_SET_WORDS 6
+#define LSM6DS3_FIFO_MAX_SETS  64
+
+struct LSM6DS3_Sample {
+  uint64_t timestamp;
+  uint8_t gyro[6];
+  uint8_t accel[6];
+};
+
+// Batches gyro and accel samples in the on-chip FIFO so they can be sampled
+// faster than sensord polls. Each read drains the FIFO in one burst and
+// timestamps the samples on the ODR cadence, anchored to the read time.
+class LSM6DS3_Fifo {
+  I2CBus *bus;
+  LSM6DS3_Accel *accel;
+  LSM6DS3_Gyro *gyro;
+  int odr_hz;
+  uint64_t period;
+  uint64_t last_timestamp = 0;
+
+public:
+  // accel and gyro must be initialized, they decode the samples
+  LSM6DS3_Fifo(I2CBus *bus, LSM6DS3_Accel *accel, LSM6DS3_Gyro *gyro, int odr_hz);
+  int init();
+  // drains the FIFO into samples, oldest first. Returns the number of samples or < 0 on error
+  int read(std::vector<LSM6DS3_Sample> &samples);
+  void fill_events(const LSM6DS3_Sample &sample, cereal::SensorEventData::Builder &gyro_event,
+                   cereal::SensorEventData::Builder &accel_event);
+};
@@ -23,4 +23,6 @@ public:
   LSM6DS3_Gyro(I2CBus *bus);
   int init();
   void get_event(cereal::SensorEventData::Builder &event);
+  // builds the event from the 6 output bytes, as read from the output registers or the FIFO
+  void fill_event(cereal::SensorEventData::Builder &event, uint64_t timestamp, const uint8_t *buffer);
 };
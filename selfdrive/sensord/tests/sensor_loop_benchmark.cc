@@ -0,0 +1,109 @@
+// runs SensorLoop against EmulatedI2CBus with the IMU FIFO and polled, and reports
+// loop time, bus transactions per cycle and jitter of the LSM6DS3 accel timestamps
+// usage: ./sensor_loop_benchmark [cycles] [replay file]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/common/timing.h"
+#include "selfdrive/sensord/emulated_i2c.h"
+#include "selfdrive/sensord/sensor_loop.h"
+
+#define LIGHT_PATH "/tmp/sensor_loop_benchmark_light"
+
+static double percentile(std::vector<double> v, double p) {
+  std::sort(v.begin(), v.end());
+  return v.empty() ? 0 : v[std::min<size_t>(v.size() - 1, p * v.size())];
+}
+
+static void run(const char *name, bool fifo, int cycles, const char *replay) {
+  setenv("SENSORD_IMU_FIFO", fifo ? "1" : "0", 1);
+
+  EmulatedI2CBus bus;
+  if (replay && !bus.load_replay(replay)) {
+    exit(1);
+  }
+  SensorLoop loop(&bus, LIGHT_PATH);
+  if (loop.init() < 0) {
+    printf("%s: sensor init failed\n", name);
+    exit(1);
+  }
+
+  std::vector<double> loop_us;
+  std::vector<uint64_t> accel_ts;
+  uint64_t transactions = 0, bytes = 0;
+  double max_accel_err = 0;
+
+  for (int c = 0; c < cycles; c++) {
+    auto begin = std::chrono::steady_clock::now();
+    const uint64_t tx = bus.transactions, b = bus.bytes;
+
+    MessageBuilder msg;
+    loop.read(msg);
+
+    auto end = std::chrono::steady_clock::now();
+    loop_us.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+    transactions += bus.transactions - tx;
+    bytes += bus.bytes - b;
+
+    auto events = msg.getRoot<cereal::Event>().asReader().getSensorEvents();
+    for (auto e : events) {
+      const auto source = e.getSource();
+      if (e.which() != cereal::SensorEventData::ACCELERATION ||
+          (source != cereal::SensorEventData::SensorSource::LSM6DS3 && source != cereal::SensorEventData::SensorSource::LSM6DS3TRC)) {
+        continue;
+      }
+      accel_ts.push_back(e.getTimestamp());
+      if (!replay) {
+        const auto v = e.getAcceleration().getV();
+        const EmulatedMotion m = synthetic_motion(e.getTimestamp());
+        for (int i = 0; i < 3; i++) {
+          max_accel_err = std::max(max_accel_err, (double)std::abs(v[i] - m.accel[i]));
+        }
+      }
+    }
+
+    std::this_thread::sleep_for(loop.period - (std::chrono::steady_clock::now() - begin));
+  }
+
+  std::vector<double> intervals;
+  for (size_t i = 1; i < accel_ts.size(); i++) {
+    intervals.push_back((int64_t)(accel_ts[i] - accel_ts[i - 1]) / 1e3);
+  }
+  double mean = 0, var = 0, max_dev = 0;
+  for (double d : intervals) mean += d;
+  mean /= std::max<size_t>(1, intervals.size());
+  for (double d : intervals) {
+    var += (d - mean) * (d - mean);
+    max_dev = std::max(max_dev, std::abs(d - mean));
+  }
+  var /= std::max<size_t>(1, intervals.size());
+
+  printf("%s:\n", name);
+  printf("  loop time        p50 %.0f us, p99 %.0f us, max %.0f us\n",
+         percentile(loop_us, 0.5), percentile(loop_us, 0.99), percentile(loop_us, 1.0));
+  printf("  bus              %.1f transactions, %.0f bytes per cycle\n", (double)transactions / cycles, (double)bytes / cycles);
+  printf("  accel events     %.2f per cycle\n", (double)accel_ts.size() / cycles);
+  printf("  accel interval   mean %.1f us, jitter (std) %.1f us, max deviation %.1f us\n", mean, std::sqrt(var), max_dev);
+  if (!replay) {
+    printf("  accel error      max %.4f m/s^2\n", max_accel_err);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  const int cycles = argc > 1 ? atoi(argv[1]) : 500;
+  const char *replay = argc > 2 ? argv[2] : nullptr;
+
+  std::ofstream(LIGHT_PATH) << 100 << std::endl;
+
+  run("fifo", true, cycles, replay);
+  run("polled", false, cycles, replay);
+  return 0;
+}
@@ -0,0 +1,106 @@
+#include "selfdrive/ui/frame_pacer.h"
+
+#include <algorithm>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/common/swaglog.h"
+
+static const struct {
+  const char *name;
+  int source;
+} wake_services[] = {
+  {"roadCameraState", WAKE_ROAD_CAMERA},
+  {"wideRoadCameraState", WAKE_WIDE_ROAD_CAMERA},
+  {"modelV2", WAKE_MODEL},
+  {"controlsState", WAKE_CONTROLS},
+};
+
+MessageWaker::MessageWaker(std::function<void()> notify) : notify(notify) {
+  thread = std::thread(&MessageWaker::run, this);
+}
+
+MessageWaker::~MessageWaker() {
+  do_exit = true;
+  thread.join();
+}
+
+void MessageWaker::run() {
+  SubMaster sm({"roadCameraState", "wideRoadCameraState", "modelV2", "controlsState"});
+  while (!do_exit) {
+    // timeout so exit is noticed
+    sm.update(100);
+    int sources = 0;
+    for (auto &s : wake_services) {
+      if (sm.updated(s.name)) {
+        sources |= s.source;
+      }
+    }
+    if (sources && pending.fetch_or(sources) == 0) {
+      notify();
+    }
+  }
+}
+
+void FrameStats::drawn(double start_ms, double end_ms, uint32_t frame_id) {
+  if (window_start == 0) {
+    window_start = start_ms;
+  }
+
+  const double draw = end_ms - start_ms;
+  draw_sum += draw;
+  draw_max = std::max(draw_max, draw);
+  // longer gaps are the view being hidden, not slow frames
+  if (prev_end > 0 && end_ms - prev_end < 1000) {
+    const double interval = end_ms - prev_end;
+    intervals++;
+    interval_sum += interval;
+    interval_max = std::max(interval_max, interval);
+    // sub 15fps
+    slow_frames += interval > 66;
+  }
+  prev_end = end_ms;
+  frames++;
+
+  // camera frames that were never shown. ids restart when camerad does
+  if (has_frame_id && frame_id > prev_frame_id) {
+    dropped += frame_id - prev_frame_id - 1;
+  }
+  has_frame_id = true;
+  prev_frame_id = frame_id;
+
+  if (end_ms - window_start >= report_interval) {
+    report(end_ms);
+  }
+}
+
+void FrameStats::input(double t_ms) {
+  if (input_t == 0) {
+    input_t = t_ms;
+  }
+}
+
+void FrameStats::swapped(double t_ms) {
+  if (input_t == 0) {
+    return;
+  }
+  const double latency = t_ms - input_t;
+  input_t = 0;
+  // inputs while the onroad view wasn't drawing aren't its latency
+  if (latency < 1000) {
+    inputs++;
+    latency_sum += latency;
+    latency_max = std::max(latency_max, latency);
+  }
+}
+
+void FrameStats::report(double t_ms) {
+  LOG("ui frames: %d in %.1f s, draw %.2f ms avg %.2f ms max, interval %.2f ms avg %.2f ms max, %d slow, "
+      "%d camera frames dropped, input to swap %.1f ms avg %.1f ms max over %d inputs",
+      frames, (t_ms - window_start) / 1000., draw_sum / frames, draw_max, intervals ? interval_sum / intervals : 0., interval_max,
+      slow_frames, dropped, inputs ? latency_sum / inputs : 0., latency_max, inputs);
+
+  window_start = t_ms;
+  frames = intervals = slow_frames = dropped = inputs = 0;
+  draw_sum = draw_max = interval_sum = interval_max = 0;
+  latency_sum = latency_max = 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+enum UIWakeSource {
+  WAKE_ROAD_CAMERA = 1 << 0,
+  WAKE_WIDE_ROAD_CAMERA = 1 << 1,
+  WAKE_MODEL = 1 << 2,
+  WAKE_CONTROLS = 1 << 3,
+};
+
+// Waits for the messages the onroad UI draws from on its own thread, so the UI thread
+// doesn't have to block or spin. Arrivals are collected as UIWakeSource bits until the
+// UI takes them, and notify is only called when there was nothing pending, so a busy UI
+// thread gets one wakeup for any number of messages. camerad publishes the camera state
+// right after sending the frame over VisionIPC, so it stands in for frame arrival.
+class MessageWaker {
+public:
+  MessageWaker(std::function<void()> notify);
+  ~MessageWaker();
+
+  // returns and clears the sources seen since the last call
+  inline int take() { return pending.exchange(0); }
+
+private:
+  void run();
+
+  std::function<void()> notify;
+  std::atomic<int> pending{0};
+  std::atomic<bool> do_exit{false};
+  std::thread thread;
+};
+
+// Frame timing of the onroad view. Collected on the UI thread and logged every
+// report_interval as one line.
+class FrameStats {
+public:
+  // a frame was drawn between start and end, showing camera frame frame_id
+  void drawn(double start_ms, double end_ms, uint32_t frame_id);
+  // a touch or click, matched to the next swap
+  void input(double t_ms);
+  void swapped(double t_ms);
+
+  static constexpr double report_interval = 10000;  // ms
+
+private:
+  void report(double t_ms);
+
+  double window_start = 0, prev_end = 0;
+  int frames = 0, intervals = 0, slow_frames = 0;
+  double draw_sum = 0, draw_max = 0, interval_sum = 0, interval_max = 0;
+
+  bool has_frame_id = false;
+  uint32_t prev_frame_id = 0;
+  int dropped = 0;
+
+  double input_t = 0;
+  int inputs = 0;
+  double latency_sum = 0, latency_max = 0;
+};
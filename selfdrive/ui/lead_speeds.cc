@@ -0,0 +1,102 @@
+#include "selfdrive/ui/lead_speeds.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+typedef struct {
+  float key, v;
+} lead_key;
+
+bool LeadSpeeds::set(const int *new_vals, int new_cnt) {
+  new_cnt = std::min(new_cnt, MAX_LEAD_SPEEDS);
+  bool changed = new_cnt != cnt;
+  for (int i = 0; i < new_cnt; ++i) {
+    if (i >= cnt || vals[i] != new_vals[i]) {
+      vals[i] = new_vals[i];
+      snprintf(strs[i], sizeof(strs[i]), "%d", vals[i]);
+      formatted++;
+      changed = true;
+    }
+  }
+  cnt = new_cnt;
+
+  if (changed) {
+    char *p = joined;
+    for (int i = 0; i < cnt; ++i) {
+      if (i > 0) {
+        *p++ = ' ';
+      }
+      const size_t len = strlen(strs[i]);
+      memcpy(p, strs[i], len);
+      p += len;
+    }
+    *p = '\0';
+  }
+  return changed;
+}
+
+static inline int display_speed(float v, float speed_conv) {
+  return (int)std::nearbyint(v * speed_conv);
+}
+
+// sorts the first n of keys by key, ascending, and writes their speeds to vals
+static int top_speeds(lead_key *keys, int cnt, int n, float speed_conv, int *vals) {
+  n = std::min(n, cnt);
+  std::partial_sort(keys, keys + n, keys + cnt, [](const lead_key &a, const lead_key &b) { return a.key < b.key; });
+  for (int i = 0; i < n; ++i) {
+    vals[i] = display_speed(keys[i].v, speed_conv);
+  }
+  return n;
+}
+
+void update_adjacent_lead_speeds(const cereal::RadarState::Reader &radar_state, float speed_conv,
+                                 LeadSpeeds &left, LeadSpeeds &right) {
+  lead_key keys[MAX_RADAR_LEADS];
+  int vals[MAX_LEAD_SPEEDS];
+
+  int cnt = 0;
+  for (auto const & l : radar_state.getLeadsLeft()) {
+    if (cnt == MAX_RADAR_LEADS) break;
+    keys[cnt++] = {-l.getVLat(), l.getVLeadK()};
+  }
+  left.set(vals, top_speeds(keys, cnt, MAX_LEAD_SPEEDS, speed_conv, vals));
+
+  cnt = 0;
+  for (auto const & l : radar_state.getLeadsRight()) {
+    if (cnt == MAX_RADAR_LEADS) break;
+    keys[cnt++] = {l.getVLat(), l.getVLeadK()};
+  }
+  right.set(vals, top_speeds(keys, cnt, MAX_LEAD_SPEEDS, speed_conv, vals));
+}
+
+void update_center_lead_speeds(const cereal::RadarState::Reader &radar_state, float speed_conv, LeadSpeeds &center) {
+  lead_key keys[MAX_RADAR_LEADS];
+  int vals[MAX_LEAD_SPEEDS];
+  int n = 0;
+
+  auto lead_one_plus = radar_state.getLeadOnePlus();
+  auto lead_one = radar_state.getLeadOne();
+  const bool show_lead_one_plus = lead_one_plus.getStatus() && lead_one_plus.getDRel() - lead_one.getDRel() > 3.0;
+  if (show_lead_one_plus) {
+    vals[n++] = display_speed(lead_one_plus.getVLeadK(), speed_conv);
+  }
+
+  int cnt = 0;
+  for (auto const & l : radar_state.getLeadsCenter()) {
+    if (cnt == MAX_RADAR_LEADS) break;
+    keys[cnt++] = {l.getDRel(), l.getVLeadK()};
+  }
+  // lead one plus is the closest center lead, skip it
+  if (show_lead_one_plus && cnt > 0) {
+    std::swap(*std::min_element(keys, keys + cnt, [](const lead_key &a, const lead_key &b) { return a.key < b.key; }), keys[cnt - 1]);
+    cnt--;
+  }
+  if (lead_one.getStatus()) {
+    const float d_min = lead_one.getDRel() + 3.0;
+    cnt = std::remove_if(keys, keys + cnt, [=](const lead_key &k) { return k.key <= d_min; }) - keys;
+  }
+  n += top_speeds(keys, cnt, MAX_LEAD_SPEEDS - n, speed_conv, vals + n);
+  center.set(vals, n);
+}
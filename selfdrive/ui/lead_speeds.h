@@ -0,0 +1,26 @@
+#pragma once
+
+#include "cereal/messaging/messaging.h"
+
+const int MAX_LEAD_SPEEDS = 6;  // more don't fit the space next to the path
+const int MAX_RADAR_LEADS = 64;
+
+// Speeds of radar leads shown as text, in display units. The text lives in fixed
+// buffers and is only formatted again for the entries whose rounded speed changed,
+// so updates don't allocate.
+struct LeadSpeeds {
+  int cnt = 0;
+  int vals[MAX_LEAD_SPEEDS] = {};
+  char strs[MAX_LEAD_SPEEDS][8] = {};
+  char joined[MAX_LEAD_SPEEDS * 8] = {};  // space separated strs
+  uint64_t formatted = 0;  // times an entry was formatted, for benchmarking
+
+  // returns true if the text changed
+  bool set(const int *new_vals, int new_cnt);
+};
+
+// left leads ordered by lateral velocity towards the path first, right leads mirrored
+void update_adjacent_lead_speeds(const cereal::RadarState::Reader &radar_state, float speed_conv,
+                                 LeadSpeeds &left, LeadSpeeds &right);
+// lead one plus if it's separate from lead one, then center leads beyond lead one by distance
+void update_center_lead_speeds(const cereal::RadarState::Reader &radar_state, float speed_conv, LeadSpeeds &center);
@@ -4,7 +4,9 @@
 #include <cassert>
 #include <string>
 #include <cmath>
+#include <cstring>
 #include <deque>
+#include <type_traits>
 
 #include <QDateTime>
 
@@ -22,6 +24,7 @@
 #include <nanovg_gl.h>
 #include <nanovg_gl_utils.h>
 
+#include "selfdrive/common/swaglog.h"
 #include "selfdrive/common/timing.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/hardware/hw.h"
@@ -497,13 +500,13 @@ static void draw_adjacent_lead_speeds(UIState *s, bool lead_drawn){
       nvgTextAlign(s->vg, NVG_ALIGN_RIGHT | NVG_ALIGN_BOTTOM);
       nvgFillColor(s->vg, COLOR_WHITE_ALPHA(200));
       int x = s->fb_w * 11 / 32;
-      nvgText(s->vg,x,y,s->scene.adjacent_leads_left_str.c_str(),NULL);
+      nvgText(s->vg,x,y,s->scene.adjacent_leads_left.joined,NULL);
 
       // right leads
       nvgTextAlign(s->vg, NVG_ALIGN_LEFT | NVG_ALIGN_BOTTOM);
       nvgFillColor(s->vg, COLOR_WHITE_ALPHA(200));
       x = s->fb_w * 21 / 32;
-      nvgText(s->vg,x,y,s->scene.adjacent_leads_right_str.c_str(),NULL);
+      nvgText(s->vg,x,y,s->scene.adjacent_leads_right.joined,NULL);
     }
      
     // center leads
@@ -519,26 +522,28 @@ static void draw_adjacent_lead_speeds(UIState *s, bool lead_drawn){
       x = s->fb_w / 2;
     }
     bool first = false;
-    for (auto const & v : s->scene.adjacent_leads_center_strs){
+    const LeadSpeeds &center = s->scene.adjacent_leads_center;
+    for (int i = 0; i < center.cnt; ++i){
+      const char *v = center.strs[i];
       if (first && lead_drawn){
         auto l1p_v = s->scene.radarState.getLeadOnePlus().getVLeadK();
         if (s->scene.lead_v - l1p_v > 7.){
           nvgFontFace(s->vg, "sans-bold");
           nvgFillColor(s->vg, COLOR_RED_ALPHA(200));
           nvgFontSize(s->vg, 110);
-          nvgText(s->vg,x,y,v.c_str(),NULL);
+          nvgText(s->vg,x,y,v,NULL);
           y -= 75;
           nvgFontFace(s->vg, "sans-semibold");
           nvgFillColor(s->vg, COLOR_WHITE_ALPHA(200));
           nvgFontSize(s->vg, 90);
         }      
         else{
-          nvgText(s->vg,x,y,v.c_str(),NULL);
+          nvgText(s->vg,x,y,v,NULL);
           y -= 60;
         }
       }
       else{
-        nvgText(s->vg,x,y,v.c_str(),NULL);
+        nvgText(s->vg,x,y,v,NULL);
         y -= 60;
       }
       first = false;
@@ -574,12 +579,12 @@ static void draw_vision_frame(UIState *s) {
   glActiveTexture(GL_TEXTURE0);
 
   if (s->last_frame) {
-    glBindTexture(GL_TEXTURE_2D, s->texture[s->last_frame->idx]->frame_tex);
+    const GLuint frame_tex = s->texture[s->last_frame->idx]->frame_tex;
     if (!Hardware::EON()) {
       // this is handled in ion on QCOM
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, s->last_frame->width, s->last_frame->height,
-                   0, GL_RGB, GL_UNSIGNED_BYTE, s->last_frame->addr);
+      s->frame_uploader->uploadRGB(frame_tex, s->last_frame, s->last_frame_id);
     }
+    glBindTexture(GL_TEXTURE_2D, frame_tex);
   }
 
   glUseProgram(s->gl_shader->prog);
@@ -896,1811 +901,1922 @@ NVGcolor color_from_thermal_status(int thermalStatus){
   }
 }
 
-static void ui_draw_measures(UIState *s){
-  if (s->scene.measure_cur_num_slots){
-    SubMaster &sm = *(s->sm);
-    UIScene &scene = s->scene;
-    const Rect maxspeed_rect = {bdr_s * 2, int(bdr_s * 1.5), 184, 202};
-    int center_x = s->fb_w - face_wheel_radius - bdr_s * 2;
-    center_x -= s->scene.power_meter_rect.w + s->fb_w / 256;
-    const int brake_y = s->fb_h - footer_h / 2;
-    const int y_min = maxspeed_rect.bottom() + bdr_s / 2;
-    const int y_max = brake_y - brake_size - bdr_s / 2;
-    const int y_rng = y_max - y_min;
-    int slot_y_rng;
-    if (scene.measure_num_rows > 4 || scene.map_open){
-      slot_y_rng = y_rng / scene.measure_max_rows;
-    }
-    else{
-      slot_y_rng = y_rng / (scene.measure_num_rows < 3 ? 3 : scene.measure_num_rows);
-    }
-    const int slot_y_rng_orig = y_rng / scene.measure_max_rows; // two columns
-    const float slot_aspect_ratio_ratio = float(slot_y_rng) / float(slot_y_rng_orig);
-    const int y_mid = (y_max + y_min) / 2;
-    const int slots_y_rng = slot_y_rng * (scene.measure_num_rows <= scene.measure_max_rows ? scene.measure_num_rows : scene.measure_max_rows);
-    const int slots_y_min = y_mid - (slots_y_rng / 2);
-  
-    NVGcolor default_name_color = COLOR_WHITE_ALPHA(200);
-    NVGcolor default_unit_color = COLOR_WHITE_ALPHA(200);
-    NVGcolor default_val_color = COLOR_WHITE_ALPHA(200);
-    int default_val_font_size = 78. * slot_aspect_ratio_ratio;
-    int default_name_font_size = 32. * (slot_y_rng_orig > 1. ? 0.9 * slot_aspect_ratio_ratio : 1.);
-    int default_unit_font_size = 38. * slot_aspect_ratio_ratio;
-  
-    // determine bounding rectangle
-    int slots_r, slots_w, slots_x;
-
-    const int slots_r_orig = brake_size + 6 + (s->scene.measure_cur_num_slots <= 5 ? 6 : 0);
-    slots_r = brake_size * slot_aspect_ratio_ratio + 6 + (scene.measure_cur_num_slots <= scene.measure_max_rows ? 6 : 0);
-    center_x -= slots_r - slots_r_orig;
-    slots_w = (scene.measure_cur_num_slots <= scene.measure_max_rows ? 2 : 4) * slots_r;
-    slots_x = (scene.measure_cur_num_slots <= scene.measure_max_rows ? center_x - slots_r : center_x - 3 * slots_r);
-
-    scene.measure_slots_rect = {slots_x, slots_y_min, slots_w, slots_y_rng};
-    // draw bounding rectangle
-    nvgBeginPath(s->vg);
-    nvgRoundedRect(s->vg, scene.measure_slots_rect.x, scene.measure_slots_rect.y, scene.measure_slots_rect.w, scene.measure_slots_rect.h, 20);
-    if (QUIState::ui_state.scene.lastTime - QUIState::ui_state.scene.measures_last_tap_t > QUIState::ui_state.scene.measures_touch_timeout){
-      nvgStrokeColor(s->vg, COLOR_WHITE_ALPHA(160));
-    }
-    else{
-      nvgStrokeColor(s->vg, COLOR_GRACE_BLUE_ALPHA(200));
-    }
-    nvgStrokeWidth(s->vg, 6);
-    nvgStroke(s->vg);
-    nvgFillColor(s->vg, COLOR_BLACK_ALPHA(100));
-    nvgFill(s->vg);
+// everything that determines what a measure slot looks like, compared to decide whether its cached image is stale
+typedef struct {
+  char name[16], val[16], unit[8];
+  NVGcolor val_color, label_color, unit_color;
+  int val_font_size, label_font_size, unit_font_size;
+} measure_text;
+
+typedef struct {
+  NVGLUframebuffer *fb;
+  int fb_w, fb_h;
+  Rect rect;
+  bool right_col;
+  measure_text text;
+} measure_slot_cache;
+
+// Each slot is rendered into its own framebuffer and only rendered again when its text, colors or
+// rect change. Frames in between composite the cached images instead of laying out and
+// tessellating every string of the panel.
+static measure_slot_cache measure_cache[std::extent_v<decltype(UIScene::measure_slots)>];
+// glyphs may reach a little past the slot rect
+const int measure_pad = 8;
+
+static bool measures_visible(const UIState *s) {
+  const auto alert_size = (*s->sm)["controlsState"].getControlsState().getAlertSize();
+  return s->scene.measure_cur_num_slots
+         && (alert_size == cereal::ControlsState::AlertSize::NONE
+             || (alert_size == cereal::ControlsState::AlertSize::SMALL && !s->scene.map_open));
+}
 
-    char const * deg = Hardware::EON() ? "°" : "°";
+// computes the strings and colors of a measure. Some measures also update scene state, so this runs every frame.
+static void measure_slot_text(UIState *s, int measure, measure_text &t){
+  SubMaster &sm = *(s->sm);
+  UIScene &scene = s->scene;
+  char const * deg = Hardware::EON() ? "°" : "°";
+
+  char (&name)[16] = t.name;
+  char (&val)[16] = t.val;
+  char (&unit)[8] = t.unit;
+  NVGcolor &val_color = t.val_color, &unit_color = t.unit_color;
+  int &val_font_size = t.val_font_size;
+  int g, b;
+  float p;
+
+  // switch to get metric strings/colors 
+  switch (measure){
+
+    case UIMeasure::CPU_TEMP_AND_PERCENTF: 
+      {
+      auto cpus = scene.deviceState.getCpuUsagePercent();
+      float cpu = 0.;
+      int num_cpu = 0;
+      for (auto c : cpus){
+        cpu += c;
+        num_cpu++;
+      }
+      if (num_cpu > 1){
+        cpu /= num_cpu;
+      }
+      val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
+      snprintf(val, sizeof(val), "%.0f%sF", scene.deviceState.getCpuTempC()[0] * 1.8 + 32., deg);
+      snprintf(unit, sizeof(unit), "%d%%", int(cpu));
+      snprintf(name, sizeof(name), "CPU");}
+      break;
     
-    // now start from the top and draw the current set of metrics
-    for (int ii = 0; ii < scene.measure_cur_num_slots; ++ii){
-      try{
-        int i = ii;
-        if (scene.measure_cur_num_slots > scene.measure_max_rows && i >= scene.measure_num_rows){
-          i += scene.measure_row_offset;
-        }
-
-        char name[16], val[16], unit[8];
-        snprintf(name, sizeof(name), "");
-        snprintf(val, sizeof(val), "");
-        snprintf(unit, sizeof(unit), "");
-        NVGcolor val_color, label_color, unit_color;
-        int val_font_size, label_font_size, unit_font_size;
-        int g, b;
-        float p;
-        
-        val_color = default_val_color;
-        label_color = default_name_color;
-        unit_color = default_unit_color;
-        val_font_size = default_val_font_size;
-        label_font_size = default_name_font_size;
-        unit_font_size = default_unit_font_size;
-
-        // switch to get metric strings/colors 
-        switch (scene.measure_slots[i]){
-
-          case UIMeasure::CPU_TEMP_AND_PERCENTF: 
-            {
-            auto cpus = scene.deviceState.getCpuUsagePercent();
-            float cpu = 0.;
-            int num_cpu = 0;
-            for (auto c : cpus){
-              cpu += c;
-              num_cpu++;
-            }
-            if (num_cpu > 1){
-              cpu /= num_cpu;
-            }
-            val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
-            snprintf(val, sizeof(val), "%.0f%sF", scene.deviceState.getCpuTempC()[0] * 1.8 + 32., deg);
-            snprintf(unit, sizeof(unit), "%d%%", int(cpu));
-            snprintf(name, sizeof(name), "CPU");}
-            break;
-          
-          case UIMeasure::CPU_TEMPF: 
-            {
-            val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
-            snprintf(val, sizeof(val), "%.0f", scene.deviceState.getCpuTempC()[0] * 1.8 + 32.);
-            snprintf(unit, sizeof(unit), "%sF", deg);
-            snprintf(name, sizeof(name), "CPU TEMP");}
-            break;
-          
-          case UIMeasure::MEMORY_TEMPF: 
-            {
-            val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
-            snprintf(val, sizeof(val), "%.0f", scene.deviceState.getMemoryTempC() * 1.8 + 32.);
-            snprintf(unit, sizeof(unit), "%sF", deg);
-            snprintf(name, sizeof(name), "MEM TEMP");}
-            break;
-          
-          case UIMeasure::AMBIENT_TEMPF: 
-            {
-            val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
-            snprintf(val, sizeof(val), "%.0f", scene.deviceState.getAmbientTempC() * 1.8 + 32.);
-            snprintf(unit, sizeof(unit), "%sF", deg);
-            snprintf(name, sizeof(name), "AMB TEMP");}
-            break;
-          
-          case UIMeasure::INTERACTION_TIMER: 
-            {
-            int s = scene.controls_state.getInteractionTimer();
-            if (s < 5){
-              val_color = nvgRGBA(255, 125, 100, 200);
-            }
-            int h = s / 3600;
-            s = s % 3600;
-            int m = s / 60;
-            s = s % 60;
-            if (h > 0){
-              snprintf(val, sizeof(val), "%d:%02d:%02d", h, m, s);
-            }
-            else{
-              snprintf(val, sizeof(val), "%d:%02d", m, s);
-            }
-            snprintf(name, sizeof(name), "INTERACT");}
-            break;
-
-          case UIMeasure::INTERVENTION_TIMER: 
-            {
-            int s = scene.controls_state.getInterventionTimer();
-            if (s < 5){
-              val_color = nvgRGBA(255, 125, 100, 200);
-            }
-            int h = s / 3600;
-            s = s % 3600;
-            int m = s / 60;
-            s = s % 60;
-            if (h > 0){
-              snprintf(val, sizeof(val), "%d:%02d:%02d", h, m, s);
-            }
-            else{
-              snprintf(val, sizeof(val), "%d:%02d", m, s);
-            }
-            snprintf(name, sizeof(name), "INTERVENE");}
-            break;
-          
-          case UIMeasure::DISTRACTION_TIMER: 
-            {
-            int s = scene.controls_state.getDistractionTimer();
-            if (s < 5){
-              val_color = nvgRGBA(255, 125, 100, 200);
-            }
-            int h = s / 3600;
-            s = s % 3600;
-            int m = s / 60;
-            s = s % 60;
-            if (h > 0){
-              snprintf(val, sizeof(val), "%d:%02d:%02d", h, m, s);
-            }
-            else{
-              snprintf(val, sizeof(val), "%d:%02d", m, s);
-            }
-            snprintf(name, sizeof(name), "DISTRACT");}
-            break;
-            
-          case UIMeasure::CPU_TEMP_AND_PERCENTC: 
-            {
-            auto cpus = scene.deviceState.getCpuUsagePercent();
-            float cpu = 0.;
-            int num_cpu = 0;
-            for (auto c : cpus){
-              cpu += c;
-              num_cpu++;
-            }
-            if (num_cpu > 1){
-              cpu /= num_cpu;
-            }
-            val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
-              snprintf(val, sizeof(val), "%.0f%sC", scene.deviceState.getCpuTempC()[0], deg);
-            snprintf(unit, sizeof(unit), "%d%%", int(cpu));
-            snprintf(name, sizeof(name), "CPU");}
-            break;
-          
-          case UIMeasure::CPU_TEMPC: 
-            {
-            val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
-            snprintf(val, sizeof(val), "%.0f", scene.deviceState.getCpuTempC()[0]);
-            snprintf(unit, sizeof(unit), "%sC", deg);
-            snprintf(name, sizeof(name), "CPU TEMP");}
-            break;
-          
-          case UIMeasure::MEMORY_TEMPC: 
-            {
-            val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
-            snprintf(val, sizeof(val), "%.0f", scene.deviceState.getMemoryTempC());
-            snprintf(unit, sizeof(unit), "%sC", deg);
-            snprintf(name, sizeof(name), "MEM TEMP");}
-            break;
-          
-          case UIMeasure::AMBIENT_TEMPC: 
-            {
-            val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
-            snprintf(val, sizeof(val), "%.0f", scene.deviceState.getAmbientTempC());
-            snprintf(unit, sizeof(unit), "%sC", deg);
-            snprintf(name, sizeof(name), "AMB TEMP");}
-            break;
-          
-          case UIMeasure::CPU_PERCENT: 
-            {
-            auto cpus = scene.deviceState.getCpuUsagePercent();
-            float cpu = 0.;
-            int num_cpu = 0;
-            for (auto c : cpus){
-              cpu += c;
-              num_cpu++;
-            }
-            if (num_cpu > 1){
-              cpu /= num_cpu;
-            }
-            val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
-            snprintf(val, sizeof(val), "%d%%", int(cpu));
-            snprintf(name, sizeof(name), "CPU PERC");}
-            break;
-            
-          case UIMeasure::FANSPEED_PERCENT: 
-            {
-            val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
-            int fs = scene.deviceState.getFanSpeedPercentDesired();
-            if (fs > 100){
-              fs = scene.fanspeed_rpm;
-              snprintf(unit, sizeof(unit), "RPM");
-              snprintf(val, sizeof(val), "%d", fs);
-            }
-            else{
-              snprintf(val, sizeof(val), "%d%%", fs);
-            }
-            snprintf(name, sizeof(name), "FAN");
-            }
-            break;
-          case UIMeasure::FANSPEED_RPM: 
-            {
-            val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
-            snprintf(val, sizeof(val), "%d", scene.fanspeed_rpm);
-            snprintf(name, sizeof(name), "FAN");
-            snprintf(unit, sizeof(unit), "RPM");}
-            break;
-          
-          case UIMeasure::MEMORY_USAGE_PERCENT: 
-            {
-            int mem_perc = scene.deviceState.getMemoryUsagePercent();
-            g = 255; 
-            b = 255;
-            p = 0.011764706 * (mem_perc); // red by 85%
-            g -= int(0.5 * p * 255.);
-            b -= int(p * 255.);
+    case UIMeasure::CPU_TEMPF: 
+      {
+      val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
+      snprintf(val, sizeof(val), "%.0f", scene.deviceState.getCpuTempC()[0] * 1.8 + 32.);
+      snprintf(unit, sizeof(unit), "%sF", deg);
+      snprintf(name, sizeof(name), "CPU TEMP");}
+      break;
+    
+    case UIMeasure::MEMORY_TEMPF: 
+      {
+      val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
+      snprintf(val, sizeof(val), "%.0f", scene.deviceState.getMemoryTempC() * 1.8 + 32.);
+      snprintf(unit, sizeof(unit), "%sF", deg);
+      snprintf(name, sizeof(name), "MEM TEMP");}
+      break;
+    
+    case UIMeasure::AMBIENT_TEMPF: 
+      {
+      val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
+      snprintf(val, sizeof(val), "%.0f", scene.deviceState.getAmbientTempC() * 1.8 + 32.);
+      snprintf(unit, sizeof(unit), "%sF", deg);
+      snprintf(name, sizeof(name), "AMB TEMP");}
+      break;
+    
+    case UIMeasure::INTERACTION_TIMER: 
+      {
+      int s = scene.controls_state.getInteractionTimer();
+      if (s < 5){
+        val_color = nvgRGBA(255, 125, 100, 200);
+      }
+      int h = s / 3600;
+      s = s % 3600;
+      int m = s / 60;
+      s = s % 60;
+      if (h > 0){
+        snprintf(val, sizeof(val), "%d:%02d:%02d", h, m, s);
+      }
+      else{
+        snprintf(val, sizeof(val), "%d:%02d", m, s);
+      }
+      snprintf(name, sizeof(name), "INTERACT");}
+      break;
+
+    case UIMeasure::INTERVENTION_TIMER: 
+      {
+      int s = scene.controls_state.getInterventionTimer();
+      if (s < 5){
+        val_color = nvgRGBA(255, 125, 100, 200);
+      }
+      int h = s / 3600;
+      s = s % 3600;
+      int m = s / 60;
+      s = s % 60;
+      if (h > 0){
+        snprintf(val, sizeof(val), "%d:%02d:%02d", h, m, s);
+      }
+      else{
+        snprintf(val, sizeof(val), "%d:%02d", m, s);
+      }
+      snprintf(name, sizeof(name), "INTERVENE");}
+      break;
+    
+    case UIMeasure::DISTRACTION_TIMER: 
+      {
+      int s = scene.controls_state.getDistractionTimer();
+      if (s < 5){
+        val_color = nvgRGBA(255, 125, 100, 200);
+      }
+      int h = s / 3600;
+      s = s % 3600;
+      int m = s / 60;
+      s = s % 60;
+      if (h > 0){
+        snprintf(val, sizeof(val), "%d:%02d:%02d", h, m, s);
+      }
+      else{
+        snprintf(val, sizeof(val), "%d:%02d", m, s);
+      }
+      snprintf(name, sizeof(name), "DISTRACT");}
+      break;
+      
+    case UIMeasure::CPU_TEMP_AND_PERCENTC: 
+      {
+      auto cpus = scene.deviceState.getCpuUsagePercent();
+      float cpu = 0.;
+      int num_cpu = 0;
+      for (auto c : cpus){
+        cpu += c;
+        num_cpu++;
+      }
+      if (num_cpu > 1){
+        cpu /= num_cpu;
+      }
+      val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
+        snprintf(val, sizeof(val), "%.0f%sC", scene.deviceState.getCpuTempC()[0], deg);
+      snprintf(unit, sizeof(unit), "%d%%", int(cpu));
+      snprintf(name, sizeof(name), "CPU");}
+      break;
+    
+    case UIMeasure::CPU_TEMPC: 
+      {
+      val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
+      snprintf(val, sizeof(val), "%.0f", scene.deviceState.getCpuTempC()[0]);
+      snprintf(unit, sizeof(unit), "%sC", deg);
+      snprintf(name, sizeof(name), "CPU TEMP");}
+      break;
+    
+    case UIMeasure::MEMORY_TEMPC: 
+      {
+      val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
+      snprintf(val, sizeof(val), "%.0f", scene.deviceState.getMemoryTempC());
+      snprintf(unit, sizeof(unit), "%sC", deg);
+      snprintf(name, sizeof(name), "MEM TEMP");}
+      break;
+    
+    case UIMeasure::AMBIENT_TEMPC: 
+      {
+      val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
+      snprintf(val, sizeof(val), "%.0f", scene.deviceState.getAmbientTempC());
+      snprintf(unit, sizeof(unit), "%sC", deg);
+      snprintf(name, sizeof(name), "AMB TEMP");}
+      break;
+    
+    case UIMeasure::CPU_PERCENT: 
+      {
+      auto cpus = scene.deviceState.getCpuUsagePercent();
+      float cpu = 0.;
+      int num_cpu = 0;
+      for (auto c : cpus){
+        cpu += c;
+        num_cpu++;
+      }
+      if (num_cpu > 1){
+        cpu /= num_cpu;
+      }
+      val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
+      snprintf(val, sizeof(val), "%d%%", int(cpu));
+      snprintf(name, sizeof(name), "CPU PERC");}
+      break;
+      
+    case UIMeasure::FANSPEED_PERCENT: 
+      {
+      val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
+      int fs = scene.deviceState.getFanSpeedPercentDesired();
+      if (fs > 100){
+        fs = scene.fanspeed_rpm;
+        snprintf(unit, sizeof(unit), "RPM");
+        snprintf(val, sizeof(val), "%d", fs);
+      }
+      else{
+        snprintf(val, sizeof(val), "%d%%", fs);
+      }
+      snprintf(name, sizeof(name), "FAN");
+      }
+      break;
+    case UIMeasure::FANSPEED_RPM: 
+      {
+      val_color = color_from_thermal_status(int(scene.deviceState.getThermalStatus()));
+      snprintf(val, sizeof(val), "%d", scene.fanspeed_rpm);
+      snprintf(name, sizeof(name), "FAN");
+      snprintf(unit, sizeof(unit), "RPM");}
+      break;
+    
+    case UIMeasure::MEMORY_USAGE_PERCENT: 
+      {
+      int mem_perc = scene.deviceState.getMemoryUsagePercent();
+      g = 255; 
+      b = 255;
+      p = 0.011764706 * (mem_perc); // red by 85%
+      g -= int(0.5 * p * 255.);
+      b -= int(p * 255.);
+      g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+      b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+      val_color = nvgRGBA(255, g, b, 200);
+      snprintf(val, sizeof(val), "%d%%", mem_perc);
+      snprintf(name, sizeof(name), "MEM USED");}
+      break;
+    
+    case UIMeasure::FREESPACE_STORAGE: 
+      {
+      int free_perc = scene.deviceState.getFreeSpacePercent();
+      g = 0;
+      b = 0;
+      p = 0.05 * free_perc; // white at or above 20% freespace
+      g += int((0.5+p) * 255.);
+      b += int(p * 255.);
+      g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+      b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+      val_color = nvgRGBA(255, g, b, 200);
+      snprintf(val, sizeof(val), "%d%%", free_perc);
+      snprintf(name, sizeof(name), "SSD FREE");}
+      break;
+
+    case UIMeasure::GPS_ACCURACY:
+      {
+      if (sm.updated("ubloxGnss")) {
+        auto data = sm["ubloxGnss"].getUbloxGnss();
+        if (data.which() == cereal::UbloxGnss::MEASUREMENT_REPORT) {
+          scene.satelliteCount = data.getMeasurementReport().getNumMeas();
+        }
+        auto data2 = sm["gpsLocationExternal"].getGpsLocationExternal();
+        scene.gpsAccuracyUblox = data2.getAccuracy();
+      }
+      snprintf(name, sizeof(name), "GPS PREC");
+      if (scene.gpsAccuracyUblox != 0.00) {
+        //show red/orange if gps accuracy is low
+        if(scene.gpsAccuracyUblox > 0.85) {
+          val_color = nvgRGBA(255, 188, 3, 200);
+        }
+        if(scene.gpsAccuracyUblox > 1.3) {
+          val_color = nvgRGBA(255, 0, 0, 200);
+        }
+        // gps accuracy is always in meters
+        if(scene.gpsAccuracyUblox > 99 || scene.gpsAccuracyUblox == 0) {
+          snprintf(val, sizeof(val), "None");
+        }else if(scene.gpsAccuracyUblox > 9.99) {
+          snprintf(val, sizeof(val), "%.1f", scene.gpsAccuracyUblox);
+        }
+        else {
+          snprintf(val, sizeof(val), "%.2f", scene.gpsAccuracyUblox);
+        }
+        snprintf(unit, sizeof(unit), "%d", scene.satelliteCount);
+      }}
+      break;
+
+    case UIMeasure::ALTITUDE:
+      {
+      if (sm.updated("gpsLocationExternal")) {
+        auto data2 = sm["gpsLocationExternal"].getGpsLocationExternal();
+        scene.altitudeUblox = data2.getAltitude();
+        scene.gpsAccuracyUblox = data2.getAccuracy();
+      }
+      snprintf(name, sizeof(name), "ELEVATION");
+      if (scene.gpsAccuracyUblox != 0.00) {
+        float tmp_val;
+        if (s->is_metric) {
+          tmp_val = scene.altitudeUblox;
+          snprintf(val, sizeof(val), "%.0f", scene.altitudeUblox);
+          snprintf(unit, sizeof(unit), "m");
+        } else {
+          tmp_val = scene.altitudeUblox * 3.2808399;
+          snprintf(val, sizeof(val), "%.0f", tmp_val);
+          snprintf(unit, sizeof(unit), "ft");
+        }
+        if (log10(tmp_val) >= 4){
+          val_font_size -= 10;
+        }
+      }}
+      break;
+
+    case UIMeasure::BEARING:
+      {
+        snprintf(name, sizeof(name), "BEARING");
+        if (scene.bearingAccuracy != 180.00) {
+          snprintf(unit, sizeof(unit), "%.0d%s", (int)scene.bearingDeg, "°");
+          if (((scene.bearingDeg >= 337.5) && (scene.bearingDeg <= 360)) || ((scene.bearingDeg >= 0) && (scene.bearingDeg <= 22.5))) {
+            snprintf(val, sizeof(val), "N");
+          } else if ((scene.bearingDeg > 22.5) && (scene.bearingDeg < 67.5)) {
+            snprintf(val, sizeof(val), "NE");
+          } else if ((scene.bearingDeg >= 67.5) && (scene.bearingDeg <= 112.5)) {
+            snprintf(val, sizeof(val), "E");
+          } else if ((scene.bearingDeg > 112.5) && (scene.bearingDeg < 157.5)) {
+            snprintf(val, sizeof(val), "SE");
+          } else if ((scene.bearingDeg >= 157.5) && (scene.bearingDeg <= 202.5)) {
+            snprintf(val, sizeof(val), "S");
+          } else if ((scene.bearingDeg > 202.5) && (scene.bearingDeg < 247.5)) {
+            snprintf(val, sizeof(val), "SW");
+          } else if ((scene.bearingDeg >= 247.5) && (scene.bearingDeg <= 292.5)) {
+            snprintf(val, sizeof(val), "W");
+          } else if ((scene.bearingDeg > 292.5) && (scene.bearingDeg < 337.5)) {
+            snprintf(val, sizeof(val), "NW");
+          }
+        } else {
+          snprintf(val, sizeof(val), "OFF");
+          snprintf(unit, sizeof(unit), "-");
+        }
+      }
+      break;
+
+    case UIMeasure::STEERING_TORQUE_EPS:
+      {
+      snprintf(name, sizeof(name), "EPS TRQ");
+      //TODO: Add orange/red color depending on torque intensity. <1x limit = white, btwn 1x-2x limit = orange, >2x limit = red
+      snprintf(val, sizeof(val), "%.1f", scene.car_state.getSteeringTorqueEps());
+      snprintf(unit, sizeof(unit), "Nm");
+      break;}
+
+    case UIMeasure::ACCELERATION:
+      {
+      snprintf(name, sizeof(name), "ACCEL");
+      snprintf(val, sizeof(val), "%.1f", scene.car_state.getAEgo());
+      snprintf(unit, sizeof(unit), "m/s²");
+      break;}
+    
+    case UIMeasure::LAT_ACCEL:
+      {
+      snprintf(name, sizeof(name), "LAT ACC");
+      snprintf(val, sizeof(val), "%.1f", sm["liveLocationKalman"].getLiveLocationKalman().getAccelerationCalibrated().getValue()[1]);
+      snprintf(unit, sizeof(unit), "m/s²");
+      break;}
+
+    case UIMeasure::DRAG_FORCE:
+      {
+      snprintf(name, sizeof(name), "DRAG FRC");
+      float v = scene.car_state.getDragForce();
+      v /= 1e3;
+      if (fabs(v) > 100.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      else{
+        snprintf(val, sizeof(val), "%.2f", v);
+      }
+      snprintf(unit, sizeof(unit), "kN");
+      break;}
+
+    case UIMeasure::DRAG_POWER:
+      {
+      snprintf(name, sizeof(name), "DRAG POW");
+      float v = scene.car_state.getDragPower();
+      v /= 1e3;
+      if (fabs(v) > 100.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      else{
+        snprintf(val, sizeof(val), "%.2f", v);
+      }
+      snprintf(unit, sizeof(unit), "kW");
+      break;}
+
+    case UIMeasure::DRAG_POWER_HP:
+      {
+      snprintf(name, sizeof(name), "DRAG POW");
+      float v = scene.car_state.getDragPower();
+      v /= 1e3;
+      v *= 1.34;
+      if (fabs(v) > 100.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      else{
+        snprintf(val, sizeof(val), "%.2f", v);
+      }
+      snprintf(unit, sizeof(unit), "hp");
+      break;}
+
+    case UIMeasure::DRAG_LOSSES:
+      {
+      snprintf(name, sizeof(name), "DRAG LOSS");
+      if (scene.car_state.getDrivePower() != 0.){
+        float v = scene.car_state.getDragPower() / scene.car_state.getDrivePower() * 100.;
+        if (v >= 0. && v <= 100.){
+          snprintf(val, sizeof(val), "%.0f%%", v);
+        }
+        else{
+          float v = scene.car_state.getDragPower();
+          v /= 1e3;
+          if (fabs(v) > 100.){
+            snprintf(val, sizeof(val), "%.0f", v);
+          }
+          else if (fabs(v) > 10.){
+            snprintf(val, sizeof(val), "%.1f", v);
+          }
+          else{
+            snprintf(val, sizeof(val), "%.2f", v);
+          }
+          snprintf(unit, sizeof(unit), "kW");
+        }
+      }
+      else{
+        snprintf(val, sizeof(val), "--");
+      }
+      break;}
+    
+    case UIMeasure::ACCEL_FORCE:
+      {
+      snprintf(name, sizeof(name), "ACCEL FRC");
+      float v = scene.car_state.getAccelForce();
+      v /= 1e3;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "kN");
+      break;}
+
+    case UIMeasure::EV_FORCE:
+      {
+      snprintf(name, sizeof(name), "EV FRC");
+      float v = scene.car_state.getEvForce();
+      v /= 1e3;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "kN");
+      break;}
+
+    case UIMeasure::REGEN_FORCE:
+      {
+      snprintf(name, sizeof(name), "REGEN FRC");
+      float v = scene.car_state.getRegenForce();
+      v /= 1e3;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "kN");
+      break;}
+
+    case UIMeasure::BRAKE_FORCE:
+      {
+      snprintf(name, sizeof(name), "BRAKE FRC");
+      float v = scene.car_state.getBrakeForce();
+      v /= 1e3;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "kN");
+      break;}
+
+    case UIMeasure::ACCEL_POWER:
+      {
+      snprintf(name, sizeof(name), "ACCEL POW");
+      float v = scene.car_state.getAccelPower();
+      v /= 1e3;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "kW");
+      break;}
+
+    case UIMeasure::EV_POWER:
+      {
+      snprintf(name, sizeof(name), "EV POW");
+      float v = scene.car_state.getEvPower();
+      v /= 1e3;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "kW");
+      break;}
+
+    case UIMeasure::REGEN_POWER:
+      {
+      snprintf(name, sizeof(name), "REGEN POW");
+      float v = scene.car_state.getRegenPower();
+      v /= 1e3;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "kW");
+      break;}
+
+    case UIMeasure::BRAKE_POWER:
+      {
+      snprintf(name, sizeof(name), "BRAKE POW");
+      float v = scene.car_state.getBrakePower();
+      v /= 1e3;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "kW");
+      break;}
+
+    case UIMeasure::DRIVE_POWER:
+      {
+      snprintf(name, sizeof(name), "DRIVE POW");
+      float v = scene.car_state.getDrivePower();
+      v /= 1e3;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else{
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      
+      snprintf(unit, sizeof(unit), "kW");
+      break;}
+
+    case UIMeasure::ICE_POWER:
+      {
+      snprintf(name, sizeof(name), "ICE POW");
+      float v = scene.car_state.getIcePower();
+      v /= 1e3;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else{
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      
+      snprintf(unit, sizeof(unit), "kW");
+      break;}
+    
+    case UIMeasure::ACCEL_POWER_HP:
+      {
+      snprintf(name, sizeof(name), "ACCEL POW");
+      float v = scene.car_state.getAccelPower();
+      v /= 1e3;
+      v *= 1.34;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "hp");
+      break;}
+
+    case UIMeasure::EV_POWER_HP:
+      {
+      snprintf(name, sizeof(name), "EV POW");
+      float v = scene.car_state.getEvPower();
+      v /= 1e3;
+      v *= 1.34;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "hp");
+      break;}
+
+    case UIMeasure::REGEN_POWER_HP:
+      {
+      snprintf(name, sizeof(name), "REGEN POW");
+      float v = scene.car_state.getRegenPower();
+      v /= 1e3;
+      v *= 1.34;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "hp");
+      break;}
+
+    case UIMeasure::BRAKE_POWER_HP:
+      {
+      snprintf(name, sizeof(name), "BRAKE POW");
+      float v = scene.car_state.getBrakePower();
+      v /= 1e3;
+      v *= 1.34;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else {
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "hp");
+      break;}
+
+    case UIMeasure::DRIVE_POWER_HP:
+      {
+      snprintf(name, sizeof(name), "DRIVE POW");
+      float v = scene.car_state.getDrivePower();
+      v /= 1e3;
+      v *= 1.34;
+      if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else{
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      snprintf(unit, sizeof(unit), "hp");
+      break;}
+
+    case UIMeasure::ICE_POWER_HP:
+      {
+      snprintf(name, sizeof(name), "ICE POW");
+      float v = scene.car_state.getIcePower();
+      v /= 1e3;
+      v *= 1.34;
+      if (fabs(v) > 100.){
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      else if (fabs(v) > 10.){
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      else{
+        snprintf(val, sizeof(val), "%.2f", v);
+      }
+      snprintf(unit, sizeof(unit), "hp");
+      break;}
+
+    case UIMeasure::VISION_CURLATACCEL:
+      {
+      snprintf(name, sizeof(name), "V:LAT ACC");
+      snprintf(val, sizeof(val), "%.1f", sm["longitudinalPlan"].getLongitudinalPlan().getVisionCurrentLateralAcceleration());
+      snprintf(unit, sizeof(unit), "m/s²");
+      break;}
+    
+    case UIMeasure::VISION_MAXVFORCURCURV:
+      {
+      snprintf(name, sizeof(name), "V:MX CUR V");
+      snprintf(val, sizeof(val), "%.1f", sm["longitudinalPlan"].getLongitudinalPlan().getVisionMaxVForCurrentCurvature() * 2.24);
+      snprintf(unit, sizeof(unit), "mph");
+      break;}
+    
+    case UIMeasure::VISION_MAXPREDLATACCEL:
+      {
+      snprintf(name, sizeof(name), "V:MX PLA");
+      snprintf(val, sizeof(val), "%.1f", sm["longitudinalPlan"].getLongitudinalPlan().getVisionMaxPredictedLateralAcceleration());
+      snprintf(unit, sizeof(unit), "m/s²");
+      break;}
+
+    case UIMeasure::LANE_POSITION:
+      {
+      snprintf(name, sizeof(name), "LANE POS");
+      auto dat = scene.lateral_plan.getLanePosition();
+      if (dat == LanePosition::LEFT){
+        snprintf(val, sizeof(val), "left");
+      }
+      else if (dat == LanePosition::RIGHT){
+        snprintf(val, sizeof(val), "right");
+      }
+      else{
+        snprintf(val, sizeof(val), "center");
+      }
+      break;}
+
+    case UIMeasure::LANE_OFFSET:
+      {
+      snprintf(name, sizeof(name), "LN OFFSET");
+      auto dat = scene.lateral_plan.getLaneOffset();
+      snprintf(val, sizeof(val), "%.1f", dat);
+      snprintf(unit, sizeof(unit), "m");
+      break;}
+    
+    case UIMeasure::TRAFFIC_COUNT_TOTAL:
+      {
+      snprintf(name, sizeof(name), "TOTAL");
+      int dat = scene.lead_vertices_oncoming.size()
+                + scene.lead_vertices_ongoing.size()
+                + scene.lead_vertices_stopped.size()
+                + (scene.lead_data[0].getStatus() ? 1 : 0)
+                + (scene.radarState.getLeadsCenter()).size();
+      snprintf(val, sizeof(val), "%d", dat);
+      snprintf(unit, sizeof(unit), "cars");
+      break;}
+
+    case UIMeasure::TRAFFIC_COUNT_ONCOMING:
+      {
+      snprintf(name, sizeof(name), "ONCOMING");
+      int dat = scene.lead_vertices_oncoming.size();
+      snprintf(val, sizeof(val), "%d", dat);
+      snprintf(unit, sizeof(unit), "cars");
+      break;}
+
+    case UIMeasure::TRAFFIC_COUNT_ONGOING:
+      {
+      snprintf(name, sizeof(name), "ONGOING");
+      int dat = scene.lead_vertices_ongoing.size()
+                + (scene.lead_data[0].getStatus() ? 1 : 0)
+                + (scene.radarState.getLeadsCenter()).size();
+      snprintf(val, sizeof(val), "%d", dat);
+      snprintf(unit, sizeof(unit), "cars");
+      break;}
+
+    case UIMeasure::TRAFFIC_COUNT_STOPPED:
+      {
+      snprintf(name, sizeof(name), "STOPPED");
+      int dat = scene.lead_vertices_stopped.size()
+                + (scene.lead_data[0].getStatus() 
+                  && scene.lead_data[0].getVLeadK() < 3 
+                    ? 1 + (scene.radarState.getLeadsCenter()).size() 
+                    : 0);
+      snprintf(val, sizeof(val), "%d", dat);
+      snprintf(unit, sizeof(unit), "cars");
+      break;}
+
+    case UIMeasure::TRAFFIC_COUNT_ADJACENT_ONGOING:
+      {
+      snprintf(name, sizeof(name), "ADJ ONGOING");
+      int dat1 = scene.lateral_plan.getTrafficCountLeft();
+      int dat2 = scene.lateral_plan.getTrafficCountRight();
+      snprintf(val, sizeof(val), "%d:%d", dat1, dat2);
+      snprintf(unit, sizeof(unit), "cars");
+      break;}
+
+    case UIMeasure::TRAFFIC_ADJ_ONGOING_MIN_DISTANCE:
+      {
+      snprintf(name, sizeof(name), "MIN ADJ SEP");
+      float dat1 = scene.lateral_plan.getTrafficMinSeperationLeft();
+      float dat2 = scene.lateral_plan.getTrafficMinSeperationRight();
+      snprintf(val, sizeof(val), "%.1f:%.1f", dat1, dat2);
+      snprintf(unit, sizeof(unit), "s");
+      break;}
+
+    case UIMeasure::LEAD_TTC:
+      {
+      snprintf(name, sizeof(name), "TTC");
+      if (scene.lead_status && scene.lead_v_rel < 0.) {
+        float ttc = -scene.lead_d_rel / scene.lead_v_rel;
+        g = 0;
+        b = 0;
+        p = 0.333 * ttc; // red for <= 3s
+        g += int((0.5+p) * 255.);
+        b += int(p * 255.);
+        g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+        b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+        val_color = nvgRGBA(255, g, b, 200);
+        if (ttc > 99.){
+          snprintf(val, sizeof(val), "99+");
+        }
+        else if (ttc >= 10.){
+          snprintf(val, sizeof(val), "%.0f", ttc);
+        }
+        else{
+          snprintf(val, sizeof(val), "%.1f", ttc);
+        }
+      } else {
+        snprintf(val, sizeof(val), "-");
+      }
+      snprintf(unit, sizeof(unit), "s");}
+      break;
+
+    case UIMeasure::LEAD_DISTANCE_LENGTH:
+      {
+        snprintf(name, sizeof(name), "REL DIST");
+        if (scene.lead_status) {
+          if (s->is_metric) {
+            g = 0;
+            b = 0;
+            p = 0.0333 * scene.lead_d_rel;
+            g += int((0.5+p) * 255.);
+            b += int(p * 255.);
             g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
             b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
             val_color = nvgRGBA(255, g, b, 200);
-            snprintf(val, sizeof(val), "%d%%", mem_perc);
-            snprintf(name, sizeof(name), "MEM USED");}
-            break;
-          
-          case UIMeasure::FREESPACE_STORAGE: 
-            {
-            int free_perc = scene.deviceState.getFreeSpacePercent();
+            snprintf(val, sizeof(val), "%.0f", scene.lead_d_rel);
+          }
+          else{
             g = 0;
             b = 0;
-            p = 0.05 * free_perc; // white at or above 20% freespace
+            p = 0.01 * scene.lead_d_rel * 3.281;
             g += int((0.5+p) * 255.);
             b += int(p * 255.);
             g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
             b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
             val_color = nvgRGBA(255, g, b, 200);
-            snprintf(val, sizeof(val), "%d%%", free_perc);
-            snprintf(name, sizeof(name), "SSD FREE");}
-            break;
-
-          case UIMeasure::GPS_ACCURACY:
-            {
-            if (sm.updated("ubloxGnss")) {
-              auto data = sm["ubloxGnss"].getUbloxGnss();
-              if (data.which() == cereal::UbloxGnss::MEASUREMENT_REPORT) {
-                scene.satelliteCount = data.getMeasurementReport().getNumMeas();
-              }
-              auto data2 = sm["gpsLocationExternal"].getGpsLocationExternal();
-              scene.gpsAccuracyUblox = data2.getAccuracy();
-            }
-            snprintf(name, sizeof(name), "GPS PREC");
-            if (scene.gpsAccuracyUblox != 0.00) {
-              //show red/orange if gps accuracy is low
-              if(scene.gpsAccuracyUblox > 0.85) {
-                val_color = nvgRGBA(255, 188, 3, 200);
-              }
-              if(scene.gpsAccuracyUblox > 1.3) {
-                val_color = nvgRGBA(255, 0, 0, 200);
-              }
-              // gps accuracy is always in meters
-              if(scene.gpsAccuracyUblox > 99 || scene.gpsAccuracyUblox == 0) {
-                snprintf(val, sizeof(val), "None");
-              }else if(scene.gpsAccuracyUblox > 9.99) {
-                snprintf(val, sizeof(val), "%.1f", scene.gpsAccuracyUblox);
-              }
-              else {
-                snprintf(val, sizeof(val), "%.2f", scene.gpsAccuracyUblox);
-              }
-              snprintf(unit, sizeof(unit), "%d", scene.satelliteCount);
-            }}
-            break;
-
-          case UIMeasure::ALTITUDE:
-            {
-            if (sm.updated("gpsLocationExternal")) {
-              auto data2 = sm["gpsLocationExternal"].getGpsLocationExternal();
-              scene.altitudeUblox = data2.getAltitude();
-              scene.gpsAccuracyUblox = data2.getAccuracy();
-            }
-            snprintf(name, sizeof(name), "ELEVATION");
-            if (scene.gpsAccuracyUblox != 0.00) {
-              float tmp_val;
-              if (s->is_metric) {
-                tmp_val = scene.altitudeUblox;
-                snprintf(val, sizeof(val), "%.0f", scene.altitudeUblox);
-                snprintf(unit, sizeof(unit), "m");
-              } else {
-                tmp_val = scene.altitudeUblox * 3.2808399;
-                snprintf(val, sizeof(val), "%.0f", tmp_val);
-                snprintf(unit, sizeof(unit), "ft");
-              }
-              if (log10(tmp_val) >= 4){
-                val_font_size -= 10;
-              }
-            }}
-            break;
-
-          case UIMeasure::BEARING:
-            {
-              snprintf(name, sizeof(name), "BEARING");
-              if (scene.bearingAccuracy != 180.00) {
-                snprintf(unit, sizeof(unit), "%.0d%s", (int)scene.bearingDeg, "°");
-                if (((scene.bearingDeg >= 337.5) && (scene.bearingDeg <= 360)) || ((scene.bearingDeg >= 0) && (scene.bearingDeg <= 22.5))) {
-                  snprintf(val, sizeof(val), "N");
-                } else if ((scene.bearingDeg > 22.5) && (scene.bearingDeg < 67.5)) {
-                  snprintf(val, sizeof(val), "NE");
-                } else if ((scene.bearingDeg >= 67.5) && (scene.bearingDeg <= 112.5)) {
-                  snprintf(val, sizeof(val), "E");
-                } else if ((scene.bearingDeg > 112.5) && (scene.bearingDeg < 157.5)) {
-                  snprintf(val, sizeof(val), "SE");
-                } else if ((scene.bearingDeg >= 157.5) && (scene.bearingDeg <= 202.5)) {
-                  snprintf(val, sizeof(val), "S");
-                } else if ((scene.bearingDeg > 202.5) && (scene.bearingDeg < 247.5)) {
-                  snprintf(val, sizeof(val), "SW");
-                } else if ((scene.bearingDeg >= 247.5) && (scene.bearingDeg <= 292.5)) {
-                  snprintf(val, sizeof(val), "W");
-                } else if ((scene.bearingDeg > 292.5) && (scene.bearingDeg < 337.5)) {
-                  snprintf(val, sizeof(val), "NW");
-                }
-              } else {
-                snprintf(val, sizeof(val), "OFF");
-                snprintf(unit, sizeof(unit), "-");
-              }
-            }
-            break;
-
-          case UIMeasure::STEERING_TORQUE_EPS:
-            {
-            snprintf(name, sizeof(name), "EPS TRQ");
-            //TODO: Add orange/red color depending on torque intensity. <1x limit = white, btwn 1x-2x limit = orange, >2x limit = red
-            snprintf(val, sizeof(val), "%.1f", scene.car_state.getSteeringTorqueEps());
-            snprintf(unit, sizeof(unit), "Nm");
-            break;}
-
-          case UIMeasure::ACCELERATION:
-            {
-            snprintf(name, sizeof(name), "ACCEL");
-            snprintf(val, sizeof(val), "%.1f", scene.car_state.getAEgo());
-            snprintf(unit, sizeof(unit), "m/s²");
-            break;}
-          
-          case UIMeasure::LAT_ACCEL:
-            {
-            snprintf(name, sizeof(name), "LAT ACC");
-            snprintf(val, sizeof(val), "%.1f", sm["liveLocationKalman"].getLiveLocationKalman().getAccelerationCalibrated().getValue()[1]);
-            snprintf(unit, sizeof(unit), "m/s²");
-            break;}
-
-          case UIMeasure::DRAG_FORCE:
-            {
-            snprintf(name, sizeof(name), "DRAG FRC");
-            float v = scene.car_state.getDragForce();
-            v /= 1e3;
-            if (fabs(v) > 100.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            else{
-              snprintf(val, sizeof(val), "%.2f", v);
-            }
-            snprintf(unit, sizeof(unit), "kN");
-            break;}
-
-          case UIMeasure::DRAG_POWER:
-            {
-            snprintf(name, sizeof(name), "DRAG POW");
-            float v = scene.car_state.getDragPower();
-            v /= 1e3;
-            if (fabs(v) > 100.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            else{
-              snprintf(val, sizeof(val), "%.2f", v);
-            }
-            snprintf(unit, sizeof(unit), "kW");
-            break;}
-
-          case UIMeasure::DRAG_POWER_HP:
-            {
-            snprintf(name, sizeof(name), "DRAG POW");
-            float v = scene.car_state.getDragPower();
-            v /= 1e3;
-            v *= 1.34;
-            if (fabs(v) > 100.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            else{
-              snprintf(val, sizeof(val), "%.2f", v);
-            }
-            snprintf(unit, sizeof(unit), "hp");
-            break;}
-
-          case UIMeasure::DRAG_LOSSES:
-            {
-            snprintf(name, sizeof(name), "DRAG LOSS");
-            if (scene.car_state.getDrivePower() != 0.){
-              float v = scene.car_state.getDragPower() / scene.car_state.getDrivePower() * 100.;
-              if (v >= 0. && v <= 100.){
-                snprintf(val, sizeof(val), "%.0f%%", v);
-              }
-              else{
-                float v = scene.car_state.getDragPower();
-                v /= 1e3;
-                if (fabs(v) > 100.){
-                  snprintf(val, sizeof(val), "%.0f", v);
-                }
-                else if (fabs(v) > 10.){
-                  snprintf(val, sizeof(val), "%.1f", v);
-                }
-                else{
-                  snprintf(val, sizeof(val), "%.2f", v);
-                }
-                snprintf(unit, sizeof(unit), "kW");
-              }
-            }
-            else{
-              snprintf(val, sizeof(val), "--");
-            }
-            break;}
-          
-          case UIMeasure::ACCEL_FORCE:
-            {
-            snprintf(name, sizeof(name), "ACCEL FRC");
-            float v = scene.car_state.getAccelForce();
-            v /= 1e3;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "kN");
-            break;}
-
-          case UIMeasure::EV_FORCE:
-            {
-            snprintf(name, sizeof(name), "EV FRC");
-            float v = scene.car_state.getEvForce();
-            v /= 1e3;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "kN");
-            break;}
-
-          case UIMeasure::REGEN_FORCE:
-            {
-            snprintf(name, sizeof(name), "REGEN FRC");
-            float v = scene.car_state.getRegenForce();
-            v /= 1e3;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "kN");
-            break;}
-
-          case UIMeasure::BRAKE_FORCE:
-            {
-            snprintf(name, sizeof(name), "BRAKE FRC");
-            float v = scene.car_state.getBrakeForce();
-            v /= 1e3;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "kN");
-            break;}
-
-          case UIMeasure::ACCEL_POWER:
-            {
-            snprintf(name, sizeof(name), "ACCEL POW");
-            float v = scene.car_state.getAccelPower();
-            v /= 1e3;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "kW");
-            break;}
-
-          case UIMeasure::EV_POWER:
-            {
-            snprintf(name, sizeof(name), "EV POW");
-            float v = scene.car_state.getEvPower();
-            v /= 1e3;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "kW");
-            break;}
-
-          case UIMeasure::REGEN_POWER:
-            {
-            snprintf(name, sizeof(name), "REGEN POW");
-            float v = scene.car_state.getRegenPower();
-            v /= 1e3;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "kW");
-            break;}
-
-          case UIMeasure::BRAKE_POWER:
-            {
-            snprintf(name, sizeof(name), "BRAKE POW");
-            float v = scene.car_state.getBrakePower();
-            v /= 1e3;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "kW");
-            break;}
-
-          case UIMeasure::DRIVE_POWER:
-            {
-            snprintf(name, sizeof(name), "DRIVE POW");
-            float v = scene.car_state.getDrivePower();
-            v /= 1e3;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else{
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            
-            snprintf(unit, sizeof(unit), "kW");
-            break;}
-
-          case UIMeasure::ICE_POWER:
-            {
-            snprintf(name, sizeof(name), "ICE POW");
-            float v = scene.car_state.getIcePower();
-            v /= 1e3;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else{
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            
-            snprintf(unit, sizeof(unit), "kW");
-            break;}
-          
-          case UIMeasure::ACCEL_POWER_HP:
-            {
-            snprintf(name, sizeof(name), "ACCEL POW");
-            float v = scene.car_state.getAccelPower();
-            v /= 1e3;
-            v *= 1.34;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "hp");
-            break;}
-
-          case UIMeasure::EV_POWER_HP:
-            {
-            snprintf(name, sizeof(name), "EV POW");
-            float v = scene.car_state.getEvPower();
-            v /= 1e3;
-            v *= 1.34;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "hp");
-            break;}
-
-          case UIMeasure::REGEN_POWER_HP:
-            {
-            snprintf(name, sizeof(name), "REGEN POW");
-            float v = scene.car_state.getRegenPower();
-            v /= 1e3;
-            v *= 1.34;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "hp");
-            break;}
-
-          case UIMeasure::BRAKE_POWER_HP:
-            {
-            snprintf(name, sizeof(name), "BRAKE POW");
-            float v = scene.car_state.getBrakePower();
-            v /= 1e3;
-            v *= 1.34;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else {
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "hp");
-            break;}
-
-          case UIMeasure::DRIVE_POWER_HP:
-            {
-            snprintf(name, sizeof(name), "DRIVE POW");
-            float v = scene.car_state.getDrivePower();
-            v /= 1e3;
-            v *= 1.34;
-            if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else{
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            snprintf(unit, sizeof(unit), "hp");
-            break;}
-
-          case UIMeasure::ICE_POWER_HP:
-            {
-            snprintf(name, sizeof(name), "ICE POW");
-            float v = scene.car_state.getIcePower();
-            v /= 1e3;
-            v *= 1.34;
-            if (fabs(v) > 100.){
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            else if (fabs(v) > 10.){
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            else{
-              snprintf(val, sizeof(val), "%.2f", v);
-            }
-            snprintf(unit, sizeof(unit), "hp");
-            break;}
-
-          case UIMeasure::VISION_CURLATACCEL:
-            {
-            snprintf(name, sizeof(name), "V:LAT ACC");
-            snprintf(val, sizeof(val), "%.1f", sm["longitudinalPlan"].getLongitudinalPlan().getVisionCurrentLateralAcceleration());
-            snprintf(unit, sizeof(unit), "m/s²");
-            break;}
-          
-          case UIMeasure::VISION_MAXVFORCURCURV:
-            {
-            snprintf(name, sizeof(name), "V:MX CUR V");
-            snprintf(val, sizeof(val), "%.1f", sm["longitudinalPlan"].getLongitudinalPlan().getVisionMaxVForCurrentCurvature() * 2.24);
-            snprintf(unit, sizeof(unit), "mph");
-            break;}
-          
-          case UIMeasure::VISION_MAXPREDLATACCEL:
-            {
-            snprintf(name, sizeof(name), "V:MX PLA");
-            snprintf(val, sizeof(val), "%.1f", sm["longitudinalPlan"].getLongitudinalPlan().getVisionMaxPredictedLateralAcceleration());
-            snprintf(unit, sizeof(unit), "m/s²");
-            break;}
-
-          case UIMeasure::LANE_POSITION:
-            {
-            snprintf(name, sizeof(name), "LANE POS");
-            auto dat = scene.lateral_plan.getLanePosition();
-            if (dat == LanePosition::LEFT){
-              snprintf(val, sizeof(val), "left");
-            }
-            else if (dat == LanePosition::RIGHT){
-              snprintf(val, sizeof(val), "right");
-            }
-            else{
-              snprintf(val, sizeof(val), "center");
-            }
-            break;}
-
-          case UIMeasure::LANE_OFFSET:
-            {
-            snprintf(name, sizeof(name), "LN OFFSET");
-            auto dat = scene.lateral_plan.getLaneOffset();
-            snprintf(val, sizeof(val), "%.1f", dat);
-            snprintf(unit, sizeof(unit), "m");
-            break;}
-          
-          case UIMeasure::TRAFFIC_COUNT_TOTAL:
-            {
-            snprintf(name, sizeof(name), "TOTAL");
-            int dat = scene.lead_vertices_oncoming.size()
-                      + scene.lead_vertices_ongoing.size()
-                      + scene.lead_vertices_stopped.size()
-                      + (scene.lead_data[0].getStatus() ? 1 : 0)
-                      + (scene.radarState.getLeadsCenter()).size();
-            snprintf(val, sizeof(val), "%d", dat);
-            snprintf(unit, sizeof(unit), "cars");
-            break;}
-
-          case UIMeasure::TRAFFIC_COUNT_ONCOMING:
-            {
-            snprintf(name, sizeof(name), "ONCOMING");
-            int dat = scene.lead_vertices_oncoming.size();
-            snprintf(val, sizeof(val), "%d", dat);
-            snprintf(unit, sizeof(unit), "cars");
-            break;}
-
-          case UIMeasure::TRAFFIC_COUNT_ONGOING:
-            {
-            snprintf(name, sizeof(name), "ONGOING");
-            int dat = scene.lead_vertices_ongoing.size()
-                      + (scene.lead_data[0].getStatus() ? 1 : 0)
-                      + (scene.radarState.getLeadsCenter()).size();
-            snprintf(val, sizeof(val), "%d", dat);
-            snprintf(unit, sizeof(unit), "cars");
-            break;}
-
-          case UIMeasure::TRAFFIC_COUNT_STOPPED:
-            {
-            snprintf(name, sizeof(name), "STOPPED");
-            int dat = scene.lead_vertices_stopped.size()
-                      + (scene.lead_data[0].getStatus() 
-                        && scene.lead_data[0].getVLeadK() < 3 
-                          ? 1 + (scene.radarState.getLeadsCenter()).size() 
-                          : 0);
-            snprintf(val, sizeof(val), "%d", dat);
-            snprintf(unit, sizeof(unit), "cars");
-            break;}
-
-          case UIMeasure::TRAFFIC_COUNT_ADJACENT_ONGOING:
-            {
-            snprintf(name, sizeof(name), "ADJ ONGOING");
-            int dat1 = scene.lateral_plan.getTrafficCountLeft();
-            int dat2 = scene.lateral_plan.getTrafficCountRight();
-            snprintf(val, sizeof(val), "%d:%d", dat1, dat2);
-            snprintf(unit, sizeof(unit), "cars");
-            break;}
-
-          case UIMeasure::TRAFFIC_ADJ_ONGOING_MIN_DISTANCE:
-            {
-            snprintf(name, sizeof(name), "MIN ADJ SEP");
-            float dat1 = scene.lateral_plan.getTrafficMinSeperationLeft();
-            float dat2 = scene.lateral_plan.getTrafficMinSeperationRight();
-            snprintf(val, sizeof(val), "%.1f:%.1f", dat1, dat2);
-            snprintf(unit, sizeof(unit), "s");
-            break;}
-
-          case UIMeasure::LEAD_TTC:
-            {
-            snprintf(name, sizeof(name), "TTC");
-            if (scene.lead_status && scene.lead_v_rel < 0.) {
-              float ttc = -scene.lead_d_rel / scene.lead_v_rel;
-              g = 0;
-              b = 0;
-              p = 0.333 * ttc; // red for <= 3s
-              g += int((0.5+p) * 255.);
-              b += int(p * 255.);
-              g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-              b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-              val_color = nvgRGBA(255, g, b, 200);
-              if (ttc > 99.){
-                snprintf(val, sizeof(val), "99+");
-              }
-              else if (ttc >= 10.){
-                snprintf(val, sizeof(val), "%.0f", ttc);
-              }
-              else{
-                snprintf(val, sizeof(val), "%.1f", ttc);
-              }
-            } else {
-              snprintf(val, sizeof(val), "-");
-            }
-            snprintf(unit, sizeof(unit), "s");}
-            break;
-
-          case UIMeasure::LEAD_DISTANCE_LENGTH:
-            {
-              snprintf(name, sizeof(name), "REL DIST");
-              if (scene.lead_status) {
-                if (s->is_metric) {
-                  g = 0;
-                  b = 0;
-                  p = 0.0333 * scene.lead_d_rel;
-                  g += int((0.5+p) * 255.);
-                  b += int(p * 255.);
-                  g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-                  b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-                  val_color = nvgRGBA(255, g, b, 200);
-                  snprintf(val, sizeof(val), "%.0f", scene.lead_d_rel);
-                }
-                else{
-                  g = 0;
-                  b = 0;
-                  p = 0.01 * scene.lead_d_rel * 3.281;
-                  g += int((0.5+p) * 255.);
-                  b += int(p * 255.);
-                  g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-                  b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-                  val_color = nvgRGBA(255, g, b, 200);
-                  float d_ft = scene.lead_d_rel * 3.281;
-                  snprintf(val, sizeof(val), "%.0f", d_ft);
-                }
-              } else {
-                snprintf(val, sizeof(val), "-");
-              }
-              if (s->is_metric) {
-                snprintf(unit, sizeof(unit), "m");
-              }
-              else{
-                snprintf(unit, sizeof(unit), "ft");
-              }
-            }
-            break;
-        
-          case UIMeasure::LEAD_DESIRED_DISTANCE_LENGTH:
-            {
-              snprintf(name, sizeof(name), "REL:DES DIST");
-              auto follow_d = scene.desiredFollowDistance * scene.car_state.getVEgo() + scene.stoppingDistance;
-              if (scene.lead_status) {
-                if (s->is_metric) {
-                  g = 0;
-                  b = 0;
-                  p = 0.0333 * scene.lead_d_rel;
-                  g += int((0.5+p) * 255.);
-                  b += int(p * 255.);
-                  g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-                  b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-                  val_color = nvgRGBA(255, g, b, 200);
-                  snprintf(val, sizeof(val), "%d:%d", (int)scene.lead_d_rel, (int)follow_d);
-                }
-                else{
-                  g = 0;
-                  b = 0;
-                  p = 0.01 * scene.lead_d_rel * 3.281;
-                  g += int((0.5+p) * 255.);
-                  b += int(p * 255.);
-                  g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-                  b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-                  val_color = nvgRGBA(255, g, b, 200);
-                  snprintf(val, sizeof(val), "%d:%d", (int)(scene.lead_d_rel * 3.281), (int)(follow_d * 3.281));
-                }
-              } else {
-                snprintf(val, sizeof(val), "-");
-              }
-              if (s->is_metric) {
-                snprintf(unit, sizeof(unit), "m");
-              }
-              else{
-                snprintf(unit, sizeof(unit), "ft");
-              }
-            }
-            break;
-            
-          case UIMeasure::LEAD_DISTANCE_TIME:
-            {
-            snprintf(name, sizeof(name), "REL DIST");
-            if (scene.lead_status && scene.car_state.getVEgo() > 0.5) {
-              float follow_t = scene.lead_d_rel / scene.car_state.getVEgo();
-              g = 0;
-              b = 0;
-              p = 0.6667 * follow_t;
-              g += int((0.5+p) * 255.);
-              b += int(p * 255.);
-              g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-              b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-              val_color = nvgRGBA(255, g, b, 200);
-              snprintf(val, sizeof(val), "%.1f", follow_t);
-            } else {
-              snprintf(val, sizeof(val), "-");
-            }
-            snprintf(unit, sizeof(unit), "s");}
-            break;
-          
-          case UIMeasure::LEAD_DESIRED_DISTANCE_TIME:
-            {
-            snprintf(name, sizeof(name), "REL:DES DIST");
-            if (scene.lead_status && scene.car_state.getVEgo() > 0.5) {
-              float follow_t = scene.lead_d_rel / scene.car_state.getVEgo();
-              float des_follow_t = scene.desiredFollowDistance + scene.stoppingDistance / scene.car_state.getVEgo();
-              g = 0;
-              b = 0;
-              p = 0.6667 * follow_t;
-              g += int((0.5+p) * 255.);
-              b += int(p * 255.);
-              g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-              b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-              val_color = nvgRGBA(255, g, b, 200);
-              snprintf(val, sizeof(val), "%.1f:%.1f", follow_t, des_follow_t);
-            } else {
-              snprintf(val, sizeof(val), "-");
-            }
-            snprintf(unit, sizeof(unit), "s");}
-            break;
-          
-          case UIMeasure::LEAD_COSTS:
-            {
-              snprintf(name, sizeof(name), "D:A COST");
-              if (scene.lead_status && scene.car_state.getVEgo() > 0.5) {
-                snprintf(val, sizeof(val), "%.1f:%.1f", scene.followDistanceCost, scene.followAccelCost);
-              } else {
-                snprintf(val, sizeof(val), "-");
-              }
-            }
-            break;
-
-          case UIMeasure::LEAD_VELOCITY_RELATIVE:
-            {
-            snprintf(name, sizeof(name), "REL SPEED");
-            if (scene.lead_status) {
-              g = 255; 
-              b = 255;
-              p = -0.2 * (scene.lead_v_rel);
-              g -= int(0.5 * p * 255.);
-              b -= int(p * 255.);
-              g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-              b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-              val_color = nvgRGBA(255, g, b, 200);
-              // lead car relative speed is always in meters
-              if (s->is_metric) {
-                snprintf(val, sizeof(val), "%.1f", (scene.lead_v_rel * 3.6));
-              } else {
-                snprintf(val, sizeof(val), "%.1f", (scene.lead_v_rel * 2.2374144));
-              }
-            } else {
-              snprintf(val, sizeof(val), "-");
-            }
-            if (s->is_metric) {
-              snprintf(unit, sizeof(unit), "km/h");;
-            } else {
-              snprintf(unit, sizeof(unit), "mph");
-            }}
-            break;
-          
-          case UIMeasure::LEAD_VELOCITY_ABS: 
-            {
-            snprintf(name, sizeof(name), "LEAD SPD");
-            if (scene.lead_status) {
-              if (s->is_metric) {
-                float v = (scene.lead_v * 3.6);
-                if (v < 100.){
-                  snprintf(val, sizeof(val), "%.1f", v);
-                }
-                else{
-                  snprintf(val, sizeof(val), "%.0f", v);
-                }
-              } else {
-                float v = (scene.lead_v * 2.2374144);
-                if (v < 100.){
-                  snprintf(val, sizeof(val), "%.1f", v);
-                }
-                else{
-                  snprintf(val, sizeof(val), "%.0f", v);
-                }
-              }
-            } else {
-              snprintf(val, sizeof(val), "-");
-            }
-            if (s->is_metric) {
-              snprintf(unit, sizeof(unit), "km/h");;
-            } else {
-              snprintf(unit, sizeof(unit), "mph");
-            }}
-            break;
-
-          case UIMeasure::STEERING_ANGLE: 
-            {
-            snprintf(name, sizeof(name), "REAL STEER");
-            float angleSteers = scene.angleSteers > 0. ? scene.angleSteers : -scene.angleSteers;
-            g = 255;
-            b = 255;
-            p = 0.0333 * angleSteers;
-            g -= int(0.5 * p * 255.);
-            b -= int(p * 255.);
-            g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-            b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-            val_color = nvgRGBA(255, g, b, 200);
-            // steering is in degrees
-            if (scene.angleSteers < 10.){
-              snprintf(val, sizeof(val), "%.1f%s", scene.angleSteers, deg);
-            }
-            else{
-              snprintf(val, sizeof(val), "%.0f%s", scene.angleSteers, deg);
-            }
-            }
-            break;
-
-          case UIMeasure::DESIRED_STEERING_ANGLE: 
-            {
-            snprintf(name, sizeof(name), "REL:DES STR.");
-            float angleSteers = scene.angleSteers > 0. ? scene.angleSteers : -scene.angleSteers;
-            g = 255;
-            b = 255;
-            p = 0.0333 * angleSteers;
-            g -= int(0.5 * p * 255.);
-            b -= int(p * 255.);
+            float d_ft = scene.lead_d_rel * 3.281;
+            snprintf(val, sizeof(val), "%.0f", d_ft);
+          }
+        } else {
+          snprintf(val, sizeof(val), "-");
+        }
+        if (s->is_metric) {
+          snprintf(unit, sizeof(unit), "m");
+        }
+        else{
+          snprintf(unit, sizeof(unit), "ft");
+        }
+      }
+      break;
+  
+    case UIMeasure::LEAD_DESIRED_DISTANCE_LENGTH:
+      {
+        snprintf(name, sizeof(name), "REL:DES DIST");
+        auto follow_d = scene.desiredFollowDistance * scene.car_state.getVEgo() + scene.stoppingDistance;
+        if (scene.lead_status) {
+          if (s->is_metric) {
+            g = 0;
+            b = 0;
+            p = 0.0333 * scene.lead_d_rel;
+            g += int((0.5+p) * 255.);
+            b += int(p * 255.);
             g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
             b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
             val_color = nvgRGBA(255, g, b, 200);
-            if (scene.controls_state.getEnabled()) {
-              // steering is in degrees
-              if (scene.angleSteers < 10. && scene.angleSteersDes < 10.){
-                snprintf(val, sizeof(val), "%.1f%s:%.1f%s", scene.angleSteers, deg, scene.angleSteersDes, deg);
-              }
-              else{
-                snprintf(val, sizeof(val), "%.0f%s:%.0f%s", scene.angleSteers, deg, scene.angleSteersDes, deg);
-              }
-              val_font_size += 12;
-            }else{
-              if (scene.angleSteers < 10.){
-                snprintf(val, sizeof(val), "%.1f%s", scene.angleSteers, deg);
-              }
-              else{
-                snprintf(val, sizeof(val), "%.0f%s", scene.angleSteers, deg);
-              }
-            }
-            }
-            break;
-
-          case UIMeasure::STEERING_ANGLE_ERROR: 
-            {
-            snprintf(name, sizeof(name), "STR. ERR.");
-            float angleSteers = scene.angleSteersErr > 0. ? scene.angleSteersErr : -scene.angleSteersErr;
-            if (scene.controls_state.getEnabled()) {
-              g = 255;
-              b = 255;
-              p = 0.2 * angleSteers;
-              g -= int(0.5 * p * 255.);
-              b -= int(p * 255.);
-              g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-              b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-              val_color = nvgRGBA(255, g, b, 200);
-              // steering is in degrees
-              if (angleSteers < 10.){
-                snprintf(val, sizeof(val), "%.1f%s", scene.angleSteersErr, deg);
-              }
-              else{
-                snprintf(val, sizeof(val), "%.0f%s", scene.angleSteersErr, deg);
-              }
-              val_font_size += 12;
-            }else{
-              snprintf(val, sizeof(val), "-");
-            }
-            }
-            break;
-
-          case UIMeasure::ENGINE_RPM: 
-            {
-              snprintf(name, sizeof(name), "ENG RPM");
-              if(scene.engineRPM == 0) {
-                snprintf(val, sizeof(val), "OFF");
-              }
-              else {
-                snprintf(val, sizeof(val), "%d", scene.engineRPM);
-              }
-            }
-            break;
-            
-          case UIMeasure::ENGINE_RPM_TEMPC: 
-            {
-              snprintf(name, sizeof(name), "ENGINE");
-              int temp = scene.car_state.getEngineCoolantTemp();
-              snprintf(unit, sizeof(unit), "%d%sC", temp, deg);
-              if(scene.engineRPM == 0 && temp < 55) {
-                snprintf(val, sizeof(val), "OFF");
-              }
-              else {
-                snprintf(val, sizeof(val), "%d", scene.engineRPM);
-                if (temp < 74){
-                  unit_color = nvgRGBA(84, 207, 249, 200); // cyan if too cool
-                }
-                else if (temp > 115){
-                  unit_color = nvgRGBA(255, 0, 0, 200); // red if too hot
-                }
-                else if (temp > 99){
-                  unit_color = nvgRGBA(255, 169, 63, 200); // orange if close to too hot
-                }
-              }
-            }
-            break;
-
-          case UIMeasure::ENGINE_RPM_TEMPF: 
-            {
-              snprintf(name, sizeof(name), "ENGINE");
-              int temp = int(float(scene.car_state.getEngineCoolantTemp()) * 1.8 + 32.5);
-              snprintf(unit, sizeof(unit), "%d%sF", temp, deg);
-              if(scene.engineRPM == 0 && temp < 130) {
-                snprintf(val, sizeof(val), "OFF");
-              }
-              else {
-                snprintf(val, sizeof(val), "%d", scene.engineRPM);
-                if (temp < 165){
-                  unit_color = nvgRGBA(84, 207, 249, 200); // cyan if too cool
-                }
-                else if (temp > 240){
-                  unit_color = nvgRGBA(255, 0, 0, 200); // red if too hot
-                }
-                else if (temp > 210){
-                  unit_color = nvgRGBA(255, 169, 63, 200); // orange if close to too hot
-                }
-              }
-            }
-            break;
-            
-          case UIMeasure::COOLANT_TEMPC: 
-            {
-              snprintf(name, sizeof(name), "COOLANT");
-              snprintf(unit, sizeof(unit), "%sC", deg);
-              int temp = scene.car_state.getEngineCoolantTemp();
-              snprintf(val, sizeof(val), "%d", temp);
-              if(scene.engineRPM > 0 || temp >= 55) {
-                if (temp < 74){
-                  val_color = nvgRGBA(84, 207, 249, 200); // cyan if too cool
-                }
-                else if (temp > 115){
-                  val_color = nvgRGBA(255, 0, 0, 200); // red if too hot
-                }
-                else if (temp > 99){
-                  val_color = nvgRGBA(255, 169, 63, 200); // orange if close to too hot
-                }
-              }
-            }
-            break;
-          
-          case UIMeasure::COOLANT_TEMPF: 
-            {
-              snprintf(name, sizeof(name), "COOLANT");
-              snprintf(unit, sizeof(unit), "%sF", deg);
-              int temp = int(float(scene.car_state.getEngineCoolantTemp()) * 1.8 + 32.5);
-              snprintf(val, sizeof(val), "%d", temp);
-              if(scene.engineRPM > 0 || temp >= 130) {
-                if (temp < 165){
-                  val_color = nvgRGBA(84, 207, 249, 200); // cyan if too cool
-                }
-                else if (temp > 240){
-                  val_color = nvgRGBA(255, 0, 0, 200); // red if too hot
-                }
-                else if (temp > 210){
-                  val_color = nvgRGBA(255, 169, 63, 200); // orange if close to too hot
-                }
-              }
-            }
-            break;
-          
-          case UIMeasure::PERCENT_GRADE:
-            {
-            auto data2 = sm["gpsLocationExternal"].getGpsLocationExternal();
-            float altitudeUblox = data2.getAltitude();
-            float gpsAccuracyUblox = data2.getAccuracy();
-            if (scene.car_state.getVEgo() > 0.0){
-              scene.percentGradeCurDist += scene.car_state.getVEgo() * (scene.lastTime - scene.percentGradeLastTime);
-              if (scene.percentGradeCurDist > scene.percentGradeLenStep){ // record position/elevation at even length intervals
-                float prevDist = scene.percentGradePositions[scene.percentGradeRollingIter];
-                scene.percentGradeRollingIter++;
-                if (scene.percentGradeRollingIter >= scene.percentGradeNumSamples){
-                  if (!scene.percentGradeIterRolled){
-                    scene.percentGradeIterRolled = true;
-                    // Calculate initial mean percent grade
-                    float u = 0.;
-                    for (int i = 0; i < scene.percentGradeNumSamples; ++i){
-                      float rise = scene.percentGradeAltitudes[i] - scene.percentGradeAltitudes[(i+1)%scene.percentGradeNumSamples];
-                      float run = scene.percentGradePositions[i] - scene.percentGradePositions[(i+1)%scene.percentGradeNumSamples];
-                      if (run != 0.){
-                        scene.percentGrades[i] = rise/run * 100.;
-                        u += scene.percentGrades[i];
-                      }
-                    }
-                    u /= float(scene.percentGradeNumSamples);
-                    scene.percentGrade = u;
-                  }
-                  scene.percentGradeRollingIter = 0;
-                }
-                scene.percentGradeAltitudes[scene.percentGradeRollingIter] = altitudeUblox;
-                scene.percentGradePositions[scene.percentGradeRollingIter] = prevDist + scene.percentGradeCurDist;
-                if (scene.percentGradeIterRolled){
-                  float rise = scene.percentGradeAltitudes[scene.percentGradeRollingIter] - scene.percentGradeAltitudes[(scene.percentGradeRollingIter+1)%scene.percentGradeNumSamples];
-                  float run = scene.percentGradePositions[scene.percentGradeRollingIter] - scene.percentGradePositions[(scene.percentGradeRollingIter+1)%scene.percentGradeNumSamples];
-                  if (run != 0.){
-                    // update rolling average
-                    float newGrade = rise/run * 100.;
-                    scene.percentGrade -= scene.percentGrades[scene.percentGradeRollingIter] / float(scene.percentGradeNumSamples);
-                    scene.percentGrade += newGrade / float(scene.percentGradeNumSamples);
-                    scene.percentGrades[scene.percentGradeRollingIter] = newGrade;
-                  }
-                }
-                scene.percentGradeCurDist = 0.;
-              }
-            }
-            scene.percentGradeLastTime = scene.lastTime;
-
-            snprintf(name, sizeof(name), "GRADE (GPS)");
-            if (scene.percentGradeIterRolled && scene.percentGradePositions[scene.percentGradeRollingIter] >= scene.percentGradeMinDist && gpsAccuracyUblox != 0.00){
-              g = 255;
-              b = 255;
-              p = 0.125 * (scene.percentGrade > 0 ? scene.percentGrade : -scene.percentGrade); // red by 8% grade
-              g -= int(0.5 * p * 255.);
-              b -= int(p * 255.);
-              g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-              b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-              val_color = nvgRGBA(255, g, b, 200);
-              snprintf(val, sizeof(val), "%.1f%%", scene.percentGrade);
-            }
-            else{
-              snprintf(val, sizeof(val), "-");
-            }}
-            break;
-          
-          case UIMeasure::PERCENT_GRADE_DEVICE:
-            {
-            scene.percentGradeDevice = tan(scene.car_state.getPitch()) * 100.;
-            snprintf(name, sizeof(name), "GRADE");
-            g = 255;
-            b = 255;
-            p = 0.125 * (scene.percentGradeDevice > 0 ? scene.percentGradeDevice : -scene.percentGradeDevice); // red by 8% grade
-            g -= int(0.5 * p * 255.);
-            b -= int(p * 255.);
+            snprintf(val, sizeof(val), "%d:%d", (int)scene.lead_d_rel, (int)follow_d);
+          }
+          else{
+            g = 0;
+            b = 0;
+            p = 0.01 * scene.lead_d_rel * 3.281;
+            g += int((0.5+p) * 255.);
+            b += int(p * 255.);
             g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
             b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
             val_color = nvgRGBA(255, g, b, 200);
-            snprintf(val, sizeof(val), "%.1f%%", scene.percentGradeDevice);
-            }
-            break;
-                    
-          case UIMeasure::ROLL_DEVICE:
-            {
-            float degroll = nvgRadToDeg(scene.device_roll);
-            snprintf(name, sizeof(name), "DEVICE ROLL");
-            val_color = nvgRGBA(255, 255, 255, 200);
-            snprintf(val, sizeof(val), "%.1f°", degroll);
-            }
-            break;
-
-          case UIMeasure::ROLL:
-            {
-            float degroll = nvgRadToDeg(scene.road_roll);
-            snprintf(name, sizeof(name), "ROAD ROLL");
-            val_color = nvgRGBA(255, 255, 255, 200);
-            snprintf(val, sizeof(val), "%.1f°", degroll);
-            }
-            break;
-
-          case UIMeasure::FOLLOW_LEVEL: 
-            {
-              std::string gap;
-              snprintf(name, sizeof(name), "GAP");
-              if (scene.dynamic_follow_active){
-                snprintf(val, sizeof(val), "%.1f", scene.dynamic_follow_level);
-              }else
-              {
-                switch (int(scene.car_state.getReaddistancelines())){
-                  case 1:
-                  gap =  "I";
-                  break;
-                
-                  case 2:
-                  gap =  "I I";
-                  break;
-                
-                  case 3:
-                  gap =  "I I I";
-                  break;
-                
-                  default:
-                  gap =  "";
-                  break;
-                }
-                snprintf(val, sizeof(val), "%s", gap.c_str());
-              }
-            }
-            break;
-            
-          case UIMeasure::HVB_VOLTAGE: 
-            {
-              snprintf(name, sizeof(name), "HVB VOLT");
-              snprintf(unit, sizeof(unit), "V");
-              float temp = scene.car_state.getHvbVoltage();
-              snprintf(val, sizeof(val), "%.0f", temp);
-              g = 255;
-              b = 255;
-              p = temp - 360.;
-              p = p > 0 ? p : -p;
-              p *= 0.01666667; // red by the time voltage deviates from nominal voltage (360) by 60V deviation from nominal
-              g -= int(0.5 * p * 255.);
-              b -= int(p * 255.);
-              g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-              b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-              val_color = nvgRGBA(255, g, b, 200);
-            }
-            break;
-          
-          case UIMeasure::HVB_CURRENT: 
-            {
-              snprintf(name, sizeof(name), "HVB CUR");
-              snprintf(unit, sizeof(unit), "A");
-              float temp = -scene.car_state.getHvbCurrent();
-              if (abs(temp) >= 100.){
-                snprintf(val, sizeof(val), "%.0f", temp);
-              }
-              else{
-                snprintf(val, sizeof(val), "%.1f", temp);
-              }
-              g = 255;
-              b = 255;
-              p = scene.car_state.getHvbVoltage() - 360.;
-              p = p > 0 ? p : -p;
-              p *= 0.01666667; // red by the time voltage deviates from nominal voltage (360) by 60V deviation from nominal
-              g -= int(0.5 * p * 255.);
-              b -= int(p * 255.);
-              g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-              b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-              val_color = nvgRGBA(255, g, b, 200);
-            }
-            break;
-
-          case UIMeasure::HVB_WATTAGE:
-            {
-            snprintf(name, sizeof(name), "HVB POW");
-            float v = -scene.car_state.getHvbWattage();
-            v /= 1e3;
-            if (v > 10){
-              snprintf(val, sizeof(val), "%.1f", v);
-            }
-            else{
-              snprintf(val, sizeof(val), "%.0f", v);
-            }
-            snprintf(unit, sizeof(unit), "kW");
-            break;}
-          
-          case UIMeasure::HVB_WATTVOLT: 
-            {
-              snprintf(name, sizeof(name), "HVB kW");
-              float temp = -scene.car_state.getHvbWattage();
-              temp /= 1e3;
-              if (abs(temp) >= 10.){
-                snprintf(val, sizeof(val), "%.0f", temp);
-              }
-              else{
-                snprintf(val, sizeof(val), "%.1f", temp);
-              }
-              temp = scene.car_state.getHvbVoltage();
-              snprintf(unit, sizeof(unit), "%.0fV", temp);
-              g = 255;
-              b = 255;
-              p = temp - 360.;
-              p = p > 0 ? p : -p;
-              p *= 0.01666667; // red by the time voltage deviates from nominal voltage (360) by 60V deviation from nominal
-              g -= int(0.5 * p * 255.);
-              b -= int(p * 255.);
-              g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
-              b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
-              val_color = nvgRGBA(255, g, b, 200);
-            }
-            break;
-
-          case UIMeasure::EV_BOTH_NOW: 
-            {
-              snprintf(name, sizeof(name), "EV NOW");
-              float temp;
-              if (scene.ev_recip_eff_wa[0] <= 0.f){
-                if (scene.car_state.getVEgo() > 0.1){
-                  temp = scene.ev_recip_eff_wa[0] * 1000.;
-                  if (abs(temp) >= 9e5){
-                    temp /= 1e6;
-                    if (abs(temp) >= 10.){
-                      snprintf(val, sizeof(val), "%.0fM", temp);
-                    }
-                    else{
-                      snprintf(val, sizeof(val), "%.1fM", temp);
-                    }
-                  }
-                  else if (abs(temp) >= 9e2){
-                    temp /= 1e3;
-                    if (abs(temp) >= 10.){
-                      snprintf(val, sizeof(val), "%.0fk", temp);
-                    }
-                    else{
-                      snprintf(val, sizeof(val), "%.1fk", temp);
-                    }
-                  }
-                  else{
-                    if (abs(temp) >= 10.){
-                      snprintf(val, sizeof(val), "%.0f", temp);
-                    }
-                    else{
-                      snprintf(val, sizeof(val), "%.1f", temp);
-                    }
-                  }
-                }
-                else {
-                  snprintf(val, sizeof(val), "--");
-                }
-                snprintf(unit, sizeof(unit), (scene.is_metric ? "Wh/km" : "Wh/mi"));
-              }
-              else{
-                temp = 1. / scene.ev_recip_eff_wa[0];
-                if (abs(temp) >= scene.ev_recip_eff_wa_max){
-                  snprintf(val, sizeof(val), (temp > 0. ? "%.0f+" : "%.0f-"), scene.ev_recip_eff_wa_max);
-                }
-                else if (abs(temp) >= 10.){
-                  snprintf(val, sizeof(val), "%.0f", temp);
-                }
-                else{
-                  snprintf(val, sizeof(val), "%.1f", temp);
-                }
-                snprintf(unit, sizeof(unit), (scene.is_metric ? "km/kWh" : "mi/kWh"));
-              }
-            }
-            break;
-
-          case UIMeasure::EV_EFF_NOW: 
-            {
-              snprintf(name, sizeof(name), "EV EFF NOW");
-              if (scene.ev_recip_eff_wa[0] == 0.f){
-                snprintf(val, sizeof(val), "--");
-              }
-              else{
-                float temp = 1. / scene.ev_recip_eff_wa[0];
-                if (abs(temp) >= scene.ev_recip_eff_wa_max){
-                  snprintf(val, sizeof(val), (temp > 0. ? "%.0f+" : "%.0f-"), scene.ev_recip_eff_wa_max);
-                }
-                else if (abs(temp) >= 10.){
-                  snprintf(val, sizeof(val), "%.0f", temp);
-                }
-                else{
-                  snprintf(val, sizeof(val), "%.1f", temp);
-                }
-              }
-              snprintf(unit, sizeof(unit), (scene.is_metric ? "km/kWh" : "mi/kWh"));
-            }
-            break;
-
-          case UIMeasure::EV_EFF_RECENT: 
-            {
-              snprintf(name, sizeof(name), (scene.is_metric ? "EV EFF 8km" : "EV EFF 5mi"));
-              if (scene.ev_recip_eff_wa[1] == 0.f){
-                snprintf(val, sizeof(val), "--");
-              }
-              else{
-                float temp = 1. / scene.ev_recip_eff_wa[1];
-                if (abs(temp) >= scene.ev_recip_eff_wa_max){
-                  snprintf(val, sizeof(val), (temp > 0. ? "%.0f+" : "%.0f-"), scene.ev_recip_eff_wa_max);
-                }
-                else if (abs(temp) >= 100.){
-                  snprintf(val, sizeof(val), "%.0f", temp);
-                }
-                else{
-                  snprintf(val, sizeof(val), "%.1f", temp);
-                }
-              }
-              snprintf(unit, sizeof(unit), (scene.is_metric ? "km/kWh" : "mi/kWh"));
-            }
-            break;
-
-          case UIMeasure::EV_EFF_TRIP: 
-            {
-              snprintf(name, sizeof(name), (scene.is_metric ? "EV EFF km/kWh" : "EV EFF mi/kWh"));
-              float temp = scene.ev_eff_total;
-              float dist = scene.ev_eff_total_dist / (scene.is_metric ? 1000. : 1609.);
-              if (abs(temp) == scene.ev_recip_eff_wa_max){
-                snprintf(val, sizeof(val), (temp > 0. ? "%.0f+" : "%.0f-"), temp);
-              }
-              else if (abs(temp) >= 100.){
-                snprintf(val, sizeof(val), "%.0f", temp);
-              }
-              else if (abs(temp) >= 10.){
-                snprintf(val, sizeof(val), "%.1f", temp);
-              }
-              else{
-                snprintf(val, sizeof(val), "%.2f", temp);
-              }
-              if (dist >= 100.){
-                snprintf(unit, sizeof(unit), "%.0f%s", dist, (scene.is_metric ? "km" : "mi"));
-              }
-              else{
-                snprintf(unit, sizeof(unit), "%.1f%s", dist, (scene.is_metric ? "km" : "mi"));
-              }
-            }
-            break;
-
-          case UIMeasure::EV_CONSUM_NOW: 
-            {
-              snprintf(name, sizeof(name), "EV CON NOW");
-              if (scene.car_state.getVEgo() > 0.1){
-                float temp = scene.ev_recip_eff_wa[0] * 1000.;
-                if (abs(temp) >= 9e5){
-                  temp /= 1e6;
-                  if (abs(temp) >= 10.){
-                    snprintf(val, sizeof(val), "%.0fM", temp);
-                  }
-                  else{
-                    snprintf(val, sizeof(val), "%.1fM", temp);
-                  }
-                }
-                else if (abs(temp) >= 9e2){
-                  temp /= 1e3;
-                  if (abs(temp) >= 10.){
-                    snprintf(val, sizeof(val), "%.0fk", temp);
-                  }
-                  else{
-                    snprintf(val, sizeof(val), "%.1fk", temp);
-                  }
-                }
-                else{
-                  if (abs(temp) >= 10.){
-                    snprintf(val, sizeof(val), "%.0f", temp);
-                  }
-                  else{
-                    snprintf(val, sizeof(val), "%.1f", temp);
-                  }
-                }
-              }
-              else{
-                snprintf(val, sizeof(val), "--");
-              }
-              snprintf(unit, sizeof(unit), (scene.is_metric ? "Wh/km" : "Wh/mi"));
-            }
-            break;
+            snprintf(val, sizeof(val), "%d:%d", (int)(scene.lead_d_rel * 3.281), (int)(follow_d * 3.281));
+          }
+        } else {
+          snprintf(val, sizeof(val), "-");
+        }
+        if (s->is_metric) {
+          snprintf(unit, sizeof(unit), "m");
+        }
+        else{
+          snprintf(unit, sizeof(unit), "ft");
+        }
+      }
+      break;
+      
+    case UIMeasure::LEAD_DISTANCE_TIME:
+      {
+      snprintf(name, sizeof(name), "REL DIST");
+      if (scene.lead_status && scene.car_state.getVEgo() > 0.5) {
+        float follow_t = scene.lead_d_rel / scene.car_state.getVEgo();
+        g = 0;
+        b = 0;
+        p = 0.6667 * follow_t;
+        g += int((0.5+p) * 255.);
+        b += int(p * 255.);
+        g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+        b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+        val_color = nvgRGBA(255, g, b, 200);
+        snprintf(val, sizeof(val), "%.1f", follow_t);
+      } else {
+        snprintf(val, sizeof(val), "-");
+      }
+      snprintf(unit, sizeof(unit), "s");}
+      break;
+    
+    case UIMeasure::LEAD_DESIRED_DISTANCE_TIME:
+      {
+      snprintf(name, sizeof(name), "REL:DES DIST");
+      if (scene.lead_status && scene.car_state.getVEgo() > 0.5) {
+        float follow_t = scene.lead_d_rel / scene.car_state.getVEgo();
+        float des_follow_t = scene.desiredFollowDistance + scene.stoppingDistance / scene.car_state.getVEgo();
+        g = 0;
+        b = 0;
+        p = 0.6667 * follow_t;
+        g += int((0.5+p) * 255.);
+        b += int(p * 255.);
+        g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+        b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+        val_color = nvgRGBA(255, g, b, 200);
+        snprintf(val, sizeof(val), "%.1f:%.1f", follow_t, des_follow_t);
+      } else {
+        snprintf(val, sizeof(val), "-");
+      }
+      snprintf(unit, sizeof(unit), "s");}
+      break;
+    
+    case UIMeasure::LEAD_COSTS:
+      {
+        snprintf(name, sizeof(name), "D:A COST");
+        if (scene.lead_status && scene.car_state.getVEgo() > 0.5) {
+          snprintf(val, sizeof(val), "%.1f:%.1f", scene.followDistanceCost, scene.followAccelCost);
+        } else {
+          snprintf(val, sizeof(val), "-");
+        }
+      }
+      break;
+
+    case UIMeasure::LEAD_VELOCITY_RELATIVE:
+      {
+      snprintf(name, sizeof(name), "REL SPEED");
+      if (scene.lead_status) {
+        g = 255; 
+        b = 255;
+        p = -0.2 * (scene.lead_v_rel);
+        g -= int(0.5 * p * 255.);
+        b -= int(p * 255.);
+        g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+        b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+        val_color = nvgRGBA(255, g, b, 200);
+        // lead car relative speed is always in meters
+        if (s->is_metric) {
+          snprintf(val, sizeof(val), "%.1f", (scene.lead_v_rel * 3.6));
+        } else {
+          snprintf(val, sizeof(val), "%.1f", (scene.lead_v_rel * 2.2374144));
+        }
+      } else {
+        snprintf(val, sizeof(val), "-");
+      }
+      if (s->is_metric) {
+        snprintf(unit, sizeof(unit), "km/h");;
+      } else {
+        snprintf(unit, sizeof(unit), "mph");
+      }}
+      break;
+    
+    case UIMeasure::LEAD_VELOCITY_ABS: 
+      {
+      snprintf(name, sizeof(name), "LEAD SPD");
+      if (scene.lead_status) {
+        if (s->is_metric) {
+          float v = (scene.lead_v * 3.6);
+          if (v < 100.){
+            snprintf(val, sizeof(val), "%.1f", v);
+          }
+          else{
+            snprintf(val, sizeof(val), "%.0f", v);
+          }
+        } else {
+          float v = (scene.lead_v * 2.2374144);
+          if (v < 100.){
+            snprintf(val, sizeof(val), "%.1f", v);
+          }
+          else{
+            snprintf(val, sizeof(val), "%.0f", v);
+          }
+        }
+      } else {
+        snprintf(val, sizeof(val), "-");
+      }
+      if (s->is_metric) {
+        snprintf(unit, sizeof(unit), "km/h");;
+      } else {
+        snprintf(unit, sizeof(unit), "mph");
+      }}
+      break;
+
+    case UIMeasure::STEERING_ANGLE: 
+      {
+      snprintf(name, sizeof(name), "REAL STEER");
+      float angleSteers = scene.angleSteers > 0. ? scene.angleSteers : -scene.angleSteers;
+      g = 255;
+      b = 255;
+      p = 0.0333 * angleSteers;
+      g -= int(0.5 * p * 255.);
+      b -= int(p * 255.);
+      g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+      b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+      val_color = nvgRGBA(255, g, b, 200);
+      // steering is in degrees
+      if (scene.angleSteers < 10.){
+        snprintf(val, sizeof(val), "%.1f%s", scene.angleSteers, deg);
+      }
+      else{
+        snprintf(val, sizeof(val), "%.0f%s", scene.angleSteers, deg);
+      }
+      }
+      break;
+
+    case UIMeasure::DESIRED_STEERING_ANGLE: 
+      {
+      snprintf(name, sizeof(name), "REL:DES STR.");
+      float angleSteers = scene.angleSteers > 0. ? scene.angleSteers : -scene.angleSteers;
+      g = 255;
+      b = 255;
+      p = 0.0333 * angleSteers;
+      g -= int(0.5 * p * 255.);
+      b -= int(p * 255.);
+      g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+      b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+      val_color = nvgRGBA(255, g, b, 200);
+      if (scene.controls_state.getEnabled()) {
+        // steering is in degrees
+        if (scene.angleSteers < 10. && scene.angleSteersDes < 10.){
+          snprintf(val, sizeof(val), "%.1f%s:%.1f%s", scene.angleSteers, deg, scene.angleSteersDes, deg);
+        }
+        else{
+          snprintf(val, sizeof(val), "%.0f%s:%.0f%s", scene.angleSteers, deg, scene.angleSteersDes, deg);
+        }
+        val_font_size += 12;
+      }else{
+        if (scene.angleSteers < 10.){
+          snprintf(val, sizeof(val), "%.1f%s", scene.angleSteers, deg);
+        }
+        else{
+          snprintf(val, sizeof(val), "%.0f%s", scene.angleSteers, deg);
+        }
+      }
+      }
+      break;
+
+    case UIMeasure::STEERING_ANGLE_ERROR: 
+      {
+      snprintf(name, sizeof(name), "STR. ERR.");
+      float angleSteers = scene.angleSteersErr > 0. ? scene.angleSteersErr : -scene.angleSteersErr;
+      if (scene.controls_state.getEnabled()) {
+        g = 255;
+        b = 255;
+        p = 0.2 * angleSteers;
+        g -= int(0.5 * p * 255.);
+        b -= int(p * 255.);
+        g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+        b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+        val_color = nvgRGBA(255, g, b, 200);
+        // steering is in degrees
+        if (angleSteers < 10.){
+          snprintf(val, sizeof(val), "%.1f%s", scene.angleSteersErr, deg);
+        }
+        else{
+          snprintf(val, sizeof(val), "%.0f%s", scene.angleSteersErr, deg);
+        }
+        val_font_size += 12;
+      }else{
+        snprintf(val, sizeof(val), "-");
+      }
+      }
+      break;
 
-          case UIMeasure::EV_CONSUM_RECENT: 
-            {
-              snprintf(name, sizeof(name), (scene.is_metric ? "EV CON 8km" : "EV CON 5mi"));
-              float temp = scene.ev_recip_eff_wa[1] * 1000.;
-              if (abs(temp) >= 9e5){
-                temp /= 1e6;
-                if (abs(temp) >= 10.){
-                  snprintf(val, sizeof(val), "%.0fM", temp);
-                }
-                else{
-                  snprintf(val, sizeof(val), "%.1fM", temp);
-                }
-              }
-              else if (abs(temp) >= 9e2){
-                temp /= 1e3;
-                if (abs(temp) >= 10.){
-                  snprintf(val, sizeof(val), "%.0fk", temp);
-                }
-                else{
-                  snprintf(val, sizeof(val), "%.1fk", temp);
-                }
-              }
-              else{
-                if (abs(temp) >= 10.){
-                  snprintf(val, sizeof(val), "%.0f", temp);
-                }
-                else{
-                  snprintf(val, sizeof(val), "%.1f", temp);
+    case UIMeasure::ENGINE_RPM: 
+      {
+        snprintf(name, sizeof(name), "ENG RPM");
+        if(scene.engineRPM == 0) {
+          snprintf(val, sizeof(val), "OFF");
+        }
+        else {
+          snprintf(val, sizeof(val), "%d", scene.engineRPM);
+        }
+      }
+      break;
+      
+    case UIMeasure::ENGINE_RPM_TEMPC: 
+      {
+        snprintf(name, sizeof(name), "ENGINE");
+        int temp = scene.car_state.getEngineCoolantTemp();
+        snprintf(unit, sizeof(unit), "%d%sC", temp, deg);
+        if(scene.engineRPM == 0 && temp < 55) {
+          snprintf(val, sizeof(val), "OFF");
+        }
+        else {
+          snprintf(val, sizeof(val), "%d", scene.engineRPM);
+          if (temp < 74){
+            unit_color = nvgRGBA(84, 207, 249, 200); // cyan if too cool
+          }
+          else if (temp > 115){
+            unit_color = nvgRGBA(255, 0, 0, 200); // red if too hot
+          }
+          else if (temp > 99){
+            unit_color = nvgRGBA(255, 169, 63, 200); // orange if close to too hot
+          }
+        }
+      }
+      break;
+
+    case UIMeasure::ENGINE_RPM_TEMPF: 
+      {
+        snprintf(name, sizeof(name), "ENGINE");
+        int temp = int(float(scene.car_state.getEngineCoolantTemp()) * 1.8 + 32.5);
+        snprintf(unit, sizeof(unit), "%d%sF", temp, deg);
+        if(scene.engineRPM == 0 && temp < 130) {
+          snprintf(val, sizeof(val), "OFF");
+        }
+        else {
+          snprintf(val, sizeof(val), "%d", scene.engineRPM);
+          if (temp < 165){
+            unit_color = nvgRGBA(84, 207, 249, 200); // cyan if too cool
+          }
+          else if (temp > 240){
+            unit_color = nvgRGBA(255, 0, 0, 200); // red if too hot
+          }
+          else if (temp > 210){
+            unit_color = nvgRGBA(255, 169, 63, 200); // orange if close to too hot
+          }
+        }
+      }
+      break;
+      
+    case UIMeasure::COOLANT_TEMPC: 
+      {
+        snprintf(name, sizeof(name), "COOLANT");
+        snprintf(unit, sizeof(unit), "%sC", deg);
+        int temp = scene.car_state.getEngineCoolantTemp();
+        snprintf(val, sizeof(val), "%d", temp);
+        if(scene.engineRPM > 0 || temp >= 55) {
+          if (temp < 74){
+            val_color = nvgRGBA(84, 207, 249, 200); // cyan if too cool
+          }
+          else if (temp > 115){
+            val_color = nvgRGBA(255, 0, 0, 200); // red if too hot
+          }
+          else if (temp > 99){
+            val_color = nvgRGBA(255, 169, 63, 200); // orange if close to too hot
+          }
+        }
+      }
+      break;
+    
+    case UIMeasure::COOLANT_TEMPF: 
+      {
+        snprintf(name, sizeof(name), "COOLANT");
+        snprintf(unit, sizeof(unit), "%sF", deg);
+        int temp = int(float(scene.car_state.getEngineCoolantTemp()) * 1.8 + 32.5);
+        snprintf(val, sizeof(val), "%d", temp);
+        if(scene.engineRPM > 0 || temp >= 130) {
+          if (temp < 165){
+            val_color = nvgRGBA(84, 207, 249, 200); // cyan if too cool
+          }
+          else if (temp > 240){
+            val_color = nvgRGBA(255, 0, 0, 200); // red if too hot
+          }
+          else if (temp > 210){
+            val_color = nvgRGBA(255, 169, 63, 200); // orange if close to too hot
+          }
+        }
+      }
+      break;
+    
+    case UIMeasure::PERCENT_GRADE:
+      {
+      auto data2 = sm["gpsLocationExternal"].getGpsLocationExternal();
+      float altitudeUblox = data2.getAltitude();
+      float gpsAccuracyUblox = data2.getAccuracy();
+      if (scene.car_state.getVEgo() > 0.0){
+        scene.percentGradeCurDist += scene.car_state.getVEgo() * (scene.lastTime - scene.percentGradeLastTime);
+        if (scene.percentGradeCurDist > scene.percentGradeLenStep){ // record position/elevation at even length intervals
+          float prevDist = scene.percentGradePositions[scene.percentGradeRollingIter];
+          scene.percentGradeRollingIter++;
+          if (scene.percentGradeRollingIter >= scene.percentGradeNumSamples){
+            if (!scene.percentGradeIterRolled){
+              scene.percentGradeIterRolled = true;
+              // Calculate initial mean percent grade
+              float u = 0.;
+              for (int i = 0; i < scene.percentGradeNumSamples; ++i){
+                float rise = scene.percentGradeAltitudes[i] - scene.percentGradeAltitudes[(i+1)%scene.percentGradeNumSamples];
+                float run = scene.percentGradePositions[i] - scene.percentGradePositions[(i+1)%scene.percentGradeNumSamples];
+                if (run != 0.){
+                  scene.percentGrades[i] = rise/run * 100.;
+                  u += scene.percentGrades[i];
                 }
               }
-              snprintf(unit, sizeof(unit), (scene.is_metric ? "Wh/km" : "Wh/mi"));
+              u /= float(scene.percentGradeNumSamples);
+              scene.percentGrade = u;
             }
-            break;
-
-          case UIMeasure::EV_CONSUM_TRIP: 
-            {
-              snprintf(name, sizeof(name), (scene.is_metric ? "EV CON Wh/km" : "EV CON Wh/mi"));
-              float dist = scene.ev_eff_total_dist / (scene.is_metric ? 1000. : 1609.);
-              if (scene.ev_eff_total == 0.f){
-                snprintf(val, sizeof(val), "--");
-              }
-              else{
-                float temp = 1000./scene.ev_eff_total;
-                if (abs(temp) >= 9e2){
-                  temp /= 1e3;
-                  if (abs(temp) >= 100.){
-                    snprintf(val, sizeof(val), "%.0fk", temp);
-                  }
-                  else if (abs(temp) >= 10.){
-                    snprintf(val, sizeof(val), "%.1fk", temp);
-                  }
-                  else{
-                    snprintf(val, sizeof(val), "%.2fk", temp);
-                  }
-                }
-                else{
-                  if (abs(temp) >= 100.){
-                    snprintf(val, sizeof(val), "%.0f", temp);
-                  }
-                  else if (abs(temp) >= 10.){
-                    snprintf(val, sizeof(val), "%.1f", temp);
-                  }
-                  else{
-                    snprintf(val, sizeof(val), "%.2f", temp);
-                  }
-                }
-              }
-              if (dist >= 100.){
-                snprintf(unit, sizeof(unit), "%.0f%s", dist, (scene.is_metric ? "km" : "mi"));
-              }
-              else{
-                snprintf(unit, sizeof(unit), "%.1f%s", dist, (scene.is_metric ? "km" : "mi"));
-              }
+            scene.percentGradeRollingIter = 0;
+          }
+          scene.percentGradeAltitudes[scene.percentGradeRollingIter] = altitudeUblox;
+          scene.percentGradePositions[scene.percentGradeRollingIter] = prevDist + scene.percentGradeCurDist;
+          if (scene.percentGradeIterRolled){
+            float rise = scene.percentGradeAltitudes[scene.percentGradeRollingIter] - scene.percentGradeAltitudes[(scene.percentGradeRollingIter+1)%scene.percentGradeNumSamples];
+            float run = scene.percentGradePositions[scene.percentGradeRollingIter] - scene.percentGradePositions[(scene.percentGradeRollingIter+1)%scene.percentGradeNumSamples];
+            if (run != 0.){
+              // update rolling average
+              float newGrade = rise/run * 100.;
+              scene.percentGrade -= scene.percentGrades[scene.percentGradeRollingIter] / float(scene.percentGradeNumSamples);
+              scene.percentGrade += newGrade / float(scene.percentGradeNumSamples);
+              scene.percentGrades[scene.percentGradeRollingIter] = newGrade;
             }
+          }
+          scene.percentGradeCurDist = 0.;
+        }
+      }
+      scene.percentGradeLastTime = scene.lastTime;
+
+      snprintf(name, sizeof(name), "GRADE (GPS)");
+      if (scene.percentGradeIterRolled && scene.percentGradePositions[scene.percentGradeRollingIter] >= scene.percentGradeMinDist && gpsAccuracyUblox != 0.00){
+        g = 255;
+        b = 255;
+        p = 0.125 * (scene.percentGrade > 0 ? scene.percentGrade : -scene.percentGrade); // red by 8% grade
+        g -= int(0.5 * p * 255.);
+        b -= int(p * 255.);
+        g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+        b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+        val_color = nvgRGBA(255, g, b, 200);
+        snprintf(val, sizeof(val), "%.1f%%", scene.percentGrade);
+      }
+      else{
+        snprintf(val, sizeof(val), "-");
+      }}
+      break;
+    
+    case UIMeasure::PERCENT_GRADE_DEVICE:
+      {
+      scene.percentGradeDevice = tan(scene.car_state.getPitch()) * 100.;
+      snprintf(name, sizeof(name), "GRADE");
+      g = 255;
+      b = 255;
+      p = 0.125 * (scene.percentGradeDevice > 0 ? scene.percentGradeDevice : -scene.percentGradeDevice); // red by 8% grade
+      g -= int(0.5 * p * 255.);
+      b -= int(p * 255.);
+      g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+      b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+      val_color = nvgRGBA(255, g, b, 200);
+      snprintf(val, sizeof(val), "%.1f%%", scene.percentGradeDevice);
+      }
+      break;
+              
+    case UIMeasure::ROLL_DEVICE:
+      {
+      float degroll = nvgRadToDeg(scene.device_roll);
+      snprintf(name, sizeof(name), "DEVICE ROLL");
+      val_color = nvgRGBA(255, 255, 255, 200);
+      snprintf(val, sizeof(val), "%.1f°", degroll);
+      }
+      break;
+
+    case UIMeasure::ROLL:
+      {
+      float degroll = nvgRadToDeg(scene.road_roll);
+      snprintf(name, sizeof(name), "ROAD ROLL");
+      val_color = nvgRGBA(255, 255, 255, 200);
+      snprintf(val, sizeof(val), "%.1f°", degroll);
+      }
+      break;
+
+    case UIMeasure::FOLLOW_LEVEL: 
+      {
+        std::string gap;
+        snprintf(name, sizeof(name), "GAP");
+        if (scene.dynamic_follow_active){
+          snprintf(val, sizeof(val), "%.1f", scene.dynamic_follow_level);
+        }else
+        {
+          switch (int(scene.car_state.getReaddistancelines())){
+            case 1:
+            gap =  "I";
             break;
           
-          case UIMeasure::EV_OBSERVED_DRIVETRAIN_EFF: 
-            {
-              snprintf(name, sizeof(name), "EV DRV EFF");
-              float temp = scene.car_state.getObservedEVDrivetrainEfficiency();
-              snprintf(val, sizeof(val), "%.2f", temp);
-            }
+            case 2:
+            gap =  "I I";
             break;
-            
-          case UIMeasure::LANE_WIDTH: 
-            {
-              snprintf(name, sizeof(name), "LANE W");
-              if (s->is_metric){
-                snprintf(unit, sizeof(unit), "m");
-                snprintf(val, sizeof(val), "%.1f", scene.lateralPlan.laneWidth);
+          
+            case 3:
+            gap =  "I I I";
+            break;
+          
+            default:
+            gap =  "";
+            break;
+          }
+          snprintf(val, sizeof(val), "%s", gap.c_str());
+        }
+      }
+      break;
+      
+    case UIMeasure::HVB_VOLTAGE: 
+      {
+        snprintf(name, sizeof(name), "HVB VOLT");
+        snprintf(unit, sizeof(unit), "V");
+        float temp = scene.car_state.getHvbVoltage();
+        snprintf(val, sizeof(val), "%.0f", temp);
+        g = 255;
+        b = 255;
+        p = temp - 360.;
+        p = p > 0 ? p : -p;
+        p *= 0.01666667; // red by the time voltage deviates from nominal voltage (360) by 60V deviation from nominal
+        g -= int(0.5 * p * 255.);
+        b -= int(p * 255.);
+        g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+        b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+        val_color = nvgRGBA(255, g, b, 200);
+      }
+      break;
+    
+    case UIMeasure::HVB_CURRENT: 
+      {
+        snprintf(name, sizeof(name), "HVB CUR");
+        snprintf(unit, sizeof(unit), "A");
+        float temp = -scene.car_state.getHvbCurrent();
+        if (abs(temp) >= 100.){
+          snprintf(val, sizeof(val), "%.0f", temp);
+        }
+        else{
+          snprintf(val, sizeof(val), "%.1f", temp);
+        }
+        g = 255;
+        b = 255;
+        p = scene.car_state.getHvbVoltage() - 360.;
+        p = p > 0 ? p : -p;
+        p *= 0.01666667; // red by the time voltage deviates from nominal voltage (360) by 60V deviation from nominal
+        g -= int(0.5 * p * 255.);
+        b -= int(p * 255.);
+        g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+        b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+        val_color = nvgRGBA(255, g, b, 200);
+      }
+      break;
+
+    case UIMeasure::HVB_WATTAGE:
+      {
+      snprintf(name, sizeof(name), "HVB POW");
+      float v = -scene.car_state.getHvbWattage();
+      v /= 1e3;
+      if (v > 10){
+        snprintf(val, sizeof(val), "%.1f", v);
+      }
+      else{
+        snprintf(val, sizeof(val), "%.0f", v);
+      }
+      snprintf(unit, sizeof(unit), "kW");
+      break;}
+    
+    case UIMeasure::HVB_WATTVOLT: 
+      {
+        snprintf(name, sizeof(name), "HVB kW");
+        float temp = -scene.car_state.getHvbWattage();
+        temp /= 1e3;
+        if (abs(temp) >= 10.){
+          snprintf(val, sizeof(val), "%.0f", temp);
+        }
+        else{
+          snprintf(val, sizeof(val), "%.1f", temp);
+        }
+        temp = scene.car_state.getHvbVoltage();
+        snprintf(unit, sizeof(unit), "%.0fV", temp);
+        g = 255;
+        b = 255;
+        p = temp - 360.;
+        p = p > 0 ? p : -p;
+        p *= 0.01666667; // red by the time voltage deviates from nominal voltage (360) by 60V deviation from nominal
+        g -= int(0.5 * p * 255.);
+        b -= int(p * 255.);
+        g = (g >= 0 ? (g <= 255 ? g : 255) : 0);
+        b = (b >= 0 ? (b <= 255 ? b : 255) : 0);
+        val_color = nvgRGBA(255, g, b, 200);
+      }
+      break;
+
+    case UIMeasure::EV_BOTH_NOW: 
+      {
+        snprintf(name, sizeof(name), "EV NOW");
+        float temp;
+        if (scene.ev_recip_eff_wa[0] <= 0.f){
+          if (scene.car_state.getVEgo() > 0.1){
+            temp = scene.ev_recip_eff_wa[0] * 1000.;
+            if (abs(temp) >= 9e5){
+              temp /= 1e6;
+              if (abs(temp) >= 10.){
+                snprintf(val, sizeof(val), "%.0fM", temp);
               }
               else{
-                snprintf(unit, sizeof(unit), "ft");
-                snprintf(val, sizeof(val), "%.1f", scene.lateralPlan.laneWidth * 3.281);
+                snprintf(val, sizeof(val), "%.1fM", temp);
               }
             }
-            break;
-
-          case UIMeasure::LANE_DIST_FROM_CENTER: 
-            {
-              snprintf(name, sizeof(name), "LANE CENTER");
-              if (s->is_metric){
-                snprintf(unit, sizeof(unit), "m");
-                snprintf(val, sizeof(val), "%.1f", scene.lateralPlan.laneCenter);
+            else if (abs(temp) >= 9e2){
+              temp /= 1e3;
+              if (abs(temp) >= 10.){
+                snprintf(val, sizeof(val), "%.0fk", temp);
               }
               else{
-                snprintf(unit, sizeof(unit), "ft");
-                snprintf(val, sizeof(val), "%.1f", scene.lateralPlan.laneCenter * 3.281);
+                snprintf(val, sizeof(val), "%.1fk", temp);
               }
             }
-            break;
-
-          case UIMeasure::DISTANCE_TRAVELLED: 
-            {
-              snprintf(name, sizeof(name), "TRIP DIST.");
-              float temp = scene.ev_eff_total_dist / (scene.is_metric ? 1000. : 1609.);
-              if (abs(temp) >= 100.){
+            else{
+              if (abs(temp) >= 10.){
                 snprintf(val, sizeof(val), "%.0f", temp);
               }
-              else if (abs(temp) >= 10.){
-                snprintf(val, sizeof(val), "%.1f", temp);
-              }
               else{
-                snprintf(val, sizeof(val), "%.2f", temp);
+                snprintf(val, sizeof(val), "%.1f", temp);
               }
-              snprintf(unit, sizeof(unit), (scene.is_metric ? "km" : "mi"));
-            }
-            break;
-            
-          case UIMeasure::DEVICE_BATTERY: 
-            {
-              snprintf(name, sizeof(name), "DEVICE BATT.");
-              snprintf(unit, sizeof(unit), "%.1f A", float(scene.deviceState.getBatteryCurrent()) * 1e-6);
-              snprintf(val, sizeof(val), "%d", scene.deviceState.getBatteryPercent());
-            }
-            break;
-
-          case UIMeasure::VISION_VF: 
-            {
-              snprintf(name, sizeof(name), "V: VF");
-              snprintf(val, sizeof(val), "%.2f", (float)scene.longitudinal_plan.getVisionVf());
             }
-            break;
+          }
+          else {
+            snprintf(val, sizeof(val), "--");
+          }
+          snprintf(unit, sizeof(unit), (scene.is_metric ? "Wh/km" : "Wh/mi"));
+        }
+        else{
+          temp = 1. / scene.ev_recip_eff_wa[0];
+          if (abs(temp) >= scene.ev_recip_eff_wa_max){
+            snprintf(val, sizeof(val), (temp > 0. ? "%.0f+" : "%.0f-"), scene.ev_recip_eff_wa_max);
+          }
+          else if (abs(temp) >= 10.){
+            snprintf(val, sizeof(val), "%.0f", temp);
+          }
+          else{
+            snprintf(val, sizeof(val), "%.1f", temp);
+          }
+          snprintf(unit, sizeof(unit), (scene.is_metric ? "km/kWh" : "mi/kWh"));
+        }
+      }
+      break;
 
-          default: {// invalid number
-            snprintf(name, sizeof(name), "INVALID");
-            snprintf(val, sizeof(val), "42");}
-            break;
+    case UIMeasure::EV_EFF_NOW: 
+      {
+        snprintf(name, sizeof(name), "EV EFF NOW");
+        if (scene.ev_recip_eff_wa[0] == 0.f){
+          snprintf(val, sizeof(val), "--");
+        }
+        else{
+          float temp = 1. / scene.ev_recip_eff_wa[0];
+          if (abs(temp) >= scene.ev_recip_eff_wa_max){
+            snprintf(val, sizeof(val), (temp > 0. ? "%.0f+" : "%.0f-"), scene.ev_recip_eff_wa_max);
+          }
+          else if (abs(temp) >= 10.){
+            snprintf(val, sizeof(val), "%.0f", temp);
+          }
+          else{
+            snprintf(val, sizeof(val), "%.1f", temp);
+          }
         }
+        snprintf(unit, sizeof(unit), (scene.is_metric ? "km/kWh" : "mi/kWh"));
+      }
+      break;
 
-        nvgTextAlign(s->vg, NVG_ALIGN_CENTER | NVG_ALIGN_BASELINE);
-        // now print the metric
-        // first value
-        
-        int vallen = strlen(val);
-        if (vallen > 4){
-          val_font_size -= (vallen - 4) * 8;
+    case UIMeasure::EV_EFF_RECENT: 
+      {
+        snprintf(name, sizeof(name), (scene.is_metric ? "EV EFF 8km" : "EV EFF 5mi"));
+        if (scene.ev_recip_eff_wa[1] == 0.f){
+          snprintf(val, sizeof(val), "--");
+        }
+        else{
+          float temp = 1. / scene.ev_recip_eff_wa[1];
+          if (abs(temp) >= scene.ev_recip_eff_wa_max){
+            snprintf(val, sizeof(val), (temp > 0. ? "%.0f+" : "%.0f-"), scene.ev_recip_eff_wa_max);
+          }
+          else if (abs(temp) >= 100.){
+            snprintf(val, sizeof(val), "%.0f", temp);
+          }
+          else{
+            snprintf(val, sizeof(val), "%.1f", temp);
+          }
         }
-        int unitlen = strlen(unit);
-        if (unitlen > 5){
-          unit_font_size -= (unitlen - 5) * 5;
+        snprintf(unit, sizeof(unit), (scene.is_metric ? "km/kWh" : "mi/kWh"));
+      }
+      break;
+
+    case UIMeasure::EV_EFF_TRIP: 
+      {
+        snprintf(name, sizeof(name), (scene.is_metric ? "EV EFF km/kWh" : "EV EFF mi/kWh"));
+        float temp = scene.ev_eff_total;
+        float dist = scene.ev_eff_total_dist / (scene.is_metric ? 1000. : 1609.);
+        if (abs(temp) == scene.ev_recip_eff_wa_max){
+          snprintf(val, sizeof(val), (temp > 0. ? "%.0f+" : "%.0f-"), temp);
         }
-        int slot_x = scene.measure_slots_rect.x + (scene.measure_cur_num_slots <= scene.measure_max_rows ? 0 : (i < scene.measure_max_rows ? slots_r * 2 : 0));
-        int x = slot_x + slots_r - unit_font_size / 2;
-        if (i >= scene.measure_max_rows){
-          x = slot_x + slots_r + unit_font_size / 2;
+        else if (abs(temp) >= 100.){
+          snprintf(val, sizeof(val), "%.0f", temp);
         }
-        int slot_y = scene.measure_slots_rect.y + (i % scene.measure_num_rows) * slot_y_rng;
-        int slot_y_mid = slot_y + slot_y_rng / 2;
-        int y = slot_y_mid + slot_y_rng / 2 - 8 - label_font_size;
-        if (strlen(name) == 0){
-          y += label_font_size / 2;
+        else if (abs(temp) >= 10.){
+          snprintf(val, sizeof(val), "%.1f", temp);
         }
-        if (strlen(unit) == 0){
-          x = slot_x + slots_r;
+        else{
+          snprintf(val, sizeof(val), "%.2f", temp);
         }
-        nvgFontFace(s->vg, "sans-semibold");
-        nvgFontSize(s->vg, val_font_size);
-        nvgFillColor(s->vg, val_color);
-        nvgText(s->vg, x, y, val, NULL);
-      
-        // now label
-        y = slot_y_mid + slot_y_rng / 2 - 9;
-        nvgFontFace(s->vg, "sans-regular");
-        nvgFontSize(s->vg, label_font_size);
-        nvgFillColor(s->vg, label_color);
-        nvgText(s->vg, x, y, name, NULL);
-      
-        // now unit
-        if (strlen(unit) > 0){
-          nvgSave(s->vg);
-          int rx = slot_x + slots_r * 2;
-          if (i >= 5){
-            rx = slot_x;
-            nvgTranslate(s->vg, rx + 13, slot_y_mid);
-            nvgRotate(s->vg, 1.5708); //-90deg in radians
+        if (dist >= 100.){
+          snprintf(unit, sizeof(unit), "%.0f%s", dist, (scene.is_metric ? "km" : "mi"));
+        }
+        else{
+          snprintf(unit, sizeof(unit), "%.1f%s", dist, (scene.is_metric ? "km" : "mi"));
+        }
+      }
+      break;
+
+    case UIMeasure::EV_CONSUM_NOW: 
+      {
+        snprintf(name, sizeof(name), "EV CON NOW");
+        if (scene.car_state.getVEgo() > 0.1){
+          float temp = scene.ev_recip_eff_wa[0] * 1000.;
+          if (abs(temp) >= 9e5){
+            temp /= 1e6;
+            if (abs(temp) >= 10.){
+              snprintf(val, sizeof(val), "%.0fM", temp);
+            }
+            else{
+              snprintf(val, sizeof(val), "%.1fM", temp);
+            }
+          }
+          else if (abs(temp) >= 9e2){
+            temp /= 1e3;
+            if (abs(temp) >= 10.){
+              snprintf(val, sizeof(val), "%.0fk", temp);
+            }
+            else{
+              snprintf(val, sizeof(val), "%.1fk", temp);
+            }
+          }
+          else{
+            if (abs(temp) >= 10.){
+              snprintf(val, sizeof(val), "%.0f", temp);
+            }
+            else{
+              snprintf(val, sizeof(val), "%.1f", temp);
+            }
+          }
+        }
+        else{
+          snprintf(val, sizeof(val), "--");
+        }
+        snprintf(unit, sizeof(unit), (scene.is_metric ? "Wh/km" : "Wh/mi"));
+      }
+      break;
+
+    case UIMeasure::EV_CONSUM_RECENT: 
+      {
+        snprintf(name, sizeof(name), (scene.is_metric ? "EV CON 8km" : "EV CON 5mi"));
+        float temp = scene.ev_recip_eff_wa[1] * 1000.;
+        if (abs(temp) >= 9e5){
+          temp /= 1e6;
+          if (abs(temp) >= 10.){
+            snprintf(val, sizeof(val), "%.0fM", temp);
+          }
+          else{
+            snprintf(val, sizeof(val), "%.1fM", temp);
+          }
+        }
+        else if (abs(temp) >= 9e2){
+          temp /= 1e3;
+          if (abs(temp) >= 10.){
+            snprintf(val, sizeof(val), "%.0fk", temp);
+          }
+          else{
+            snprintf(val, sizeof(val), "%.1fk", temp);
+          }
+        }
+        else{
+          if (abs(temp) >= 10.){
+            snprintf(val, sizeof(val), "%.0f", temp);
+          }
+          else{
+            snprintf(val, sizeof(val), "%.1f", temp);
+          }
+        }
+        snprintf(unit, sizeof(unit), (scene.is_metric ? "Wh/km" : "Wh/mi"));
+      }
+      break;
+
+    case UIMeasure::EV_CONSUM_TRIP: 
+      {
+        snprintf(name, sizeof(name), (scene.is_metric ? "EV CON Wh/km" : "EV CON Wh/mi"));
+        float dist = scene.ev_eff_total_dist / (scene.is_metric ? 1000. : 1609.);
+        if (scene.ev_eff_total == 0.f){
+          snprintf(val, sizeof(val), "--");
+        }
+        else{
+          float temp = 1000./scene.ev_eff_total;
+          if (abs(temp) >= 9e2){
+            temp /= 1e3;
+            if (abs(temp) >= 100.){
+              snprintf(val, sizeof(val), "%.0fk", temp);
+            }
+            else if (abs(temp) >= 10.){
+              snprintf(val, sizeof(val), "%.1fk", temp);
+            }
+            else{
+              snprintf(val, sizeof(val), "%.2fk", temp);
+            }
           }
           else{
-            nvgTranslate(s->vg, rx - 13, slot_y_mid);
-            nvgRotate(s->vg, -1.5708); //-90deg in radians
+            if (abs(temp) >= 100.){
+              snprintf(val, sizeof(val), "%.0f", temp);
+            }
+            else if (abs(temp) >= 10.){
+              snprintf(val, sizeof(val), "%.1f", temp);
+            }
+            else{
+              snprintf(val, sizeof(val), "%.2f", temp);
+            }
           }
-          nvgFontFace(s->vg, "sans-regular");
-          nvgFontSize(s->vg, unit_font_size);
-          nvgFillColor(s->vg, unit_color);
-          nvgText(s->vg, 0, 0, unit, NULL);
-          nvgRestore(s->vg);
         }
+        if (dist >= 100.){
+          snprintf(unit, sizeof(unit), "%.0f%s", dist, (scene.is_metric ? "km" : "mi"));
+        }
+        else{
+          snprintf(unit, sizeof(unit), "%.1f%s", dist, (scene.is_metric ? "km" : "mi"));
+        }
+      }
+      break;
+    
+    case UIMeasure::EV_OBSERVED_DRIVETRAIN_EFF: 
+      {
+        snprintf(name, sizeof(name), "EV DRV EFF");
+        float temp = scene.car_state.getObservedEVDrivetrainEfficiency();
+        snprintf(val, sizeof(val), "%.2f", temp);
+      }
+      break;
+      
+    case UIMeasure::LANE_WIDTH: 
+      {
+        snprintf(name, sizeof(name), "LANE W");
+        if (s->is_metric){
+          snprintf(unit, sizeof(unit), "m");
+          snprintf(val, sizeof(val), "%.1f", scene.lateralPlan.laneWidth);
+        }
+        else{
+          snprintf(unit, sizeof(unit), "ft");
+          snprintf(val, sizeof(val), "%.1f", scene.lateralPlan.laneWidth * 3.281);
+        }
+      }
+      break;
+
+    case UIMeasure::LANE_DIST_FROM_CENTER: 
+      {
+        snprintf(name, sizeof(name), "LANE CENTER");
+        if (s->is_metric){
+          snprintf(unit, sizeof(unit), "m");
+          snprintf(val, sizeof(val), "%.1f", scene.lateralPlan.laneCenter);
+        }
+        else{
+          snprintf(unit, sizeof(unit), "ft");
+          snprintf(val, sizeof(val), "%.1f", scene.lateralPlan.laneCenter * 3.281);
+        }
+      }
+      break;
+
+    case UIMeasure::DISTANCE_TRAVELLED: 
+      {
+        snprintf(name, sizeof(name), "TRIP DIST.");
+        float temp = scene.ev_eff_total_dist / (scene.is_metric ? 1000. : 1609.);
+        if (abs(temp) >= 100.){
+          snprintf(val, sizeof(val), "%.0f", temp);
+        }
+        else if (abs(temp) >= 10.){
+          snprintf(val, sizeof(val), "%.1f", temp);
+        }
+        else{
+          snprintf(val, sizeof(val), "%.2f", temp);
+        }
+        snprintf(unit, sizeof(unit), (scene.is_metric ? "km" : "mi"));
+      }
+      break;
       
-        // update touch rect
-        scene.measure_slot_touch_rects[i] = {slot_x, slot_y, slots_r * 2, slot_y_rng};
+    case UIMeasure::DEVICE_BATTERY: 
+      {
+        snprintf(name, sizeof(name), "DEVICE BATT.");
+        snprintf(unit, sizeof(unit), "%.1f A", float(scene.deviceState.getBatteryCurrent()) * 1e-6);
+        snprintf(val, sizeof(val), "%d", scene.deviceState.getBatteryPercent());
+      }
+      break;
+
+    case UIMeasure::VISION_VF: 
+      {
+        snprintf(name, sizeof(name), "V: VF");
+        snprintf(val, sizeof(val), "%.2f", (float)scene.longitudinal_plan.getVisionVf());
+      }
+      break;
+
+    default: {// invalid number
+      snprintf(name, sizeof(name), "INVALID");
+      snprintf(val, sizeof(val), "42");}
+      break;
+  }
+}
+
+static void draw_measure_slot(UIState *s, int i, const measure_text &t, const Rect &slot){
+  const int slots_r = slot.w / 2;
+  const int slot_y_rng = slot.h;
+  const int slot_x = slot.x;
+  const int slot_y = slot.y;
+  int val_font_size = t.val_font_size;
+  int unit_font_size = t.unit_font_size;
+
+  nvgTextAlign(s->vg, NVG_ALIGN_CENTER | NVG_ALIGN_BASELINE);
+  // now print the metric
+  // first value
+  
+  int vallen = strlen(t.val);
+  if (vallen > 4){
+    val_font_size -= (vallen - 4) * 8;
+  }
+  int unitlen = strlen(t.unit);
+  if (unitlen > 5){
+    unit_font_size -= (unitlen - 5) * 5;
+  }
+  int x = slot_x + slots_r - unit_font_size / 2;
+  if (i >= s->scene.measure_max_rows){
+    x = slot_x + slots_r + unit_font_size / 2;
+  }
+  int slot_y_mid = slot_y + slot_y_rng / 2;
+  int y = slot_y_mid + slot_y_rng / 2 - 8 - t.label_font_size;
+  if (strlen(t.name) == 0){
+    y += t.label_font_size / 2;
+  }
+  if (unitlen == 0){
+    x = slot_x + slots_r;
+  }
+  nvgFontFace(s->vg, "sans-semibold");
+  nvgFontSize(s->vg, val_font_size);
+  nvgFillColor(s->vg, t.val_color);
+  nvgText(s->vg, x, y, t.val, NULL);
+
+  // now label
+  y = slot_y_mid + slot_y_rng / 2 - 9;
+  nvgFontFace(s->vg, "sans-regular");
+  nvgFontSize(s->vg, t.label_font_size);
+  nvgFillColor(s->vg, t.label_color);
+  nvgText(s->vg, x, y, t.name, NULL);
+
+  // now unit
+  if (unitlen > 0){
+    nvgSave(s->vg);
+    int rx = slot_x + slots_r * 2;
+    if (i >= 5){
+      rx = slot_x;
+      nvgTranslate(s->vg, rx + 13, slot_y_mid);
+      nvgRotate(s->vg, 1.5708); //-90deg in radians
+    }
+    else{
+      nvgTranslate(s->vg, rx - 13, slot_y_mid);
+      nvgRotate(s->vg, -1.5708); //-90deg in radians
+    }
+    nvgFontFace(s->vg, "sans-regular");
+    nvgFontSize(s->vg, unit_font_size);
+    nvgFillColor(s->vg, t.unit_color);
+    nvgText(s->vg, 0, 0, t.unit, NULL);
+    nvgRestore(s->vg);
+  }
+}
+
+// renders the slot into its framebuffer if what it shows changed. Must be called outside of an nvg frame.
+static void update_measure_slot(UIState *s, int i, const measure_text &t, const Rect &slot){
+  measure_slot_cache &c = measure_cache[i];
+  const bool right_col = i >= s->scene.measure_max_rows;
+  if (c.fb && c.right_col == right_col && memcmp(&c.rect, &slot, sizeof(slot)) == 0 && memcmp(&c.text, &t, sizeof(t)) == 0){
+    return;
+  }
+
+  const int w = slot.w + 2 * measure_pad, h = slot.h + 2 * measure_pad;
+  if (!c.fb || c.fb_w != w || c.fb_h != h){
+    if (c.fb){
+      nvgluDeleteFramebuffer(c.fb);
+    }
+    c.fb = nvgluCreateFramebuffer(s->vg, w, h, 0);
+    c.fb_w = w;
+    c.fb_h = h;
+  }
+  c.rect = slot;
+  c.right_col = right_col;
+  c.text = t;
+  if (!c.fb){
+    // drawn directly in the main frame instead
+    LOGE_100("failed to create measure slot framebuffer");
+    return;
+  }
+
+  GLint prev_fbo;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prev_fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, c.fb->fbo);
+  glViewport(0, 0, w, h);
+  glClearColor(0, 0, 0, 0);
+  glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+  nvgBeginFrame(s->vg, w, h, 1.0f);
+  nvgTranslate(s->vg, measure_pad - slot.x, measure_pad - slot.y);
+  draw_measure_slot(s, i, t, slot);
+  nvgEndFrame(s->vg);
+  glBindFramebuffer(GL_FRAMEBUFFER, prev_fbo);
+}
+
+// lays out the panel, computes every slot and refreshes the stale slot images
+static void ui_update_measures(UIState *s){
+  if (!measures_visible(s)){
+    return;
+  }
+
+  UIScene &scene = s->scene;
+  const Rect maxspeed_rect = {bdr_s * 2, int(bdr_s * 1.5), 184, 202};
+  int center_x = s->fb_w - face_wheel_radius - bdr_s * 2;
+  center_x -= s->scene.power_meter_rect.w + s->fb_w / 256;
+  const int brake_y = s->fb_h - footer_h / 2;
+  const int y_min = maxspeed_rect.bottom() + bdr_s / 2;
+  const int y_max = brake_y - brake_size - bdr_s / 2;
+  const int y_rng = y_max - y_min;
+  int slot_y_rng;
+  if (scene.measure_num_rows > 4 || scene.map_open){
+    slot_y_rng = y_rng / scene.measure_max_rows;
+  }
+  else{
+    slot_y_rng = y_rng / (scene.measure_num_rows < 3 ? 3 : scene.measure_num_rows);
+  }
+  const int slot_y_rng_orig = y_rng / scene.measure_max_rows; // two columns
+  const float slot_aspect_ratio_ratio = float(slot_y_rng) / float(slot_y_rng_orig);
+  const int y_mid = (y_max + y_min) / 2;
+  const int slots_y_rng = slot_y_rng * (scene.measure_num_rows <= scene.measure_max_rows ? scene.measure_num_rows : scene.measure_max_rows);
+  const int slots_y_min = y_mid - (slots_y_rng / 2);
+
+  NVGcolor default_name_color = COLOR_WHITE_ALPHA(200);
+  NVGcolor default_unit_color = COLOR_WHITE_ALPHA(200);
+  NVGcolor default_val_color = COLOR_WHITE_ALPHA(200);
+  int default_val_font_size = 78. * slot_aspect_ratio_ratio;
+  int default_name_font_size = 32. * (slot_y_rng_orig > 1. ? 0.9 * slot_aspect_ratio_ratio : 1.);
+  int default_unit_font_size = 38. * slot_aspect_ratio_ratio;
+
+  // determine bounding rectangle
+  int slots_r, slots_w, slots_x;
+
+  const int slots_r_orig = brake_size + 6 + (s->scene.measure_cur_num_slots <= 5 ? 6 : 0);
+  slots_r = brake_size * slot_aspect_ratio_ratio + 6 + (scene.measure_cur_num_slots <= scene.measure_max_rows ? 6 : 0);
+  center_x -= slots_r - slots_r_orig;
+  slots_w = (scene.measure_cur_num_slots <= scene.measure_max_rows ? 2 : 4) * slots_r;
+  slots_x = (scene.measure_cur_num_slots <= scene.measure_max_rows ? center_x - slots_r : center_x - 3 * slots_r);
+
+  scene.measure_slots_rect = {slots_x, slots_y_min, slots_w, slots_y_rng};
+
+  measure_text defaults = {};
+  defaults.val_color = default_val_color;
+  defaults.label_color = default_name_color;
+  defaults.unit_color = default_unit_color;
+  defaults.val_font_size = default_val_font_size;
+  defaults.label_font_size = default_name_font_size;
+  defaults.unit_font_size = default_unit_font_size;
+
+  // now start from the top and compute the current set of metrics
+  for (int ii = 0; ii < scene.measure_cur_num_slots; ++ii){
+    try{
+      int i = ii;
+      if (scene.measure_cur_num_slots > scene.measure_max_rows && i >= scene.measure_num_rows){
+        i += scene.measure_row_offset;
       }
-      catch(...){}
+
+      measure_text t = defaults;
+      measure_slot_text(s, scene.measure_slots[i], t);
+
+      int slot_x = scene.measure_slots_rect.x + (scene.measure_cur_num_slots <= scene.measure_max_rows ? 0 : (i < scene.measure_max_rows ? slots_r * 2 : 0));
+      int slot_y = scene.measure_slots_rect.y + (i % scene.measure_num_rows) * slot_y_rng;
+      scene.measure_slot_touch_rects[i] = {slot_x, slot_y, slots_r * 2, slot_y_rng};
+      update_measure_slot(s, i, t, scene.measure_slot_touch_rects[i]);
+    }
+    catch(...){}
+  }
+}
+
+static void ui_draw_measures(UIState *s){
+  UIScene &scene = s->scene;
+  if (!scene.measure_cur_num_slots){
+    return;
+  }
+  // draw bounding rectangle
+  nvgBeginPath(s->vg);
+  nvgRoundedRect(s->vg, scene.measure_slots_rect.x, scene.measure_slots_rect.y, scene.measure_slots_rect.w, scene.measure_slots_rect.h, 20);
+  if (QUIState::ui_state.scene.lastTime - QUIState::ui_state.scene.measures_last_tap_t > QUIState::ui_state.scene.measures_touch_timeout){
+    nvgStrokeColor(s->vg, COLOR_WHITE_ALPHA(160));
+  }
+  else{
+    nvgStrokeColor(s->vg, COLOR_GRACE_BLUE_ALPHA(200));
+  }
+  nvgStrokeWidth(s->vg, 6);
+  nvgStroke(s->vg);
+  nvgFillColor(s->vg, COLOR_BLACK_ALPHA(100));
+  nvgFill(s->vg);
+
+  for (int ii = 0; ii < scene.measure_cur_num_slots; ++ii){
+    int i = ii;
+    if (scene.measure_cur_num_slots > scene.measure_max_rows && i >= scene.measure_num_rows){
+      i += scene.measure_row_offset;
+    }
+    const measure_slot_cache &c = measure_cache[i];
+    if (!c.fb){
+      draw_measure_slot(s, i, c.text, c.rect);
+      continue;
     }
+    const float x = c.rect.x - measure_pad, y = c.rect.y - measure_pad;
+    nvgBeginPath(s->vg);
+    nvgRect(s->vg, x, y, c.fb_w, c.fb_h);
+    nvgFillPaint(s->vg, nvgImagePattern(s->vg, x, y, c.fb_w, c.fb_h, 0, c.fb->image, 1.0f));
+    nvgFill(s->vg);
   }
 }
 
@@ -2920,24 +3036,49 @@ static void ui_draw_vision_face(UIState *s) {
   ui_draw_circle_image(s, center_x, center_y, radius, "driver_face", s->scene.dm_active);
 }
 
-static void ui_draw_vision_power_meter(UIState *s) {
-  Rect & outer_rect = s->scene.power_meter_rect;
-  if (s->scene.brake_indicator_enabled && s->scene.power_meter_mode < 2){
+static int power_meter_alert_offset(const UIState *s) {
+  const auto alert_size = (*s->sm)["controlsState"].getControlsState().getAlertSize();
+  return alert_size == cereal::ControlsState::AlertSize::SMALL ? s->fb_h * 7 / 32
+         : alert_size == cereal::ControlsState::AlertSize::MID ? s->fb_h * 6 / 16 : 0;
+}
+
+// lays out the power meter, or the brake indicator in its place, before anything is drawn,
+// so the measures placed next to it use this frame's rect
+static void update_power_meter_rect(UIState *s) {
+  const auto alert_size = (*s->sm)["controlsState"].getControlsState().getAlertSize();
+  if (alert_size != cereal::ControlsState::AlertSize::NONE
+      && alert_size != cereal::ControlsState::AlertSize::SMALL
+      && alert_size != cereal::ControlsState::AlertSize::MID) {
+    return;
+  }
+
+  if (s->scene.power_meter_mode >= 2){
+    s->scene.power_meter_rect = {s->fb_w * 125 / 128, 1, 1, 1};
+  }
+  else if (s->scene.brake_indicator_enabled){
     const int w = s->fb_w * 3 / 128;
     const int x = s->fb_w * 121 / 128 - 6;
-    int alert_offset = (*s->sm)["controlsState"].getControlsState().getAlertSize() == cereal::ControlsState::AlertSize::SMALL
-                    ? s->fb_h * 7 / 32
-                     : (*s->sm)["controlsState"].getControlsState().getAlertSize() == cereal::ControlsState::AlertSize::MID
-                     ? s->fb_h * 6 / 16 : 0;
+    const int alert_offset = power_meter_alert_offset(s);
     int h = (s->scene.power_meter_mode == 0 || alert_offset ? 22 : 21) * s->fb_h / 32 - 6;
     h -= alert_offset;
-    const int hu = h / 2;
-    const int hl = h - hu;
     int y = (s->scene.power_meter_mode == 0 || alert_offset ? 30 : 29) * s->fb_h / 32;
     y -= alert_offset;
+    s->scene.power_meter_rect = {x, y-h, 2 * w, h};
+    s->scene.brake_touch_rect = s->scene.power_meter_rect;
+  }
+}
+
+static void ui_draw_vision_power_meter(UIState *s) {
+  const Rect & outer_rect = s->scene.power_meter_rect;
+  if (s->scene.brake_indicator_enabled && s->scene.power_meter_mode < 2){
+    const int w = outer_rect.w / 2;
+    const int x = outer_rect.x;
+    const int alert_offset = power_meter_alert_offset(s);
+    const int h = outer_rect.h;
+    const int hu = h / 2;
+    const int hl = h - hu;
+    const int y = outer_rect.bottom();
     const int y_mid = y - hl;
-    outer_rect = {x, y-h, 2 * w, h};
-    s->scene.brake_touch_rect = outer_rect;
     const int y_offset = 2;
 
     int ipow = 0;
@@ -3574,7 +3715,6 @@ static void ui_draw_vision(UIState *s) {
     }
     else{
       ui_draw_vision_brake(s);
-      s->scene.power_meter_rect = {s->fb_w * 125 / 128, 1, 1, 1};
     }
     if (!s->scene.map_open || (*s->sm)["controlsState"].getControlsState().getAlertSize() == cereal::ControlsState::AlertSize::NONE){
       ui_draw_measures(s);
@@ -3587,7 +3727,6 @@ static void ui_draw_vision(UIState *s) {
     }
     else{
       ui_draw_vision_brake(s);
-      s->scene.power_meter_rect = {s->fb_w * 125 / 128, 1, 1, 1};
     }
   }
   if (s->scene.lane_pos_enabled){
@@ -3607,6 +3746,12 @@ static void ui_draw_vision(UIState *s) {
 void ui_draw(UIState *s, int w, int h) {
   const bool draw_vision = s->scene.started && s->vipc_client->connected;
 
+  // renders into the measure slot framebuffers, so it goes before the main nvg frame
+  if (draw_vision) {
+    update_power_meter_rect(s);
+    ui_update_measures(s);
+  }
+
   glViewport(0, 0, s->fb_w, s->fb_h);
   if (draw_vision) {
     draw_vision_frame(s);
@@ -3769,7 +3914,20 @@ void ui_nvg_init(UIState *s) {
   ui_resize(s, s->fb_w, s->fb_h);
 }
 
+void ui_free_measure_slots() {
+  for (auto &c : measure_cache) {
+    if (c.fb) {
+      nvgluDeleteFramebuffer(c.fb);
+    }
+    c = {};
+  }
+}
+
 void ui_resize(UIState *s, int width, int height) {
+  // the slot images are sized for the old layout, they're rendered again on the next frame
+  if (width != s->fb_w || height != s->fb_h) {
+    ui_free_measure_slots();
+  }
   s->fb_w = width;
   s->fb_h = height;
 
@@ -9,3 +9,5 @@ void ui_fill_rect(NVGcontext *vg, const Rect &r, const NVGpaint &paint, float ra
 void ui_fill_rect(NVGcontext *vg, const Rect &r, const NVGcolor &color, float radius = 0);
 void ui_nvg_init(UIState *s);
 void ui_resize(UIState *s, int width, int height);
+// frees the measure slot framebuffers, needs the GL context current
+void ui_free_measure_slots();
@@ -1,5 +1,10 @@
 #include "selfdrive/ui/qt/api.h"
 
+#include <sys/stat.h>
+
+#include <mutex>
+#include <thread>
+
 #include <openssl/bio.h>
 #include <openssl/pem.h>
 #include <openssl/rsa.h>
@@ -7,7 +12,6 @@
 #include <QCryptographicHash>
 #include <QDateTime>
 #include <QDebug>
-#include <QFile>
 #include <QJsonDocument>
 #include <QNetworkRequest>
 
@@ -19,34 +23,123 @@
 namespace CommaApi {
 
 QByteArray rsa_sign(const QByteArray &data) {
-  auto file = QFile(Path::rsa_file().c_str());
-  if (!file.open(QIODevice::ReadOnly)) {
-    qDebug() << "No RSA private key found, please run manager.py or registration.py";
-    return QByteArray();
+  return TokenManager::instance().sign(data);
+}
+
+QString create_jwt(const QJsonObject &payloads, int expiry) {
+  return TokenManager::instance().createJwt(payloads, expiry);
+}
+
+// inode and mtime of a file, tells when it's replaced or rewritten without reading it
+struct FileStamp {
+  ino_t ino = 0;
+  struct timespec mtime = {};
+
+  bool operator==(const FileStamp &other) const {
+    return ino == other.ino && mtime.tv_sec == other.mtime.tv_sec && mtime.tv_nsec == other.mtime.tv_nsec;
+  }
+  bool operator!=(const FileStamp &other) const { return !(*this == other); }
+};
+
+static FileStamp file_stamp(const std::string &path) {
+  struct stat st = {};
+  FileStamp stamp;
+  if (stat(path.c_str(), &st) == 0) {
+    stamp.ino = st.st_ino;
+#ifdef __APPLE__
+    stamp.mtime = st.st_mtimespec;
+#else
+    stamp.mtime = st.st_mtim;
+#endif
+  }
+  return stamp;
+}
+
+struct TokenManager::Private {
+  const std::string key_path, auth_path;
+  const std::string dongle_id_path = Params().getParamPath("DongleId");
+
+  // guards the key and the dongle id, both only checked when signing
+  std::mutex key_lock;
+  RSA *rsa = nullptr;
+  FileStamp key_stamp;
+  QString dongle_id;
+  FileStamp dongle_id_stamp;
+
+  std::mutex token_lock;
+  QString device_token;
+  qint64 device_token_iat = 0;
+  bool refreshing = false;
+  std::thread refresher;
+
+  FileStamp auth_stamp;
+  QString account_token;
+};
+
+TokenManager::TokenManager(const std::string &key_path, const std::string &auth_path)
+    : d(new Private{key_path, auth_path}) {}
+
+TokenManager::~TokenManager() {
+  if (d->refresher.joinable()) {
+    d->refresher.join();
   }
-  auto key = file.readAll();
-  file.close();
-  file.deleteLater();
-  BIO* mem = BIO_new_mem_buf(key.data(), key.size());
-  assert(mem);
-  RSA* rsa_private = PEM_read_bio_RSAPrivateKey(mem, NULL, NULL, NULL);
-  assert(rsa_private);
+  RSA_free(d->rsa);
+}
+
+TokenManager &TokenManager::instance() {
+  static TokenManager manager(Path::rsa_file(), Path::HOME + "/.comma/auth.json");
+  return manager;
+}
+
+QByteArray TokenManager::sign(const QByteArray &data) {
+  std::lock_guard lk(d->key_lock);
+  // registration may write a new key
+  const FileStamp stamp = file_stamp(d->key_path);
+  if (d->rsa && stamp != d->key_stamp) {
+    RSA_free(d->rsa);
+    d->rsa = nullptr;
+  }
+  if (!d->rsa) {
+    // a missing key isn't remembered, registration creates it
+    std::string key = util::read_file(d->key_path);
+    if (key.empty()) {
+      qDebug() << "No RSA private key found, please run manager.py or registration.py";
+      return QByteArray();
+    }
+    BIO* mem = BIO_new_mem_buf(key.data(), key.size());
+    assert(mem);
+    d->rsa = PEM_read_bio_RSAPrivateKey(mem, NULL, NULL, NULL);
+    assert(d->rsa);
+    BIO_free(mem);
+    d->key_stamp = stamp;
+  }
+
   auto sig = QByteArray();
-  sig.resize(RSA_size(rsa_private));
+  sig.resize(RSA_size(d->rsa));
   unsigned int sig_len;
-  int ret = RSA_sign(NID_sha256, (unsigned char*)data.data(), data.size(), (unsigned char*)sig.data(), &sig_len, rsa_private);
+  int ret = RSA_sign(NID_sha256, (unsigned char*)data.data(), data.size(), (unsigned char*)sig.data(), &sig_len, d->rsa);
   assert(ret == 1);
   assert(sig_len == sig.size());
-  BIO_free(mem);
-  RSA_free(rsa_private);
   return sig;
 }
 
-QString create_jwt(const QJsonObject &payloads, int expiry) {
+QString TokenManager::identity() {
+  std::lock_guard lk(d->key_lock);
+  // registration writes the param, a missing one is read again every time
+  const FileStamp stamp = file_stamp(d->dongle_id_path);
+  if (stamp == FileStamp{} || stamp != d->dongle_id_stamp) {
+    d->dongle_id = getDongleId().value_or("");
+    d->dongle_id_stamp = stamp;
+  }
+  return d->dongle_id;
+}
+
+QString TokenManager::signJwt(const QJsonObject &payloads, int expiry, qint64 &iat, bool &cacheable) {
   QJsonObject header = {{"alg", "RS256"}};
 
   auto t = QDateTime::currentSecsSinceEpoch();
-  QJsonObject payload = {{"identity", getDongleId().value_or("")}, {"nbf", t}, {"iat", t}, {"exp", t + expiry}};
+  const QString identity = this->identity();
+  QJsonObject payload = {{"identity", identity}, {"nbf", t}, {"iat", t}, {"exp", t + expiry}};
   for (auto it = payloads.begin(); it != payloads.end(); ++it) {
     payload.insert(it.key(), it.value());
   }
@@ -56,11 +149,79 @@ QString create_jwt(const QJsonObject &payloads, int expiry) {
                 QJsonDocument(payload).toJson(QJsonDocument::Compact).toBase64(b64_opts);
 
   auto hash = QCryptographicHash::hash(jwt.toUtf8(), QCryptographicHash::Sha256);
-  auto sig = rsa_sign(hash);
+  auto sig = sign(hash);
   jwt += '.' + sig.toBase64(b64_opts);
+
+  iat = t;
+  // until the device is registered the token changes as soon as it has a dongle id
+  cacheable = !identity.isEmpty() && !sig.isEmpty();
   return jwt;
 }
 
+QString TokenManager::createJwt(const QJsonObject &payloads, int expiry) {
+  qint64 iat;
+  bool cacheable;
+  return signJwt(payloads, expiry, iat, cacheable);
+}
+
+QString TokenManager::deviceToken() {
+  // nothing is read here, the key and the dongle id are checked when the token is signed
+  const qint64 t = QDateTime::currentSecsSinceEpoch();
+  std::lock_guard lk(d->token_lock);
+  // the clock can also jump back before iat, e.g. when it's first synced
+  const qint64 age = t - d->device_token_iat;
+  if (d->device_token.isEmpty() || age < -60 || age >= TOKEN_EXPIRY - 60) {
+    d->device_token.clear();
+    qint64 iat;
+    bool cacheable;
+    QString token = signJwt({}, TOKEN_EXPIRY, iat, cacheable);
+    if (cacheable) {
+      d->device_token = token;
+      d->device_token_iat = iat;
+    }
+    return token;
+  }
+
+  if (age >= TOKEN_EXPIRY - REFRESH_MARGIN && !d->refreshing) {
+    d->refreshing = true;
+    // the previous refresh already finished
+    if (d->refresher.joinable()) {
+      d->refresher.join();
+    }
+    d->refresher = std::thread(&TokenManager::refreshDeviceToken, this);
+  }
+  return d->device_token;
+}
+
+void TokenManager::refreshDeviceToken() {
+  qint64 iat;
+  bool cacheable;
+  QString token = signJwt({}, TOKEN_EXPIRY, iat, cacheable);
+
+  std::lock_guard lk(d->token_lock);
+  if (cacheable) {
+    d->device_token = token;
+    d->device_token_iat = iat;
+  }
+  d->refreshing = false;
+}
+
+void TokenManager::clearDeviceToken() {
+  std::lock_guard lk(d->token_lock);
+  d->device_token.clear();
+}
+
+QString TokenManager::accountToken() {
+  const FileStamp stamp = file_stamp(d->auth_path);
+  std::lock_guard lk(d->token_lock);
+  if (stamp != d->auth_stamp) {
+    d->auth_stamp = stamp;
+    QJsonDocument json_d = QJsonDocument::fromJson(QByteArray::fromStdString(util::read_file(d->auth_path)));
+    d->account_token = json_d["access_token"].toString();
+  }
+  return d->account_token;
+}
+
 }  // namespace CommaApi
 
 HttpRequest::HttpRequest(QObject *parent, bool create_jwt, int timeout) : create_jwt(create_jwt), QObject(parent) {
@@ -81,14 +242,8 @@ void HttpRequest::sendRequest(const QString &requestURL, const HttpRequest::Meth
     qDebug() << "HttpRequest is active";
     return;
   }
-  QString token;
-  if(create_jwt) {
-    token = CommaApi::create_jwt();
-  } else {
-    QString token_json = QString::fromStdString(util::read_file(util::getenv("HOME") + "/.comma/auth.json"));
-    QJsonDocument json_d = QJsonDocument::fromJson(token_json.toUtf8());
-    token = json_d["access_token"].toString();
-  }
+  auto &tokens = CommaApi::TokenManager::instance();
+  QString token = create_jwt ? tokens.deviceToken() : tokens.accountToken();
 
   QNetworkRequest request;
   request.setUrl(QUrl(requestURL));
@@ -115,6 +270,10 @@ void HttpRequest::requestFinished() {
     networkTimer->stop();
     QString response = reply->readAll();
 
+    if (create_jwt && reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 401) {
+      // signed with a key or dongle id that was replaced since
+      CommaApi::TokenManager::instance().clearDeviceToken();
+    }
     if (reply->error() == QNetworkReply::NoError) {
       success = true;
       emit receivedResponse(response);
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <string>
+
 #include <QJsonObject>
 #include <QNetworkReply>
 #include <QString>
@@ -13,6 +16,38 @@ const QString BASE_URL = util::getenv("API_HOST", "https://api.commadotai.com").
 QByteArray rsa_sign(const QByteArray &data);
 QString create_jwt(const QJsonObject &payloads = {}, int expiry = 3600);
 
+// Holds the private key once it's been read, and the tokens requests are sent with.
+// The device token is reused until it's close to expiring, then requests keep using it
+// while a new one is signed in the background. The key, the dongle id and auth.json are
+// only read again when they change. A new key or dongle id is picked up by the next
+// refresh, or right away when the api rejects the cached token.
+class TokenManager {
+public:
+  TokenManager(const std::string &key_path, const std::string &auth_path);
+  ~TokenManager();
+  static TokenManager &instance();
+
+  QByteArray sign(const QByteArray &data);
+  QString createJwt(const QJsonObject &payloads = {}, int expiry = 3600);
+  QString deviceToken();
+  // signs a new device token on the next request
+  void clearDeviceToken();
+  // access token of the account logged in through setup
+  QString accountToken();
+
+  static constexpr int TOKEN_EXPIRY = 3600;  // s
+  static constexpr int REFRESH_MARGIN = 600;  // s
+
+private:
+  QString identity();
+  QString signJwt(const QJsonObject &payloads, int expiry, qint64 &iat, bool &cacheable);
+  void refreshDeviceToken();
+
+  // the key, the cached tokens and the refresh thread
+  struct Private;
+  std::unique_ptr<Private> d;
+};
+
 }  // namespace CommaApi
 
 /**
@@ -5,7 +5,6 @@
 #include <QMouseEvent>
 #include <QVBoxLayout>
 
-#include "selfdrive/common/params.h"
 #include "selfdrive/ui/qt/util.h"
 #include "selfdrive/ui/qt/widgets/drive_stats.h"
 #include "selfdrive/ui/qt/widgets/prime.h"
@@ -67,7 +66,8 @@ void HomeWindow::showDriverView(bool show) {
 }
 
 void HomeWindow::mousePressEvent(QMouseEvent* e) {
-  Params().putBool("ScreenTapped", true);
+  UIParams &params = *QUIState::ui_state.params;
+  params.putBool(UIParam::ScreenTapped, true);
   // Toggle speed limit control enabled
   Rect touch_rect = QUIState::ui_state.scene.speed_limit_sign_touch_rect;
   SubMaster &sm = *(QUIState::ui_state.sm);
@@ -76,7 +76,7 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
     // If touching the speed limit sign area when visible
     QUIState::ui_state.scene.last_speed_limit_sign_tap = seconds_since_boot();
     QUIState::ui_state.scene.speed_limit_control_enabled = !QUIState::ui_state.scene.speed_limit_control_enabled;
-    Params().putBool("SpeedLimitControl", QUIState::ui_state.scene.speed_limit_control_enabled);
+    params.putBool(UIParam::SpeedLimitControl, QUIState::ui_state.scene.speed_limit_control_enabled);
 		return;
   }
 
@@ -85,7 +85,7 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
     QUIState::ui_state.scene.adjacent_lead_info_touch_rect.ptInRect(e->x(), e->y())) {
     // If touching the speed limit sign area when visible
     QUIState::ui_state.scene.adjacent_lead_info_print_at_lead = !QUIState::ui_state.scene.adjacent_lead_info_print_at_lead;
-    Params().putBool("PrintAdjacentLeadSpeedsAtLead", QUIState::ui_state.scene.adjacent_lead_info_print_at_lead);
+    params.putBool(UIParam::PrintAdjacentLeadSpeedsAtLead, QUIState::ui_state.scene.adjacent_lead_info_print_at_lead);
 		return;
   }
   
@@ -96,13 +96,7 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
     if (QUIState::ui_state.scene.laneless_mode > 2) {
       QUIState::ui_state.scene.laneless_mode = 0;
     }
-    if (QUIState::ui_state.scene.laneless_mode == 0) {
-      Params().put("LanelessMode", "0", 1);
-    } else if (QUIState::ui_state.scene.laneless_mode == 1) {
-      Params().put("LanelessMode", "1", 1);
-    } else if (QUIState::ui_state.scene.laneless_mode == 2) {
-      Params().put("LanelessMode", "2", 1);
-    }
+    params.putInt(UIParam::LanelessMode, QUIState::ui_state.scene.laneless_mode);
     return;
   }
   
@@ -114,8 +108,6 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
     }
     if (QUIState::ui_state.scene.lastTime - QUIState::ui_state.scene.measures_last_tap_t < QUIState::ui_state.scene.measures_touch_timeout && QUIState::ui_state.scene.started && QUIState::ui_state.scene.measure_slot_touch_rects[i].ptInRect(e->x(), e->y())){
       // user pressed one of the measure boxes. Need to increment the data shown.
-      char slotName[16];
-      snprintf(slotName, sizeof(slotName), "MeasureSlot%.2d", i);
       int slot_val = (QUIState::ui_state.scene.measure_slots[i] + 1) % QUIState::ui_state.scene.num_measures;
       if (!QUIState::ui_state.scene.car_is_ev){
         bool metric_is_dup = false;
@@ -144,9 +136,7 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
         }
       }
       QUIState::ui_state.scene.measure_slots[i] = slot_val;
-      char val_str[6];
-      sprintf(val_str, "%1d", slot_val);
-      Params().put(slotName, val_str, strlen(val_str));
+      params.putInt(UIParams::measureSlot(i), slot_val);
       QUIState::ui_state.scene.measures_last_tap_t = QUIState::ui_state.scene.lastTime;
       return;
     }
@@ -164,9 +154,7 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
         QUIState::ui_state.scene.measure_num_rows /= 2;
       }
       QUIState::ui_state.scene.measure_row_offset = QUIState::ui_state.scene.measure_max_rows - QUIState::ui_state.scene.measure_num_rows;
-      char val_str[6];
-      sprintf(val_str, "%1d", QUIState::ui_state.scene.measure_config_num);
-      Params().put("MeasureConfigNum", val_str, strlen(val_str));
+      params.putInt(UIParam::MeasureConfigNum, QUIState::ui_state.scene.measure_config_num);
     }
     QUIState::ui_state.scene.measures_last_tap_t = QUIState::ui_state.scene.lastTime;
     return;
@@ -176,21 +164,21 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
   if (QUIState::ui_state.scene.started 
     && QUIState::ui_state.scene.wheel_touch_rect.ptInRect(e->x(), e->y()))
   {
-    bool vision_enabled = Params().getBool("TurnVisionControl");
-    bool map_enabled = Params().getBool("TurnSpeedControl");
+    bool vision_enabled = params.getBool(UIParam::TurnVisionControl);
+    bool map_enabled = params.getBool(UIParam::TurnSpeedControl);
     if (vision_enabled && map_enabled){
-      Params().putBool("TurnVisionControl", false);
-      Params().putBool("TurnSpeedControl", false);
+      params.putBool(UIParam::TurnVisionControl, false);
+      params.putBool(UIParam::TurnSpeedControl, false);
     }
     else if (!vision_enabled && !map_enabled){
-      Params().putBool("TurnVisionControl", true);
+      params.putBool(UIParam::TurnVisionControl, true);
     }
     else if (vision_enabled && !map_enabled){
-      Params().putBool("TurnSpeedControl", true);
+      params.putBool(UIParam::TurnSpeedControl, true);
     }
     else {
-      Params().putBool("TurnVisionControl", true);
-      Params().putBool("TurnSpeedControl", true);
+      params.putBool(UIParam::TurnVisionControl, true);
+      params.putBool(UIParam::TurnSpeedControl, true);
     }
     return;
   }
@@ -200,7 +188,7 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
     && QUIState::ui_state.scene.maxspeed_touch_rect.ptInRect(e->x(), e->y())
     && QUIState::ui_state.scene.one_pedal_fade <= 0.)
   {
-    Params().putBool("Coasting", !Params().getBool("Coasting"));
+    params.putBool(UIParam::Coasting, !params.getBool(UIParam::Coasting));
     return;
   }
   
@@ -209,43 +197,43 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
     && QUIState::ui_state.scene.one_pedal_touch_rect.ptInRect(e->x(), e->y())
     && QUIState::ui_state.scene.one_pedal_fade > 0.)
   {
-    Params().putBool("OnePedalModeEngageOnGas", !Params().getBool("OnePedalModeEngageOnGas"));
+    params.putBool(UIParam::OnePedalModeEngageOnGas, !params.getBool(UIParam::OnePedalModeEngageOnGas));
     return;
   }
   
   // accel_mode button
   if (QUIState::ui_state.scene.started && QUIState::ui_state.scene.accel_mode_touch_rect.ptInRect(e->x(), e->y())){
-    Params().put("AccelMode", std::to_string((std::stoi(Params().get("AccelMode")) + 1) % 3).c_str(), 1);
+    params.putInt(UIParam::AccelMode, (params.getInt(UIParam::AccelMode) + 1) % 3);
     return;
   }
   
   // dynamic_follow_mode button
   if (QUIState::ui_state.scene.started && QUIState::ui_state.scene.dynamic_follow_mode_touch_rect.ptInRect(e->x(), e->y())){
-    Params().putBool("DynamicFollow", !Params().getBool("DynamicFollow"));
+    params.putBool(UIParam::DynamicFollow, !params.getBool(UIParam::DynamicFollow));
     return;
   }
 
   // power meter text press to change units
   if (QUIState::ui_state.scene.started && QUIState::ui_state.scene.power_meter_text_rect.ptInRect(e->x(), e->y())){
     QUIState::ui_state.scene.power_meter_metric = !QUIState::ui_state.scene.power_meter_metric;
-    Params().putBool("PowerMeterMetric", QUIState::ui_state.scene.power_meter_metric);
+    params.putBool(UIParam::PowerMeterMetric, QUIState::ui_state.scene.power_meter_metric);
     return;
   }
   // brake indicator or power meter press
   if (QUIState::ui_state.scene.started && QUIState::ui_state.scene.brake_touch_rect.ptInRect(e->x(), e->y())){
     QUIState::ui_state.scene.power_meter_mode = (QUIState::ui_state.scene.power_meter_mode + 1) % 3;
-    Params().put("PowerMeterMode", std::to_string(QUIState::ui_state.scene.power_meter_mode).c_str(), 1);
+    params.putInt(UIParam::PowerMeterMode, QUIState::ui_state.scene.power_meter_mode);
     return;
   }
   
   // screen dim button (dm face icon)
   if (QUIState::ui_state.scene.started && QUIState::ui_state.scene.screen_dim_touch_rect.ptInRect(e->x(), e->y())){
-    int dim_mode = std::stoi(Params().get("ScreenDimMode")) - 1;
+    int dim_mode = params.getInt(UIParam::ScreenDimMode) - 1;
     if (dim_mode < 0){
       dim_mode = QUIState::ui_state.scene.screen_dim_mode_max;
     }
     QUIState::ui_state.scene.screen_dim_mode = dim_mode;
-    Params().put("ScreenDimMode", std::to_string(dim_mode).c_str(), 1);
+    params.putInt(UIParam::ScreenDimMode, dim_mode);
     return;
   }
   
@@ -253,18 +241,18 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
   if (QUIState::ui_state.scene.started && QUIState::ui_state.scene.lane_pos_enabled && QUIState::ui_state.scene.lane_pos_left_touch_rect.ptInRect(e->x(), e->y())){
     if (QUIState::ui_state.scene.auto_lane_pos_active){
       QUIState::ui_state.scene.auto_lane_pos_active = false;
-      Params().putBool("AutoLanePositionActive", false);
+      params.putBool(UIParam::AutoLanePositionActive, false);
       if (QUIState::ui_state.scene.lane_pos == -1){
         // user pressed left button when auto mode was on right position, so enable left position
         QUIState::ui_state.scene.lane_pos = 1;
         QUIState::ui_state.scene.lane_pos_timeout_dist = QUIState::ui_state.scene.lane_pos_dist_short;
         QUIState::ui_state.scene.lane_pos_set_t = QUIState::ui_state.scene.lastTime;
         QUIState::ui_state.scene.lane_pos_dist_since_set = 0.;
-        Params().put("LanePosition", "1", 1);
+        params.putInt(UIParam::LanePosition, 1);
       }
       else{
         QUIState::ui_state.scene.lane_pos = 0;
-        Params().put("LanePosition", "0", 1);
+        params.putInt(UIParam::LanePosition, 0);
         QUIState::ui_state.scene.lane_pos_set_t = 0;
       }
     }
@@ -276,15 +264,15 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
         }
         else{
           QUIState::ui_state.scene.lane_pos = 0;
-          Params().put("LanePosition", "0", 1);
+          params.putInt(UIParam::LanePosition, 0);
         }
       }
       else if (QUIState::ui_state.scene.lane_pos == -1 && QUIState::ui_state.scene.lastTime - QUIState::ui_state.scene.lane_pos_set_t < 2.){
         // activate auto mode
         QUIState::ui_state.scene.auto_lane_pos_active = true;
-        Params().putBool("AutoLanePositionActive", true);
+        params.putBool(UIParam::AutoLanePositionActive, true);
         QUIState::ui_state.scene.lane_pos = 0;
-        Params().put("LanePosition", "0", 1);
+        params.putInt(UIParam::LanePosition, 0);
         QUIState::ui_state.scene.lane_pos_set_t = 0;
       }
       else{
@@ -292,7 +280,7 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
         QUIState::ui_state.scene.lane_pos_timeout_dist = QUIState::ui_state.scene.lane_pos_dist_short;
         QUIState::ui_state.scene.lane_pos_set_t = QUIState::ui_state.scene.lastTime;
         QUIState::ui_state.scene.lane_pos_dist_since_set = 0.;
-        Params().put("LanePosition", "1", 1);
+        params.putInt(UIParam::LanePosition, 1);
       }
     }
     return;
@@ -300,18 +288,18 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
   if (QUIState::ui_state.scene.started && QUIState::ui_state.scene.lane_pos_enabled && QUIState::ui_state.scene.lane_pos_right_touch_rect.ptInRect(e->x(), e->y())){
     if (QUIState::ui_state.scene.auto_lane_pos_active){
       QUIState::ui_state.scene.auto_lane_pos_active = false;
-      Params().putBool("AutoLanePositionActive", false);
+      params.putBool(UIParam::AutoLanePositionActive, false);
       if (QUIState::ui_state.scene.lane_pos == 1){
         // user pressed left button when auto mode was on right position, so enable left position
         QUIState::ui_state.scene.lane_pos = -1;
         QUIState::ui_state.scene.lane_pos_timeout_dist = QUIState::ui_state.scene.lane_pos_dist_short;
         QUIState::ui_state.scene.lane_pos_set_t = QUIState::ui_state.scene.lastTime;
         QUIState::ui_state.scene.lane_pos_dist_since_set = 0.;
-        Params().put("LanePosition", "-1", 2);
+        params.putInt(UIParam::LanePosition, -1);
       }
       else{
         QUIState::ui_state.scene.lane_pos = 0;
-        Params().put("LanePosition", "0", 1);
+        params.putInt(UIParam::LanePosition, 0);
         QUIState::ui_state.scene.lane_pos_set_t = 0;
       }
     }
@@ -323,15 +311,15 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
         }
         else{
           QUIState::ui_state.scene.lane_pos = 0;
-          Params().put("LanePosition", "0", 1);
+          params.putInt(UIParam::LanePosition, 0);
         }
       }
       else if (QUIState::ui_state.scene.lane_pos == 1 && QUIState::ui_state.scene.lastTime - QUIState::ui_state.scene.lane_pos_set_t < 2.){
         // activate auto mode
         QUIState::ui_state.scene.auto_lane_pos_active = true;
-        Params().putBool("AutoLanePositionActive", true);
+        params.putBool(UIParam::AutoLanePositionActive, true);
         QUIState::ui_state.scene.lane_pos = 0;
-        Params().put("LanePosition", "0", 1);
+        params.putInt(UIParam::LanePosition, 0);
         QUIState::ui_state.scene.lane_pos_set_t = 0;
       }
       else{
@@ -339,7 +327,7 @@ void HomeWindow::mousePressEvent(QMouseEvent* e) {
         QUIState::ui_state.scene.lane_pos_timeout_dist = QUIState::ui_state.scene.lane_pos_dist_short;
         QUIState::ui_state.scene.lane_pos_set_t = QUIState::ui_state.scene.lastTime;
         QUIState::ui_state.scene.lane_pos_dist_since_set = 0.;
-        Params().put("LanePosition", "-1", 2);
+        params.putInt(UIParam::LanePosition, -1);
       }
     }
     return;
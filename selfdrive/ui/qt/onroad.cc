@@ -202,10 +202,14 @@ void OnroadAlerts::paintEvent(QPaintEvent *event) {
 
 NvgWindow::NvgWindow(QWidget *parent) : QOpenGLWidget(parent) {
   setAttribute(Qt::WA_OpaquePaintEvent);
+  QObject::connect(this, &QOpenGLWidget::frameSwapped, [=] {
+    QUIState::ui_state.frame_stats.swapped(millis_since_boot());
+  });
 }
 
 NvgWindow::~NvgWindow() {
   makeCurrent();
+  ui_free_measure_slots();
   doneCurrent();
 }
 
@@ -228,7 +232,9 @@ void NvgWindow::updateState(const UIState &s) {
   if (isVisible() != s.vipc_client->connected) {
     setVisible(s.vipc_client->connected);
   }
-  repaint();
+  // queue a paint instead of drawing right away, so state updates that arrive
+  // within one display refresh are drawn once
+  update();
 }
 
 void NvgWindow::resizeGL(int w, int h) {
@@ -236,9 +242,11 @@ void NvgWindow::resizeGL(int w, int h) {
 }
 
 void NvgWindow::paintGL() {
+  const double start_t = millis_since_boot();
   ui_draw(&QUIState::ui_state, width(), height());
 
   double cur_draw_t = millis_since_boot();
+  QUIState::ui_state.frame_stats.drawn(start_t, cur_draw_t, QUIState::ui_state.last_frame_id);
   double dt = cur_draw_t - prev_draw_t;
   if (dt > 66) {
     // warn on sub 15fps
@@ -36,6 +36,26 @@ const char frame_fragment_shader[] =
 #endif
   "}\n";
 
+// I420 planes in three single channel textures. camerad converts to YUV with BT.601 limited range
+const char frame_fragment_shader_yuv[] =
+#ifdef NANOVG_GL3_IMPLEMENTATION
+  "#version 150 core\n"
+#else
+  "#version 300 es\n"
+#endif
+  "precision mediump float;\n"
+  "uniform sampler2D uTextureY;\n"
+  "uniform sampler2D uTextureU;\n"
+  "uniform sampler2D uTextureV;\n"
+  "in vec4 vTexCoord;\n"
+  "out vec4 colorOut;\n"
+  "void main() {\n"
+  "  float y = 1.164 * (texture(uTextureY, vTexCoord.xy).r - 0.0625);\n"
+  "  float u = texture(uTextureU, vTexCoord.xy).r - 0.5;\n"
+  "  float v = texture(uTextureV, vTexCoord.xy).r - 0.5;\n"
+  "  colorOut = vec4(y + 1.596 * v, y - 0.391 * u - 0.813 * v, y + 2.018 * u, 1.0);\n"
+  "}\n";
+
 const mat4 device_transform = {{
   1.0,  0.0, 0.0, 0.0,
   0.0,  1.0, 0.0, 0.0,
@@ -90,12 +110,24 @@ mat4 get_fit_view_transform(float widget_aspect_ratio, float frame_aspect_ratio)
   return frame_transform;
 }
 
+VisionStreamType yuv_stream(VisionStreamType stream_type) {
+  switch (stream_type) {
+    case VISION_STREAM_RGB_FRONT: return VISION_STREAM_YUV_FRONT;
+    case VISION_STREAM_RGB_WIDE: return VISION_STREAM_YUV_WIDE;
+    default: return VISION_STREAM_YUV_BACK;
+  }
+}
+
 } // namespace
 
 CameraViewWidget::CameraViewWidget(VisionStreamType stream_type, bool zoom, QWidget* parent) :
                                    stream_type(stream_type), zoomed_view(zoom), QOpenGLWidget(parent) {
   setAttribute(Qt::WA_OpaquePaintEvent);
 
+  // the YUV stream is half the size of the RGB one, but needs a copy where the RGB
+  // frame is imported as an EGLImage
+  yuv = !Hardware::EON() && getenv("CAMERA_VIEW_YUV") != nullptr;
+
   timer = new QTimer(this);
   connect(timer, &QTimer::timeout, this, &CameraViewWidget::updateFrame);
 }
@@ -106,6 +138,11 @@ CameraViewWidget::~CameraViewWidget() {
     glDeleteVertexArrays(1, &frame_vao);
     glDeleteBuffers(1, &frame_vbo);
     glDeleteBuffers(1, &frame_ibo);
+    glDeleteTextures(3, yuv_tex);
+    for (auto &t : texture) {
+      t.reset();
+    }
+    uploader.reset();
   }
   doneCurrent();
 }
@@ -113,7 +150,7 @@ CameraViewWidget::~CameraViewWidget() {
 void CameraViewWidget::initializeGL() {
   initializeOpenGLFunctions();
 
-  gl_shader = std::make_unique<GLShader>(frame_vertex_shader, frame_fragment_shader);
+  gl_shader = std::make_unique<GLShader>(frame_vertex_shader, yuv ? frame_fragment_shader_yuv : frame_fragment_shader);
   GLint frame_pos_loc = glGetAttribLocation(gl_shader->prog, "aPosition");
   GLint frame_texcoord_loc = glGetAttribLocation(gl_shader->prog, "aTexCoord");
 
@@ -143,7 +180,7 @@ void CameraViewWidget::initializeGL() {
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 
-  vipc_client = std::make_unique<VisionIpcClient>("camerad", stream_type, true);
+  vipc_client = std::make_unique<VisionIpcClient>("camerad", yuv ? yuv_stream(stream_type) : stream_type, true);
 }
 
 void CameraViewWidget::showEvent(QShowEvent *event) {
@@ -203,17 +240,27 @@ void CameraViewWidget::paintGL() {
   glViewport(0, 0, width(), height());
 
   glBindVertexArray(frame_vao);
-  glActiveTexture(GL_TEXTURE0);
+  glUseProgram(gl_shader->prog);
 
-  glBindTexture(GL_TEXTURE_2D, texture[latest_frame->idx]->frame_tex);
-  if (!Hardware::EON()) {
-    // this is handled in ion on QCOM
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, latest_frame->width, latest_frame->height,
-                  0, GL_RGB, GL_UNSIGNED_BYTE, latest_frame->addr);
+  if (yuv) {
+    uploader->uploadYUV(yuv_tex, latest_frame, latest_frame_id);
+    const char *samplers[] = {"uTextureY", "uTextureU", "uTextureV"};
+    for (int i = 0; i < 3; i++) {
+      glActiveTexture(GL_TEXTURE0 + i);
+      glBindTexture(GL_TEXTURE_2D, yuv_tex[i]);
+      glUniform1i(gl_shader->getUniformLocation(samplers[i]), i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+  } else {
+    const GLuint frame_tex = texture[latest_frame->idx]->frame_tex;
+    if (!Hardware::EON()) {
+      // this is handled in ion on QCOM
+      uploader->uploadRGB(frame_tex, latest_frame, latest_frame_id);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, frame_tex);
+    glUniform1i(gl_shader->getUniformLocation("uTexture"), 0);
   }
-
-  glUseProgram(gl_shader->prog);
-  glUniform1i(gl_shader->getUniformLocation("uTexture"), 0);
   glUniformMatrix4fv(gl_shader->getUniformLocation("uTransform"), 1, GL_TRUE, frame_mat.v);
 
   assert(glGetError() == GL_NO_ERROR);
@@ -226,7 +273,13 @@ void CameraViewWidget::paintGL() {
 void CameraViewWidget::updateFrame() {
   if (!vipc_client->connected && vipc_client->connect(false)) {
     // init vision
-    for (int i = 0; i < vipc_client->num_buffers; i++) {
+    if (!Hardware::EON()) {
+      uploader = std::make_unique<FrameUploader>();
+    }
+    if (yuv) {
+      initYUVTextures(vipc_client->buffers[0].width, vipc_client->buffers[0].height);
+    }
+    for (int i = 0; !yuv && i < vipc_client->num_buffers; i++) {
       texture[i].reset(new EGLImageTexture(&vipc_client->buffers[i]));
 
       glBindTexture(GL_TEXTURE_2D, texture[i]->frame_tex);
@@ -244,9 +297,11 @@ void CameraViewWidget::updateFrame() {
   }
 
   if (vipc_client->connected) {
-    VisionBuf *buf = vipc_client->recv();
+    VisionIpcBufExtra extra = {};
+    VisionBuf *buf = vipc_client->recv(&extra);
     if (buf != nullptr) {
       latest_frame = buf;
+      latest_frame_id = extra.frame_id;
       update();
       emit frameUpdated();
     } else {
@@ -254,3 +309,21 @@ void CameraViewWidget::updateFrame() {
     }
   }
 }
+
+void CameraViewWidget::initYUVTextures(int width, int height) {
+  if (yuv_tex[0] == 0) {
+    glGenTextures(3, yuv_tex);
+  }
+  for (int i = 0; i < 3; i++) {
+    const int w = i == 0 ? width : width / 2;
+    const int h = i == 0 ? height : height / 2;
+    glBindTexture(GL_TEXTURE_2D, yuv_tex[i]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    // chroma is sampled between texels at full resolution
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, i == 0 ? GL_NEAREST : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, i == 0 ? GL_NEAREST : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+  assert(glGetError() == GL_NO_ERROR);
+}
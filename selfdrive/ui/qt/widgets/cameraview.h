@@ -35,12 +35,18 @@ protected slots:
   void updateFrame();
 
 private:
+  void initYUVTextures(int width, int height);
+
   bool zoomed_view;
+  bool yuv = false;
   VisionBuf *latest_frame = nullptr;
+  uint32_t latest_frame_id = 0;
   GLuint frame_vao, frame_vbo, frame_ibo;
   mat4 frame_mat;
   std::unique_ptr<VisionIpcClient> vipc_client;
   std::unique_ptr<EGLImageTexture> texture[UI_BUF_COUNT];
+  GLuint yuv_tex[3] = {};
+  std::unique_ptr<FrameUploader> uploader;
   std::unique_ptr<GLShader> gl_shader;
 
   QTimer* timer;
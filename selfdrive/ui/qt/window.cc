@@ -2,6 +2,7 @@
 
 #include <QFontDatabase>
 
+#include "selfdrive/common/timing.h"
 #include "selfdrive/hardware/hw.h"
 
 MainWindow::MainWindow(QWidget *parent) : QWidget(parent) {
@@ -78,6 +79,9 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
   // wake screen on tap
   if (event->type() == QEvent::MouseButtonPress || event->type() == QEvent::TouchBegin) {
     device.setAwake(true, true);
+    if (QUIState::ui_state.scene.started) {
+      QUIState::ui_state.frame_stats.input(millis_since_boot());
+    }
   }
 
 #ifdef QCOM
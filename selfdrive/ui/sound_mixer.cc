@@ -0,0 +1,145 @@
+#include "selfdrive/ui/sound_mixer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "selfdrive/common/util.h"
+
+template <typename T>
+static T read_le(const std::string &data, size_t pos) {
+  T val;
+  memcpy(&val, data.data() + pos, sizeof(T));
+  return val;
+}
+
+// downmixes to mono and resamples linearly to out_rate
+bool decode_wav(const std::string &data, int out_rate, std::vector<int16_t> &pcm) {
+  if (data.size() < 12 || data.compare(0, 4, "RIFF") != 0 || data.compare(8, 4, "WAVE") != 0) {
+    return false;
+  }
+
+  int format = 0, channels = 0, rate = 0, bits = 0;
+  size_t samples = 0, samples_len = 0;
+  for (size_t i = 12; i + 8 <= data.size();) {
+    const size_t body = i + 8;
+    const size_t size = std::min<size_t>(read_le<uint32_t>(data, i + 4), data.size() - body);
+    if (data.compare(i, 4, "fmt ") == 0 && size >= 16) {
+      format = read_le<uint16_t>(data, body);
+      channels = read_le<uint16_t>(data, body + 2);
+      rate = read_le<uint32_t>(data, body + 4);
+      bits = read_le<uint16_t>(data, body + 14);
+    } else if (data.compare(i, 4, "data") == 0) {
+      samples = body;
+      samples_len = size;
+    }
+    // chunks are padded to even sizes
+    i = body + size + (size & 1);
+  }
+  if (format != 1 || bits != 16 || channels < 1 || channels > 2 || rate <= 0 || samples_len == 0) {
+    return false;
+  }
+
+  const size_t in_frames = samples_len / (2 * channels);
+  if (in_frames == 0) {
+    return false;
+  }
+  std::vector<float> mono(in_frames);
+  for (size_t i = 0; i < in_frames; i++) {
+    float sum = 0;
+    for (int c = 0; c < channels; c++) {
+      sum += read_le<int16_t>(data, samples + (i * channels + c) * 2);
+    }
+    mono[i] = sum / channels;
+  }
+
+  const double step = (double)rate / out_rate;
+  pcm.resize((size_t)(in_frames / step));
+  for (size_t i = 0; i < pcm.size(); i++) {
+    const double src = i * step;
+    const size_t j = std::min((size_t)src, in_frames - 1);
+    const float a = mono[j], b = mono[std::min(j + 1, in_frames - 1)];
+    pcm[i] = (int16_t)std::lrint(a + (b - a) * (src - j));
+  }
+  return !pcm.empty();
+}
+
+int SoundMixer::load(const std::string &path) {
+  std::vector<int16_t> pcm;
+  if (!decode_wav(util::read_file(path), SAMPLE_RATE, pcm)) {
+    return -1;
+  }
+
+  std::lock_guard lk(lock);
+  sounds.push_back(std::move(pcm));
+  // a sound has at most one voice, so play never allocates
+  voices.reserve(sounds.size());
+  return sounds.size() - 1;
+}
+
+void SoundMixer::play(int id, bool loop, float volume) {
+  std::lock_guard lk(lock);
+  if (id < 0 || id >= (int)sounds.size()) {
+    return;
+  }
+
+  const Voice v = {id, 0, loop, volume, clock(), false};
+  auto it = std::find_if(voices.begin(), voices.end(), [=](const Voice &other) { return other.id == id; });
+  if (it != voices.end()) {
+    *it = v;
+  } else {
+    voices.push_back(v);
+  }
+}
+
+void SoundMixer::stopLooping() {
+  std::lock_guard lk(lock);
+  voices.erase(std::remove_if(voices.begin(), voices.end(), [](const Voice &v) { return v.loop; }), voices.end());
+}
+
+bool SoundMixer::playing() {
+  std::lock_guard lk(lock);
+  return !voices.empty();
+}
+
+void SoundMixer::mix(int16_t *out, int frames, double queued_ms) {
+  std::lock_guard lk(lock);
+  const uint64_t now = clock();
+
+  const int chunk = 256;
+  float acc[chunk];
+  for (int done = 0; done < frames; done += chunk) {
+    const int n = std::min(frames - done, chunk);
+    std::fill(acc, acc + n, 0.f);
+
+    for (Voice &v : voices) {
+      const std::vector<int16_t> &pcm = sounds[v.id];
+      if (!v.started) {
+        v.started = true;
+        latency_ms = (now - v.play_ns) / 1e6 + queued_ms + done * 1000. / SAMPLE_RATE;
+        has_latency = true;
+      }
+      for (int i = 0; i < n && v.pos < pcm.size(); i++) {
+        acc[i] += pcm[v.pos++] * v.volume;
+        if (v.loop && v.pos == pcm.size()) {
+          v.pos = 0;
+        }
+      }
+    }
+    voices.erase(std::remove_if(voices.begin(), voices.end(), [&](const Voice &v) { return v.pos == sounds[v.id].size(); }), voices.end());
+
+    for (int i = 0; i < n; i++) {
+      out[done + i] = (int16_t)std::clamp(acc[i], -32768.f, 32767.f);
+    }
+  }
+}
+
+bool SoundMixer::takeLatency(double &ms) {
+  std::lock_guard lk(lock);
+  if (!has_latency) {
+    return false;
+  }
+  ms = latency_ms;
+  has_latency = false;
+  return true;
+}
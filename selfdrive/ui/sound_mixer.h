@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "selfdrive/common/timing.h"
+
+// Mixes preloaded sounds into a mono 16 bit stream for an audio output to pull from.
+// Sounds are decoded and resampled to the output rate when they're loaded, so starting one
+// doesn't touch the filesystem and mixing doesn't allocate. play and stopLooping can be
+// called from another thread than mix.
+class SoundMixer {
+public:
+  static constexpr int SAMPLE_RATE = 48000;
+
+  // clock times latency in ns, tests pass their own to make it deterministic
+  explicit SoundMixer(uint64_t (*clock)() = nanos_since_boot) : clock(clock) {}
+
+  // returns the id to play the sound with, or -1 if the file isn't a 16 bit PCM wav
+  int load(const std::string &path);
+  // starts a sound from the beginning, restarting it if it's already playing
+  void play(int id, bool loop, float volume);
+  // one-shot sounds play to the end
+  void stopLooping();
+  bool playing();
+
+  // fills out with the next frames. queued_ms is the audio the output holds ahead of them
+  void mix(int16_t *out, int frames, double queued_ms = 0);
+  // time from play until the sound's first frame was mixed, plus the audio queued ahead of it.
+  // returns false if no sound started since the last call
+  bool takeLatency(double &ms);
+
+private:
+  struct Voice {
+    int id;
+    size_t pos;
+    bool loop;
+    float volume;
+    uint64_t play_ns;
+    bool started;
+  };
+
+  uint64_t (*clock)();
+  std::mutex lock;
+  std::vector<std::vector<int16_t>> sounds;
+  std::vector<Voice> voices;
+  bool has_latency = false;
+  double latency_ms = 0;
+};
+
+bool decode_wav(const std::string &data, int out_rate, std::vector<int16_t> &pcm);
@@ -3,77 +3,155 @@
 #include <map>
 
 #include <QApplication>
+#include <QAudioDeviceInfo>
+#include <QAudioFormat>
+#include <QAudioOutput>
+#include <QIODevice>
 #include <QString>
-#include <QSoundEffect>
+#include <QThread>
 
-#include "selfdrive/common/params.h"
 #include "cereal/messaging/messaging.h"
+#include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/timing.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/hardware/hw.h"
+#include "selfdrive/ui/sound_mixer.h"
 #include "selfdrive/ui/ui.h"
 
 // TODO: detect when we can't play sounds
 // TODO: detect when we can't display the UI
 
+// the output pulls from the mixer continuously, so starting a sound doesn't open the device
+const int OUTPUT_BUFFER_MS = 40;
+
+class MixerDevice : public QIODevice {
+public:
+  MixerDevice(SoundMixer *mixer, QObject *parent) : QIODevice(parent), mixer(mixer) {}
+  QAudioOutput *output = nullptr;
+
+  bool isSequential() const override { return true; }
+  qint64 bytesAvailable() const override { return SoundMixer::SAMPLE_RATE * sizeof(int16_t) + QIODevice::bytesAvailable(); }
+
+protected:
+  qint64 readData(char *data, qint64 maxlen) override {
+    const int frames = maxlen / sizeof(int16_t);
+    // audio already in the output buffer plays before this
+    const double queued_ms = output ? (output->bufferSize() - output->bytesFree()) * 1000. / (SoundMixer::SAMPLE_RATE * sizeof(int16_t)) : 0;
+    mixer->mix((int16_t *)data, frames, queued_ms);
+    return frames * sizeof(int16_t);
+  }
+  qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+  SoundMixer *mixer;
+};
+
+class AudioSink : public QObject {
+public:
+  AudioSink(SoundMixer *mixer, bool null_sink) : mixer(mixer), null_sink(null_sink) {}
+
+  void start() {
+    if (null_sink || !startOutput()) {
+      startNullSink();
+    }
+  }
+
+private:
+  bool startOutput() {
+    QAudioFormat format;
+    format.setSampleRate(SoundMixer::SAMPLE_RATE);
+    format.setChannelCount(1);
+    format.setSampleSize(16);
+    format.setSampleType(QAudioFormat::SignedInt);
+    format.setByteOrder(QAudioFormat::LittleEndian);
+    format.setCodec("audio/pcm");
+    if (!QAudioDeviceInfo::defaultOutputDevice().isFormatSupported(format)) {
+      LOGE("audio output doesn't support %d Hz mono 16 bit, using null sink", SoundMixer::SAMPLE_RATE);
+      return false;
+    }
+
+    MixerDevice *device = new MixerDevice(mixer, this);
+    device->open(QIODevice::ReadOnly);
+    QAudioOutput *output = new QAudioOutput(format, this);
+    output->setBufferSize(SoundMixer::SAMPLE_RATE * sizeof(int16_t) * OUTPUT_BUFFER_MS / 1000);
+    device->output = output;
+    output->start(device);
+    return true;
+  }
+
+  // consumes the mix at the output rate without audio hardware
+  void startNullSink() {
+    null_sink_buf.resize(SoundMixer::SAMPLE_RATE / 10);
+    null_sink_t = nanos_since_boot();
+    QTimer *timer = new QTimer(this);
+    QObject::connect(timer, &QTimer::timeout, [=]() {
+      const uint64_t t = nanos_since_boot();
+      int frames = (t - null_sink_t) * SoundMixer::SAMPLE_RATE / 1000000000ULL;
+      null_sink_t += frames * 1000000000ULL / SoundMixer::SAMPLE_RATE;
+      while (frames > 0) {
+        const int n = std::min<int>(frames, null_sink_buf.size());
+        mixer->mix(null_sink_buf.data(), n);
+        frames -= n;
+      }
+    });
+    timer->start(OUTPUT_BUFFER_MS / 2);
+  }
+
+  SoundMixer *mixer;
+  bool null_sink;
+  std::vector<int16_t> null_sink_buf;
+  uint64_t null_sink_t = 0;
+};
+
 class Sound : public QObject {
 public:
   explicit Sound(QObject *parent = 0) {
     // TODO: merge again and add EQ in the amp config
-    {
-      const QString sound_asset_path = Hardware::TICI() ? "../assets/sounds_tici/" : "../assets/sounds/";
-      std::tuple<AudibleAlert, QString, bool> sound_list[] = {
-        {AudibleAlert::CHIME_DISENGAGE, sound_asset_path + "disengaged.wav", false},
-        {AudibleAlert::CHIME_ENGAGE, sound_asset_path + "engaged.wav", false},
-        {AudibleAlert::CHIME_WARNING1, sound_asset_path + "warning_1.wav", false},
-        {AudibleAlert::CHIME_WARNING2, sound_asset_path + "warning_2.wav", false},
-        {AudibleAlert::CHIME_WARNING2_REPEAT, sound_asset_path + "warning_2.wav", true},
-        {AudibleAlert::CHIME_WARNING_REPEAT, sound_asset_path + "warning_repeat.wav", true},
-        {AudibleAlert::CHIME_ERROR, sound_asset_path + "error.wav", false},
-        {AudibleAlert::CHIME_PROMPT, sound_asset_path + "error.wav", false}
-      };
-      for (auto &[alert, fn, loops] : sound_list) {
-        QSoundEffect *s = new QSoundEffect(this);
-        QObject::connect(s, &QSoundEffect::statusChanged, this, &Sound::checkStatus);
-        s->setSource(QUrl::fromLocalFile(fn));
-        sounds[alert] = {s, loops ? QSoundEffect::Infinite : 0};
-      }
-    }
-    { // again for custom sounds
-      const QString sound_asset_path = Hardware::TICI() ? "../assets/sounds_tici/" : "../assets/sounds/";
-      std::tuple<AudibleAlert, QString, bool> sound_list[] = {
-        {AudibleAlert::CHIME_DISENGAGE, sound_asset_path + "disengaged_cust.wav", false},
-        {AudibleAlert::CHIME_ENGAGE, sound_asset_path + "engaged_cust.wav", false},
-        {AudibleAlert::CHIME_WARNING1, sound_asset_path + "warning_1_cust.wav", false},
-        {AudibleAlert::CHIME_WARNING2, sound_asset_path + "warning_2_cust.wav", false},
-        {AudibleAlert::CHIME_WARNING2_REPEAT, sound_asset_path + "warning_1_cust.wav", true},
-        {AudibleAlert::CHIME_WARNING_REPEAT, sound_asset_path + "warning_repeat_cust.wav", true},
-        {AudibleAlert::CHIME_ERROR, sound_asset_path + "error_cust.wav", false},
-        {AudibleAlert::CHIME_PROMPT, sound_asset_path + "error_cust.wav", false}
-      };
-      for (auto &[alert, fn, loops] : sound_list) {
-        QSoundEffect *s = new QSoundEffect(this);
-        QObject::connect(s, &QSoundEffect::statusChanged, this, &Sound::checkStatus);
-        s->setSource(QUrl::fromLocalFile(fn));
-        customSounds[alert] = {s, loops ? QSoundEffect::Infinite : 0};
+    const QString sound_asset_path = Hardware::TICI() ? "../assets/sounds_tici/" : "../assets/sounds/";
+    std::tuple<AudibleAlert, QString, QString, bool> sound_list[] = {
+      {AudibleAlert::CHIME_DISENGAGE, "disengaged.wav", "disengaged_cust.wav", false},
+      {AudibleAlert::CHIME_ENGAGE, "engaged.wav", "engaged_cust.wav", false},
+      {AudibleAlert::CHIME_WARNING1, "warning_1.wav", "warning_1_cust.wav", false},
+      {AudibleAlert::CHIME_WARNING2, "warning_2.wav", "warning_2_cust.wav", false},
+      {AudibleAlert::CHIME_WARNING2_REPEAT, "warning_2.wav", "warning_1_cust.wav", true},
+      {AudibleAlert::CHIME_WARNING_REPEAT, "warning_repeat.wav", "warning_repeat_cust.wav", true},
+      {AudibleAlert::CHIME_ERROR, "error.wav", "error_cust.wav", false},
+      {AudibleAlert::CHIME_PROMPT, "error.wav", "error_cust.wav", false}
+    };
+    // the same file may be loaded twice, which is fine for a handful of short sounds
+    for (auto &[alert, fn, custom_fn, loops] : sound_list) {
+      const int id = loadSound(sound_asset_path + fn);
+      int custom_id = mixer.load((sound_asset_path + custom_fn).toStdString());
+      if (custom_id < 0) {
+        LOGE("failed to load sound %s, using %s instead", qPrintable(custom_fn), qPrintable(fn));
+        custom_id = id;
       }
+      sounds[alert] = {id, loops};
+      customSounds[alert] = {custom_id, loops};
     }
 
+    params = new UIParams(this);
     sm = new SubMaster({"carState", "controlsState"});
 
+    // the output runs on its own thread, update blocks waiting for messages
+    audio_thread = new QThread(this);
+    sink = new AudioSink(&mixer, getenv("SOUNDD_NULL_SINK") != nullptr);
+    sink->moveToThread(audio_thread);
+    QObject::connect(audio_thread, &QThread::started, sink, [=]() { sink->start(); });
+    audio_thread->start(QThread::TimeCriticalPriority);
+
     QTimer *timer = new QTimer(this);
     QObject::connect(timer, &QTimer::timeout, this, &Sound::update);
     timer->start();
   };
   ~Sound() {
+    audio_thread->quit();
+    audio_thread->wait();
+    delete sink;
     delete sm;
   };
 
 private slots:
-  void checkStatus() {
-    QSoundEffect *s = qobject_cast<QSoundEffect*>(sender());
-    assert(s->status() != QSoundEffect::Error);
-  }
-
   void update() {
     sm->update(100);
     if (sm->updated("carState")) {
@@ -91,54 +169,52 @@ private slots:
                ((nanos_since_boot() - sm->rcv_time("controlsState")) / 1e9 > CONTROLS_TIMEOUT)) {
       setAlert(CONTROLS_UNRESPONSIVE_ALERT);
     }
+
+    double latency_ms;
+    if (mixer.takeLatency(latency_ms)) {
+      LOG("alert sound latency %.1f ms", latency_ms);
+    }
   }
 
   void setAlert(Alert a) {
     if (!alert.equal(a)) {
       alert = a;
-      // stop sounds
-      for (auto &[s, loops] : sounds) {
-        // Only stop repeating sounds
-        if (s->loopsRemaining() == QSoundEffect::Infinite) {
-          s->stop();
-        }
-      }
-      
-      for (auto &[s, loops] : customSounds) {
-        // Only stop repeating sounds
-        if (s->loopsRemaining() == QSoundEffect::Infinite) {
-          s->stop();
-        }
-      }
+      // Only stop repeating sounds
+      mixer.stopLooping();
 
       // play sound
       if (alert.sound != AudibleAlert::NONE && shouldPlaySound(a)) {
-        if (Params().getBool("CustomSounds")){
-          auto &[s, loops] = customSounds[alert.sound];
-          s->setLoopCount(loops);
-          s->setVolume(volume);
-          s->play();
-        }
-        else{
-          auto &[s, loops] = sounds[alert.sound];
-          s->setLoopCount(loops);
-          s->setVolume(volume);
-          s->play();
-        }
+        auto &[id, loops] = params->getBool(UIParam::CustomSounds) ? customSounds[alert.sound] : sounds[alert.sound];
+        mixer.play(id, loops, volume);
       }
     }
   }
-  
+
   bool shouldPlaySound(Alert a) {
-    bool silentEngageDisengage = Params().getBool("SilentEngageDisengage");
+    bool silentEngageDisengage = params->getBool(UIParam::SilentEngageDisengage);
     return !silentEngageDisengage || (a.sound != AudibleAlert::CHIME_ENGAGE && a.sound != AudibleAlert::CHIME_DISENGAGE);
   }
 
 private:
+  // alerts must be audible, so a stock sound that doesn't load is fatal in every build
+  int loadSound(const QString &fn) {
+    const int id = mixer.load(fn.toStdString());
+    if (id < 0) {
+      LOGE("failed to load sound %s", qPrintable(fn));
+      exit(1);
+    }
+    return id;
+  }
+
   Alert alert;
   float volume = Hardware::MIN_VOLUME;
-  QMap<AudibleAlert, QPair<QSoundEffect*, int>> sounds, customSounds;
+  SoundMixer mixer;
+  std::map<AudibleAlert, std::pair<int, bool>> sounds, customSounds;
+  UIParams *params;
   SubMaster *sm;
+
+  QThread *audio_thread;
+  AudioSink *sink;
 };
 
 int main(int argc, char **argv) {
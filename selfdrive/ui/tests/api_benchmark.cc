@@ -0,0 +1,168 @@
+// measures the per request overhead of authenticated api requests against a local stub server
+// usage: ./api_benchmark [requests]
+// compares HttpRequest with cached tokens against the previous approach of reading and parsing
+// the private key and signing a new token for every request. runs in a temporary HOME with a
+// generated key, so it doesn't touch the device's identity
+
+#include <openssl/bn.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+
+#include "selfdrive/common/params.h"
+#include "selfdrive/common/util.h"
+#include "selfdrive/hardware/hw.h"
+#include "selfdrive/ui/qt/api.h"
+
+// answers every request with an empty json object and keeps the connection open
+class StubServer : public QTcpServer {
+public:
+  std::set<QByteArray> auth_headers;
+
+protected:
+  void incomingConnection(qintptr fd) override {
+    QTcpSocket *socket = new QTcpSocket(this);
+    socket->setSocketDescriptor(fd);
+    QObject::connect(socket, &QTcpSocket::readyRead, [=]() {
+      buf[socket] += socket->readAll();
+      int end;
+      while ((end = buf[socket].indexOf("\r\n\r\n")) >= 0) {
+        const QByteArray head = buf[socket].left(end);
+        buf[socket].remove(0, end + 4);
+        for (const QByteArray &line : head.split('\n')) {
+          if (line.toLower().startsWith("authorization:")) {
+            auth_headers.insert(line.mid(14).trimmed());
+          }
+        }
+        socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 2\r\n\r\n{}");
+      }
+    });
+    QObject::connect(socket, &QTcpSocket::disconnected, [=]() {
+      buf.erase(socket);
+      socket->deleteLater();
+    });
+  }
+
+private:
+  std::map<QTcpSocket *, QByteArray> buf;
+};
+
+static bool write_key(const std::string &path) {
+  RSA *rsa = RSA_new();
+  BIGNUM *e = BN_new();
+  BN_set_word(e, RSA_F4);
+  bool ok = RSA_generate_key_ex(rsa, 2048, e, NULL) == 1;
+  if (ok) {
+    QDir().mkpath(QFileInfo(path.c_str()).path());
+    FILE *f = fopen(path.c_str(), "w");
+    ok = f && PEM_write_RSAPrivateKey(f, rsa, NULL, NULL, 0, NULL, NULL) == 1;
+    if (f) fclose(f);
+  }
+  BN_free(e);
+  RSA_free(rsa);
+  return ok;
+}
+
+static void report(const char *name, std::vector<double> &times, int failed) {
+  std::sort(times.begin(), times.end());
+  double sum = 0;
+  for (double t : times) sum += t;
+  printf("%-32s %8.3f ms avg %8.3f ms p50 %8.3f ms p99 %8.3f ms max, %d failed\n", name, sum / times.size(),
+         times[times.size() / 2], times[times.size() * 99 / 100], times.back(), failed);
+}
+
+static void run(const char *name, const QString &url, int requests, bool create_jwt, std::function<void()> before_send = nullptr) {
+  HttpRequest request(nullptr, create_jwt);
+  QEventLoop loop;
+  bool success = false;
+  QObject::connect(&request, &HttpRequest::requestDone, [&](bool s) {
+    success = s;
+    loop.quit();
+  });
+
+  std::vector<double> times;
+  int failed = 0;
+  for (int i = 0; i < requests; i++) {
+    auto start = std::chrono::steady_clock::now();
+    if (before_send) {
+      before_send();
+    }
+    request.sendRequest(url);
+    loop.exec();
+    times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    failed += !success;
+  }
+  report(name, times, failed);
+}
+
+int main(int argc, char *argv[]) {
+  const int requests = argc > 1 ? std::max(1, atoi(argv[1])) : 200;
+  QCoreApplication app(argc, argv);
+
+  QTemporaryDir home;
+  if (!Hardware::PC() || !home.isValid()) {
+    fprintf(stderr, "needs a PC and a temporary directory\n");
+    return 1;
+  }
+  // every path below, including params, is under the temporary HOME
+  Path::HOME = home.path().toStdString();
+  const std::string auth_path = Path::HOME + "/.comma/auth.json";
+  if (!write_key(Path::rsa_file())) {
+    fprintf(stderr, "failed to generate a key\n");
+    return 1;
+  }
+  const std::string auth = "{\"access_token\": \"benchmark\"}";
+  util::write_file(auth_path.c_str(), auth.data(), auth.size(), O_WRONLY | O_CREAT | O_TRUNC);
+  Params().put("DongleId", "0123456789abcdef");
+
+  StubServer server;
+  if (!server.listen(QHostAddress::LocalHost)) {
+    fprintf(stderr, "failed to listen: %s\n", qPrintable(server.errorString()));
+    return 1;
+  }
+  const QString url = QString("http://127.0.0.1:%1/v1/me/").arg(server.serverPort());
+  printf("%d sequential requests to %s\n", requests, qPrintable(url));
+
+  // warm up the connection
+  run("warm up", url, 10, true);
+
+  server.auth_headers.clear();
+  run("device token, cached", url, requests, true);
+  printf("  %zu distinct tokens sent\n", server.auth_headers.size());
+  {
+    // the cached path on its own, what every request pays before it's sent
+    std::vector<double> times;
+    for (int i = 0; i < requests; i++) {
+      auto start = std::chrono::steady_clock::now();
+      CommaApi::TokenManager::instance().deviceToken();
+      times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    report("deviceToken(), cached", times, 0);
+  }
+  run("device token, signed per request", url, requests, true, [&]() {
+    // a new manager has nothing cached, like rsa_sign used to re-read the key
+    CommaApi::TokenManager(Path::rsa_file(), auth_path).createJwt();
+  });
+  run("account token, cached", url, requests, false);
+  run("account token, read per request", url, requests, false, [&]() {
+    QJsonDocument::fromJson(QByteArray::fromStdString(util::read_file(auth_path)))["access_token"].toString();
+  });
+  return 0;
+}
@@ -0,0 +1,137 @@
+// measures the per radarState cost of preparing the adjacent lead speed text
+// usage: ./lead_speeds_benchmark [leads per side] [updates]
+// compares LeadSpeeds against the previous approach of sorting copies of the lead lists
+// and building std::strings on every update
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cereal/messaging/messaging.h"
+#include "selfdrive/ui/lead_speeds.h"
+
+typedef cereal::RadarState::LeadData::Reader LeadData;
+
+const float speed_conv = 2.2374144;
+
+static std::string legacy_adjacent(capnp::List<cereal::RadarState::LeadData>::Reader leads, bool descending) {
+  std::vector<LeadData> leads_vec;
+  leads_vec.reserve(leads.size());
+  for (auto const & l : leads) {
+    leads_vec.push_back(l);
+  }
+  std::sort(leads_vec.begin(), leads_vec.end(), [=](LeadData const & a, LeadData const & b) {
+    return descending ? a.getVLat() > b.getVLat() : a.getVLat() < b.getVLat();
+  });
+  std::string str = "";
+  char val[16];
+  for (int i = 0; i < leads_vec.size(); ++i) {
+    if (i > 0) {
+      str += " ";
+    }
+    snprintf(val, sizeof(val), "%.0f", leads_vec[i].getVLeadK() * speed_conv);
+    str += val;
+  }
+  return str;
+}
+
+static std::vector<std::string> legacy_center(const cereal::RadarState::Reader &radar_state) {
+  auto leads = radar_state.getLeadsCenter();
+  std::vector<LeadData> leads_vec;
+  std::vector<std::string> strs;
+  leads_vec.reserve(leads.size() + 1);
+  char val[16];
+  auto lead_one_plus = radar_state.getLeadOnePlus();
+  auto lead_one = radar_state.getLeadOne();
+  int start_i = 0;
+  if (lead_one_plus.getStatus() && lead_one_plus.getDRel() - lead_one.getDRel() > 3.0) {
+    start_i++;
+    snprintf(val, sizeof(val), "%.0f", lead_one_plus.getVLeadK() * speed_conv);
+    strs.push_back(val);
+  }
+  for (auto const & l : leads) {
+    leads_vec.push_back(l);
+  }
+  std::sort(leads_vec.begin(), leads_vec.end(), [](LeadData const & a, LeadData const & b) { return a.getDRel() < b.getDRel(); });
+  for (int i = start_i; i < leads_vec.size(); ++i) {
+    if (!lead_one.getStatus() || leads_vec[i].getDRel() - lead_one.getDRel() > 3.0) {
+      snprintf(val, sizeof(val), "%.0f", leads_vec[i].getVLeadK() * speed_conv);
+      strs.push_back(val);
+    }
+  }
+  return strs;
+}
+
+static void fill_leads(capnp::List<cereal::RadarState::LeadData>::Builder leads, std::mt19937 &rng, float t) {
+  std::uniform_real_distribution<float> u(-1.f, 1.f);
+  for (int i = 0; i < leads.size(); ++i) {
+    // slowly varying tracks, like a steady highway scene
+    leads[i].setDRel(10.f + 12.f * i + 2.f * std::sin(t + i));
+    leads[i].setVLat(u(rng));
+    leads[i].setVLeadK(28.f + 0.5f * i + 0.3f * std::sin(0.2f * t + i));
+    leads[i].setStatus(true);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  const int num_leads = argc > 1 ? atoi(argv[1]) : 12;
+  const int updates = argc > 2 ? atoi(argv[2]) : 200000;
+
+  // a few seconds of radarState at 20Hz, replayed in a loop
+  const int num_msgs = 200;
+  std::mt19937 rng(0);
+  std::vector<std::unique_ptr<MessageBuilder>> msgs;
+  for (int i = 0; i < num_msgs; ++i) {
+    auto msg = std::make_unique<MessageBuilder>();
+    auto rs = msg->initEvent().initRadarState();
+    const float t = i * 0.05;
+    fill_leads(rs.initLeadsLeft(num_leads), rng, t);
+    fill_leads(rs.initLeadsRight(num_leads), rng, t);
+    fill_leads(rs.initLeadsCenter(num_leads / 2), rng, t);
+    auto lead_one = rs.initLeadOne();
+    lead_one.setStatus(true);
+    lead_one.setDRel(8.f);
+    auto lead_one_plus = rs.initLeadOnePlus();
+    lead_one_plus.setStatus(true);
+    lead_one_plus.setDRel(20.f);
+    lead_one_plus.setVLeadK(27.f);
+    msgs.push_back(std::move(msg));
+  }
+  std::vector<cereal::RadarState::Reader> readers;
+  for (auto &msg : msgs) {
+    readers.push_back(msg->getRoot<cereal::Event>().asReader().getRadarState());
+  }
+
+  size_t sink = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < updates; ++i) {
+    const auto &rs = readers[i % num_msgs];
+    sink += legacy_adjacent(rs.getLeadsLeft(), true).size();
+    sink += legacy_adjacent(rs.getLeadsRight(), false).size();
+    sink += legacy_center(rs).size();
+  }
+  const double legacy_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / updates;
+
+  LeadSpeeds left, right, center;
+  begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < updates; ++i) {
+    const auto &rs = readers[i % num_msgs];
+    update_adjacent_lead_speeds(rs, speed_conv, left, right);
+    update_center_lead_speeds(rs, speed_conv, center);
+    sink += left.cnt + right.cnt + center.cnt;
+  }
+  const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / updates;
+
+  const uint64_t formatted = left.formatted + right.formatted + center.formatted;
+  printf("leads            %d per side, %d center\n", num_leads, num_leads / 2);
+  printf("legacy           %.0f ns per update\n", legacy_ns);
+  printf("lead speeds      %.0f ns per update, %.2f entries formatted per update\n", ns, (double)formatted / updates);
+  printf("left  \"%s\"\nright \"%s\"\n(%zu)\n", left.joined, right.joined, sink);
+  return 0;
+}
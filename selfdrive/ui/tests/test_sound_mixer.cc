@@ -0,0 +1,107 @@
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <unistd.h>
+
+#include "selfdrive/common/util.h"
+#include "selfdrive/ui/sound_mixer.h"
+
+static std::string make_wav(int rate, int channels, const std::vector<int16_t> &samples) {
+  auto le32 = [](uint32_t v) { return std::string((const char *)&v, 4); };
+  auto le16 = [](uint16_t v) { return std::string((const char *)&v, 2); };
+  const uint32_t data_len = samples.size() * 2;
+  std::string wav = "RIFF" + le32(4 + 8 + 16 + 8 + 6 + 8 + data_len) + "WAVE";
+  wav += "fmt " + le32(16) + le16(1) + le16(channels) + le32(rate) + le32(rate * channels * 2) + le16(channels * 2) + le16(16);
+  // unknown chunks are skipped
+  wav += "LIST" + le32(6) + std::string(6, '\0');
+  wav += "data" + le32(data_len) + std::string((const char *)samples.data(), data_len);
+  return wav;
+}
+
+TEST_CASE("decode_wav") {
+  std::vector<int16_t> pcm;
+
+  SECTION("mono at the output rate is unchanged") {
+    std::vector<int16_t> samples = {0, 100, -100, 32767, -32768};
+    REQUIRE(decode_wav(make_wav(48000, 1, samples), 48000, pcm));
+    REQUIRE(pcm == samples);
+  }
+  SECTION("stereo is downmixed") {
+    REQUIRE(decode_wav(make_wav(48000, 2, {100, 300, -200, 0}), 48000, pcm));
+    REQUIRE(pcm == std::vector<int16_t>{200, -100});
+  }
+  SECTION("resampled linearly") {
+    REQUIRE(decode_wav(make_wav(24000, 1, {0, 100, 200, 300}), 48000, pcm));
+    REQUIRE(pcm == std::vector<int16_t>{0, 50, 100, 150, 200, 250, 300, 300});
+  }
+  SECTION("rejects other formats") {
+    std::string wav = make_wav(48000, 1, {0, 1});
+    REQUIRE_FALSE(decode_wav(wav.substr(0, 20), 48000, pcm));
+    wav[20] = 3;  // float
+    REQUIRE_FALSE(decode_wav(wav, 48000, pcm));
+    REQUIRE_FALSE(decode_wav("", 48000, pcm));
+  }
+}
+
+// the mixer's clock, only moves when a test advances it
+static uint64_t fake_ns = 0;
+static uint64_t fake_clock() { return fake_ns; }
+
+TEST_CASE("SoundMixer") {
+  char path[] = "/tmp/test_sound_mixer_XXXXXX";
+  const int fd = mkstemp(path);
+  REQUIRE(fd != -1);
+  close(fd);
+  const std::string wav = make_wav(48000, 1, std::vector<int16_t>(1000, 1000));
+  REQUIRE(util::write_file(path, wav.data(), wav.size(), O_WRONLY | O_TRUNC) == 0);
+
+  SoundMixer mixer(fake_clock);
+  const int id = mixer.load(path);
+  unlink(path);
+  REQUIRE(id >= 0);
+  REQUIRE(mixer.load(std::string(path) + "/does_not_exist.wav") == -1);
+
+  std::vector<int16_t> out(600);
+  SECTION("one-shot plays once and stops") {
+    mixer.play(id, false, 0.5);
+    mixer.mix(out.data(), out.size());
+    REQUIRE(out[0] == 500);
+    mixer.stopLooping();
+    mixer.mix(out.data(), out.size());
+    REQUIRE(out[399] == 500);
+    REQUIRE(out[400] == 0);
+    REQUIRE_FALSE(mixer.playing());
+  }
+  SECTION("looping plays until stopped") {
+    mixer.play(id, true, 1.0);
+    for (int i = 0; i < 10; i++) {
+      mixer.mix(out.data(), out.size());
+    }
+    REQUIRE(out.back() == 1000);
+    mixer.stopLooping();
+    mixer.mix(out.data(), out.size());
+    REQUIRE(out[0] == 0);
+  }
+  SECTION("restarting a playing sound doesn't stack it") {
+    mixer.play(id, false, 1.0);
+    mixer.mix(out.data(), 100);
+    mixer.play(id, false, 1.0);
+    mixer.mix(out.data(), out.size());
+    REQUIRE(out[0] == 1000);
+  }
+  SECTION("latency through a null sink") {
+    // a sink pulling 10 ms periods with 40 ms queued in the output
+    const int period = SoundMixer::SAMPLE_RATE / 100;
+    double latency_ms = 0;
+    REQUIRE_FALSE(mixer.takeLatency(latency_ms));
+    for (int i = 0; i < 20; i++) {
+      mixer.play(id, false, 1.0);
+      // the next period is pulled up to 10 ms after the sound starts
+      fake_ns += (i % 10) * 1000000ULL;
+      mixer.mix(out.data(), period, 40);
+      REQUIRE(mixer.takeLatency(latency_ms));
+      REQUIRE(latency_ms == Approx(40 + i % 10));
+      REQUIRE_FALSE(mixer.takeLatency(latency_ms));
+    }
+  }
+}
@@ -10,8 +10,8 @@
 
 #include <QDateTime>
 
-#include "selfdrive/common/params.h"
 #include "selfdrive/common/swaglog.h"
+#include "selfdrive/common/timing.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/common/visionimg.h"
 #include "selfdrive/common/watchdog.h"
@@ -113,6 +113,9 @@ static void ui_init_vision(UIState *s) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_GREEN);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
   }
+  if (!Hardware::EON()) {
+    s->frame_uploader = std::make_unique<FrameUploader>();
+  }
   assert(glGetError() == GL_NO_ERROR);
 }
 
@@ -188,29 +191,29 @@ static void update_leads(UIState *s, const cereal::ModelDataV2::Reader &model) {
 static void update_line_data(const UIState *s, const cereal::ModelDataV2::XYZTData::Reader &line,
                              float y_off, float z_off, line_vertices_data *pvd, int max_idx, bool allow_invert=true, float y_offset = 0.) {
   const auto line_x = line.getX(), line_y = line.getY(), line_z = line.getZ();
-  std::vector<vertex_data> left_points, right_points;
+  // left points go straight into the polygon, right points are appended in reverse once the count is known
+  vertex_data right_points[TRAJECTORY_SIZE];
+  int cnt = 0;
   for (int i = 0; i <= max_idx; i++) {
     vertex_data left, right;
     bool l = calib_frame_to_full_frame(s, line_x[i], line_y[i] - y_off + y_offset, line_z[i] + z_off, &left);
     bool r = calib_frame_to_full_frame(s, line_x[i], line_y[i] + y_off + y_offset, line_z[i] + z_off, &right);
     if (l && r) {
       // For wider lines the drawn polygon will "invert" when going over a hill and cause artifacts
-      if (!allow_invert && left_points.size() && left.y > left_points.back().y) {
+      if (!allow_invert && cnt && left.y > pvd->v[cnt - 1].y) {
         continue;
       }
-      left_points.push_back(left);
-      right_points.push_back(right);
+      pvd->v[cnt] = left;
+      right_points[cnt] = right;
+      cnt++;
     }
   }
 
-  pvd->cnt = 2 * left_points.size();
-  assert(left_points.size() == right_points.size());
+  pvd->cnt = 2 * cnt;
   assert(pvd->cnt <= std::size(pvd->v));
 
-  for (int left_idx = 0; left_idx < left_points.size(); left_idx++){
-    int right_idx = 2 * left_points.size() - left_idx - 1;
-    pvd->v[left_idx] = left_points[left_idx];
-    pvd->v[right_idx] = right_points[left_idx];
+  for (int i = 0; i < cnt; i++){
+    pvd->v[2 * cnt - i - 1] = right_points[i];
   }
 }
 
@@ -274,56 +277,54 @@ static void update_state(UIState *s) {
 
   scene.map_open = (s->fb_h != 0 && (float)s->fb_w / (float)s->fb_h < 1.5);
   
-  if (t - scene.paramsCheckLast > scene.paramsCheckFreq){
-    scene.paramsCheckLast = t;
-    scene.disableDisengageOnGasEnabled = Params().getBool("DisableDisengageOnGas");
-    scene.speed_limit_control_enabled = Params().getBool("SpeedLimitControl");
-    scene.screen_dim_mode = std::stoi(Params().get("ScreenDimMode"));
-    scene.lane_pos_enabled = Params().getBool("LanePositionEnabled");
-    scene.lead_info_print_enabled = Params().getBool("PrintLeadInfo");
-    scene.adjacent_lead_info_print_enabled = Params().getBool("PrintAdjacentLeadSpeeds");
-    scene.adjacent_paths_enabled = Params().getBool("AdjacentPaths");
-    scene.speed_limit_eu_style = int(Params().getBool("EUSpeedLimitStyle"));
-    scene.show_debug_ui = Params().getBool("ShowDebugUI");
-    scene.brake_indicator_enabled = Params().getBool("BrakeIndicator");
-    if (scene.auto_lane_pos_active){
-      scene.lane_pos = std::stoi(Params().get("LanePosition"));
-    }
-    if (scene.disableDisengageOnGasEnabled){
-      scene.onePedalModeActive = Params().getBool("OnePedalMode");
-      scene.onePedalEngageOnGasEnabled = Params().getBool("OnePedalModeEngageOnGas");
-      scene.visionBrakingEnabled = Params().getBool("TurnVisionControl");
-      scene.mapBrakingEnabled = Params().getBool("TurnSpeedControl");
-    }
-    if (scene.accel_mode_button_enabled){
-      scene.accel_mode = std::stoi(Params().get("AccelMode"));
-    }
-    if (scene.dynamic_follow_mode_button_enabled){
-      scene.dynamic_follow_active = std::stoi(Params().get("DynamicFollow"));
-    }
-    if (scene.ev_eff_total_dist < 10.){
-      float oldDist = std::stof(Params().get("EVConsumptionTripDistance"));
-      if (oldDist > scene.ev_eff_total_dist){
-        scene.ev_eff_total_dist = oldDist;
-        scene.ev_recip_eff_wa[1] = std::stof(Params().get("EVConsumption5Mi"));
-        scene.ev_eff_total_dist = oldDist;
-        scene.ev_eff_total_kWh = std::stof(Params().get("EVConsumptionTripkWh"));
+  // params come from the snapshot, which only touches the filesystem when a param file changes
+  const UIParams &params = *s->params;
+  scene.disableDisengageOnGasEnabled = params.getBool(UIParam::DisableDisengageOnGas);
+  scene.speed_limit_control_enabled = params.getBool(UIParam::SpeedLimitControl);
+  scene.screen_dim_mode = params.getInt(UIParam::ScreenDimMode);
+  scene.lane_pos_enabled = params.getBool(UIParam::LanePositionEnabled);
+  scene.lead_info_print_enabled = params.getBool(UIParam::PrintLeadInfo);
+  scene.adjacent_lead_info_print_enabled = params.getBool(UIParam::PrintAdjacentLeadSpeeds);
+  scene.adjacent_paths_enabled = params.getBool(UIParam::AdjacentPaths);
+  scene.speed_limit_eu_style = int(params.getBool(UIParam::EUSpeedLimitStyle));
+  scene.show_debug_ui = params.getBool(UIParam::ShowDebugUI);
+  scene.brake_indicator_enabled = params.getBool(UIParam::BrakeIndicator);
+  if (scene.auto_lane_pos_active){
+    scene.lane_pos = params.getInt(UIParam::LanePosition);
+  }
+  if (scene.disableDisengageOnGasEnabled){
+    scene.onePedalModeActive = params.getBool(UIParam::OnePedalMode);
+    scene.onePedalEngageOnGasEnabled = params.getBool(UIParam::OnePedalModeEngageOnGas);
+    scene.visionBrakingEnabled = params.getBool(UIParam::TurnVisionControl);
+    scene.mapBrakingEnabled = params.getBool(UIParam::TurnSpeedControl);
+  }
+  if (scene.accel_mode_button_enabled){
+    scene.accel_mode = params.getInt(UIParam::AccelMode);
+  }
+  if (scene.dynamic_follow_mode_button_enabled){
+    scene.dynamic_follow_active = params.getBool(UIParam::DynamicFollow);
+  }
+  if (scene.ev_eff_total_dist < 10.){
+    float oldDist = params.getFloat(UIParam::EVConsumptionTripDistance);
+    if (oldDist > scene.ev_eff_total_dist){
+      scene.ev_eff_total_dist = oldDist;
+      scene.ev_recip_eff_wa[1] = params.getFloat(UIParam::EVConsumption5Mi);
+      scene.ev_eff_total_kWh = params.getFloat(UIParam::EVConsumptionTripkWh);
+    }
+  }
+  scene.car_is_ev = params.getBool(UIParam::CarIsEV);
+  if (s->sm->frame - scene.started_frame > 100 && s->sm->frame - scene.started_frame < 130 && !scene.car_is_ev){
+    for (int i = 0; i < scene.measure_max_num_slots; ++i){
+      bool metric_is_dup = false;
+      for (int j = 0; j < i && !metric_is_dup; ++j){
+        metric_is_dup = (scene.measure_slots[i] == scene.measure_slots[j]);
       }
-    }
-    scene.car_is_ev = Params().getBool("CarIsEV");
-    if (s->sm->frame - scene.started_frame > 100 && s->sm->frame - scene.started_frame < 130 && !scene.car_is_ev){
-      for (int i = 0; i < scene.measure_max_num_slots; ++i){
-        bool metric_is_dup = false;
+      while (metric_is_dup || scene.EVMeasures.count(static_cast<UIMeasure>(scene.measure_slots[i]))){
+        scene.measure_slots[i] = (scene.measure_slots[i]+1) % scene.num_measures;
+        metric_is_dup = false;
         for (int j = 0; j < i && !metric_is_dup; ++j){
           metric_is_dup = (scene.measure_slots[i] == scene.measure_slots[j]);
         }
-        while (metric_is_dup || scene.EVMeasures.count(static_cast<UIMeasure>(scene.measure_slots[i]))){
-          scene.measure_slots[i] = (scene.measure_slots[i]+1) % scene.num_measures;
-          metric_is_dup = false;
-          for (int j = 0; j < i && !metric_is_dup; ++j){
-            metric_is_dup = (scene.measure_slots[i] == scene.measure_slots[j]);
-          }
-        }
       }
     }
   }
@@ -331,27 +332,15 @@ static void update_state(UIState *s) {
   if (scene.started){
 
     if (scene.ev_eff_total_dist > 10. && sm.frame % scene.ev_eff_params_write_freq == 0) {
-      {
-        char val_str[18];
-        sprintf(val_str, "%.3f", scene.ev_recip_eff_wa[1]);
-        Params().put("EVConsumption5Mi", val_str, strlen(val_str));
-      }
-      {
-        char val_str[18];
-        sprintf(val_str, "%.3f", scene.ev_eff_total_kWh);
-        Params().put("EVConsumptionTripkWh", val_str, strlen(val_str));
-      }
-      {
-        char val_str[18];
-        sprintf(val_str, "%.3f", scene.ev_eff_total_dist);
-        Params().put("EVConsumptionTripDistance", val_str, strlen(val_str));
-      }
+      s->params->putFloat(UIParam::EVConsumption5Mi, scene.ev_recip_eff_wa[1]);
+      s->params->putFloat(UIParam::EVConsumptionTripkWh, scene.ev_eff_total_kWh);
+      s->params->putFloat(UIParam::EVConsumptionTripDistance, scene.ev_eff_total_dist);
     }
     
     if (scene.lane_pos != 0 && !s->scene.auto_lane_pos_active && scene.lane_pos_dist_since_set > scene.lane_pos_timeout_dist){
       scene.lane_pos = 0;
       scene.lane_pos_timeout_dist = scene.lane_pos_dist_short;
-      Params().put("LanePosition", "0", 1);
+      s->params->putInt(UIParam::LanePosition, 0);
     }
   
     // fade screen brightness
@@ -432,7 +421,7 @@ static void update_state(UIState *s) {
 
     bool car_is_ev = scene.car_state.getHvbWattage() != 0.0;
     if (car_is_ev && !scene.car_is_ev){
-      Params().putBool("CarIsEV", true);
+      s->params->putBool(UIParam::CarIsEV, true);
     }
     scene.car_is_ev = scene.car_is_ev || car_is_ev;
     
@@ -469,7 +458,7 @@ static void update_state(UIState *s) {
       scene.lane_pos_dist_since_set += scene.car_state.getVEgo() * (t - scene.lane_pos_dist_last_t);
       if (!s->scene.auto_lane_pos_active && abs(scene.car_state.getSteeringAngleDeg()) > scene.lane_pos_max_steer_deg){
         scene.lane_pos = 0;
-        Params().put("LanePosition", "0", 1);
+        s->params->putInt(UIParam::LanePosition, 0);
       }
     }
     scene.lane_pos_dist_last_t = t;
@@ -491,77 +480,13 @@ static void update_state(UIState *s) {
       scene.lead_y_vals.clear();
     }
     if (scene.adjacent_lead_info_print_enabled){
+      const float speed_conv = s->is_metric ? 3.6 : 2.2374144;
       if (!scene.adjacent_lead_info_print_at_lead){
-        // left leads
-        {
-          auto leads = radar_state.getLeadsLeft();
-          std::vector<LeadData> leads_vec;
-          leads_vec.reserve(leads.size());
-          for (auto const & l : leads){
-            leads_vec.push_back(l);
-          }
-          std::sort(leads_vec.begin(), leads_vec.end(), [](LeadData const & a, LeadData const & b){return a.getVLat() > b.getVLat();});
-          scene.adjacent_leads_left_str = "";
-          char val[16];
-          int cnt = 0;
-          for (int i = 0; i < leads_vec.size(); ++i){
-            if (cnt > 0){
-              scene.adjacent_leads_left_str += " ";
-            }
-            snprintf(val, sizeof(val), "%.0f", leads_vec[i].getVLeadK() * (s->is_metric ? 3.6 : 2.2374144));
-            scene.adjacent_leads_left_str += val;
-            cnt++;
-          }
-        }
-        // right leads
-        {
-          auto leads = radar_state.getLeadsRight();
-          std::vector<LeadData> leads_vec;
-          leads_vec.reserve(leads.size());
-          for (auto const & l : leads){
-            leads_vec.push_back(l);
-          }
-          std::sort(leads_vec.begin(), leads_vec.end(), [](LeadData const & a, LeadData const & b){return a.getVLat() < b.getVLat();});
-          scene.adjacent_leads_right_str = "";
-          char val[16];
-          int cnt = 0;
-          for (int i = 0; i < leads_vec.size(); ++i){
-            if (cnt > 0){
-              scene.adjacent_leads_right_str += " ";
-            }
-            snprintf(val, sizeof(val), "%.0f", leads_vec[i].getVLeadK() * (s->is_metric ? 3.6 : 2.2374144));
-            scene.adjacent_leads_right_str += val;
-            cnt++;
-          }
-        }
+        update_adjacent_lead_speeds(radar_state, speed_conv, scene.adjacent_leads_left, scene.adjacent_leads_right);
       }
       // center leads
       // printed the same despite adjacent lead printing style
-      {
-        auto leads = radar_state.getLeadsCenter();
-        std::vector<LeadData> leads_vec;
-        scene.adjacent_leads_center_strs.clear();
-        leads_vec.reserve(leads.size()+1);
-        char val[16];
-        auto lead_one_plus = radar_state.getLeadOnePlus();
-        auto lead_one = radar_state.getLeadOne();
-        int start_i = 0;
-        if (lead_one_plus.getStatus() && lead_one_plus.getDRel() - lead_one.getDRel() > 3.0){
-          start_i++;
-          snprintf(val, sizeof(val), "%.0f", lead_one_plus.getVLeadK() * (s->is_metric ? 3.6 : 2.2374144));
-          scene.adjacent_leads_center_strs.push_back(val);
-        }
-        for (auto const & l : leads){
-          leads_vec.push_back(l);
-        }
-        std::sort(leads_vec.begin(), leads_vec.end(), [](LeadData const & a, LeadData const & b){return a.getDRel() < b.getDRel();});
-        for (int i = start_i; i < leads_vec.size(); ++i){
-          if (!lead_one.getStatus() || leads_vec[i].getDRel() - lead_one.getDRel() > 3.0){
-            snprintf(val, sizeof(val), "%.0f", leads_vec[i].getVLeadK() * (s->is_metric ? 3.6 : 2.2374144));
-            scene.adjacent_leads_center_strs.push_back(val);
-          }
-        }
-      }
+      update_center_lead_speeds(radar_state, speed_conv, scene.adjacent_leads_center);
     }
   }
   if (sm.updated("modelV2") && s->vg) {
@@ -720,15 +645,12 @@ static void update_state(UIState *s) {
 }
 
 static void update_params(UIState *s) {
-  const uint64_t frame = s->sm->frame;
   UIScene &scene = s->scene;
-  if (frame % (5*UI_FREQ) == 0) {
-    scene.is_metric = Params().getBool("IsMetric");
-    s->is_metric = scene.is_metric;
-  }
+  scene.is_metric = s->params->getBool(UIParam::IsMetric);
+  s->is_metric = scene.is_metric;
 }
 
-static void update_vision(UIState *s) {
+static void update_vision(UIState *s, bool frame_ready) {
   if (!s->vipc_client->connected && s->scene.started) {
     if (s->vipc_client->connect(false)) {
       ui_init_vision(s);
@@ -736,14 +658,17 @@ static void update_vision(UIState *s) {
   }
 
   if (s->vipc_client->connected) {
-    VisionBuf * buf = s->vipc_client->recv();
-    if (buf != nullptr) {
-      s->last_frame = buf;
-    } else if (!Hardware::PC()) {
+    // the frame is sent before the camera state that woke us, so it's either queued already or
+    // close behind. show the newest queued frame
+    VisionIpcBufExtra extra = {};
+    VisionBuf *buf = s->vipc_client->recv(&extra, frame_ready ? 5 : 0);
+    if (buf == nullptr && frame_ready && !Hardware::PC()) {
       LOGE("visionIPC receive timeout");
     }
-  } else if (s->scene.started) {
-    util::sleep_for(1000. / UI_FREQ);
+    for (; buf != nullptr; buf = s->vipc_client->recv(&extra, 0)) {
+      s->last_frame = buf;
+      s->last_frame_id = extra.frame_id;
+    }
   }
 }
 
@@ -767,38 +692,37 @@ static void update_status(UIState *s) {
       s->status = STATUS_DISENGAGED;
       s->scene.started_frame = s->sm->frame;
 
-      if (Params().getBool("LowOverheadMode") && s->scene.screen_dim_mode_cur == s->scene.screen_dim_mode_max){
+      const UIParams &params = *s->params;
+      if (params.getBool(UIParam::LowOverheadMode) && s->scene.screen_dim_mode_cur == s->scene.screen_dim_mode_max){
         s->scene.screen_dim_mode_cur -= 1;
-        Params().put("ScreenDimMode", std::to_string(s->scene.screen_dim_mode_cur).c_str(), 1);
+        s->params->putInt(UIParam::ScreenDimMode, s->scene.screen_dim_mode_cur);
       }
-      s->scene.power_meter_mode = std::stoi(Params().get("PowerMeterMode"));
-      s->scene.power_meter_metric = Params().getBool("PowerMeterMetric");
-      s->scene.end_to_end = Params().getBool("EndToEndToggle");
-      s->scene.color_path = Params().getBool("ColorPath");
-      s->scene.alt_engage_color_enabled = Params().getBool("AlternateColors");
-      s->scene.adjacent_lead_info_print_at_lead = Params().getBool("PrintAdjacentLeadSpeedsAtLead");
+      s->scene.power_meter_mode = params.getInt(UIParam::PowerMeterMode);
+      s->scene.power_meter_metric = params.getBool(UIParam::PowerMeterMetric);
+      s->scene.end_to_end = params.getBool(UIParam::EndToEndToggle);
+      s->scene.color_path = params.getBool(UIParam::ColorPath);
+      s->scene.alt_engage_color_enabled = params.getBool(UIParam::AlternateColors);
+      s->scene.adjacent_lead_info_print_at_lead = params.getBool(UIParam::PrintAdjacentLeadSpeedsAtLead);
       if (!s->scene.end_to_end){
         s->scene.laneless_btn_touch_rect = {1,1,1,1};
       }
-      s->scene.laneless_mode = std::stoi(Params().get("LanelessMode"));
-      s->scene.brake_percent = std::stoi(Params().get("FrictionBrakePercent"));
+      s->scene.laneless_mode = params.getInt(UIParam::LanelessMode);
+      s->scene.brake_percent = params.getInt(UIParam::FrictionBrakePercent);
 
-      s->scene.accel_mode_button_enabled = Params().getBool("AccelModeButton");
+      s->scene.accel_mode_button_enabled = params.getBool(UIParam::AccelModeButton);
       if (!s->scene.accel_mode_button_enabled){
         s->scene.accel_mode_touch_rect = {1,1,1,1};
       }
-      s->scene.dynamic_follow_mode_button_enabled = Params().getBool("DynamicFollowToggle");
+      s->scene.dynamic_follow_mode_button_enabled = params.getBool(UIParam::DynamicFollowToggle);
       if (!s->scene.dynamic_follow_mode_button_enabled){
         s->scene.dynamic_follow_mode_touch_rect = {1,1,1,1};
       }
 
-      if (Params().getBool("EVConsumptionReset")) {
-        char val_str[18];
-        sprintf(val_str, "0.0");
-        Params().put("EVConsumption5Mi", val_str, strlen(val_str));
-        Params().put("EVConsumptionTripkWh", val_str, strlen(val_str));
-        Params().put("EVConsumptionTripDistance", val_str, strlen(val_str));
-        Params().putBool("EVConsumptionReset", false);
+      if (params.getBool(UIParam::EVConsumptionReset)) {
+        s->params->putFloat(UIParam::EVConsumption5Mi, 0.);
+        s->params->putFloat(UIParam::EVConsumptionTripkWh, 0.);
+        s->params->putFloat(UIParam::EVConsumptionTripDistance, 0.);
+        s->params->putBool(UIParam::EVConsumptionReset, false);
         s->scene.ev_recip_eff_wa[1] = 0.0;
         s->scene.ev_eff_total_dist = 0.0;
         s->scene.ev_eff_total_kWh = 0.0;
@@ -818,7 +742,7 @@ static void update_status(UIState *s) {
       s->scene.ev_eff_total_kWh = 0.;
       s->scene.ev_eff_total_dist = 0.;
 
-      s->scene.measure_config_num = std::stoi(Params().get("MeasureConfigNum"));
+      s->scene.measure_config_num = params.getInt(UIParam::MeasureConfigNum);
       s->scene.measure_cur_num_slots = s->scene.measure_config_list[s->scene.measure_config_num];
       s->scene.measure_num_rows = s->scene.measure_cur_num_slots;
       if (s->scene.measure_num_rows > s->scene.measure_max_rows){
@@ -826,12 +750,10 @@ static void update_status(UIState *s) {
       }
       s->scene.measure_row_offset = s->scene.measure_max_rows - s->scene.measure_num_rows;
       for (int i = 0; i < s->scene.measure_max_num_slots; ++i){
-        char slotName[16];
-        snprintf(slotName, sizeof(slotName), "MeasureSlot%.2d", i);
-        s->scene.measure_slots[i] = std::stoi(Params().get(slotName));
+        s->scene.measure_slots[i] = params.getInt(UIParams::measureSlot(i));
       }
 
-      s->wide_camera = Hardware::TICI() ? Params().getBool("EnableWideCamera") : false;
+      s->wide_camera = Hardware::TICI() ? params.getBool(UIParam::EnableWideCamera) : false;
 
       // Update intrinsics matrix after possible wide camera toggle change
       if (s->vg) {
@@ -845,9 +767,9 @@ static void update_status(UIState *s) {
         s->vipc_client = s->vipc_client_rear;
       }
 
-      s->scene.speed_limit_control_enabled = Params().getBool("SpeedLimitControl");
-      s->scene.speed_limit_perc_offset = Params().getBool("SpeedLimitPercOffset");
-      s->scene.show_debug_ui = Params().getBool("ShowDebugUI");
+      s->scene.speed_limit_control_enabled = params.getBool(UIParam::SpeedLimitControl);
+      s->scene.speed_limit_perc_offset = params.getBool(UIParam::SpeedLimitPercOffset);
+      s->scene.show_debug_ui = params.getBool(UIParam::ShowDebugUI);
     } else {
       s->vipc_client->connected = false;
     }
@@ -867,33 +789,61 @@ QUIState::QUIState(QObject *parent) : QObject(parent) {
   ui_state.fb_h = vwp_h;
   ui_state.scene.started = false;
   ui_state.last_frame = nullptr;
-  ui_state.wide_camera = Hardware::TICI() ? Params().getBool("EnableWideCamera") : false;
+  for (auto leads : {&ui_state.scene.lead_vertices_oncoming, &ui_state.scene.lead_vertices_ongoing, &ui_state.scene.lead_vertices_stopped}) {
+    leads->reserve(MAX_RADAR_LEADS);
+  }
+  ui_state.params = new UIParams(this);
+  ui_state.wide_camera = Hardware::TICI() ? ui_state.params->getBool(UIParam::EnableWideCamera) : false;
 
   ui_state.vipc_client_rear = new VisionIpcClient("camerad", VISION_STREAM_RGB_BACK, true);
   ui_state.vipc_client_wide = new VisionIpcClient("camerad", VISION_STREAM_RGB_WIDE, true);
 
   ui_state.vipc_client = ui_state.vipc_client_rear;
 
-  // update timer
+  waker = std::make_unique<MessageWaker>([=] {
+    QMetaObject::invokeMethod(this, "wake", Qt::QueuedConnection);
+  });
+
+  // update timer. offroad it sets the update rate, onroad it only runs when nothing woke us for a while
   timer = new QTimer(this);
-  QObject::connect(timer, &QTimer::timeout, this, &QUIState::update);
+  QObject::connect(timer, &QTimer::timeout, [=] { update(); });
   timer->start(0);
 }
 
-void QUIState::update() {
+void QUIState::wake() {
+  const int sources = waker->take();
+  if (!ui_state.scene.started || sources == 0) {
+    return;
+  }
+
+  // Camera frames set the onroad update rate, as they did when the UI blocked on VisionIPC.
+  // Many timeouts count updates, so the rate stays UI_FREQ and other messages only update
+  // on their own while no frames arrive.
+  const double t = millis_since_boot();
+  const int camera = ui_state.wide_camera ? WAKE_WIDE_ROAD_CAMERA : WAKE_ROAD_CAMERA;
+  if (sources & camera) {
+    last_frame_wake_t = t;
+    update(true);
+  } else if (t - last_frame_wake_t > 1.5 * 1000 / UI_FREQ && t - last_update_t > 0.9 * 1000 / UI_FREQ) {
+    update();
+  }
+}
+
+void QUIState::update(bool frame_ready) {
+  last_update_t = millis_since_boot();
+  timer->start();
+
   update_params(&ui_state);
   update_sockets(&ui_state);
   update_state(&ui_state);
   update_status(&ui_state);
-  update_vision(&ui_state);
+  update_vision(&ui_state, frame_ready);
 
   if (ui_state.scene.started != started_prev || ui_state.sm->frame == 1) {
     started_prev = ui_state.scene.started;
     emit offroadTransition(!ui_state.scene.started);
 
-    // Change timeout to 0 when onroad, this will call update continuously.
-    // This puts visionIPC in charge of update frequency, reducing video latency
-    timer->start(ui_state.scene.started ? 0 : 1000 / UI_FREQ);
+    timer->start(ui_state.scene.started ? 2 * 1000 / UI_FREQ : 1000 / UI_FREQ);
   }
 
   watchdog_kick();
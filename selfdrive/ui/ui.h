@@ -25,6 +25,9 @@
 #include "selfdrive/common/params.h"
 #include "selfdrive/common/util.h"
 #include "selfdrive/common/visionimg.h"
+#include "selfdrive/ui/frame_pacer.h"
+#include "selfdrive/ui/lead_speeds.h"
+#include "selfdrive/ui/ui_params.h"
 
 #define COLOR_BLACK nvgRGBA(0, 0, 0, 255)
 #define COLOR_BLACK_ALPHA(x) nvgRGBA(0, 0, 0, x)
@@ -286,8 +289,7 @@ typedef struct UIScene {
   bool adjacent_paths_enabled;
   bool adjacent_lead_info_print_enabled;
   bool adjacent_lead_info_print_at_lead;
-  std::string adjacent_leads_left_str, adjacent_leads_right_str;
-  std::vector<std::string> adjacent_leads_center_strs;
+  LeadSpeeds adjacent_leads_left, adjacent_leads_right, adjacent_leads_center;
   Rect adjacent_lead_info_touch_rect = {1,1,1,1};
 
   LaneTraffic traffic_left, traffic_right;
@@ -403,7 +405,6 @@ typedef struct UIScene {
   float bearingDeg;
   
   float lastTime = 0., sessionInitTime = 0.;
-  float paramsCheckLast = 0., paramsCheckFreq = 0.1; // check params at 10Hz
   bool onePedalModeActive, disableDisengageOnGasEnabled, onePedalEngageOnGasEnabled, visionBrakingEnabled, mapBrakingEnabled;
 
   int lead_status;
@@ -508,6 +509,7 @@ typedef struct UIState {
   VisionIpcClient * vipc_client_rear;
   VisionIpcClient * vipc_client_wide;
   VisionBuf * last_frame;
+  uint32_t last_frame_id;
 
   // framebuffer
   int fb_w, fb_h;
@@ -519,6 +521,7 @@ typedef struct UIState {
   std::map<std::string, int> images;
 
   std::unique_ptr<SubMaster> sm;
+  UIParams *params;
 
   UIStatus status;
   UIScene scene;
@@ -526,6 +529,7 @@ typedef struct UIState {
   // graphics
   std::unique_ptr<GLShader> gl_shader;
   std::unique_ptr<EGLImageTexture> texture[UI_BUF_COUNT];
+  std::unique_ptr<FrameUploader> frame_uploader;
 
   GLuint frame_vao, frame_vbo, frame_ibo;
   mat4 rear_frame_mat;
@@ -536,6 +540,8 @@ typedef struct UIState {
 
   float car_space_transform[6];
   bool wide_camera;
+
+  FrameStats frame_stats;
 } UIState;
 
 
@@ -553,10 +559,14 @@ signals:
   void offroadTransition(bool offroad);
 
 private slots:
-  void update();
+  void wake();
 
 private:
+  void update(bool frame_ready = false);
+
   QTimer *timer;
+  std::unique_ptr<MessageWaker> waker;
+  double last_update_t = 0, last_frame_wake_t = 0;
   bool started_prev = true;
 };
 
@@ -0,0 +1,135 @@
+#include "selfdrive/ui/ui_params.h"
+
+#include <cstdlib>
+#include <iterator>
+
+#include "selfdrive/common/swaglog.h"
+
+// same order as UIParam
+static const char *param_names[] = {
+  "AccelModeButton", "AdjacentPaths", "AlternateColors", "AutoLanePositionActive", "BrakeIndicator",
+  "CarIsEV", "Coasting", "ColorPath", "CustomSounds", "DisableDisengageOnGas", "DynamicFollow", "DynamicFollowToggle",
+  "EnableWideCamera", "EndToEndToggle", "EUSpeedLimitStyle", "EVConsumptionReset", "IsMetric",
+  "LanePositionEnabled", "LowOverheadMode", "OnePedalMode", "OnePedalModeEngageOnGas", "PowerMeterMetric",
+  "PrimeRedirected", "PrintAdjacentLeadSpeeds", "PrintAdjacentLeadSpeedsAtLead", "PrintLeadInfo",
+  "ScreenTapped", "ShowDebugUI", "SilentEngageDisengage", "SpeedLimitControl", "SpeedLimitPercOffset", "TurnSpeedControl",
+  "TurnVisionControl",
+  "AccelMode", "FrictionBrakePercent", "LanelessMode", "LanePosition", "MeasureConfigNum",
+  "MeasureSlot00", "MeasureSlot01", "MeasureSlot02", "MeasureSlot03", "MeasureSlot04",
+  "MeasureSlot05", "MeasureSlot06", "MeasureSlot07", "MeasureSlot08", "MeasureSlot09",
+  "PowerMeterMode", "ScreenDimMode",
+  "EVConsumption5Mi", "EVConsumptionTripDistance", "EVConsumptionTripkWh",
+};
+static_assert(std::size(param_names) == (int)UIParam::NUM_PARAMS);
+
+static inline bool is_bool(int idx) { return idx < (int)UIParam::AccelMode; }
+static inline bool is_float(int idx) { return idx >= (int)UIParam::EVConsumption5Mi; }
+
+static inline struct timespec mtime(const struct stat &st) {
+#ifdef __APPLE__
+  return st.st_mtimespec;
+#else
+  return st.st_mtim;
+#endif
+}
+
+UIParams::UIParams(QObject *parent) : QObject(parent) {
+  for (int i = 0; i < (int)UIParam::NUM_PARAMS; i++) {
+    struct stat st = {};
+    stat(params.getParamPath(param_names[i]).c_str(), &st);
+    load(i, st);
+  }
+
+  // Params::put renames a finished temp file into the directory, so every write shows up as a directory change
+  watcher = new QFileSystemWatcher(this);
+  watcher->addPath(QString::fromStdString(params.getParamsPath() + "/d"));
+  QObject::connect(watcher, &QFileSystemWatcher::directoryChanged, this, &UIParams::refresh);
+
+  writer = std::thread(&UIParams::writerThread, this);
+}
+
+UIParams::~UIParams() {
+  {
+    std::lock_guard lk(lock);
+    stop = true;
+  }
+  cv.notify_one();
+  writer.join();
+}
+
+void UIParams::load(int idx, const struct stat &st) {
+  Value &v = values[idx];
+  v.ino = st.st_ino;
+  v.mtime = mtime(st);
+
+  const std::string val = st.st_ino ? params.get(param_names[idx]) : "";
+  if (is_bool(idx)) {
+    v.i = val == "1";
+  } else if (is_float(idx)) {
+    v.f = strtof(val.c_str(), nullptr);
+  } else {
+    v.i = strtol(val.c_str(), nullptr, 10);
+  }
+}
+
+void UIParams::refresh() {
+  for (int i = 0; i < (int)UIParam::NUM_PARAMS; i++) {
+    if (pending[i] > 0) {
+      continue;
+    }
+    struct stat st = {};
+    stat(params.getParamPath(param_names[i]).c_str(), &st);
+    const Value &v = values[i];
+    const struct timespec t = mtime(st);
+    if (st.st_ino != v.ino || t.tv_sec != v.mtime.tv_sec || t.tv_nsec != v.mtime.tv_nsec) {
+      load(i, st);
+    }
+  }
+}
+
+void UIParams::putBool(UIParam p, bool val) {
+  put(p, val, 0, val ? "1" : "0");
+}
+
+void UIParams::putInt(UIParam p, int val) {
+  put(p, val, 0, std::to_string(val));
+}
+
+void UIParams::putFloat(UIParam p, float val) {
+  char val_str[18];
+  snprintf(val_str, sizeof(val_str), "%.3f", val);
+  put(p, 0, val, val_str);
+}
+
+void UIParams::put(UIParam p, int i, float f, std::string val) {
+  values[(int)p].i = i;
+  values[(int)p].f = f;
+  pending[(int)p]++;
+  {
+    std::lock_guard lk(lock);
+    queue.emplace_back(p, std::move(val));
+  }
+  cv.notify_one();
+}
+
+void UIParams::writerThread() {
+  std::unique_lock lk(lock);
+  while (true) {
+    cv.wait(lk, [this] { return stop || !queue.empty(); });
+    // pending writes are flushed before exiting
+    if (queue.empty()) {
+      break;
+    }
+    auto [p, val] = std::move(queue.front());
+    queue.pop_front();
+
+    lk.unlock();
+    if (params.put(param_names[(int)p], val.data(), val.size()) != 0) {
+      LOGE("failed to write param %s", param_names[(int)p]);
+    }
+    pending[(int)p]--;
+    // pick up the new inode, the directory notification may have come while the write was pending
+    QMetaObject::invokeMethod(this, "refresh", Qt::QueuedConnection);
+    lk.lock();
+  }
+}
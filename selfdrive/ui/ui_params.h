@@ -0,0 +1,117 @@
+#pragma once
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <QFileSystemWatcher>
+#include <QObject>
+
+#include "selfdrive/common/params.h"
+
+enum class UIParam {
+  // bool
+  AccelModeButton,
+  AdjacentPaths,
+  AlternateColors,
+  AutoLanePositionActive,
+  BrakeIndicator,
+  CarIsEV,
+  Coasting,
+  ColorPath,
+  CustomSounds,
+  DisableDisengageOnGas,
+  DynamicFollow,
+  DynamicFollowToggle,
+  EnableWideCamera,
+  EndToEndToggle,
+  EUSpeedLimitStyle,
+  EVConsumptionReset,
+  IsMetric,
+  LanePositionEnabled,
+  LowOverheadMode,
+  OnePedalMode,
+  OnePedalModeEngageOnGas,
+  PowerMeterMetric,
+  PrimeRedirected,
+  PrintAdjacentLeadSpeeds,
+  PrintAdjacentLeadSpeedsAtLead,
+  PrintLeadInfo,
+  ScreenTapped,
+  ShowDebugUI,
+  SilentEngageDisengage,
+  SpeedLimitControl,
+  SpeedLimitPercOffset,
+  TurnSpeedControl,
+  TurnVisionControl,
+  // int
+  AccelMode,
+  FrictionBrakePercent,
+  LanelessMode,
+  LanePosition,
+  MeasureConfigNum,
+  MeasureSlot00, MeasureSlot01, MeasureSlot02, MeasureSlot03, MeasureSlot04,
+  MeasureSlot05, MeasureSlot06, MeasureSlot07, MeasureSlot08, MeasureSlot09,
+  PowerMeterMode,
+  ScreenDimMode,
+  // float
+  EVConsumption5Mi,
+  EVConsumptionTripDistance,
+  EVConsumptionTripkWh,
+  NUM_PARAMS
+};
+
+// Typed snapshot of the params the UI uses. Everything is read once at startup and a
+// param is only read and parsed again when its file in the params directory changes,
+// so getters are plain loads. Puts update the snapshot right away and are written to
+// disk in order on a background thread, keeping the fsyncs off the UI thread.
+class UIParams : public QObject {
+  Q_OBJECT
+
+public:
+  UIParams(QObject *parent = nullptr);
+  ~UIParams();
+
+  inline bool getBool(UIParam p) const { return values[(int)p].i != 0; }
+  inline int getInt(UIParam p) const { return values[(int)p].i; }
+  inline float getFloat(UIParam p) const { return values[(int)p].f; }
+
+  void putBool(UIParam p, bool val);
+  void putInt(UIParam p, int val);
+  void putFloat(UIParam p, float val);
+
+  static inline UIParam measureSlot(int i) { return UIParam((int)UIParam::MeasureSlot00 + i); }
+
+private slots:
+  void refresh();
+
+private:
+  struct Value {
+    int i;
+    float f;
+    ino_t ino;
+    struct timespec mtime;
+  };
+
+  void load(int idx, const struct stat &st);
+  void put(UIParam p, int i, float f, std::string val);
+  void writerThread();
+
+  Params params;
+  QFileSystemWatcher *watcher;
+  Value values[(int)UIParam::NUM_PARAMS] = {};
+
+  // params with queued writes aren't refreshed from disk, the snapshot already holds the newest value
+  std::atomic<int> pending[(int)UIParam::NUM_PARAMS] = {};
+  std::mutex lock;
+  std::condition_variable cv;
+  std::deque<std::pair<UIParam, std::string>> queue;
+  bool stop = false;
+  std::thread writer;
+};